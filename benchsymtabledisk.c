@@ -0,0 +1,112 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtabledisk.c                                                */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+#include "symtabledisk.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*--------------------------------------------------------------------*/
+
+/* Ratios of page cache size to page file size that are measured */
+static const double CACHE_RATIOS[] = {0.01, 0.05, 0.1, 0.25, 0.5, 0.75,
+                                      1.0, 1.25};
+
+/* Number of ratios measured */
+static const size_t CACHE_RATIOS_LEN =
+    sizeof(CACHE_RATIOS) / sizeof(CACHE_RATIOS[0]);
+
+/*--------------------------------------------------------------------*/
+
+/* Fill a disk-backed SymTable object that caches uCacheBytes bytes of
+pages with iBindingCount bindings, then look up iBindingCount keys
+chosen at random. Write the lookup throughput to stdout, and return
+the number of bytes of the table's page file, or 0 if the table could
+not be made. */
+
+static size_t measure(int iBindingCount, size_t uCacheBytes,
+                      double dRatio)
+{
+    enum {MAX_KEY_LENGTH = 16};
+
+    SymTable_T oSymTable;
+    char acKey[MAX_KEY_LENGTH];
+    clock_t iInitialClock;
+    clock_t iFinalClock;
+    size_t uFileBytes;
+    double dSeconds;
+    int i;
+    int iFound = 0;
+
+    oSymTable = SymTable_newDisk(NULL, uCacheBytes,
+                                 &SymTable_pointerCodec);
+    if (oSymTable == NULL)
+        return 0;
+
+    for (i = 0; i < iBindingCount; i++)
+    {
+        sprintf(acKey, "%d", i);
+        (void)SymTable_put(oSymTable, acKey, NULL);
+    }
+
+    srand(1);
+    iInitialClock = clock();
+    for (i = 0; i < iBindingCount; i++)
+    {
+        sprintf(acKey, "%d", rand() % iBindingCount);
+        iFound += SymTable_contains(oSymTable, acKey);
+    }
+    iFinalClock = clock();
+
+    dSeconds = ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC;
+    uFileBytes = SymTable_getFileBytes(oSymTable);
+    if (dRatio > 0)
+        printf("cache/data %5.2f: %10.0f lookups/s (%d found)\n",
+               dRatio, dSeconds > 0 ? iBindingCount / dSeconds : 0.0,
+               iFound);
+    fflush(stdout);
+
+    SymTable_free(oSymTable);
+    return uFileBytes;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Measure the lookup throughput of a disk-backed SymTable object that
+contains argv[1] bindings, for page caches of several sizes relative
+to the size of its page file. Exit with EXIT_FAILURE if argv[1] is
+missing or not a positive number. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+    int iBindingCount;
+    size_t uFileBytes;
+    size_t u;
+
+    if (argc != 2 || sscanf(argv[1], "%d", &iBindingCount) != 1 ||
+        iBindingCount <= 0)
+    {
+        fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Learn the size of the page file with a cache that holds it all */
+    uFileBytes = measure(iBindingCount,
+                         (size_t)iBindingCount * 256 + 1024 * 1024, 0);
+    if (uFileBytes == 0)
+    {
+        fprintf(stderr, "Cannot create table\n");
+        exit(EXIT_FAILURE);
+    }
+    printf("%d bindings use %lu bytes of pages\n", iBindingCount,
+           (unsigned long)uFileBytes);
+
+    for (u = 0; u < CACHE_RATIOS_LEN; u++)
+        (void)measure(iBindingCount,
+                      (size_t)(CACHE_RATIOS[u] * (double)uFileBytes),
+                      CACHE_RATIOS[u]);
+
+    return 0;
+}
@@ -0,0 +1,277 @@
+/*--------------------------------------------------------------------*/
+/* loadsymtable.c                                                     */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+#define _XOPEN_SOURCE 700
+
+#include "symtableclient.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*--------------------------------------------------------------------*/
+
+/* Number of keys that the requests choose from */
+enum {KEY_COUNT = 100000};
+
+/* Greatest number of bytes of a key */
+enum {MAX_KEY_LENGTH = 16};
+
+/* Each Load is the work and the results of one client thread */
+struct Load
+{
+    /* The thread */
+    pthread_t thread;
+    /* Name of the server's socket */
+    const char *socketPath;
+    /* Number of requests to send, and number sent per batch */
+    int requestCount;
+    int depth;
+    /* Percentage of requests that are gets; the rest are puts */
+    int getPercent;
+    /* Value sent by puts, and its number of bytes */
+    const char *value;
+    size_t valueLength;
+    /* Seed of the random choices */
+    unsigned int seed;
+    /* Round-trip time of each batch, in microseconds */
+    double *latencies;
+    /* Number of batches, and number of responses that were errors */
+    int batchCount;
+    int errorCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the time of the monotonic clock in seconds */
+
+static double now(void)
+{
+    struct timespec sTime;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &sTime);
+    return (double)sTime.tv_sec + (double)sTime.tv_nsec / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the next random number from *puSeed */
+
+static unsigned int nextRandom(unsigned int *puSeed)
+{
+    *puSeed = *puSeed * 1103515245U + 12345U;
+    return *puSeed >> 8;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Send the requests of pvLoad, a Load, in batches, recording the
+round-trip time of each batch. Return NULL */
+
+static void *runLoad(void *pvLoad)
+{
+    struct Load *psLoad = pvLoad;
+    SymTableClient_T oClient;
+    char acKey[MAX_KEY_LENGTH];
+    const void *pvValue;
+    size_t uLength;
+    double dStart;
+    int iSent = 0;
+    int iBatch;
+    int i;
+
+    oClient = SymTableClient_connect(psLoad->socketPath);
+    if (oClient == NULL)
+    {
+        psLoad->errorCount = psLoad->requestCount;
+        return NULL;
+    }
+
+    while (iSent < psLoad->requestCount)
+    {
+        iBatch = psLoad->requestCount - iSent;
+        if (iBatch > psLoad->depth)
+            iBatch = psLoad->depth;
+
+        dStart = now();
+        for (i = 0; i < iBatch; i++)
+        {
+            sprintf(acKey, "%u", nextRandom(&psLoad->seed) % KEY_COUNT);
+            if ((int)(nextRandom(&psLoad->seed) % 100) < psLoad->getPercent)
+                (void)SymTableClient_sendGet(oClient, acKey);
+            else
+                (void)SymTableClient_sendPut(oClient, acKey, psLoad->value,
+                                             psLoad->valueLength);
+        }
+        for (i = 0; i < iBatch; i++)
+            if (SymTableClient_receive(oClient, &pvValue, &uLength) !=
+                SYMTABLEPROTO_OK)
+                psLoad->errorCount++;
+
+        psLoad->latencies[psLoad->batchCount++] = (now() - dStart) * 1e6;
+        iSent += iBatch;
+    }
+
+    SymTableClient_free(oClient);
+    return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the doubles at pvFirst and pvSecond for qsort */
+
+static int compareDoubles(const void *pvFirst, const void *pvSecond)
+{
+    double dFirst = *(const double *)pvFirst;
+    double dSecond = *(const double *)pvSecond;
+
+    return (dFirst > dSecond) - (dFirst < dSecond);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Bind every key the requests choose from, through a client of the
+server listening on pcSocketPath, to the uLength bytes at pcValue.
+Return 1 (TRUE) if successful, or 0 (FALSE) otherwise */
+
+static int preload(const char *pcSocketPath, const char *pcValue,
+                   size_t uLength)
+{
+    SymTableClient_T oClient;
+    char acKey[MAX_KEY_LENGTH];
+    const void *pvValue;
+    size_t uValueLength;
+    int iSuccessful = 1;
+    int i;
+
+    oClient = SymTableClient_connect(pcSocketPath);
+    if (oClient == NULL)
+        return 0;
+    for (i = 0; i < KEY_COUNT; i++)
+    {
+        sprintf(acKey, "%d", i);
+        if (!SymTableClient_sendPut(oClient, acKey, pcValue, uLength))
+            iSuccessful = 0;
+    }
+    for (i = 0; i < KEY_COUNT; i++)
+        if (SymTableClient_receive(oClient, &pvValue, &uValueLength) !=
+            SYMTABLEPROTO_OK)
+            iSuccessful = 0;
+    SymTableClient_free(oClient);
+    return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Measure a symtableserver listening on the socket named argv[1] with
+argv[2] clients, each sending argv[3] requests in batches of argv[4]
+(default 1), argv[5] percent of them gets (default 90) and the rest
+puts of argv[6]-byte values (default 100). Write the throughput and
+the distribution of batch round-trip times to stdout. Exit with
+EXIT_FAILURE if an argument is invalid or the server cannot be
+reached. Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+    struct Load *psLoads;
+    char *pcValue;
+    double *pdAll;
+    double dStart, dSeconds;
+    int iClientCount, iRequestCount;
+    int iDepth = 1, iGetPercent = 90, iValueLength = 100;
+    int iBatchCount = 0, iErrorCount = 0;
+    int i;
+
+    if (argc < 4 || argc > 7 ||
+        sscanf(argv[2], "%d", &iClientCount) != 1 || iClientCount <= 0 ||
+        sscanf(argv[3], "%d", &iRequestCount) != 1 || iRequestCount <= 0 ||
+        (argc > 4 && (sscanf(argv[4], "%d", &iDepth) != 1 || iDepth <= 0)) ||
+        (argc > 5 && (sscanf(argv[5], "%d", &iGetPercent) != 1 ||
+                      iGetPercent < 0 || iGetPercent > 100)) ||
+        (argc > 6 && (sscanf(argv[6], "%d", &iValueLength) != 1 ||
+                      iValueLength < 0 ||
+                      iValueLength > SYMTABLEPROTO_MAX_VALUE)))
+    {
+        fprintf(stderr, "Usage: %s socketpath clients requests [depth "
+                "[getpercent [valuebytes]]]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    pcValue = malloc((size_t)iValueLength + 1);
+    psLoads = calloc((size_t)iClientCount, sizeof(struct Load));
+    if (pcValue == NULL || psLoads == NULL)
+    {
+        fprintf(stderr, "Insufficient memory\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(pcValue, 'v', (size_t)iValueLength);
+
+    if (!preload(argv[1], pcValue, (size_t)iValueLength))
+    {
+        fprintf(stderr, "Cannot reach server at %s\n", argv[1]);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Run every client at once */
+    dStart = now();
+    for (i = 0; i < iClientCount; i++)
+    {
+        psLoads[i].socketPath = argv[1];
+        psLoads[i].requestCount = iRequestCount;
+        psLoads[i].depth = iDepth;
+        psLoads[i].getPercent = iGetPercent;
+        psLoads[i].value = pcValue;
+        psLoads[i].valueLength = (size_t)iValueLength;
+        psLoads[i].seed = (unsigned int)i + 1;
+        psLoads[i].latencies = malloc(
+            ((size_t)iRequestCount / (size_t)iDepth + 1) * sizeof(double));
+        if (psLoads[i].latencies == NULL ||
+            pthread_create(&psLoads[i].thread, NULL, runLoad,
+                           &psLoads[i]) != 0)
+        {
+            fprintf(stderr, "Cannot start client %d\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (i = 0; i < iClientCount; i++)
+        (void)pthread_join(psLoads[i].thread, NULL);
+    dSeconds = now() - dStart;
+
+    /* Gather the round-trip times of every batch */
+    for (i = 0; i < iClientCount; i++)
+        iBatchCount += psLoads[i].batchCount;
+    pdAll = malloc(((size_t)iBatchCount + 1) * sizeof(double));
+    if (pdAll == NULL)
+    {
+        fprintf(stderr, "Insufficient memory\n");
+        exit(EXIT_FAILURE);
+    }
+    iBatchCount = 0;
+    for (i = 0; i < iClientCount; i++)
+    {
+        memcpy(pdAll + iBatchCount, psLoads[i].latencies,
+               (size_t)psLoads[i].batchCount * sizeof(double));
+        iBatchCount += psLoads[i].batchCount;
+        iErrorCount += psLoads[i].errorCount;
+        free(psLoads[i].latencies);
+    }
+    qsort(pdAll, (size_t)iBatchCount, sizeof(double), compareDoubles);
+
+    printf("%d clients, depth %d, %d%% gets, %d-byte values\n",
+           iClientCount, iDepth, iGetPercent, iValueLength);
+    printf("%10.0f requests/s (%d errors)\n",
+           (double)iClientCount * iRequestCount / dSeconds, iErrorCount);
+    if (iBatchCount > 0)
+        printf("batch round trip: p50 %.1f us, p99 %.1f us, "
+               "max %.1f us\n",
+               pdAll[iBatchCount / 2], pdAll[iBatchCount * 99 / 100],
+               pdAll[iBatchCount - 1]);
+
+    free(pdAll);
+    free(psLoads);
+    free(pcValue);
+    return 0;
+}
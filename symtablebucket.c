@@ -0,0 +1,489 @@
+/*--------------------------------------------------------------------*/
+/* symtablebucket.c                                                   */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+/* Hash-table-based implementation of symbol table that maps string
+keys to void* values, with buckets the size of one cache line. Each
+key is stored with defensive copy to ensure ownership by symbol table.
+Every bucket is a 64-byte block, aligned to 64 bytes, that holds up to
+BUCKET_ENTRIES bindings as a 16-bit tag, a key pointer and a value
+pointer each, followed by a pointer to an overflow bucket that is
+used only once the bucket is full. A lookup compares the tags first
+and follows a key pointer only when its tag matches, so most lookups
+read exactly one cache line of the table. Within each chain of
+buckets, the bindings are packed at the front and every bucket but
+the last is full */
+
+#define _XOPEN_SOURCE 700
+
+#include "symtable.h"
+#include "symtablehashcode.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Number of bindings that fit in a bucket */
+enum {BUCKET_ENTRIES = 3};
+
+/* Number of bytes of a cache line, to which buckets are aligned */
+enum {CACHE_LINE = 64};
+
+/* Initial number of buckets. Must be a power of two so that a hash
+code can be reduced to a bucket index with a mask */
+static const size_t INITIAL_BUCKET_COUNT = 256;
+
+/* The bucket array is doubled when adding one more binding would
+make the average number of bindings per bucket exceed MAX_LOAD. Two
+of three entries keeps the chance that a bucket overflows near one in
+seven */
+static const size_t MAX_LOAD = 2;
+
+/* Tag of an empty entry */
+static const uint16_t EMPTY = 0;
+
+/* A Bucket holds up to BUCKET_ENTRIES bindings in one cache line */
+struct Bucket
+{
+    /* Tag of each entry, taken from the high bits of the key's hash
+    code, or EMPTY if the entry is not in use */
+    uint16_t tags[BUCKET_ENTRIES];
+    /* Pointers to the key strings (defensive copies) */
+    const char *keys[BUCKET_ENTRIES];
+    /* Pointers to the associated values */
+    const void *values[BUCKET_ENTRIES];
+    /* Pointer to the next bucket of the chain, or NULL */
+    struct Bucket *overflow;
+};
+
+/* SymTable structure represents overall hash table */
+struct SymTable
+{
+    /* Array of buckets, aligned to a cache line */
+    struct Bucket *buckets;
+    /* Number of buckets in buckets array (a power of two) */
+    size_t bucketCount;
+    /* Stores total number of bindings in SymTable */
+    size_t bindingsCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the full hash code for pcKey. The bucket index is its low
+bits and the tag its top 16 bits */
+
+static size_t SymTable_hash(const char *pcKey)
+{
+    return (size_t)SymTableHashCode_full(pcKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the tag for a key whose hash code is uHash, never EMPTY */
+
+static uint16_t SymTable_tag(size_t uHash)
+{
+    uint16_t uTag = (uint16_t)(uHash >> (sizeof(size_t) * 8 - 16));
+
+    if (uTag == EMPTY)
+        return 1;
+    return uTag;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new bucket array of uCount empty buckets aligned to a
+cache line, or NULL if insufficient memory is available */
+
+static struct Bucket *SymTable_newBuckets(size_t uCount)
+{
+    void *pvBuckets;
+
+    if (posix_memalign(&pvBuckets, CACHE_LINE,
+                       uCount * sizeof(struct Bucket)) != 0)
+        return NULL;
+    memset(pvBuckets, 0, uCount * sizeof(struct Bucket));
+    return pvBuckets;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free every overflow bucket of the bucket array aBuckets of uCount
+buckets */
+
+static void SymTable_freeOverflow(struct Bucket *aBuckets,
+                                  size_t uCount)
+{
+    struct Bucket *curr, *next;
+    size_t u;
+
+    for (u = 0; u < uCount; u++)
+    {
+        for (curr = aBuckets[u].overflow; curr != NULL; curr = next)
+        {
+            next = curr->overflow;
+            free(curr);
+        }
+    }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add a binding of pcKey, whose hash code is uHash, to pvValue at the
+end of its chain in the bucket array aBuckets of uCount buckets.
+pcKey must not be bound already. Return 1 (TRUE) if successful, or 0
+(FALSE) if insufficient memory is available */
+
+static int SymTable_insert(struct Bucket *aBuckets, size_t uCount,
+                           const char *pcKey, size_t uHash,
+                           const void *pvValue)
+{
+    struct Bucket *curr;
+    size_t j;
+
+    /* Find the last bucket of the chain */
+    curr = &aBuckets[uHash & (uCount - 1)];
+    while (curr->overflow != NULL)
+        curr = curr->overflow;
+
+    /* Find its first empty entry, chaining a new bucket if full */
+    for (j = 0; j < BUCKET_ENTRIES && curr->tags[j] != EMPTY; j++)
+        ;
+    if (j == BUCKET_ENTRIES)
+    {
+        curr->overflow = SymTable_newBuckets(1);
+        if (curr->overflow == NULL)
+            return 0;
+        curr = curr->overflow;
+        j = 0;
+    }
+
+    curr->tags[j] = SymTable_tag(uHash);
+    curr->keys[j] = pcKey;
+    curr->values[j] = pvValue;
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Find the binding of oSymTable whose key is pcKey and whose hash
+code is uHash. Return the bucket holding it and store its entry index
+in *puEntry, or return NULL if no such binding exists */
+
+static struct Bucket *SymTable_find(SymTable_T oSymTable,
+                                    const char *pcKey, size_t uHash,
+                                    size_t *puEntry)
+{
+    struct Bucket *curr;
+    uint16_t uTag = SymTable_tag(uHash);
+    size_t j;
+
+    curr = &oSymTable->buckets[uHash & (oSymTable->bucketCount - 1)];
+    do
+    {
+        /* Compare the tags, reading a key only when its tag matches.
+        An empty entry ends the chain, since entries are packed */
+        for (j = 0; j < BUCKET_ENTRIES; j++)
+        {
+            if (curr->tags[j] == EMPTY)
+                return NULL;
+            if (curr->tags[j] == uTag &&
+                strcmp(curr->keys[j], pcKey) == 0)
+            {
+                *puEntry = j;
+                return curr;
+            }
+        }
+        curr = curr->overflow;
+    } while (curr != NULL);
+
+    return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Double the bucket array of oSymTable and reinsert every binding.
+Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+available, in which case oSymTable is left unchanged */
+
+static int SymTable_tryExpand(SymTable_T oSymTable)
+{
+    struct Bucket *newBuckets;
+    struct Bucket *curr;
+    size_t newBucketCount;
+    size_t u, j;
+
+    newBucketCount = oSymTable->bucketCount * 2;
+
+    /* Handle case where bucket array size would overflow */
+    if (newBucketCount > (size_t)-1 / sizeof(struct Bucket))
+        return 0;
+
+    newBuckets = SymTable_newBuckets(newBucketCount);
+    if (newBuckets == NULL)
+        return 0;
+
+    /* Reinsert all existing bindings into new bucket array. The hash
+    codes are not kept, so each key is hashed again. If an overflow
+    bucket cannot be allocated, discard the new array; the keys still
+    belong to the old one */
+    for (u = 0; u < oSymTable->bucketCount; u++)
+    {
+        for (curr = &oSymTable->buckets[u]; curr != NULL;
+             curr = curr->overflow)
+        {
+            for (j = 0; j < BUCKET_ENTRIES &&
+                        curr->tags[j] != EMPTY; j++)
+            {
+                if (!SymTable_insert(newBuckets, newBucketCount,
+                                     curr->keys[j],
+                                     SymTable_hash(curr->keys[j]),
+                                     curr->values[j]))
+                {
+                    SymTable_freeOverflow(newBuckets, newBucketCount);
+                    free(newBuckets);
+                    return 0;
+                }
+            }
+        }
+    }
+
+    /* Swaps in the new bucket array and records new size */
+    SymTable_freeOverflow(oSymTable->buckets, oSymTable->bucketCount);
+    free(oSymTable->buckets);
+    oSymTable->buckets = newBuckets;
+    oSymTable->bucketCount = newBucketCount;
+
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+    SymTable_T oSymTable;
+
+    assert(sizeof(struct Bucket) == CACHE_LINE);
+
+    /* Allocate memory for a new symbol table */
+    oSymTable = malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+        return NULL;
+
+    /* Initialize fields for new symbol table */
+    oSymTable->bucketCount = INITIAL_BUCKET_COUNT;
+    oSymTable->bindingsCount = 0;
+    oSymTable->buckets = SymTable_newBuckets(INITIAL_BUCKET_COUNT);
+
+    /* Handle case where allocation of memory for bucket array fails */
+    if (oSymTable->buckets == NULL)
+    {
+        free(oSymTable);
+        return NULL;
+    }
+
+    return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    struct Bucket *curr;
+    size_t u, j;
+
+    assert(oSymTable != NULL);
+
+    /* Free the key copy of every binding */
+    for (u = 0; u < oSymTable->bucketCount; u++)
+    {
+        for (curr = &oSymTable->buckets[u]; curr != NULL;
+             curr = curr->overflow)
+        {
+            for (j = 0; j < BUCKET_ENTRIES &&
+                        curr->tags[j] != EMPTY; j++)
+                free((void *)curr->keys[j]);
+        }
+    }
+
+    SymTable_freeOverflow(oSymTable->buckets, oSymTable->bucketCount);
+    free(oSymTable->buckets);
+    free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    return oSymTable->bindingsCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable,
+                 const char *pcKey, const void *pvValue)
+{
+    size_t uHash, uEntry;
+    char *keyCopy;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* Handle condition where binding with pcKey already exists */
+    uHash = SymTable_hash(pcKey);
+    if (SymTable_find(oSymTable, pcKey, uHash, &uEntry) != NULL)
+        return 0;
+
+    /* Attempt to expand hash table if adding one more binding warrants
+    an expansion */
+    if (oSymTable->bindingsCount + 1 >
+        oSymTable->bucketCount * MAX_LOAD)
+        (void)SymTable_tryExpand(oSymTable);
+
+    /* Copy the key string defensively */
+    keyCopy = malloc(strlen(pcKey) + 1);
+    if (keyCopy == NULL)
+        return 0;
+    strcpy(keyCopy, pcKey);
+
+    /* Handle condition of insufficient memory for overflow bucket */
+    if (!SymTable_insert(oSymTable->buckets, oSymTable->bucketCount,
+                         keyCopy, uHash, pvValue))
+    {
+        free(keyCopy);
+        return 0;
+    }
+
+    oSymTable->bindingsCount++;
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable,
+                       const char *pcKey, const void *pvValue)
+{
+    struct Bucket *curr;
+    void *oldValue;
+    size_t uEntry;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* Handle condition where no binding with pcKey exists */
+    curr = SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey),
+                         &uEntry);
+    if (curr == NULL)
+        return NULL;
+
+    oldValue = (void *)curr->values[uEntry];
+    curr->values[uEntry] = pvValue;
+    return oldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t uEntry;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey),
+                         &uEntry) != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    struct Bucket *curr;
+    size_t uEntry;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    curr = SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey),
+                         &uEntry);
+    if (curr == NULL)
+        return NULL;
+    return (void *)curr->values[uEntry];
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    struct Bucket *curr, *last, *beforeLast;
+    size_t uHash, uEntry, k;
+    void *bindingValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* Handle condition where no binding with pcKey exists */
+    uHash = SymTable_hash(pcKey);
+    curr = SymTable_find(oSymTable, pcKey, uHash, &uEntry);
+    if (curr == NULL)
+        return NULL;
+
+    bindingValue = (void *)curr->values[uEntry];
+    free((void *)curr->keys[uEntry]);
+
+    /* Find the last bucket of the chain and its last binding */
+    beforeLast = NULL;
+    last = &oSymTable->buckets[uHash & (oSymTable->bucketCount - 1)];
+    while (last->overflow != NULL)
+    {
+        beforeLast = last;
+        last = last->overflow;
+    }
+    for (k = BUCKET_ENTRIES - 1; last->tags[k] == EMPTY; k--)
+        ;
+
+    /* Move that binding into the hole, keeping the chain packed */
+    curr->tags[uEntry] = last->tags[k];
+    curr->keys[uEntry] = last->keys[k];
+    curr->values[uEntry] = last->values[k];
+    last->tags[k] = EMPTY;
+
+    /* Free the last bucket if it is an overflow bucket left empty */
+    if (k == 0 && beforeLast != NULL)
+    {
+        beforeLast->overflow = NULL;
+        free(last);
+    }
+
+    oSymTable->bindingsCount--;
+    return bindingValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue,
+                                  void *pvExtra),
+                  const void *pvExtra)
+{
+    struct Bucket *curr;
+    size_t u, j;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /* Iterate over every binding of every chain */
+    for (u = 0; u < oSymTable->bucketCount; u++)
+    {
+        for (curr = &oSymTable->buckets[u]; curr != NULL;
+             curr = curr->overflow)
+        {
+            for (j = 0; j < BUCKET_ENTRIES &&
+                        curr->tags[j] != EMPTY; j++)
+                (*pfApply)(curr->keys[j], (void *)curr->values[j],
+                           (void *)pvExtra);
+        }
+    }
+}
@@ -0,0 +1,340 @@
+/*--------------------------------------------------------------------*/
+/* symtableclient.c                                                   */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+/* Client of symtableserver. Requests are encoded into an output
+buffer and responses are read into an input buffer. The socket does
+not block: while sending, the client also reads any responses that
+have arrived, so that a server that stops reading until its responses
+are read can never deadlock with a client that is still sending */
+
+#define _XOPEN_SOURCE 700
+
+#include "symtableclient.h"
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* Least number of free bytes in the input buffer for each read */
+enum {READ_BYTES = 64 * 1024};
+
+/* SymTableClient structure represents a connection and its buffers */
+struct SymTableClient
+{
+    /* Socket connected to the server */
+    int fd;
+    /* 1 (TRUE) once the connection has failed */
+    int failed;
+    /* Encoded requests not yet sent */
+    unsigned char *out;
+    /* Number of bytes in out, and number of them already sent */
+    size_t outUsed;
+    size_t outSent;
+    /* Number of bytes allocated for out */
+    size_t outCapacity;
+    /* Responses received but not yet returned */
+    unsigned char *in;
+    /* Offset of the first byte in in not yet returned */
+    size_t inStart;
+    /* Number of bytes in in */
+    size_t inUsed;
+    /* Number of bytes allocated for in */
+    size_t inCapacity;
+    /* Number of bytes in in of the response last returned */
+    size_t lastLength;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Make room for at least uBytes more bytes in the buffer *ppucBuffer
+holding uUsed of its *puCapacity bytes. Return 1 (TRUE) if successful,
+or 0 (FALSE) if insufficient memory is available */
+
+static int SymTableClient_reserve(unsigned char **ppucBuffer,
+                                  size_t *puCapacity, size_t uUsed,
+                                  size_t uBytes)
+{
+    unsigned char *pucNew;
+    size_t uCapacity;
+
+    if (*puCapacity - uUsed >= uBytes)
+        return 1;
+
+    uCapacity = *puCapacity > 0 ? *puCapacity : READ_BYTES;
+    while (uCapacity - uUsed < uBytes)
+        uCapacity *= 2;
+    pucNew = realloc(*ppucBuffer, uCapacity);
+    if (pucNew == NULL)
+        return 0;
+    *ppucBuffer = pucNew;
+    *puCapacity = uCapacity;
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read whatever responses have arrived for oClient into its input
+buffer. Return 1 (TRUE) if successful, including when nothing has
+arrived, or 0 (FALSE) if the connection has failed */
+
+static int SymTableClient_fill(SymTableClient_T oClient)
+{
+    ssize_t iRead;
+
+    /* Discard the bytes already returned before growing the buffer */
+    if (oClient->inStart > 0 &&
+        oClient->inCapacity - oClient->inUsed < READ_BYTES)
+    {
+        memmove(oClient->in, oClient->in + oClient->inStart,
+                oClient->inUsed - oClient->inStart);
+        oClient->inUsed -= oClient->inStart;
+        oClient->inStart = 0;
+    }
+    if (!SymTableClient_reserve(&oClient->in, &oClient->inCapacity,
+                                oClient->inUsed, READ_BYTES))
+        return 0;
+
+    iRead = read(oClient->fd, oClient->in + oClient->inUsed,
+                 oClient->inCapacity - oClient->inUsed);
+    if (iRead > 0)
+        oClient->inUsed += (size_t)iRead;
+    else if (iRead == 0 ||
+             (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+        return 0;
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Wait until the socket of oClient is readable, or also writable if
+iWrite is 1 (TRUE). Return the events that occurred, or 0 if waiting
+failed */
+
+static short SymTableClient_wait(SymTableClient_T oClient, int iWrite)
+{
+    struct pollfd sPoll;
+
+    sPoll.fd = oClient->fd;
+    sPoll.events = (short)(POLLIN | (iWrite ? POLLOUT : 0));
+    sPoll.revents = 0;
+    while (poll(&sPoll, 1, -1) < 0)
+        if (errno != EINTR)
+            return 0;
+    return sPoll.revents;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Queue a request of kind iOperation for key pcKey with the uLength
+bytes at pvValue. Return 1 (TRUE) if successful, or 0 (FALSE)
+otherwise */
+
+static int SymTableClient_send(SymTableClient_T oClient, int iOperation,
+                               const char *pcKey, const void *pvValue,
+                               size_t uLength)
+{
+    unsigned char *pucHeader;
+    uint32_t uKeyLength32, uLength32;
+    size_t uKeyLength;
+
+    assert(oClient != NULL);
+    assert(pcKey != NULL);
+
+    uKeyLength = strlen(pcKey);
+    if (oClient->failed || uKeyLength > SYMTABLEPROTO_MAX_KEY ||
+        uLength > SYMTABLEPROTO_MAX_VALUE)
+        return 0;
+
+    /* Send what is already queued once a batch is large */
+    if (oClient->outUsed - oClient->outSent >= READ_BYTES &&
+        !SymTableClient_flush(oClient))
+        return 0;
+
+    /* Discard the bytes already sent before growing the buffer */
+    if (oClient->outSent == oClient->outUsed)
+        oClient->outSent = oClient->outUsed = 0;
+    if (!SymTableClient_reserve(&oClient->out, &oClient->outCapacity,
+                                oClient->outUsed,
+                                SYMTABLEPROTO_REQUEST_HEADER +
+                                    uKeyLength + uLength))
+        return 0;
+
+    /* Encode the header, the key and the value */
+    uKeyLength32 = (uint32_t)uKeyLength;
+    uLength32 = (uint32_t)uLength;
+    pucHeader = oClient->out + oClient->outUsed;
+    pucHeader[0] = (unsigned char)iOperation;
+    memcpy(pucHeader + 1, &uKeyLength32, sizeof(uint32_t));
+    memcpy(pucHeader + 5, &uLength32, sizeof(uint32_t));
+    memcpy(pucHeader + SYMTABLEPROTO_REQUEST_HEADER, pcKey, uKeyLength);
+    if (uLength > 0)
+        memcpy(pucHeader + SYMTABLEPROTO_REQUEST_HEADER + uKeyLength,
+               pvValue, uLength);
+    oClient->outUsed += SYMTABLEPROTO_REQUEST_HEADER + uKeyLength +
+                        uLength;
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTableClient_T SymTableClient_connect(const char *pcPath)
+{
+    SymTableClient_T oClient;
+    struct sockaddr_un sAddress;
+
+    assert(pcPath != NULL);
+
+    if (strlen(pcPath) >= sizeof(sAddress.sun_path))
+        return NULL;
+
+    oClient = calloc(1, sizeof(struct SymTableClient));
+    if (oClient == NULL)
+        return NULL;
+
+    memset(&sAddress, 0, sizeof(sAddress));
+    sAddress.sun_family = AF_UNIX;
+    strcpy(sAddress.sun_path, pcPath);
+
+    oClient->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (oClient->fd < 0)
+    {
+        free(oClient);
+        return NULL;
+    }
+    if (connect(oClient->fd, (struct sockaddr *)&sAddress,
+                sizeof(sAddress)) != 0 ||
+        fcntl(oClient->fd, F_SETFL, O_NONBLOCK) != 0)
+    {
+        SymTableClient_free(oClient);
+        return NULL;
+    }
+
+    return oClient;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTableClient_free(SymTableClient_T oClient)
+{
+    assert(oClient != NULL);
+
+    (void)close(oClient->fd);
+    free(oClient->out);
+    free(oClient->in);
+    free(oClient);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableClient_sendGet(SymTableClient_T oClient, const char *pcKey)
+{
+    return SymTableClient_send(oClient, SYMTABLEPROTO_GET, pcKey, NULL, 0);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableClient_sendPut(SymTableClient_T oClient, const char *pcKey,
+                           const void *pvValue, size_t uLength)
+{
+    assert(pvValue != NULL || uLength == 0);
+
+    return SymTableClient_send(oClient, SYMTABLEPROTO_PUT, pcKey, pvValue,
+                               uLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableClient_sendRemove(SymTableClient_T oClient,
+                              const char *pcKey)
+{
+    return SymTableClient_send(oClient, SYMTABLEPROTO_REMOVE, pcKey, NULL,
+                               0);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableClient_flush(SymTableClient_T oClient)
+{
+    ssize_t iSent;
+    short iEvents;
+
+    assert(oClient != NULL);
+
+    while (!oClient->failed && oClient->outSent < oClient->outUsed)
+    {
+        iEvents = SymTableClient_wait(oClient, 1);
+
+        /* Take in responses so that the server can keep reading */
+        if ((iEvents & (POLLIN | POLLHUP | POLLERR)) != 0 &&
+            !SymTableClient_fill(oClient))
+            oClient->failed = 1;
+        else if ((iEvents & POLLOUT) != 0)
+        {
+            iSent = send(oClient->fd, oClient->out + oClient->outSent,
+                         oClient->outUsed - oClient->outSent,
+                         MSG_NOSIGNAL);
+            if (iSent > 0)
+                oClient->outSent += (size_t)iSent;
+            else if (errno != EAGAIN && errno != EWOULDBLOCK &&
+                     errno != EINTR)
+                oClient->failed = 1;
+        }
+        else if (iEvents == 0)
+            oClient->failed = 1;
+    }
+
+    return !oClient->failed;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableClient_receive(SymTableClient_T oClient,
+                           const void **ppvValue, size_t *puLength)
+{
+    unsigned char *pucHeader;
+    uint32_t uLength32;
+
+    assert(oClient != NULL);
+    assert(ppvValue != NULL);
+    assert(puLength != NULL);
+
+    /* Release the response last returned */
+    oClient->inStart += oClient->lastLength;
+    oClient->lastLength = 0;
+
+    if (!SymTableClient_flush(oClient))
+        return -1;
+
+    /* Wait until the whole next response has arrived */
+    for (;;)
+    {
+        if (oClient->inUsed - oClient->inStart >=
+            SYMTABLEPROTO_RESPONSE_HEADER)
+        {
+            pucHeader = oClient->in + oClient->inStart;
+            memcpy(&uLength32, pucHeader + 1, sizeof(uint32_t));
+            if (oClient->inUsed - oClient->inStart >=
+                SYMTABLEPROTO_RESPONSE_HEADER + (size_t)uLength32)
+                break;
+        }
+        if (SymTableClient_wait(oClient, 0) == 0 ||
+            !SymTableClient_fill(oClient))
+        {
+            oClient->failed = 1;
+            return -1;
+        }
+    }
+
+    oClient->lastLength = SYMTABLEPROTO_RESPONSE_HEADER + uLength32;
+    *ppvValue = pucHeader + SYMTABLEPROTO_RESPONSE_HEADER;
+    *puLength = uLength32;
+    return pucHeader[0];
+}
@@ -0,0 +1,75 @@
+/*--------------------------------------------------------------------*/
+/* symtableclient.h                                                   */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+# ifndef SYMTABLECLIENT
+# define SYMTABLECLIENT
+
+#include "symtableproto.h"
+#include <stddef.h>
+
+/*
+A SymTableClient_T is a pointer to a connection to a symtableserver.
+Requests are buffered by the SymTableClient_send functions and sent
+together, either when SymTableClient_flush is called or when a
+response is received, so a caller may pipeline any number of requests
+before receiving their responses in order. A client is used by one
+thread at a time.
+*/
+typedef struct SymTableClient *SymTableClient_T;
+
+/*--------------------------------------------------------------------*/
+/* Return a new SymTableClient object connected to the server
+listening on the Unix domain socket named pcPath, or NULL if
+insufficient memory is available or the connection fails */
+
+SymTableClient_T SymTableClient_connect(const char *pcPath);
+
+/*--------------------------------------------------------------------*/
+/* Close the connection of oClient and free all memory occupied by
+it. Responses not yet received are lost */
+
+void SymTableClient_free(SymTableClient_T oClient);
+
+/*--------------------------------------------------------------------*/
+/* Queue a request for the value of key pcKey. Return 1 (TRUE) if
+successful, or 0 (FALSE) if insufficient memory is available, the key
+is too long, or the connection has failed */
+
+int SymTableClient_sendGet(SymTableClient_T oClient, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* Queue a request to bind key pcKey to the uLength bytes at pvValue.
+Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+available, the key or value is too long, or the connection has
+failed */
+
+int SymTableClient_sendPut(SymTableClient_T oClient, const char *pcKey,
+                           const void *pvValue, size_t uLength);
+
+/*--------------------------------------------------------------------*/
+/* Queue a request to remove the binding of key pcKey. Return 1 (TRUE)
+if successful, or 0 (FALSE) if insufficient memory is available, the
+key is too long, or the connection has failed */
+
+int SymTableClient_sendRemove(SymTableClient_T oClient,
+                              const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* Send every queued request of oClient to the server. Return 1 (TRUE)
+if successful, or 0 (FALSE) if the connection has failed */
+
+int SymTableClient_flush(SymTableClient_T oClient);
+
+/*--------------------------------------------------------------------*/
+/* Send every queued request of oClient, then wait for the response to
+the earliest request whose response has not been received. Return its
+status, a SYMTABLEPROTO status, and store the address and length of
+its value in *ppvValue and *puLength; the value remains valid until
+the next call on oClient. Return -1 if the connection has failed */
+
+int SymTableClient_receive(SymTableClient_T oClient,
+                           const void **ppvValue, size_t *puLength);
+
+# endif
@@ -0,0 +1,93 @@
+/*--------------------------------------------------------------------*/
+/* symtablecodec.c                                                    */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+/* Codecs that convert symbol table values to and from bytes */
+
+#include "symtablecodec.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+/* Write the bits of pointer pvValue to pvBuf if uBufSize bytes are
+enough, and return the size of a pointer */
+
+static size_t SymTable_encodePointer(const void *pvValue, void *pvBuf,
+                                     size_t uBufSize)
+{
+    if (uBufSize >= sizeof(pvValue))
+        memcpy(pvBuf, &pvValue, sizeof(pvValue));
+    return sizeof(pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the pointer whose bits are the uLength bytes at pvBuf */
+
+static void *SymTable_decodePointer(const void *pvBuf, size_t uLength)
+{
+    void *pvValue;
+
+    assert(pvBuf != NULL);
+    assert(uLength == sizeof(pvValue));
+
+    memcpy(&pvValue, pvBuf, sizeof(pvValue));
+    return pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write string pvValue, including its terminating null character, to
+pvBuf if uBufSize bytes are enough, and return its length plus one.
+A NULL pvValue is encoded as zero bytes */
+
+static size_t SymTable_encodeString(const void *pvValue, void *pvBuf,
+                                    size_t uBufSize)
+{
+    size_t uLength;
+
+    if (pvValue == NULL)
+        return 0;
+
+    uLength = strlen((const char *)pvValue) + 1;
+    if (uBufSize >= uLength)
+        memcpy(pvBuf, pvValue, uLength);
+    return uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a newly allocated copy of the string encoded in the uLength
+bytes at pvBuf, or NULL if uLength is 0 or insufficient memory is
+available */
+
+static void *SymTable_decodeString(const void *pvBuf, size_t uLength)
+{
+    char *pcValue;
+
+    if (uLength == 0)
+        return NULL;
+
+    pcValue = malloc(uLength);
+    if (pcValue == NULL)
+        return NULL;
+
+    memcpy(pcValue, pvBuf, uLength);
+    pcValue[uLength - 1] = '\0';
+    return pcValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+const struct SymTable_Codec SymTable_pointerCodec =
+{
+    SymTable_encodePointer, SymTable_decodePointer, NULL
+};
+
+const struct SymTable_Codec SymTable_stringCodec =
+{
+    SymTable_encodeString, SymTable_decodeString, free
+};
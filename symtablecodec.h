@@ -0,0 +1,49 @@
+/*--------------------------------------------------------------------*/
+/* symtablecodec.h                                                    */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+# ifndef SYMTABLECODEC
+# define SYMTABLECODEC
+
+#include <stddef.h>
+
+/*
+A SymTable_Codec converts the void* values of a symbol table to and
+from bytes, for symbol tables that keep their values outside the
+memory of the process, such as in a file.
+*/
+struct SymTable_Codec
+{
+    /* Write the encoding of pvValue to pvBuf, which has room for
+    uBufSize bytes, and return the length of the encoding. If the
+    encoding is longer than uBufSize bytes, write nothing and return
+    its length */
+    size_t (*pfEncode)(const void *pvValue, void *pvBuf,
+                       size_t uBufSize);
+
+    /* Return the value whose encoding is the uLength bytes at pvBuf.
+    *pfDecode may return NULL only for a value that was NULL when
+    encoded, or if insufficient memory is available */
+    void *(*pfDecode)(const void *pvBuf, size_t uLength);
+
+    /* Free a value returned by *pfDecode, or NULL if decoded values
+    own no memory */
+    void (*pfFree)(void *pvValue);
+};
+
+/*--------------------------------------------------------------------*/
+/* Codec that stores the void* value itself. Decoding returns the very
+pointer that was encoded, so values keep their identity, but the
+encoding is only meaningful within the process that wrote it */
+
+extern const struct SymTable_Codec SymTable_pointerCodec;
+
+/*--------------------------------------------------------------------*/
+/* Codec for values that are NULL or point to strings. Decoding
+returns a newly allocated copy of the string, which the caller owns
+and frees with free */
+
+extern const struct SymTable_Codec SymTable_stringCodec;
+
+# endif
@@ -0,0 +1,474 @@
+/*--------------------------------------------------------------------*/
+/* symtablecompact.c                                                  */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+/* Compact-dictionary implementation of symbol table that maps string
+keys to void* values. Each key is stored with defensive copy to
+ensure ownership by symbol table. Bindings live in a dense array of
+entries in the order they were added, and a separate sparse index of
+small integers maps hash codes to entry positions by open addressing.
+Each index element is 1, 2, 4 or 8 bytes wide, the smallest width
+that can name every entry, so a binding costs one entry plus a few
+bytes of index instead of a separately allocated node. Removal leaves
+a hole in the entry array and a tombstone in the index; both are
+dropped the next time the arrays are rebuilt. SymTable_map scans the
+entry array from start to end, so it visits bindings in the order
+they were added */
+
+#include "symtable.h"
+#include "symtablehashcode.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Initial number of index elements. Must be a power of two so that
+a hash code can be reduced to an index position with a mask */
+static const size_t INITIAL_INDEX_SIZE = 8;
+
+/* Index element that names no entry, and index element of a removed
+entry */
+enum {INDEX_EMPTY = -1, INDEX_REMOVED = -2};
+
+/* Number of bits of the hash code mixed into each later probe */
+static const unsigned PERTURB_SHIFT = 5;
+
+/* Each Entry holds one key-value pair, or is a hole left by a
+removal */
+struct Entry
+{
+    /* Full hash code of key */
+    size_t hash;
+    /* Pointer to the key string (defensive copy), or NULL if the
+    binding was removed */
+    const char *key;
+    /* Pointer to the associated value */
+    const void *value;
+};
+
+/* SymTable structure represents overall hash table */
+struct SymTable
+{
+    /* Array of entries in the order their bindings were added */
+    struct Entry *entries;
+    /* Number of entries used, including holes */
+    size_t entriesUsed;
+    /* Number of entries allocated, two thirds of indexSize */
+    size_t entriesCapacity;
+    /* Array of indexSize elements, each indexWidth bytes wide */
+    void *index;
+    /* Number of index elements (a power of two) */
+    size_t indexSize;
+    /* Number of bytes of each index element */
+    size_t indexWidth;
+    /* Stores total number of bindings in SymTable */
+    size_t bindingsCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the full hash code for pcKey */
+
+static size_t SymTable_hash(const char *pcKey)
+{
+    return (size_t)SymTableHashCode_full(pcKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bytes of each element of an index of
+uIndexSize elements: the fewest that can hold every entry position as
+well as INDEX_EMPTY and INDEX_REMOVED */
+
+static size_t SymTable_indexWidth(size_t uIndexSize)
+{
+    if (uIndexSize <= (size_t)INT8_MAX + 1)
+        return 1;
+    if (uIndexSize <= (size_t)INT16_MAX + 1)
+        return 2;
+    if (uIndexSize <= (size_t)INT32_MAX + 1)
+        return 4;
+    return 8;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return element i of the index pvIndex whose elements are uWidth
+bytes wide */
+
+static long long SymTable_getIndex(const void *pvIndex, size_t uWidth,
+                                   size_t i)
+{
+    switch (uWidth)
+    {
+        case 1:
+            return ((const int8_t *)pvIndex)[i];
+        case 2:
+            return ((const int16_t *)pvIndex)[i];
+        case 4:
+            return ((const int32_t *)pvIndex)[i];
+        default:
+            return ((const int64_t *)pvIndex)[i];
+    }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Set element i of the index pvIndex whose elements are uWidth bytes
+wide to iValue */
+
+static void SymTable_setIndex(void *pvIndex, size_t uWidth, size_t i,
+                              long long iValue)
+{
+    switch (uWidth)
+    {
+        case 1:
+            ((int8_t *)pvIndex)[i] = (int8_t)iValue;
+            break;
+        case 2:
+            ((int16_t *)pvIndex)[i] = (int16_t)iValue;
+            break;
+        case 4:
+            ((int32_t *)pvIndex)[i] = (int32_t)iValue;
+            break;
+        default:
+            ((int64_t *)pvIndex)[i] = (int64_t)iValue;
+            break;
+    }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the position in the index of oSymTable of the element that
+names the entry of key pcKey whose hash code is uHash, or
+oSymTable->indexSize if no such element exists. Each probe mixes
+further bits of the hash code into the position, so keys whose low
+bits collide soon go separate ways */
+
+static size_t SymTable_findIndex(SymTable_T oSymTable,
+                                 const char *pcKey, size_t uHash)
+{
+    size_t mask = oSymTable->indexSize - 1;
+    size_t perturb = uHash;
+    size_t i = uHash & mask;
+    struct Entry *curr;
+    long long ix;
+
+    for (;;)
+    {
+        ix = SymTable_getIndex(oSymTable->index, oSymTable->indexWidth, i);
+
+        /* Handle condition where pcKey cannot be further along */
+        if (ix == INDEX_EMPTY)
+            return oSymTable->indexSize;
+
+        /* Handle condition where binding with pcKey exists */
+        if (ix >= 0)
+        {
+            curr = &oSymTable->entries[ix];
+            if (curr->hash == uHash && strcmp(curr->key, pcKey) == 0)
+                return i;
+        }
+
+        /* Otherwise, move on to the next position */
+        perturb >>= PERTURB_SHIFT;
+        i = (i * 5 + perturb + 1) & mask;
+    }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Set the first element of the index pvIndex of uIndexSize elements
+of uWidth bytes that is reached by hash code uHash and does not name
+an entry to iEntry */
+
+static void SymTable_placeIndex(void *pvIndex, size_t uIndexSize,
+                                size_t uWidth, size_t uHash,
+                                long long iEntry)
+{
+    size_t mask = uIndexSize - 1;
+    size_t perturb = uHash;
+    size_t i = uHash & mask;
+
+    while (SymTable_getIndex(pvIndex, uWidth, i) >= 0)
+    {
+        perturb >>= PERTURB_SHIFT;
+        i = (i * 5 + perturb + 1) & mask;
+    }
+    SymTable_setIndex(pvIndex, uWidth, i, iEntry);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Rebuild the arrays of oSymTable with room for at least twice as
+many bindings as it holds, dropping the holes left by removals.
+Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+available, in which case oSymTable is unchanged */
+
+static int SymTable_rebuild(SymTable_T oSymTable)
+{
+    struct Entry *newEntries;
+    void *newIndex;
+    size_t newIndexSize, newWidth, newCapacity;
+    size_t i, used = 0;
+
+    /* Grow the index until two thirds of it hold twice the bindings */
+    newIndexSize = INITIAL_INDEX_SIZE;
+    while (newIndexSize * 2 / 3 < oSymTable->bindingsCount * 2 + 1)
+        newIndexSize *= 2;
+    newWidth = SymTable_indexWidth(newIndexSize);
+    newCapacity = newIndexSize * 2 / 3;
+
+    newEntries = malloc(newCapacity * sizeof(struct Entry));
+    newIndex = malloc(newIndexSize * newWidth);
+    if (newEntries == NULL || newIndex == NULL)
+    {
+        free(newEntries);
+        free(newIndex);
+        return 0;
+    }
+
+    /* Every byte of an empty element is 0xFF, which is INDEX_EMPTY at
+    any width */
+    memset(newIndex, 0xFF, newIndexSize * newWidth);
+
+    /* Copy the bindings in order, skipping holes, and index them */
+    for (i = 0; i < oSymTable->entriesUsed; i++)
+    {
+        if (oSymTable->entries[i].key == NULL)
+            continue;
+        newEntries[used] = oSymTable->entries[i];
+        SymTable_placeIndex(newIndex, newIndexSize, newWidth,
+                            newEntries[used].hash, (long long)used);
+        used++;
+    }
+
+    /* Swap in the new arrays */
+    free(oSymTable->entries);
+    free(oSymTable->index);
+    oSymTable->entries = newEntries;
+    oSymTable->entriesUsed = used;
+    oSymTable->entriesCapacity = newCapacity;
+    oSymTable->index = newIndex;
+    oSymTable->indexSize = newIndexSize;
+    oSymTable->indexWidth = newWidth;
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+    SymTable_T oSymTable;
+
+    /* Allocate memory for a new symbol table */
+    oSymTable = malloc(sizeof(struct SymTable));
+
+    /* Handle case if allocation of memory to symTable pointer fails */
+    if (oSymTable == NULL)
+        return NULL;
+
+    /* Initialize fields for new symbol table */
+    oSymTable->entries = NULL;
+    oSymTable->entriesUsed = 0;
+    oSymTable->entriesCapacity = 0;
+    oSymTable->index = NULL;
+    oSymTable->indexSize = 0;
+    oSymTable->indexWidth = 0;
+    oSymTable->bindingsCount = 0;
+
+    /* Handle case where allocation of the initial arrays fails */
+    if (!SymTable_rebuild(oSymTable))
+    {
+        free(oSymTable);
+        return NULL;
+    }
+
+    return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    /* Free the key copy of every binding */
+    for (i = 0; i < oSymTable->entriesUsed; i++)
+        free((void *)oSymTable->entries[i].key);
+
+    free(oSymTable->entries);
+    free(oSymTable->index);
+    free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    return oSymTable->bindingsCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable,
+                 const char *pcKey, const void *pvValue)
+{
+    struct Entry *newEntry;
+    size_t uHash;
+    char *keyCopy;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* Handle condition where binding with pcKey already exists */
+    uHash = SymTable_hash(pcKey);
+    if (SymTable_findIndex(oSymTable, pcKey, uHash) !=
+        oSymTable->indexSize)
+        return 0;
+
+    /* Rebuild if the entry array is full */
+    if (oSymTable->entriesUsed == oSymTable->entriesCapacity &&
+        !SymTable_rebuild(oSymTable))
+        return 0;
+
+    /* Copy the key string defensively */
+    keyCopy = malloc(strlen(pcKey) + 1);
+    if (keyCopy == NULL)
+        return 0;
+    strcpy(keyCopy, pcKey);
+
+    /* Append the entry and index it */
+    newEntry = &oSymTable->entries[oSymTable->entriesUsed];
+    newEntry->hash = uHash;
+    newEntry->key = keyCopy;
+    newEntry->value = pvValue;
+    SymTable_placeIndex(oSymTable->index, oSymTable->indexSize,
+                        oSymTable->indexWidth, uHash,
+                        (long long)oSymTable->entriesUsed);
+    oSymTable->entriesUsed++;
+    oSymTable->bindingsCount++;
+
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the entry of oSymTable whose key is pcKey, or NULL if no
+such entry exists */
+
+static struct Entry *SymTable_findEntry(SymTable_T oSymTable,
+                                        const char *pcKey)
+{
+    size_t i;
+
+    i = SymTable_findIndex(oSymTable, pcKey, SymTable_hash(pcKey));
+    if (i == oSymTable->indexSize)
+        return NULL;
+    return &oSymTable->entries[SymTable_getIndex(oSymTable->index,
+                                                 oSymTable->indexWidth,
+                                                 i)];
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable,
+                       const char *pcKey, const void *pvValue)
+{
+    struct Entry *curr;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* Handle condition where no binding with pcKey exists */
+    curr = SymTable_findEntry(oSymTable, pcKey);
+    if (curr == NULL)
+        return NULL;
+
+    oldValue = (void *)curr->value;
+    curr->value = pvValue;
+    return oldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_findEntry(oSymTable, pcKey) != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    struct Entry *curr;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    curr = SymTable_findEntry(oSymTable, pcKey);
+    if (curr == NULL)
+        return NULL;
+    return (void *)curr->value;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    struct Entry *curr;
+    void *bindingValue;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* Handle condition where no binding with pcKey exists */
+    i = SymTable_findIndex(oSymTable, pcKey, SymTable_hash(pcKey));
+    if (i == oSymTable->indexSize)
+        return NULL;
+
+    /* Leave a tombstone in the index, so that probes continue past
+    it, and a hole in the entry array */
+    curr = &oSymTable->entries[SymTable_getIndex(oSymTable->index,
+                                                 oSymTable->indexWidth,
+                                                 i)];
+    SymTable_setIndex(oSymTable->index, oSymTable->indexWidth, i,
+                      INDEX_REMOVED);
+    bindingValue = (void *)curr->value;
+    free((void *)curr->key);
+    curr->key = NULL;
+    oSymTable->bindingsCount--;
+
+    return bindingValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue,
+                                  void *pvExtra),
+                  const void *pvExtra)
+{
+    struct Entry *curr;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /* Visit the bindings in the order they were added */
+    for (i = 0; i < oSymTable->entriesUsed; i++)
+    {
+        curr = &oSymTable->entries[i];
+        if (curr->key != NULL)
+            (*pfApply)(curr->key, (void *)curr->value, (void *)pvExtra);
+    }
+}
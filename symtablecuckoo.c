@@ -0,0 +1,662 @@
+/*--------------------------------------------------------------------*/
+/* symtablecuckoo.c                                                   */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+/* Bucketized cuckoo hash implementation of symbol table that maps
+string keys to void* values. Each key is stored with defensive copy to
+ensure ownership by symbol table. Every key may live in exactly one of
+two candidate buckets, so a lookup reads at most two buckets no matter
+how full the table is. Each bucket holds several slots laid out to
+fill one 64-byte cache line on 64-bit hosts: a short hash tag and a
+key pointer per slot. Values sit in a separate array and are read only
+once a key matches. An insertion that finds both buckets full evicts a
+binding to its other bucket, repeating until a free slot turns up; if
+that chain grows too long the bucket array is doubled */
+
+#include "symtable.h"
+#include "symtablehashcode.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Number of slots in each bucket. With 2-byte tags and 8-byte key
+pointers, six slots fill exactly one 64-byte cache line */
+enum {SLOTS_PER_BUCKET = 6};
+
+/* Size of a cache line, to which the bucket array is aligned */
+enum {CACHE_LINE_SIZE = 64};
+
+/* Initial number of buckets. Must be a power of two so that the
+alternate bucket can be found by XOR with a mask */
+static const size_t INITIAL_BUCKET_COUNT = 128;
+
+/* Maximum number of evictions tried by one insertion before the
+bucket array is considered full */
+static const size_t MAX_KICKS = 500;
+
+/* Maximum number of doublings tried by one expansion when bindings
+still fail to fit in the larger bucket array */
+static const size_t MAX_EXPAND_TRIES = 4;
+
+/* The bucket array is doubled when adding one more binding would make
+the fraction of used slots exceed MAX_LOAD_NUMER / MAX_LOAD_DENOM */
+static const size_t MAX_LOAD_NUMER = 9;
+static const size_t MAX_LOAD_DENOM = 10;
+
+/* Each Bucket holds up to SLOTS_PER_BUCKET keys together with a tag
+taken from each key's hash code, so most mismatches are rejected
+without dereferencing the key */
+struct Bucket
+{
+    /* Hash tag of the key in each slot */
+    unsigned short tags[SLOTS_PER_BUCKET];
+    /* Pointer to the key string (defensive copy) in each slot, or
+    NULL if the slot is empty */
+    const char *keys[SLOTS_PER_BUCKET];
+};
+
+/* A Cuckoo describes one bucket array together with its values */
+struct Cuckoo
+{
+    /* Cache-line aligned array of buckets */
+    struct Bucket *buckets;
+    /* Block returned by calloc that contains buckets */
+    void *bucketsBlock;
+    /* Value of the binding in each slot, indexed by bucket index
+    times SLOTS_PER_BUCKET plus slot index */
+    const void **values;
+    /* Number of buckets (a power of two) */
+    size_t bucketCount;
+};
+
+/* SymTable structure represents overall hash table */
+struct SymTable
+{
+    /* The bucket array */
+    struct Cuckoo cuckoo;
+    /* Key of a binding that was evicted but could not be placed, or
+    NULL if there is none. Lookups check it after both buckets */
+    const char *stashKey;
+    /* Value of the stashed binding */
+    const void *stashValue;
+    /* State of the generator that picks eviction victims */
+    size_t seed;
+    /* Stores total number of bindings in SymTable */
+    size_t bindingsCount;
+};
+
+/* A Location identifies the key and value storage of one binding */
+struct Location
+{
+    /* Pointer to the stored key pointer */
+    const char **ppcKey;
+    /* Pointer to the stored value pointer */
+    const void **ppvValue;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the full hash code for pcKey */
+
+static size_t SymTable_hash(const char *pcKey)
+{
+    return (size_t)SymTableHashCode_full(pcKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the tag stored alongside a key whose hash code is uHash. The
+tag comes from the top bits, which the bucket index does not use */
+
+static unsigned short SymTable_tag(size_t uHash)
+{
+    return (unsigned short)(uHash >> (sizeof(size_t) * 8 - 16));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the other candidate bucket of a key whose tag is usTag and
+one of whose buckets is uBucket, in an array with uMask + 1 buckets.
+Applying the function twice yields uBucket again, so an evicted key
+can be moved without recomputing its hash code */
+
+static size_t SymTable_altBucket(size_t uBucket, unsigned short usTag,
+                                 size_t uMask)
+{
+    return (uBucket ^ (((size_t)usTag + 1) * 0x5bd1e995U)) & uMask;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Allocate an empty bucket array of uBucketCount buckets into
+*psCuckoo. Return 1 (TRUE) if successful, or 0 (FALSE) if
+insufficient memory is available */
+
+static int SymTable_newCuckoo(struct Cuckoo *psCuckoo,
+                              size_t uBucketCount)
+{
+    uintptr_t uAddr;
+
+    psCuckoo->bucketsBlock = calloc(1, uBucketCount *
+                                    sizeof(struct Bucket) +
+                                    CACHE_LINE_SIZE);
+    if (psCuckoo->bucketsBlock == NULL)
+        return 0;
+
+    psCuckoo->values = calloc(uBucketCount * SLOTS_PER_BUCKET,
+                              sizeof(const void *));
+    if (psCuckoo->values == NULL)
+    {
+        free(psCuckoo->bucketsBlock);
+        return 0;
+    }
+
+    /* Round the start of the array up to a cache line boundary */
+    uAddr = (uintptr_t)psCuckoo->bucketsBlock;
+    uAddr = (uAddr + CACHE_LINE_SIZE - 1) &
+            ~(uintptr_t)(CACHE_LINE_SIZE - 1);
+    psCuckoo->buckets = (struct Bucket *)uAddr;
+    psCuckoo->bucketCount = uBucketCount;
+
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the bucket array of *psCuckoo, but not the keys in it */
+
+static void SymTable_freeCuckoo(struct Cuckoo *psCuckoo)
+{
+    free(psCuckoo->bucketsBlock);
+    free((void *)psCuckoo->values);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store key pcKey with tag usTag and value pvValue in a free slot of
+bucket uBucket of *psCuckoo. Return 1 (TRUE) if successful, or 0
+(FALSE) if the bucket is full */
+
+static int SymTable_placeInBucket(struct Cuckoo *psCuckoo,
+                                  size_t uBucket, const char *pcKey,
+                                  unsigned short usTag,
+                                  const void *pvValue)
+{
+    struct Bucket *psBucket = &psCuckoo->buckets[uBucket];
+    size_t s;
+
+    for (s = 0; s < SLOTS_PER_BUCKET; s++)
+    {
+        if (psBucket->keys[s] == NULL)
+        {
+            psBucket->keys[s] = pcKey;
+            psBucket->tags[s] = usTag;
+            psCuckoo->values[uBucket * SLOTS_PER_BUCKET + s] = pvValue;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Insert the binding of key *ppcKey, whose hash code is uHash, and
+value *ppvValue into *psCuckoo, evicting other bindings to their
+alternate buckets as necessary. Use *puSeed to choose victims. Return
+1 (TRUE) if successful. Otherwise return 0 (FALSE) and leave in
+*ppcKey and *ppvValue the binding that was left without a slot, which
+is not necessarily the one passed in */
+
+static int SymTable_insert(struct Cuckoo *psCuckoo, size_t *puSeed,
+                           const char **ppcKey, const void **ppvValue,
+                           size_t uHash)
+{
+    size_t uMask = psCuckoo->bucketCount - 1;
+    size_t uBucket, uAlt, uSlot, uKick;
+    unsigned short usTag, usSwapTag;
+    const char *pcSwapKey;
+    const void *pvSwapValue;
+    struct Bucket *psBucket;
+
+    usTag = SymTable_tag(uHash);
+    uBucket = uHash & uMask;
+    uAlt = SymTable_altBucket(uBucket, usTag, uMask);
+
+    /* Try both candidate buckets of the new key first */
+    if (SymTable_placeInBucket(psCuckoo, uBucket, *ppcKey, usTag,
+                               *ppvValue))
+        return 1;
+    if (SymTable_placeInBucket(psCuckoo, uAlt, *ppcKey, usTag,
+                               *ppvValue))
+        return 1;
+
+    /* Both are full, so repeatedly evict a victim from the bucket
+    being filled and carry it to its own alternate bucket */
+    for (uKick = 0; uKick < MAX_KICKS; uKick++)
+    {
+        *puSeed = *puSeed * (size_t)6364136223846793005ULL +
+                  (size_t)1442695040888963407ULL;
+        if (uKick == 0 && ((*puSeed >> 40) & 1))
+            uBucket = uAlt;
+        uSlot = (size_t)(*puSeed >> 33) % SLOTS_PER_BUCKET;
+
+        /* Swap the carried binding with the victim */
+        psBucket = &psCuckoo->buckets[uBucket];
+        pcSwapKey = psBucket->keys[uSlot];
+        usSwapTag = psBucket->tags[uSlot];
+        pvSwapValue =
+            psCuckoo->values[uBucket * SLOTS_PER_BUCKET + uSlot];
+        psBucket->keys[uSlot] = *ppcKey;
+        psBucket->tags[uSlot] = usTag;
+        psCuckoo->values[uBucket * SLOTS_PER_BUCKET + uSlot] =
+            *ppvValue;
+        *ppcKey = pcSwapKey;
+        usTag = usSwapTag;
+        *ppvValue = pvSwapValue;
+
+        /* Move on to the victim's other bucket */
+        uBucket = SymTable_altBucket(uBucket, usTag, uMask);
+        if (SymTable_placeInBucket(psCuckoo, uBucket, *ppcKey, usTag,
+                                   *ppvValue))
+            return 1;
+    }
+
+    return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Move every binding of oSymTable, including the stashed one, into a
+bucket array with at least twice as many buckets. Return 1 (TRUE) if
+successful, or 0 (FALSE) if insufficient memory is available, in which
+case oSymTable is left unchanged */
+
+static int SymTable_tryExpand(SymTable_T oSymTable)
+{
+    struct Cuckoo newCuckoo;
+    struct Cuckoo *psOld = &oSymTable->cuckoo;
+    size_t newBucketCount, uTry, b, s;
+    const char *pcKey, *newStashKey;
+    const void *pvValue, *newStashValue;
+    int iFits;
+
+    newBucketCount = psOld->bucketCount;
+
+    for (uTry = 0; uTry < MAX_EXPAND_TRIES; uTry++)
+    {
+        /* Handle case where bucket count would overflow */
+        if (newBucketCount * 2 < newBucketCount)
+            return 0;
+        newBucketCount *= 2;
+
+        if (!SymTable_newCuckoo(&newCuckoo, newBucketCount))
+            return 0;
+
+        /* Reinsert all existing bindings; the new array may stash one
+        binding of its own */
+        newStashKey = NULL;
+        newStashValue = NULL;
+        iFits = 1;
+        for (b = 0; iFits && b <= psOld->bucketCount; b++)
+        {
+            for (s = 0; iFits && s < SLOTS_PER_BUCKET; s++)
+            {
+                /* The final pass visits only the stash */
+                if (b == psOld->bucketCount)
+                {
+                    if (s > 0)
+                        break;
+                    pcKey = oSymTable->stashKey;
+                    pvValue = oSymTable->stashValue;
+                }
+                else
+                {
+                    pcKey = psOld->buckets[b].keys[s];
+                    pvValue =
+                        psOld->values[b * SLOTS_PER_BUCKET + s];
+                }
+                if (pcKey == NULL)
+                    continue;
+
+                if (SymTable_insert(&newCuckoo, &oSymTable->seed,
+                                    &pcKey, &pvValue,
+                                    SymTable_hash(pcKey)))
+                    continue;
+
+                /* Stash the binding left over, unless the stash of the
+                new array is already taken */
+                if (newStashKey == NULL)
+                {
+                    newStashKey = pcKey;
+                    newStashValue = pvValue;
+                }
+                else
+                    iFits = 0;
+            }
+        }
+
+        if (iFits)
+        {
+            /* Swaps in the new bucket array */
+            SymTable_freeCuckoo(psOld);
+            *psOld = newCuckoo;
+            oSymTable->stashKey = newStashKey;
+            oSymTable->stashValue = newStashValue;
+            return 1;
+        }
+
+        /* Otherwise, try again with an even larger array */
+        SymTable_freeCuckoo(&newCuckoo);
+    }
+
+    return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Find the binding with key pcKey in oSymTable. Return 1 (TRUE) and
+fill *psLoc with its location if it exists, or 0 (FALSE) otherwise */
+
+static int SymTable_locate(SymTable_T oSymTable, const char *pcKey,
+                           struct Location *psLoc)
+{
+    struct Cuckoo *psCuckoo = &oSymTable->cuckoo;
+    size_t uMask = psCuckoo->bucketCount - 1;
+    size_t uHash, uBucket, uTry, s;
+    unsigned short usTag;
+    struct Bucket *psBucket;
+
+    uHash = SymTable_hash(pcKey);
+    usTag = SymTable_tag(uHash);
+    uBucket = uHash & uMask;
+
+    /* Search the two candidate buckets */
+    for (uTry = 0; uTry < 2; uTry++)
+    {
+        psBucket = &psCuckoo->buckets[uBucket];
+        for (s = 0; s < SLOTS_PER_BUCKET; s++)
+        {
+            /* Handle condition where binding with pcKey exists */
+            if (psBucket->tags[s] == usTag &&
+                psBucket->keys[s] != NULL &&
+                strcmp(psBucket->keys[s], pcKey) == 0)
+            {
+                psLoc->ppcKey = &psBucket->keys[s];
+                psLoc->ppvValue =
+                    &psCuckoo->values[uBucket * SLOTS_PER_BUCKET + s];
+                return 1;
+            }
+        }
+        uBucket = SymTable_altBucket(uBucket, usTag, uMask);
+    }
+
+    /* Finally check the stash */
+    if (oSymTable->stashKey != NULL &&
+        strcmp(oSymTable->stashKey, pcKey) == 0)
+    {
+        psLoc->ppcKey = &oSymTable->stashKey;
+        psLoc->ppvValue = &oSymTable->stashValue;
+        return 1;
+    }
+
+    /* Handle condition where no binding with pcKey exists */
+    return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+    SymTable_T oSymTable;
+
+    /* Allocate memory for a new symbol table */
+    oSymTable = malloc(sizeof(struct SymTable));
+
+    /* Handle case if allocation of memory to symTable pointer fails */
+    if (oSymTable == NULL)
+    {
+        return NULL;
+    }
+
+    /* Initialize fields for new symbol table */
+    oSymTable->stashKey = NULL;
+    oSymTable->stashValue = NULL;
+    oSymTable->seed = 1;
+    oSymTable->bindingsCount = 0;
+
+    /* Handle case where allocation of memory for array of buckets
+    fails */
+    if (!SymTable_newCuckoo(&oSymTable->cuckoo, INITIAL_BUCKET_COUNT))
+    {
+        free(oSymTable);
+        return NULL;
+    }
+
+    return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    struct Cuckoo *psCuckoo;
+    size_t b, s;
+
+    assert(oSymTable != NULL);
+
+    psCuckoo = &oSymTable->cuckoo;
+
+    /* Free the key copy held in every occupied slot */
+    for (b = 0; b < psCuckoo->bucketCount; b++)
+    {
+        for (s = 0; s < SLOTS_PER_BUCKET; s++)
+            free((void *)psCuckoo->buckets[b].keys[s]);
+    }
+    free((void *)oSymTable->stashKey);
+
+    /* Free the bucket array */
+    SymTable_freeCuckoo(psCuckoo);
+    /* Free the symbol table structure */
+    free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    return oSymTable->bindingsCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable,
+                 const char *pcKey, const void *pvValue)
+{
+    struct Location loc;
+    size_t slotCount;
+    const char *homelessKey;
+    const void *homelessValue;
+    char *keyCopy;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* Handle condition where binding with pcKey already exists */
+    if (SymTable_locate(oSymTable, pcKey, &loc))
+        return 0;
+
+    /* Attempt to expand hash table if adding one more binding would
+    exceed the maximum load factor, or if the stash is taken */
+    slotCount = oSymTable->cuckoo.bucketCount * SLOTS_PER_BUCKET;
+    if (oSymTable->stashKey != NULL ||
+        (oSymTable->bindingsCount + 1) * MAX_LOAD_DENOM >
+        slotCount * MAX_LOAD_NUMER)
+        (void)SymTable_tryExpand(oSymTable);
+
+    /* The new binding may be left without a slot, and the stash has
+    room for only one binding. An expansion may have stashed a binding
+    of its own, so fail if the stash is still taken */
+    if (oSymTable->stashKey != NULL)
+        return 0;
+
+    /* Copy the key string defensively */
+    keyCopy = malloc(strlen(pcKey) + 1);
+
+    /* Handle condition of insufficient memory for defensive copy
+    of key string */
+    if (keyCopy == NULL)
+        return 0;
+
+    /* Copy string into newly allocated memory */
+    strcpy(keyCopy, pcKey);
+
+    /* Insert new binding. A binding left without a slot goes to the
+    stash, which was checked to be empty above, and the next expansion
+    tries to find it a slot */
+    homelessKey = keyCopy;
+    homelessValue = pvValue;
+    if (!SymTable_insert(&oSymTable->cuckoo, &oSymTable->seed,
+                         &homelessKey, &homelessValue,
+                         SymTable_hash(keyCopy)))
+    {
+        oSymTable->stashKey = homelessKey;
+        oSymTable->stashValue = homelessValue;
+        (void)SymTable_tryExpand(oSymTable);
+    }
+
+    oSymTable->bindingsCount++;
+
+    /* Successful insertion*/
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable,
+                       const char *pcKey, const void *pvValue)
+{
+    struct Location loc;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* Handle condition where no binding with pcKey exists */
+    if (!SymTable_locate(oSymTable, pcKey, &loc))
+        return NULL;
+
+    /* Save old value, then replace with new value */
+    oldValue = (void *)*loc.ppvValue;
+    *loc.ppvValue = pvValue;
+    return oldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    struct Location loc;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_locate(oSymTable, pcKey, &loc);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    struct Location loc;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* Handle condition where no binding with pcKey exists */
+    if (!SymTable_locate(oSymTable, pcKey, &loc))
+        return NULL;
+
+    return (void *)*loc.ppvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    struct Location loc;
+    const char *stashKey;
+    const void *stashValue;
+    void *bindingValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* Handle condition where no binding with pcKey exists */
+    if (!SymTable_locate(oSymTable, pcKey, &loc))
+        return NULL;
+
+    bindingValue = (void *)*loc.ppvValue;
+    free((void *)*loc.ppcKey);
+    *loc.ppcKey = NULL;
+    *loc.ppvValue = NULL;
+    oSymTable->bindingsCount--;
+
+    /* A slot is now free, so give the stashed binding another chance
+    to move into the bucket array */
+    if (oSymTable->stashKey != NULL)
+    {
+        stashKey = oSymTable->stashKey;
+        stashValue = oSymTable->stashValue;
+        oSymTable->stashKey = NULL;
+        oSymTable->stashValue = NULL;
+        if (!SymTable_insert(&oSymTable->cuckoo, &oSymTable->seed,
+                             &stashKey, &stashValue,
+                             SymTable_hash(stashKey)))
+        {
+            oSymTable->stashKey = stashKey;
+            oSymTable->stashValue = stashValue;
+        }
+    }
+
+    return bindingValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue,
+                                  void *pvExtra),
+                  const void *pvExtra)
+{
+    struct Cuckoo *psCuckoo;
+    size_t b, s;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    psCuckoo = &oSymTable->cuckoo;
+
+    /* Iterate over all occupied slots */
+    for (b = 0; b < psCuckoo->bucketCount; b++)
+    {
+        for (s = 0; s < SLOTS_PER_BUCKET; s++)
+        {
+            /* Apply the function on each key/value */
+            if (psCuckoo->buckets[b].keys[s] != NULL)
+                (void)(*pfApply)(psCuckoo->buckets[b].keys[s],
+                                 (void *)psCuckoo->values
+                                     [b * SLOTS_PER_BUCKET + s],
+                                 (void *)pvExtra);
+        }
+    }
+
+    /* Apply the function on the stashed binding, if any */
+    if (oSymTable->stashKey != NULL)
+        (void)(*pfApply)(oSymTable->stashKey,
+                         (void *)oSymTable->stashValue,
+                         (void *)pvExtra);
+}
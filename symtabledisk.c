@@ -0,0 +1,882 @@
+/*--------------------------------------------------------------------*/
+/* symtabledisk.c                                                     */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+/* Disk-backed implementation of symbol table that maps string keys to
+void* values. Bindings are packed, together with a copy of their key
+and the encoding of their value, into fixed-size pages of a file, and
+located by extendible hashing: an in-memory directory maps the low
+bits of a key's hash code to the number of the page that holds the
+key, so every operation reads at most one page. A page that overflows
+is split in two on one more hash bit. Pages are read and written with
+pread and pwrite through a cache of a bounded number of frames, which
+are reused in CLOCK order, writing a frame back only if it changed */
+
+#define _XOPEN_SOURCE 700
+
+#include "symtabledisk.h"
+#include "symtablehashcode.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Size of a page in bytes */
+enum {PAGE_SIZE = 4096};
+
+/* Largest number of hash bits the directory may use */
+enum {MAX_GLOBAL_DEPTH = 32};
+
+/* Smallest number of frames in the page cache */
+enum {MIN_FRAME_COUNT = 2};
+
+/* Byte offsets of the fields of a record. A record consists of the
+32-bit hash code of its key, the 16-bit lengths of its key (including
+the null character) and of its encoded value, the key string, and
+the encoded value */
+enum {REC_HASH = 0, REC_KEYLEN = 4, REC_VALUELEN = 6, REC_KEY = 8};
+
+/* Each PageHeader describes the records packed into a page */
+struct PageHeader
+{
+    /* Number of records in the page */
+    unsigned short count;
+    /* Number of bytes of data used by the records */
+    unsigned short usedBytes;
+    /* Number of low hash bits shared by every key in the page */
+    unsigned short localDepth;
+    /* Unused, keeps the header 8 bytes long */
+    unsigned short reserved;
+};
+
+/* Number of data bytes in a page */
+enum {PAGE_DATA_SIZE = PAGE_SIZE - sizeof(struct PageHeader)};
+
+/* Each Page is the in-memory image of PAGE_SIZE bytes of the file */
+struct Page
+{
+    /* Description of the records */
+    struct PageHeader header;
+    /* Packed records */
+    unsigned char data[PAGE_DATA_SIZE];
+};
+
+/* Each Frame holds one cached page */
+struct Frame
+{
+    /* Number of the page held, valid if inUse is 1 (TRUE) */
+    uint32_t pageNo;
+    /* 1 (TRUE) if the frame holds a page */
+    int inUse;
+    /* 1 (TRUE) if the page changed since it was read */
+    int dirty;
+    /* 1 (TRUE) if the page was used since the clock hand last passed */
+    int referenced;
+    /* 1 (TRUE) if the page must stay cached for now */
+    int pinned;
+    /* The page image */
+    struct Page *page;
+};
+
+/* SymTable structure represents overall disk-backed table */
+struct SymTable
+{
+    /* File descriptor of the page file */
+    int fd;
+    /* Array of 2^globalDepth page numbers */
+    uint32_t *directory;
+    /* Number of low hash bits used to index the directory */
+    size_t globalDepth;
+    /* Number of pages in the file */
+    uint32_t pageCount;
+    /* Array of frames of the page cache */
+    struct Frame *frames;
+    /* Number of frames */
+    size_t frameCount;
+    /* Index of the next frame the clock hand examines */
+    size_t clockHand;
+    /* Array mapping each page number to its frame index plus one, or
+    0 if the page is not cached */
+    size_t *pageFrames;
+    /* Number of entries pageFrames has room for */
+    size_t pageFramesSize;
+    /* Block of memory holding the page images of all frames */
+    struct Page *pageBlock;
+    /* Functions that encode and decode values */
+    const struct SymTable_Codec *codec;
+    /* Stores total number of bindings in SymTable */
+    size_t bindingsCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the 32-bit hash code for pcKey */
+
+static uint32_t SymTable_hash(const char *pcKey)
+{
+    return (uint32_t)SymTableHashCode_full(pcKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the 16-bit field at byte offset uOffset of pucRec */
+
+static size_t SymTable_recField(const unsigned char *pucRec,
+                                size_t uOffset)
+{
+    unsigned short usField;
+    memcpy(&usField, pucRec + uOffset, sizeof(usField));
+    return usField;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash code stored in the record at pucRec */
+
+static uint32_t SymTable_recHash(const unsigned char *pucRec)
+{
+    uint32_t uiHash;
+    memcpy(&uiHash, pucRec + REC_HASH, sizeof(uiHash));
+    return uiHash;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the size in bytes of the record at pucRec */
+
+static size_t SymTable_recSize(const unsigned char *pucRec)
+{
+    return REC_KEY + SymTable_recField(pucRec, REC_KEYLEN) +
+           SymTable_recField(pucRec, REC_VALUELEN);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the value decoded by the codec of oSymTable from the record
+at pucRec */
+
+static void *SymTable_recValue(SymTable_T oSymTable,
+                               const unsigned char *pucRec)
+{
+    size_t uKeyLength = SymTable_recField(pucRec, REC_KEYLEN);
+
+    return (*oSymTable->codec->pfDecode)(
+        pucRec + REC_KEY + uKeyLength,
+        SymTable_recField(pucRec, REC_VALUELEN));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free pvValue, which the codec of oSymTable decoded but which is not
+being returned to the client */
+
+static void SymTable_freeValue(SymTable_T oSymTable, void *pvValue)
+{
+    if (oSymTable->codec->pfFree != NULL && pvValue != NULL)
+        (*oSymTable->codec->pfFree)(pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the page held by psFrame of oSymTable back to the file if it
+changed. Return 1 (TRUE) if successful, or 0 (FALSE) if the write
+failed */
+
+static int SymTable_writeBack(SymTable_T oSymTable,
+                              struct Frame *psFrame)
+{
+    if (!psFrame->inUse || !psFrame->dirty)
+        return 1;
+
+    if (pwrite(oSymTable->fd, psFrame->page, PAGE_SIZE,
+               (off_t)psFrame->pageNo * PAGE_SIZE) != PAGE_SIZE)
+        return 0;
+
+    psFrame->dirty = 0;
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a frame of oSymTable that may be reused, writing back the
+page it holds if needed, or NULL if that write failed */
+
+static struct Frame *SymTable_victim(SymTable_T oSymTable)
+{
+    struct Frame *psFrame;
+
+    /* Advance the clock hand past recently used frames, clearing
+    their referenced bits */
+    for (;;)
+    {
+        psFrame = &oSymTable->frames[oSymTable->clockHand];
+        oSymTable->clockHand =
+            (oSymTable->clockHand + 1) % oSymTable->frameCount;
+
+        if (!psFrame->inUse)
+            return psFrame;
+        if (psFrame->pinned)
+            continue;
+        if (!psFrame->referenced)
+            break;
+        psFrame->referenced = 0;
+    }
+
+    if (!SymTable_writeBack(oSymTable, psFrame))
+        return NULL;
+
+    oSymTable->pageFrames[psFrame->pageNo] = 0;
+    psFrame->inUse = 0;
+    return psFrame;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the image of page uiPageNo of oSymTable, reading it into the
+cache if necessary, or NULL if it cannot be read. The image remains
+valid until the next call that fetches or creates a page */
+
+static struct Page *SymTable_fetch(SymTable_T oSymTable,
+                                   uint32_t uiPageNo)
+{
+    struct Frame *psFrame;
+    size_t uFrame;
+
+    assert(uiPageNo < oSymTable->pageCount);
+
+    /* Handle condition where page is already cached */
+    uFrame = oSymTable->pageFrames[uiPageNo];
+    if (uFrame != 0)
+    {
+        psFrame = &oSymTable->frames[uFrame - 1];
+        psFrame->referenced = 1;
+        return psFrame->page;
+    }
+
+    psFrame = SymTable_victim(oSymTable);
+    if (psFrame == NULL)
+        return NULL;
+
+    if (pread(oSymTable->fd, psFrame->page, PAGE_SIZE,
+              (off_t)uiPageNo * PAGE_SIZE) != PAGE_SIZE)
+        return NULL;
+
+    psFrame->pageNo = uiPageNo;
+    psFrame->inUse = 1;
+    psFrame->dirty = 0;
+    psFrame->referenced = 1;
+    oSymTable->pageFrames[uiPageNo] =
+        (size_t)(psFrame - oSymTable->frames) + 1;
+    return psFrame->page;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Mark page uiPageNo of oSymTable, which is cached, as changed */
+
+static void SymTable_markDirty(SymTable_T oSymTable, uint32_t uiPageNo)
+{
+    size_t uFrame = oSymTable->pageFrames[uiPageNo];
+
+    assert(uFrame != 0);
+    oSymTable->frames[uFrame - 1].dirty = 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add an empty page with local depth uDepth at the end of the file of
+oSymTable and store its number in *puiPageNo. Return its image, which
+is cached and marked as changed, or NULL if insufficient memory is
+available */
+
+static struct Page *SymTable_newPage(SymTable_T oSymTable,
+                                     size_t uDepth, uint32_t *puiPageNo)
+{
+    struct Frame *psFrame;
+    size_t *newPageFrames;
+    size_t newSize;
+
+    /* Handle case where the page count would overflow */
+    if (oSymTable->pageCount == UINT32_MAX)
+        return NULL;
+
+    /* Grow the page-to-frame map if it is full */
+    if (oSymTable->pageCount == oSymTable->pageFramesSize)
+    {
+        newSize = oSymTable->pageFramesSize * 2;
+        newPageFrames = realloc(oSymTable->pageFrames,
+                                newSize * sizeof(size_t));
+        if (newPageFrames == NULL)
+            return NULL;
+        memset(newPageFrames + oSymTable->pageFramesSize, 0,
+               (newSize - oSymTable->pageFramesSize) * sizeof(size_t));
+        oSymTable->pageFrames = newPageFrames;
+        oSymTable->pageFramesSize = newSize;
+    }
+
+    psFrame = SymTable_victim(oSymTable);
+    if (psFrame == NULL)
+        return NULL;
+
+    /* The page only reaches the file when its frame is written back */
+    memset(psFrame->page, 0, PAGE_SIZE);
+    psFrame->page->header.localDepth = (unsigned short)uDepth;
+    psFrame->pageNo = oSymTable->pageCount;
+    psFrame->inUse = 1;
+    psFrame->dirty = 1;
+    psFrame->referenced = 1;
+    oSymTable->pageFrames[psFrame->pageNo] =
+        (size_t)(psFrame - oSymTable->frames) + 1;
+
+    *puiPageNo = oSymTable->pageCount++;
+    return psFrame->page;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Copy the record at pucRec to the end of psPage, which must have room
+for it */
+
+static void SymTable_appendRecord(struct Page *psPage,
+                                  const unsigned char *pucRec)
+{
+    size_t uSize = SymTable_recSize(pucRec);
+
+    assert(psPage->header.usedBytes + uSize <= PAGE_DATA_SIZE);
+
+    memcpy(psPage->data + psPage->header.usedBytes, pucRec, uSize);
+    psPage->header.usedBytes += (unsigned short)uSize;
+    psPage->header.count++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of the page of oSymTable in which a key whose hash
+code is uiHash belongs */
+
+static uint32_t SymTable_pageOf(SymTable_T oSymTable, uint32_t uiHash)
+{
+    return oSymTable->directory[(size_t)uiHash &
+                                (((size_t)1 << oSymTable->globalDepth) -
+                                 1)];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the offset within psPage of the record whose key is pcKey
+and whose hash code is uiHash, or PAGE_DATA_SIZE if there is none */
+
+static size_t SymTable_findRecord(struct Page *psPage,
+                                  const char *pcKey, uint32_t uiHash)
+{
+    size_t off = 0;
+    const unsigned char *pucRec;
+
+    /* Scan all the records in the page */
+    while (off < psPage->header.usedBytes)
+    {
+        pucRec = psPage->data + off;
+
+        /* Handle condition where binding with pcKey exists */
+        if (SymTable_recHash(pucRec) == uiHash &&
+            strcmp((const char *)(pucRec + REC_KEY), pcKey) == 0)
+            return off;
+
+        /* Otherwise, move on to the next record */
+        off += SymTable_recSize(pucRec);
+    }
+
+    /* Handle condition where no binding with pcKey exists */
+    return PAGE_DATA_SIZE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Split page uiPageNo of oSymTable, in which a key whose hash code is
+uiHash belongs, into two pages that use one more hash bit, doubling
+the directory if needed. Return 1 (TRUE) if successful, or 0 (FALSE)
+if insufficient memory is available, a page cannot be read or written,
+or every hash bit is already in use */
+
+static int SymTable_split(SymTable_T oSymTable, uint32_t uiPageNo,
+                          uint32_t uiHash)
+{
+    struct Page oldCopy;
+    struct Page *psPage, *psNew;
+    struct Frame *psOldFrame;
+    uint32_t *newDirectory;
+    uint32_t uiNewPageNo;
+    size_t uFrame, depth, dirSize, i, off;
+    const unsigned char *pucRec;
+
+    psPage = SymTable_fetch(oSymTable, uiPageNo);
+    if (psPage == NULL)
+        return 0;
+    uFrame = oSymTable->pageFrames[uiPageNo];
+    psOldFrame = &oSymTable->frames[uFrame - 1];
+    depth = psPage->header.localDepth;
+
+    /* Handle case where no hash bit is left to split on */
+    if (depth == MAX_GLOBAL_DEPTH)
+        return 0;
+
+    /* Double the directory if the page uses all of its bits */
+    if (depth == oSymTable->globalDepth)
+    {
+        dirSize = (size_t)1 << oSymTable->globalDepth;
+        newDirectory = realloc(oSymTable->directory,
+                               2 * dirSize * sizeof(uint32_t));
+        if (newDirectory == NULL)
+            return 0;
+
+        /* The upper half of the directory mirrors the lower half */
+        for (i = 0; i < dirSize; i++)
+            newDirectory[dirSize + i] = newDirectory[i];
+
+        oSymTable->directory = newDirectory;
+        oSymTable->globalDepth++;
+    }
+
+    /* Pin the old page while the new page is created, so that it is
+    not evicted and both pages can be rewritten without reading the
+    file again. Nothing has changed if the new page cannot be made */
+    psOldFrame->pinned = 1;
+    psNew = SymTable_newPage(oSymTable, depth + 1, &uiNewPageNo);
+    psOldFrame->pinned = 0;
+    if (psNew == NULL)
+        return 0;
+    oldCopy = *psPage;
+
+    /* Move the records whose hash bit depth is set to the new page */
+    for (off = 0; off < oldCopy.header.usedBytes;
+         off += SymTable_recSize(pucRec))
+    {
+        pucRec = oldCopy.data + off;
+        if ((SymTable_recHash(pucRec) >> depth) & 1)
+            SymTable_appendRecord(psNew, pucRec);
+    }
+
+    /* Keep the other records in the old page */
+    psPage->header.count = 0;
+    psPage->header.usedBytes = 0;
+    psPage->header.localDepth = (unsigned short)(depth + 1);
+    for (off = 0; off < oldCopy.header.usedBytes;
+         off += SymTable_recSize(pucRec))
+    {
+        pucRec = oldCopy.data + off;
+        if (((SymTable_recHash(pucRec) >> depth) & 1) == 0)
+            SymTable_appendRecord(psPage, pucRec);
+    }
+    SymTable_markDirty(oSymTable, uiPageNo);
+
+    /* Point the directory entries whose bit depth is set at the new
+    page. They are the entries that share the old page's low bits */
+    dirSize = (size_t)1 << oSymTable->globalDepth;
+    for (i = (size_t)uiHash & (((size_t)1 << depth) - 1); i < dirSize;
+         i += (size_t)1 << depth)
+    {
+        if ((i >> depth) & 1)
+            oSymTable->directory[i] = uiNewPageNo;
+    }
+
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store the record at pucRec, whose hash code is uiHash, in the page
+of oSymTable where it belongs, splitting pages until it fits. Return 1
+(TRUE) if successful, or 0 (FALSE) otherwise */
+
+static int SymTable_storeRecord(SymTable_T oSymTable,
+                                const unsigned char *pucRec,
+                                uint32_t uiHash)
+{
+    struct Page *psPage;
+    uint32_t uiPageNo;
+    size_t uRecSize = SymTable_recSize(pucRec);
+
+    for (;;)
+    {
+        uiPageNo = SymTable_pageOf(oSymTable, uiHash);
+        psPage = SymTable_fetch(oSymTable, uiPageNo);
+        if (psPage == NULL)
+            return 0;
+
+        /* Handle condition where the page has room */
+        if (psPage->header.usedBytes + uRecSize <= PAGE_DATA_SIZE)
+        {
+            SymTable_appendRecord(psPage, pucRec);
+            SymTable_markDirty(oSymTable, uiPageNo);
+            return 1;
+        }
+
+        if (!SymTable_split(oSymTable, uiPageNo, uiHash))
+            return 0;
+    }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Build in pucRec, which has room for PAGE_DATA_SIZE bytes, the record
+for key pcKey with hash code uiHash and value pvValue encoded by the
+codec of oSymTable. Return 1 (TRUE) if successful, or 0 (FALSE) if
+the record would not fit in a page */
+
+static int SymTable_buildRecord(SymTable_T oSymTable,
+                                unsigned char *pucRec,
+                                const char *pcKey, uint32_t uiHash,
+                                const void *pvValue)
+{
+    size_t uKeyLength, uValueLength;
+    unsigned short usField;
+
+    uKeyLength = strlen(pcKey) + 1;
+    if (REC_KEY + uKeyLength > PAGE_DATA_SIZE)
+        return 0;
+
+    uValueLength = (*oSymTable->codec->pfEncode)(
+        pvValue, pucRec + REC_KEY + uKeyLength,
+        PAGE_DATA_SIZE - REC_KEY - uKeyLength);
+    if (REC_KEY + uKeyLength + uValueLength > PAGE_DATA_SIZE)
+        return 0;
+
+    memcpy(pucRec + REC_HASH, &uiHash, sizeof(uiHash));
+    usField = (unsigned short)uKeyLength;
+    memcpy(pucRec + REC_KEYLEN, &usField, sizeof(usField));
+    usField = (unsigned short)uValueLength;
+    memcpy(pucRec + REC_VALUELEN, &usField, sizeof(usField));
+    memcpy(pucRec + REC_KEY, pcKey, uKeyLength);
+
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Remove the record at offset off from page uiPageNo of oSymTable,
+whose image is psPage */
+
+static void SymTable_deleteRecord(SymTable_T oSymTable,
+                                  struct Page *psPage,
+                                  uint32_t uiPageNo, size_t off)
+{
+    unsigned char *pucRec = psPage->data + off;
+    size_t uRecSize = SymTable_recSize(pucRec);
+
+    /* Close the gap left by the record */
+    memmove(pucRec, pucRec + uRecSize,
+            psPage->header.usedBytes - off - uRecSize);
+    psPage->header.usedBytes -= (unsigned short)uRecSize;
+    psPage->header.count--;
+    SymTable_markDirty(oSymTable, uiPageNo);
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newDisk(const char *pcPath, size_t uCacheBytes,
+                            const struct SymTable_Codec *psCodec)
+{
+    SymTable_T oSymTable;
+    char acTemplate[] = "/tmp/symtableXXXXXX";
+    uint32_t uiPageNo;
+    size_t i;
+
+    assert(psCodec != NULL);
+
+    /* Allocate memory for a new symbol table */
+    oSymTable = calloc(1, sizeof(struct SymTable));
+
+    /* Handle case if allocation of memory to symTable pointer fails */
+    if (oSymTable == NULL)
+    {
+        return NULL;
+    }
+
+    /* Initialize fields for new symbol table */
+    oSymTable->codec = psCodec;
+    oSymTable->frameCount = uCacheBytes / PAGE_SIZE;
+    if (oSymTable->frameCount < MIN_FRAME_COUNT)
+        oSymTable->frameCount = MIN_FRAME_COUNT;
+    oSymTable->pageFramesSize = 64;
+    oSymTable->frames = calloc(oSymTable->frameCount,
+                               sizeof(struct Frame));
+    oSymTable->pageBlock = malloc(oSymTable->frameCount *
+                                  sizeof(struct Page));
+    oSymTable->pageFrames = calloc(oSymTable->pageFramesSize,
+                                   sizeof(size_t));
+    oSymTable->directory = malloc(sizeof(uint32_t));
+
+    /* Open the page file. An unnamed file is removed at once, so the
+    space is reclaimed when the file is closed */
+    if (pcPath == NULL)
+    {
+        oSymTable->fd = mkstemp(acTemplate);
+        if (oSymTable->fd >= 0)
+            (void)unlink(acTemplate);
+    }
+    else
+        oSymTable->fd = open(pcPath, O_RDWR | O_CREAT | O_TRUNC, 0666);
+
+    /* Handle case where any allocation fails or file cannot be
+    opened */
+    if (oSymTable->frames == NULL || oSymTable->pageBlock == NULL ||
+        oSymTable->pageFrames == NULL || oSymTable->directory == NULL ||
+        oSymTable->fd < 0)
+    {
+        SymTable_free(oSymTable);
+        return NULL;
+    }
+
+    for (i = 0; i < oSymTable->frameCount; i++)
+        oSymTable->frames[i].page = &oSymTable->pageBlock[i];
+
+    /* Start with a single page that every key maps to */
+    if (SymTable_newPage(oSymTable, 0, &uiPageNo) == NULL)
+    {
+        SymTable_free(oSymTable);
+        return NULL;
+    }
+    oSymTable->directory[0] = uiPageNo;
+
+    return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+    return SymTable_newDisk(NULL, SYMTABLEDISK_DEFAULT_CACHE_BYTES,
+                            &SymTable_pointerCodec);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+
+    /* Close the page file. Changed pages are not written back, since
+    the file is not reopened */
+    if (oSymTable->fd >= 0)
+        (void)close(oSymTable->fd);
+
+    /* Free the cache, the directory and the symbol table structure */
+    free(oSymTable->frames);
+    free(oSymTable->pageBlock);
+    free(oSymTable->pageFrames);
+    free(oSymTable->directory);
+    free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    return oSymTable->bindingsCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getFileBytes(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    return (size_t)oSymTable->pageCount * PAGE_SIZE;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable,
+                 const char *pcKey, const void *pvValue)
+{
+    unsigned char aucRec[PAGE_DATA_SIZE];
+    struct Page *psPage;
+    uint32_t uiHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uiHash = SymTable_hash(pcKey);
+    psPage = SymTable_fetch(oSymTable,
+                            SymTable_pageOf(oSymTable, uiHash));
+
+    /* Handle condition where page cannot be read, or binding with
+    pcKey already exists */
+    if (psPage == NULL ||
+        SymTable_findRecord(psPage, pcKey, uiHash) != PAGE_DATA_SIZE)
+        return 0;
+
+    /* Handle condition where binding is too large for a page */
+    if (!SymTable_buildRecord(oSymTable, aucRec, pcKey, uiHash,
+                              pvValue))
+        return 0;
+
+    if (!SymTable_storeRecord(oSymTable, aucRec, uiHash))
+        return 0;
+
+    oSymTable->bindingsCount++;
+
+    /* Successful insertion*/
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable,
+                       const char *pcKey, const void *pvValue)
+{
+    unsigned char aucOldRec[PAGE_DATA_SIZE];
+    unsigned char aucRec[PAGE_DATA_SIZE];
+    struct Page *psPage;
+    uint32_t uiHash, uiPageNo;
+    size_t off;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uiHash = SymTable_hash(pcKey);
+    uiPageNo = SymTable_pageOf(oSymTable, uiHash);
+    psPage = SymTable_fetch(oSymTable, uiPageNo);
+    if (psPage == NULL)
+        return NULL;
+    off = SymTable_findRecord(psPage, pcKey, uiHash);
+
+    /* Handle condition where no binding with pcKey exists, or the new
+    value does not fit in a page */
+    if (off == PAGE_DATA_SIZE ||
+        !SymTable_buildRecord(oSymTable, aucRec, pcKey, uiHash,
+                              pvValue))
+        return NULL;
+
+    /* Save old value */
+    oldValue = SymTable_recValue(oSymTable, psPage->data + off);
+
+    /* Replace the record, since the new encoding may differ in length.
+    If the new record cannot be stored, put back the old one, which
+    fits in the space it just left */
+    memcpy(aucOldRec, psPage->data + off,
+           SymTable_recSize(psPage->data + off));
+    SymTable_deleteRecord(oSymTable, psPage, uiPageNo, off);
+    if (!SymTable_storeRecord(oSymTable, aucRec, uiHash))
+    {
+        (void)SymTable_storeRecord(oSymTable, aucOldRec, uiHash);
+        SymTable_freeValue(oSymTable, oldValue);
+        return NULL;
+    }
+
+    return oldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    struct Page *psPage;
+    uint32_t uiHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uiHash = SymTable_hash(pcKey);
+    psPage = SymTable_fetch(oSymTable,
+                            SymTable_pageOf(oSymTable, uiHash));
+
+    return psPage != NULL &&
+           SymTable_findRecord(psPage, pcKey, uiHash) != PAGE_DATA_SIZE;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    struct Page *psPage;
+    uint32_t uiHash;
+    size_t off;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uiHash = SymTable_hash(pcKey);
+    psPage = SymTable_fetch(oSymTable,
+                            SymTable_pageOf(oSymTable, uiHash));
+    if (psPage == NULL)
+        return NULL;
+    off = SymTable_findRecord(psPage, pcKey, uiHash);
+
+    /* Handle condition where no binding with pcKey exists */
+    if (off == PAGE_DATA_SIZE)
+        return NULL;
+
+    return SymTable_recValue(oSymTable, psPage->data + off);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    struct Page *psPage;
+    uint32_t uiHash, uiPageNo;
+    size_t off;
+    void *bindingValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uiHash = SymTable_hash(pcKey);
+    uiPageNo = SymTable_pageOf(oSymTable, uiHash);
+    psPage = SymTable_fetch(oSymTable, uiPageNo);
+    if (psPage == NULL)
+        return NULL;
+    off = SymTable_findRecord(psPage, pcKey, uiHash);
+
+    /* Handle condition where no binding with pcKey exists */
+    if (off == PAGE_DATA_SIZE)
+        return NULL;
+
+    bindingValue = SymTable_recValue(oSymTable, psPage->data + off);
+    SymTable_deleteRecord(oSymTable, psPage, uiPageNo, off);
+
+    oSymTable->bindingsCount--;
+    return bindingValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue,
+                                  void *pvExtra),
+                  const void *pvExtra)
+{
+    struct Page *psPage;
+    uint32_t uiPageNo;
+    size_t off;
+    const unsigned char *pucRec;
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /* Every page in the file is in use, so walk the file in order */
+    for (uiPageNo = 0; uiPageNo < oSymTable->pageCount; uiPageNo++)
+    {
+        psPage = SymTable_fetch(oSymTable, uiPageNo);
+        if (psPage == NULL)
+            continue;
+
+        /* Apply the function on each key/value in the page. The
+        decoded value is freed once the function returns */
+        for (off = 0; off < psPage->header.usedBytes;
+             off += SymTable_recSize(pucRec))
+        {
+            pucRec = psPage->data + off;
+            pvValue = SymTable_recValue(oSymTable, pucRec);
+            (void)(*pfApply)((const char *)(pucRec + REC_KEY), pvValue,
+                             (void *)pvExtra);
+            SymTable_freeValue(oSymTable, pvValue);
+        }
+    }
+}
@@ -0,0 +1,41 @@
+/*--------------------------------------------------------------------*/
+/* symtabledisk.h                                                     */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+# ifndef SYMTABLEDISK
+# define SYMTABLEDISK
+
+#include "symtable.h"
+#include "symtablecodec.h"
+
+/*--------------------------------------------------------------------*/
+/* Return a new SymTable object that contains no bindings and keeps
+them in pages of the file named pcPath, or in an unnamed temporary
+file if pcPath is NULL. At most uCacheBytes bytes of pages are cached
+in memory. Values are stored through the functions of *psCodec, so
+SymTable_get, SymTable_replace and SymTable_remove return values
+decoded by *psCodec, which the caller owns. A binding whose key and
+encoded value together take more than about 4000 bytes cannot be
+stored. The file is working storage only: its previous contents are
+discarded, and it does not hold a usable table after SymTable_free.
+Return NULL if insufficient memory is available or the file cannot be
+created.
+
+SymTable_new is equivalent to SymTable_newDisk(NULL,
+SYMTABLEDISK_DEFAULT_CACHE_BYTES, &SymTable_pointerCodec) */
+
+SymTable_T SymTable_newDisk(const char *pcPath, size_t uCacheBytes,
+                            const struct SymTable_Codec *psCodec);
+
+/*--------------------------------------------------------------------*/
+/* Return the number of bytes of pages that oSymTable uses in its
+file, whether or not they have been written to the file yet */
+
+size_t SymTable_getFileBytes(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+/* Number of bytes of pages cached by a table made by SymTable_new */
+enum {SYMTABLEDISK_DEFAULT_CACHE_BYTES = 1024 * 1024};
+
+# endif
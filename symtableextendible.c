@@ -0,0 +1,575 @@
+/*--------------------------------------------------------------------*/
+/* symtableextendible.c                                               */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+/* Extendible-hashing implementation of symbol table that maps string
+keys to void* values. Each key is stored with defensive copy to
+ensure ownership by symbol table. Bindings are packed as variable-size
+records into fixed-size pages of PAGE_SIZE bytes. A directory of
+2^globalDepth entries maps the low globalDepth bits of a key's hash
+code to the page that holds the key, so every lookup reads exactly
+one page. A page that overflows is split in two on one more hash bit,
+and the directory doubles only when the page already uses every bit
+the directory has. Pages contain no pointers other than the stored
+value (and, for keys too long to pack, a pointer to the key), so the
+same layout can be written to or mapped from a file page for page */
+
+#include "symtable.h"
+#include "symtablehashcode.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Size of a page in bytes */
+enum {PAGE_SIZE = 4096};
+
+/* Largest number of hash bits the directory may use */
+enum {MAX_GLOBAL_DEPTH = 32};
+
+/* Byte offsets of the fields of a record. A record consists of the
+32-bit hash code of its key, a 16-bit key field, the value pointer,
+and then either the key string itself or a pointer to it. The key
+field is the key's length plus one for a key stored in the record, or
+0 for a key stored out of line */
+enum {REC_HASH = 0, REC_KEYFIELD = 4, REC_VALUE = 6,
+      REC_KEY = REC_VALUE + sizeof(void *)};
+
+/* Each PageHeader describes the records packed into a page */
+struct PageHeader
+{
+    /* Number of records in the page */
+    unsigned short count;
+    /* Number of bytes of data used by the records */
+    unsigned short usedBytes;
+    /* Number of low hash bits shared by every key in the page */
+    unsigned short localDepth;
+    /* Unused, keeps the header 8 bytes long */
+    unsigned short reserved;
+};
+
+/* Number of data bytes in a page */
+enum {PAGE_DATA_SIZE = PAGE_SIZE - sizeof(struct PageHeader)};
+
+/* Largest record that stores its key inline. Longer keys are stored
+out of line so that a page always holds several records */
+enum {MAX_INLINE_RECORD = PAGE_DATA_SIZE / 4};
+
+/* Each Page is a block of PAGE_SIZE bytes holding packed records */
+struct Page
+{
+    /* Description of the records */
+    struct PageHeader header;
+    /* Packed records */
+    unsigned char data[PAGE_DATA_SIZE];
+};
+
+/* SymTable structure represents overall hash table */
+struct SymTable
+{
+    /* Array of 2^globalDepth pointers to pages */
+    struct Page **directory;
+    /* Number of low hash bits used to index the directory */
+    size_t globalDepth;
+    /* Stores total number of bindings in SymTable */
+    size_t bindingsCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the 32-bit hash code for pcKey */
+
+static uint32_t SymTable_hash(const char *pcKey)
+{
+    return (uint32_t)SymTableHashCode_full(pcKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the hash code stored in the record at pucRec */
+
+static uint32_t SymTable_recHash(const unsigned char *pucRec)
+{
+    uint32_t uiHash;
+    memcpy(&uiHash, pucRec + REC_HASH, sizeof(uiHash));
+    return uiHash;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the key field stored in the record at pucRec */
+
+static unsigned short SymTable_recKeyField(const unsigned char *pucRec)
+{
+    unsigned short usKeyField;
+    memcpy(&usKeyField, pucRec + REC_KEYFIELD, sizeof(usKeyField));
+    return usKeyField;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the key of the record at pucRec */
+
+static const char *SymTable_recKey(const unsigned char *pucRec)
+{
+    const char *pcKey;
+
+    if (SymTable_recKeyField(pucRec) != 0)
+        return (const char *)(pucRec + REC_KEY);
+
+    memcpy(&pcKey, pucRec + REC_KEY, sizeof(pcKey));
+    return pcKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the value of the record at pucRec */
+
+static void *SymTable_recValue(const unsigned char *pucRec)
+{
+    void *pvValue;
+    memcpy(&pvValue, pucRec + REC_VALUE, sizeof(pvValue));
+    return pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the size in bytes of the record at pucRec */
+
+static size_t SymTable_recSize(const unsigned char *pucRec)
+{
+    unsigned short usKeyField = SymTable_recKeyField(pucRec);
+
+    if (usKeyField != 0)
+        return REC_KEY + usKeyField;
+    return REC_KEY + sizeof(char *);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Copy the record at pucRec to the end of psPage, which must have room
+for it */
+
+static void SymTable_appendRecord(struct Page *psPage,
+                                  const unsigned char *pucRec)
+{
+    size_t uSize = SymTable_recSize(pucRec);
+
+    assert(psPage->header.usedBytes + uSize <= PAGE_DATA_SIZE);
+
+    memcpy(psPage->data + psPage->header.usedBytes, pucRec, uSize);
+    psPage->header.usedBytes += (unsigned short)uSize;
+    psPage->header.count++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the index of the directory entry of oSymTable for a key
+whose hash code is uiHash */
+
+static size_t SymTable_dirIndex(SymTable_T oSymTable, uint32_t uiHash)
+{
+    return (size_t)uiHash & (((size_t)1 << oSymTable->globalDepth) - 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the offset within psPage of the record whose key is pcKey
+and whose hash code is uiHash, or PAGE_DATA_SIZE if there is none */
+
+static size_t SymTable_findRecord(struct Page *psPage,
+                                  const char *pcKey, uint32_t uiHash)
+{
+    size_t off = 0;
+    const unsigned char *pucRec;
+
+    /* Scan all the records in the page */
+    while (off < psPage->header.usedBytes)
+    {
+        pucRec = psPage->data + off;
+
+        /* Handle condition where binding with pcKey exists */
+        if (SymTable_recHash(pucRec) == uiHash &&
+            strcmp(SymTable_recKey(pucRec), pcKey) == 0)
+            return off;
+
+        /* Otherwise, move on to the next record */
+        off += SymTable_recSize(pucRec);
+    }
+
+    /* Handle condition where no binding with pcKey exists */
+    return PAGE_DATA_SIZE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Split the page of oSymTable referenced by directory entry uIndex
+into two pages that use one more hash bit, doubling the directory if
+needed. Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient
+memory is available or every hash bit is already in use, in which case
+oSymTable is left unchanged */
+
+static int SymTable_split(SymTable_T oSymTable, size_t uIndex)
+{
+    struct Page *psOld = oSymTable->directory[uIndex];
+    struct Page *psNew;
+    struct Page oldCopy;
+    struct Page **newDirectory;
+    size_t depth = psOld->header.localDepth;
+    size_t dirSize, i, off;
+    const unsigned char *pucRec;
+
+    /* Handle case where no hash bit is left to split on */
+    if (depth == MAX_GLOBAL_DEPTH)
+        return 0;
+
+    psNew = calloc(1, sizeof(struct Page));
+    if (psNew == NULL)
+        return 0;
+
+    /* Double the directory if the page uses all of its bits */
+    if (depth == oSymTable->globalDepth)
+    {
+        dirSize = (size_t)1 << oSymTable->globalDepth;
+        newDirectory = realloc(oSymTable->directory,
+                               2 * dirSize * sizeof(struct Page *));
+        if (newDirectory == NULL)
+        {
+            free(psNew);
+            return 0;
+        }
+
+        /* The upper half of the directory mirrors the lower half */
+        for (i = 0; i < dirSize; i++)
+            newDirectory[dirSize + i] = newDirectory[i];
+
+        oSymTable->directory = newDirectory;
+        oSymTable->globalDepth++;
+    }
+
+    /* Redistribute the records of the old page on hash bit depth */
+    oldCopy = *psOld;
+    psOld->header.count = 0;
+    psOld->header.usedBytes = 0;
+    psOld->header.localDepth = (unsigned short)(depth + 1);
+    psNew->header.localDepth = (unsigned short)(depth + 1);
+    for (off = 0; off < oldCopy.header.usedBytes;
+         off += SymTable_recSize(pucRec))
+    {
+        pucRec = oldCopy.data + off;
+        if ((SymTable_recHash(pucRec) >> depth) & 1)
+            SymTable_appendRecord(psNew, pucRec);
+        else
+            SymTable_appendRecord(psOld, pucRec);
+    }
+
+    /* Point the directory entries whose bit depth is set at the new
+    page. They are the entries that share the old page's low bits */
+    dirSize = (size_t)1 << oSymTable->globalDepth;
+    for (i = uIndex & (((size_t)1 << depth) - 1); i < dirSize;
+         i += (size_t)1 << depth)
+    {
+        if ((i >> depth) & 1)
+            oSymTable->directory[i] = psNew;
+    }
+
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+    SymTable_T oSymTable;
+
+    /* Allocate memory for a new symbol table */
+    oSymTable = malloc(sizeof(struct SymTable));
+
+    /* Handle case if allocation of memory to symTable pointer fails */
+    if (oSymTable == NULL)
+    {
+        return NULL;
+    }
+
+    /* Initialize fields for new symbol table, starting with a single
+    page that every key maps to */
+    oSymTable->globalDepth = 0;
+    oSymTable->bindingsCount = 0;
+    oSymTable->directory = malloc(sizeof(struct Page *));
+
+    /* Handle case where allocation of memory for directory fails */
+    if (oSymTable->directory == NULL)
+    {
+        free(oSymTable);
+        return NULL;
+    }
+
+    oSymTable->directory[0] = calloc(1, sizeof(struct Page));
+
+    /* Handle case where allocation of memory for first page fails */
+    if (oSymTable->directory[0] == NULL)
+    {
+        free(oSymTable->directory);
+        free(oSymTable);
+        return NULL;
+    }
+
+    return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    struct Page *psPage;
+    size_t dirSize, i, off;
+    const unsigned char *pucRec;
+
+    assert(oSymTable != NULL);
+
+    dirSize = (size_t)1 << oSymTable->globalDepth;
+    for (i = 0; i < dirSize; i++)
+    {
+        psPage = oSymTable->directory[i];
+
+        /* Visit each page once, through the highest directory entry
+        that refers to it, so no later entry refers to a freed page */
+        if (i + ((size_t)1 << psPage->header.localDepth) < dirSize)
+            continue;
+
+        /* Free the out-of-line key copies in the page */
+        for (off = 0; off < psPage->header.usedBytes;
+             off += SymTable_recSize(pucRec))
+        {
+            pucRec = psPage->data + off;
+            if (SymTable_recKeyField(pucRec) == 0)
+                free((void *)SymTable_recKey(pucRec));
+        }
+
+        /* Free the page */
+        free(psPage);
+    }
+
+    /* Free the directory */
+    free(oSymTable->directory);
+    /* Free the symbol table structure */
+    free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    return oSymTable->bindingsCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable,
+                 const char *pcKey, const void *pvValue)
+{
+    unsigned char aucRec[MAX_INLINE_RECORD];
+    struct Page *psPage;
+    size_t uIndex, uKeyLength, uRecSize;
+    uint32_t uiHash;
+    unsigned short usKeyField;
+    char *keyCopy = NULL;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uiHash = SymTable_hash(pcKey);
+    uIndex = SymTable_dirIndex(oSymTable, uiHash);
+
+    /* Handle condition where binding with pcKey already exists */
+    if (SymTable_findRecord(oSymTable->directory[uIndex], pcKey,
+                            uiHash) != PAGE_DATA_SIZE)
+        return 0;
+
+    /* Build the record, copying the key into it if it fits */
+    uKeyLength = strlen(pcKey);
+    memcpy(aucRec + REC_HASH, &uiHash, sizeof(uiHash));
+    memcpy(aucRec + REC_VALUE, &pvValue, sizeof(pvValue));
+    if (REC_KEY + uKeyLength + 1 <= MAX_INLINE_RECORD)
+    {
+        usKeyField = (unsigned short)(uKeyLength + 1);
+        memcpy(aucRec + REC_KEY, pcKey, uKeyLength + 1);
+    }
+    else
+    {
+        /* Copy the long key string defensively, out of line */
+        keyCopy = malloc(uKeyLength + 1);
+
+        /* Handle condition of insufficient memory for defensive copy
+        of key string */
+        if (keyCopy == NULL)
+            return 0;
+
+        strcpy(keyCopy, pcKey);
+        usKeyField = 0;
+        memcpy(aucRec + REC_KEY, &keyCopy, sizeof(keyCopy));
+    }
+    memcpy(aucRec + REC_KEYFIELD, &usKeyField, sizeof(usKeyField));
+    uRecSize = SymTable_recSize(aucRec);
+
+    /* Split the key's page until it has room for the record */
+    for (;;)
+    {
+        uIndex = SymTable_dirIndex(oSymTable, uiHash);
+        psPage = oSymTable->directory[uIndex];
+        if (psPage->header.usedBytes + uRecSize <= PAGE_DATA_SIZE)
+            break;
+
+        /* Handle condition of insufficient memory for a new page */
+        if (!SymTable_split(oSymTable, uIndex))
+        {
+            free(keyCopy);
+            return 0;
+        }
+    }
+
+    SymTable_appendRecord(psPage, aucRec);
+    oSymTable->bindingsCount++;
+
+    /* Successful insertion*/
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable,
+                       const char *pcKey, const void *pvValue)
+{
+    struct Page *psPage;
+    uint32_t uiHash;
+    size_t off;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uiHash = SymTable_hash(pcKey);
+    psPage = oSymTable->directory[SymTable_dirIndex(oSymTable, uiHash)];
+    off = SymTable_findRecord(psPage, pcKey, uiHash);
+
+    /* Handle condition where no binding with pcKey exists */
+    if (off == PAGE_DATA_SIZE)
+        return NULL;
+
+    /* Save old value, then replace with new value */
+    oldValue = SymTable_recValue(psPage->data + off);
+    memcpy(psPage->data + off + REC_VALUE, &pvValue, sizeof(pvValue));
+    return oldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    uint32_t uiHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uiHash = SymTable_hash(pcKey);
+    return SymTable_findRecord(
+               oSymTable->directory[SymTable_dirIndex(oSymTable, uiHash)],
+               pcKey, uiHash) != PAGE_DATA_SIZE;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    struct Page *psPage;
+    uint32_t uiHash;
+    size_t off;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uiHash = SymTable_hash(pcKey);
+    psPage = oSymTable->directory[SymTable_dirIndex(oSymTable, uiHash)];
+    off = SymTable_findRecord(psPage, pcKey, uiHash);
+
+    /* Handle condition where no binding with pcKey exists */
+    if (off == PAGE_DATA_SIZE)
+        return NULL;
+
+    return SymTable_recValue(psPage->data + off);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    struct Page *psPage;
+    unsigned char *pucRec;
+    uint32_t uiHash;
+    size_t off, uRecSize;
+    void *bindingValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uiHash = SymTable_hash(pcKey);
+    psPage = oSymTable->directory[SymTable_dirIndex(oSymTable, uiHash)];
+    off = SymTable_findRecord(psPage, pcKey, uiHash);
+
+    /* Handle condition where no binding with pcKey exists */
+    if (off == PAGE_DATA_SIZE)
+        return NULL;
+
+    pucRec = psPage->data + off;
+    bindingValue = SymTable_recValue(pucRec);
+    if (SymTable_recKeyField(pucRec) == 0)
+        free((void *)SymTable_recKey(pucRec));
+
+    /* Close the gap left by the record */
+    uRecSize = SymTable_recSize(pucRec);
+    memmove(pucRec, pucRec + uRecSize,
+            psPage->header.usedBytes - off - uRecSize);
+    psPage->header.usedBytes -= (unsigned short)uRecSize;
+    psPage->header.count--;
+
+    oSymTable->bindingsCount--;
+    return bindingValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue,
+                                  void *pvExtra),
+                  const void *pvExtra)
+{
+    struct Page *psPage;
+    size_t dirSize, i, off;
+    const unsigned char *pucRec;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    dirSize = (size_t)1 << oSymTable->globalDepth;
+    for (i = 0; i < dirSize; i++)
+    {
+        psPage = oSymTable->directory[i];
+
+        /* Visit each page once, through the lowest directory entry
+        that refers to it */
+        if (i >> psPage->header.localDepth != 0)
+            continue;
+
+        /* Apply the function on each key/value in the page */
+        for (off = 0; off < psPage->header.usedBytes;
+             off += SymTable_recSize(pucRec))
+        {
+            pucRec = psPage->data + off;
+            (void)(*pfApply)(SymTable_recKey(pucRec),
+                             SymTable_recValue(pucRec),
+                             (void *)pvExtra);
+        }
+    }
+}
@@ -0,0 +1,424 @@
+/*--------------------------------------------------------------------*/
+/* symtablefrozen.c                                                   */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+/* Read-only symbol table with front-coded keys. The keys are sorted
+and split into blocks of BLOCK_SIZE keys. Within a block, each key is
+stored as two variable-length numbers, the length of the prefix it
+shares with the key before it and the length of the rest of the key,
+followed by the bytes of the rest; the first key of a block shares
+nothing, so every block can be decoded on its own. The offsets of the
+blocks form a sparse index that is binary searched on the first key of
+each block. The block is then scanned without rebuilding any key: the
+scan tracks how much of the key being looked up matches the current
+key, and since the keys are sorted, the shared-prefix length of the
+next key alone tells whether it can still match */
+
+#include "symtablefrozen.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Number of keys in each block. Larger blocks save memory in the
+index and in the first keys, smaller blocks shorten the scan */
+enum {BLOCK_SIZE = 16};
+
+/* Each Pair is a binding of the symbol table being frozen */
+struct Pair
+{
+    /* Pointer to the key string, owned by the symbol table */
+    const char *key;
+    /* Pointer to the associated value */
+    const void *value;
+};
+
+/* A Collector gathers the bindings of a symbol table into an array */
+struct Collector
+{
+    /* Array of pairs */
+    struct Pair *pairs;
+    /* Number of pairs gathered so far */
+    size_t count;
+};
+
+/* SymTableFrozen structure represents a frozen table */
+struct SymTableFrozen
+{
+    /* Front-coded keys of every block, one after another */
+    unsigned char *keyBytes;
+    /* Number of bytes of keyBytes */
+    size_t keyBytesCount;
+    /* Offset in keyBytes of the start of each block */
+    size_t *blockOffsets;
+    /* Number of blocks */
+    size_t blockCount;
+    /* Values of the bindings, in increasing order of key */
+    const void **values;
+    /* Stores total number of bindings in SymTableFrozen */
+    size_t bindingsCount;
+    /* Buffer with room for the longest key, used by map */
+    char *keyBuffer;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Add the binding of pcKey to pvValue to pvCollector, a Collector */
+
+static void SymTableFrozen_collect(const char *pcKey, void *pvValue,
+                                   void *pvCollector)
+{
+    struct Collector *psCollector = pvCollector;
+
+    psCollector->pairs[psCollector->count].key = pcKey;
+    psCollector->pairs[psCollector->count].value = pvValue;
+    psCollector->count++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the keys of the Pairs at pvFirst and pvSecond for qsort */
+
+static int SymTableFrozen_comparePairs(const void *pvFirst,
+                                       const void *pvSecond)
+{
+    return strcmp(((const struct Pair *)pvFirst)->key,
+                  ((const struct Pair *)pvSecond)->key);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the length of the longest common prefix of pcFirst and
+pcSecond */
+
+static size_t SymTableFrozen_prefix(const char *pcFirst,
+                                    const char *pcSecond)
+{
+    size_t u;
+
+    for (u = 0; pcFirst[u] != '\0' && pcFirst[u] == pcSecond[u]; u++)
+        ;
+    return u;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of bytes of the variable-length encoding of
+uNumber */
+
+static size_t SymTableFrozen_numberBytes(size_t uNumber)
+{
+    size_t uBytes = 1;
+
+    while (uNumber >= 0x80)
+    {
+        uNumber >>= 7;
+        uBytes++;
+    }
+    return uBytes;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the variable-length encoding of uNumber, seven bits per byte
+with the high bit set on all but the last byte, at pucBuf. Return a
+pointer to the byte after it */
+
+static unsigned char *SymTableFrozen_writeNumber(unsigned char *pucBuf,
+                                                 size_t uNumber)
+{
+    while (uNumber >= 0x80)
+    {
+        *pucBuf++ = (unsigned char)(uNumber | 0x80);
+        uNumber >>= 7;
+    }
+    *pucBuf++ = (unsigned char)uNumber;
+    return pucBuf;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number encoded at *ppucBuf, and advance *ppucBuf past
+it */
+
+static size_t SymTableFrozen_readNumber(const unsigned char **ppucBuf)
+{
+    const unsigned char *pucBuf = *ppucBuf;
+    size_t uNumber = 0;
+    unsigned int uShift = 0;
+
+    while (*pucBuf >= 0x80)
+    {
+        uNumber |= (size_t)(*pucBuf++ & 0x7F) << uShift;
+        uShift += 7;
+    }
+    uNumber |= (size_t)*pucBuf++ << uShift;
+    *ppucBuf = pucBuf;
+    return uNumber;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the uLength bytes at pucBytes with pcKey as strcmp would
+compare them as a string. Return a negative number, zero or a
+positive number */
+
+static int SymTableFrozen_compare(const unsigned char *pucBytes,
+                                  size_t uLength, const char *pcKey)
+{
+    const unsigned char *pucKey = (const unsigned char *)pcKey;
+    size_t u;
+
+    for (u = 0; u < uLength; u++)
+    {
+        if (pucKey[u] != pucBytes[u])
+            return (int)pucBytes[u] - (int)pucKey[u];
+    }
+    return pucKey[uLength] == '\0' ? 0 : -1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the index, in increasing order of key, of the binding of
+oFrozen whose key is pcKey, or bindingsCount if no such binding
+exists */
+
+static size_t SymTableFrozen_find(SymTableFrozen_T oFrozen,
+                                  const char *pcKey)
+{
+    const unsigned char *pucKey = (const unsigned char *)pcKey;
+    const unsigned char *pucBuf;
+    size_t lo, hi, mid, entries;
+    size_t uShared, uRest, uMatched, u, j;
+
+    if (oFrozen->bindingsCount == 0)
+        return 0;
+
+    /* Find the last block whose first key is not greater than pcKey.
+    A first key shares no prefix, so its length follows a zero */
+    lo = 0;
+    hi = oFrozen->blockCount;
+    while (hi - lo > 1)
+    {
+        mid = lo + (hi - lo) / 2;
+        pucBuf = oFrozen->keyBytes + oFrozen->blockOffsets[mid] + 1;
+        uRest = SymTableFrozen_readNumber(&pucBuf);
+        if (SymTableFrozen_compare(pucBuf, uRest, pcKey) <= 0)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    /* Scan the block, keeping in uMatched the length of the prefix
+    of pcKey that the current key matches */
+    entries = oFrozen->bindingsCount - lo * BLOCK_SIZE;
+    if (entries > BLOCK_SIZE)
+        entries = BLOCK_SIZE;
+    pucBuf = oFrozen->keyBytes + oFrozen->blockOffsets[lo];
+    uMatched = 0;
+    for (j = 0; j < entries; j++)
+    {
+        uShared = SymTableFrozen_readNumber(&pucBuf);
+        uRest = SymTableFrozen_readNumber(&pucBuf);
+
+        /* A key that differs from the one before it within the part
+        that matched pcKey is greater than pcKey, as is every key
+        after it */
+        if (uShared < uMatched)
+            return oFrozen->bindingsCount;
+
+        /* A key that agrees with the one before it beyond that part
+        is still less than pcKey */
+        if (uShared > uMatched)
+        {
+            pucBuf += uRest;
+            continue;
+        }
+
+        /* Otherwise compare the rest of the key with pcKey */
+        for (u = 0; u < uRest && pucKey[uMatched + u] == pucBuf[u] &&
+                    pucKey[uMatched + u] != '\0'; u++)
+            ;
+        if (u == uRest && pucKey[uMatched + u] == '\0')
+            return lo * BLOCK_SIZE + j;
+        if (u < uRest && pucKey[uMatched + u] < pucBuf[u])
+            return oFrozen->bindingsCount;
+        uMatched += u;
+        pucBuf += uRest;
+    }
+
+    return oFrozen->bindingsCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTableFrozen_T SymTableFrozen_new(SymTable_T oSymTable)
+{
+    SymTableFrozen_T oFrozen;
+    struct Collector sCollector;
+    unsigned char *pucBuf;
+    size_t uBytes, uMaxLength, uShared, uLength, i;
+
+    assert(oSymTable != NULL);
+
+    /* Gather the bindings and sort them by key */
+    sCollector.count = 0;
+    sCollector.pairs = malloc((SymTable_getLength(oSymTable) + 1) *
+                              sizeof(struct Pair));
+    if (sCollector.pairs == NULL)
+        return NULL;
+    SymTable_map(oSymTable, SymTableFrozen_collect, &sCollector);
+    qsort(sCollector.pairs, sCollector.count, sizeof(struct Pair),
+          SymTableFrozen_comparePairs);
+
+    /* Measure the front-coded keys */
+    uBytes = 0;
+    uMaxLength = 0;
+    for (i = 0; i < sCollector.count; i++)
+    {
+        uLength = strlen(sCollector.pairs[i].key);
+        if (uLength > uMaxLength)
+            uMaxLength = uLength;
+        uShared = 0;
+        if (i % BLOCK_SIZE != 0)
+            uShared = SymTableFrozen_prefix(sCollector.pairs[i - 1].key,
+                                            sCollector.pairs[i].key);
+        uBytes += SymTableFrozen_numberBytes(uShared) +
+                  SymTableFrozen_numberBytes(uLength - uShared) +
+                  (uLength - uShared);
+    }
+
+    /* Allocate memory for the frozen table */
+    oFrozen = malloc(sizeof(struct SymTableFrozen));
+    if (oFrozen == NULL)
+    {
+        free(sCollector.pairs);
+        return NULL;
+    }
+    oFrozen->bindingsCount = sCollector.count;
+    oFrozen->keyBytesCount = uBytes;
+    oFrozen->blockCount = (sCollector.count + BLOCK_SIZE - 1) /
+                          BLOCK_SIZE;
+    oFrozen->keyBytes = malloc(uBytes + 1);
+    oFrozen->blockOffsets = malloc((oFrozen->blockCount + 1) *
+                                   sizeof(size_t));
+    oFrozen->values = malloc((sCollector.count + 1) *
+                             sizeof(const void *));
+    oFrozen->keyBuffer = malloc(uMaxLength + 1);
+    if (oFrozen->keyBytes == NULL || oFrozen->blockOffsets == NULL ||
+        oFrozen->values == NULL || oFrozen->keyBuffer == NULL)
+    {
+        free(sCollector.pairs);
+        SymTableFrozen_free(oFrozen);
+        return NULL;
+    }
+
+    /* Write the front-coded keys and the values */
+    pucBuf = oFrozen->keyBytes;
+    for (i = 0; i < sCollector.count; i++)
+    {
+        uShared = 0;
+        if (i % BLOCK_SIZE == 0)
+            oFrozen->blockOffsets[i / BLOCK_SIZE] =
+                (size_t)(pucBuf - oFrozen->keyBytes);
+        else
+            uShared = SymTableFrozen_prefix(sCollector.pairs[i - 1].key,
+                                            sCollector.pairs[i].key);
+        uLength = strlen(sCollector.pairs[i].key);
+        pucBuf = SymTableFrozen_writeNumber(pucBuf, uShared);
+        pucBuf = SymTableFrozen_writeNumber(pucBuf, uLength - uShared);
+        memcpy(pucBuf, sCollector.pairs[i].key + uShared,
+               uLength - uShared);
+        pucBuf += uLength - uShared;
+        oFrozen->values[i] = sCollector.pairs[i].value;
+    }
+    assert((size_t)(pucBuf - oFrozen->keyBytes) == uBytes);
+
+    free(sCollector.pairs);
+    return oFrozen;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTableFrozen_free(SymTableFrozen_T oFrozen)
+{
+    assert(oFrozen != NULL);
+
+    free(oFrozen->keyBytes);
+    free(oFrozen->blockOffsets);
+    free(oFrozen->values);
+    free(oFrozen->keyBuffer);
+    free(oFrozen);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTableFrozen_getLength(SymTableFrozen_T oFrozen)
+{
+    assert(oFrozen != NULL);
+    return oFrozen->bindingsCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTableFrozen_getKeyBytes(SymTableFrozen_T oFrozen)
+{
+    assert(oFrozen != NULL);
+    return oFrozen->keyBytesCount +
+           oFrozen->blockCount * sizeof(size_t);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableFrozen_contains(SymTableFrozen_T oFrozen,
+                            const char *pcKey)
+{
+    assert(oFrozen != NULL);
+    assert(pcKey != NULL);
+
+    return SymTableFrozen_find(oFrozen, pcKey) !=
+           oFrozen->bindingsCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTableFrozen_get(SymTableFrozen_T oFrozen, const char *pcKey)
+{
+    size_t i;
+
+    assert(oFrozen != NULL);
+    assert(pcKey != NULL);
+
+    i = SymTableFrozen_find(oFrozen, pcKey);
+    if (i == oFrozen->bindingsCount)
+        return NULL;
+    return (void *)oFrozen->values[i];
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTableFrozen_map(SymTableFrozen_T oFrozen,
+                        void (*pfApply)(const char *pcKey,
+                                        void *pvValue, void *pvExtra),
+                        const void *pvExtra)
+{
+    const unsigned char *pucBuf;
+    size_t uShared, uRest, i;
+
+    assert(oFrozen != NULL);
+    assert(pfApply != NULL);
+
+    /* Rebuild each key in the buffer from the key before it */
+    pucBuf = oFrozen->keyBytes;
+    for (i = 0; i < oFrozen->bindingsCount; i++)
+    {
+        uShared = SymTableFrozen_readNumber(&pucBuf);
+        uRest = SymTableFrozen_readNumber(&pucBuf);
+        memcpy(oFrozen->keyBuffer + uShared, pucBuf, uRest);
+        oFrozen->keyBuffer[uShared + uRest] = '\0';
+        pucBuf += uRest;
+
+        (*pfApply)(oFrozen->keyBuffer, (void *)oFrozen->values[i],
+                   (void *)pvExtra);
+    }
+}
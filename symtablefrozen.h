@@ -0,0 +1,71 @@
+/*--------------------------------------------------------------------*/
+/* symtablefrozen.h                                                   */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+# ifndef SYMTABLEFROZEN
+# define SYMTABLEFROZEN
+
+#include "symtable.h"
+
+/*
+A SymTableFrozen_T is a pointer to a read-only copy of the bindings of
+a symbol table. Its keys are sorted and front coded: each is stored as
+the length of the prefix it shares with the key before it and the
+bytes that follow, in blocks whose first keys form a sparse index. A
+lookup searches the index and then scans one block. Keys that share
+long prefixes therefore take a fraction of the memory of one copy per
+key, at the cost of a little more work per lookup. Values are the
+void* values of the symbol table, still owned by the caller.
+*/
+typedef struct SymTableFrozen *SymTableFrozen_T;
+
+/*--------------------------------------------------------------------*/
+/* Return a new SymTableFrozen object holding a copy of every binding
+of oSymTable as it is now, or NULL if insufficient memory is
+available. Later changes to oSymTable do not affect the copy */
+
+SymTableFrozen_T SymTableFrozen_new(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+/* Free all memory occupied by oFrozen */
+
+void SymTableFrozen_free(SymTableFrozen_T oFrozen);
+
+/*--------------------------------------------------------------------*/
+/* Return the number of bindings in oFrozen */
+
+size_t SymTableFrozen_getLength(SymTableFrozen_T oFrozen);
+
+/*--------------------------------------------------------------------*/
+/* Return the number of bytes that oFrozen uses to store its keys,
+including its index */
+
+size_t SymTableFrozen_getKeyBytes(SymTableFrozen_T oFrozen);
+
+/*--------------------------------------------------------------------*/
+/* Return 1 (TRUE) if oFrozen contains a binding whose key is pcKey,
+and 0 (FALSE) otherwise */
+
+int SymTableFrozen_contains(SymTableFrozen_T oFrozen,
+                            const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* Return the value of the binding within oFrozen whose key is pcKey,
+or NULL if no such binding exists */
+
+void *SymTableFrozen_get(SymTableFrozen_T oFrozen, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* Apply function *pfApply to each binding in oFrozen, in increasing
+order of key, passing pvExtra as an extra parameter. The key passed
+to *pfApply is valid only until it returns. Unlike the lookup
+functions, SymTableFrozen_map must not be called by two threads at
+once for the same oFrozen */
+
+void SymTableFrozen_map(SymTableFrozen_T oFrozen,
+                        void (*pfApply)(const char *pcKey,
+                                        void *pvValue, void *pvExtra),
+                        const void *pvExtra);
+
+# endif
@@ -8,18 +8,46 @@ keys to void* values. Each key is stored with defensive copy to
 ensure ownership by symbol table. Collisions handled via separate
 chaining with linked lists within each bucket. When symbol table
 becomes full, resizes and rehashes all bindings into a larger bucket
-array if there is sufficient memory */
-
-#include "symtable.h"
+array if there is sufficient memory. Each binding also owns a slot in
+a dense array, so that a handle made of a slot index and the slot's
+generation, which changes whenever the slot is freed, names the
+binding for as long as it exists. A table made by SymTable_recover
+also appends each update to a write-ahead log. A table made by
+SymTable_newWithKeys takes its key copies from a shared SymTableKeys
+store instead of copying each key itself. SymTable_buildParallel
+fills a new table from arrays of keys and values on several threads,
+each of which owns a range of the bucket array. After
+SymTable_setRehashThreads, the rehash of a large table is likewise
+split across threads by ranges of old buckets. SymTable_freeAsync
+leaves freeing a table to a detached thread. SymTable_clear keeps
+the bucket array and puts the removed bindings, with their key copies,
+on a free list from which later insertions take them */
+
+#define _XOPEN_SOURCE 700
+
+#include "symtablehash.h"
+#include "symtablehashcode.h"
+#include "symtablekeys.h"
+#include "symtablelog.h"
 #include <assert.h>
+#include <errno.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 /* List of prime numbers used for hash table sizes. Each number
 represents number of buckets for particular binding counts. When hash
 table grows, moves to the next prime count */
 static const size_t BUCKET_COUNTS[] = {509, 1021, 2039, 4093, 8191,
-                                       16381, 32749, 65521};
+                                       16381, 32749, 65521, 131071,
+                                       262139, 524287, 1048573,
+                                       2097143, 4194301, 8388593,
+                                       16777213, 33554393, 67108859,
+                                       134217689, 268435399,
+                                       536870909, 1073741789,
+                                       2147483647};
 
 /* Number of hash table sizes */
 static const size_t BUCKET_COUNTS_LEN =
@@ -28,14 +56,35 @@ static const size_t BUCKET_COUNTS_LEN =
 /* Each Binding represents a key-value pair in hash table bucket */
 struct Binding
 {
-    /* Pointer to the key string (defensive copy) */
+    /* Pointer to the key string (defensive copy, or string of the
+    shared key store) */
     const char *key;
     /* Pointer to the associated value */
     const void *value;
     /* Pointer to next binding in bucket chain */
     struct Binding *next;
+    /* Hash code of the key, before reduction to a bucket index */
+    size_t hash;
+    /* Index of the slot of the binding */
+    size_t slot;
+    /* Number of bytes the defensive copy of the key has room for */
+    size_t keyCapacity;
+};
+
+/* Each Slot names a binding, or is free */
+struct Slot
+{
+    /* Binding named by the slot, or NULL if the slot is free */
+    struct Binding *binding;
+    /* Generation of the slot, which changes whenever it is freed */
+    size_t generation;
+    /* Index of the next free slot if the slot is free */
+    size_t nextFree;
 };
 
+/* Index that names no slot */
+static const size_t NO_SLOT = (size_t)-1;
+
 /* SymTable structure represents overall hash table */
 struct SymTable
 {
@@ -45,8 +94,118 @@ struct SymTable
     size_t bindingsCount;
     /* Stores index into BUCKET_COUNTS array */
     size_t bucketSizeIndex;
+    /* Log of updates, or NULL if updates are not logged */
+    SymTableLog_T log;
+    /* Array of slots, the number in use or free, and the number
+    allocated */
+    struct Slot *slots;
+    size_t slotsCount;
+    size_t slotsCapacity;
+    /* Index of the first free slot, or NO_SLOT */
+    size_t freeSlot;
+    /* Shared store of key strings, or NULL if the table copies its
+    keys itself */
+    SymTableKeys_T keys;
+    /* Number of threads that share a rehash of a large table */
+    size_t rehashThreads;
+    /* Bindings removed by SymTable_clear, chained through next, each
+    keeping its key copy unless the table has a shared store */
+    struct Binding *freeBindings;
+    /* Saves started by SymTable_saveAsync that have not finished,
+    chained through next */
+    SymTableSave_T saves;
 };
 
+/* Greatest number of threads used by SymTable_buildParallel or by
+one rehash */
+enum {MAX_WORKER_THREADS = 64};
+
+/* Least number of bindings for which a rehash is split across
+threads */
+enum {PARALLEL_REHASH_MIN = 65536};
+
+/* A RehashWorker is one thread of a parallel rehash, which moves the
+bindings of a range of old buckets into the new bucket array */
+struct RehashWorker
+{
+    /* Old buckets begin to end-1 are the range of the worker */
+    struct Binding **oldBuckets;
+    size_t begin;
+    size_t end;
+    /* The new bucket array, shared by every worker, and its size */
+    struct Binding **newBuckets;
+    size_t newBucketCount;
+};
+
+/* A Build is the work shared by the threads of SymTable_buildParallel.
+Thread t first hashes the keys of slice t of the input and counts how
+many fall in each partition of the bucket array; then lists the
+indices of those keys by partition in order, so that the keys of
+partition p occupy positions begin to end of the order array in input
+order; and finally inserts the keys of partition p = t */
+struct Build
+{
+    /* The table being built */
+    SymTable_T table;
+    /* The input arrays and their length */
+    const char *const *keys;
+    const void *const *values;
+    size_t count;
+    /* Number of threads, which is also the number of partitions */
+    size_t threadCount;
+    /* Hash code of each key */
+    size_t *hashes;
+    /* Indices of the keys, grouped by partition */
+    size_t *order;
+    /* Number of keys of slice t in partition p at [t * threadCount +
+    p], and later the position in order of the next of them */
+    size_t *offsets;
+};
+
+/* A BuildWorker is one thread of SymTable_buildParallel */
+struct BuildWorker
+{
+    /* The shared work */
+    struct Build *build;
+    /* Index of the thread, of its slice and of its partition */
+    size_t index;
+    /* Positions in order of the keys of the partition */
+    size_t begin;
+    size_t end;
+    /* Number of bindings made, and first and last free slot left by
+    duplicate keys, or NO_SLOT */
+    size_t bindingsCount;
+    size_t freeHead;
+    size_t freeTail;
+    /* 1 (TRUE) if insufficient memory was available */
+    int failed;
+};
+
+/* SymTableSave structure tracks a child process writing a snapshot */
+struct SymTableSave
+{
+    /* Process ID of the child */
+    pid_t pid;
+    /* 1 (TRUE) once the child has exited */
+    int finished;
+    /* 1 (TRUE) if the child wrote the snapshot */
+    int successful;
+    /* Table whose snapshot is being written, or NULL once the save is
+    finished or the table is freed */
+    SymTable_T table;
+    /* Next unfinished save of the same table */
+    struct SymTableSave *next;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a hash code for pcKey, not yet reduced to a bucket index */
+
+static size_t SymTable_hashCode(const char *pcKey)
+{
+    return (size_t)SymTableHashCode_string(pcKey, NULL);
+}
+
 /*--------------------------------------------------------------------*/
 
 /* Return a hash code for pcKey that is between 0 and uBucketCount-1,
@@ -54,16 +213,113 @@ inclusive. */
 
 static size_t SymTable_hash(const char *pcKey, size_t uBucketCount)
 {
-    const size_t HASH_MULTIPLIER = 65599;
-    size_t u;
-    size_t uHash = 0;
+    return SymTable_hashCode(pcKey) % uBucketCount;
+}
 
-    assert(pcKey != NULL);
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if pcBound, the key of a binding, equals pcKey, or
+0 (FALSE) otherwise. A key taken from the same shared store as
+pcBound is equal to it exactly when it is the same string, which is
+checked first */
+
+static int SymTable_keyEquals(const char *pcBound, const char *pcKey)
+{
+    return pcBound == pcKey || strcmp(pcBound, pcKey) == 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a copy of pcKey owned by oSymTable, taken from its shared
+store if it has one, or NULL if insufficient memory is available */
+
+static const char *SymTable_copyKey(SymTable_T oSymTable,
+                                    const char *pcKey)
+{
+    char *keyCopy;
+
+    if (oSymTable->keys != NULL)
+        return SymTableKeys_intern(oSymTable->keys, pcKey);
+
+    keyCopy = malloc(strlen(pcKey) + 1);
+    if (keyCopy == NULL)
+        return NULL;
+    strcpy(keyCopy, pcKey);
+    return keyCopy;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free pcKey, a copy made by SymTable_copyKey for oSymTable */
+
+static void SymTable_freeKey(SymTable_T oSymTable, const char *pcKey)
+{
+    if (oSymTable->keys != NULL)
+        SymTableKeys_release(oSymTable->keys, pcKey);
+    else
+        free((void *)pcKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run *pfRun on each of the uWorkerCount workers of pvWorkers, an
+array of workers of uWorkerSize bytes each, at once, the first on the
+calling thread, and wait for them all. A worker whose thread cannot be
+started runs on the calling thread */
+
+static void SymTable_runWorkers(void *pvWorkers, size_t uWorkerSize,
+                                size_t uWorkerCount,
+                                void *(*pfRun)(void *))
+{
+    pthread_t aThreads[MAX_WORKER_THREADS];
+    int aiStarted[MAX_WORKER_THREADS];
+    char *pcWorkers = pvWorkers;
+    size_t t;
+
+    assert(uWorkerCount <= MAX_WORKER_THREADS);
+
+    for (t = 1; t < uWorkerCount; t++)
+        aiStarted[t] = pthread_create(&aThreads[t], NULL, pfRun,
+                                      pcWorkers + t * uWorkerSize) == 0;
+    (void)(*pfRun)(pcWorkers);
+    for (t = 1; t < uWorkerCount; t++)
+    {
+        if (aiStarted[t])
+            (void)pthread_join(aThreads[t], NULL);
+        else
+            (void)(*pfRun)(pcWorkers + t * uWorkerSize);
+    }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Move the bindings of the old buckets of pvWorker, a RehashWorker,
+to the front of their chains in the new bucket array. Other workers
+push onto the same chains, so each push is a compare-and-swap */
 
-    for (u = 0; pcKey[u] != '\0'; u++)
-        uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+static void *SymTable_rehashRange(void *pvWorker)
+{
+    struct RehashWorker *psWorker = pvWorker;
+    struct Binding *curr, *next, *head;
+    struct Binding **link;
+    size_t i;
 
-    return uHash % uBucketCount;
+    for (i = psWorker->begin; i < psWorker->end; i++)
+    {
+        for (curr = psWorker->oldBuckets[i]; curr != NULL; curr = next)
+        {
+            next = curr->next;
+            link = &psWorker->newBuckets[curr->hash %
+                                         psWorker->newBucketCount];
+            head = __atomic_load_n(link, __ATOMIC_RELAXED);
+            do
+                curr->next = head;
+            while (!__atomic_compare_exchange_n(link, &head, curr, 1,
+                                                __ATOMIC_RELAXED,
+                                                __ATOMIC_RELAXED));
+        }
+    }
+    return NULL;
 }
 
 /*--------------------------------------------------------------------*/
@@ -71,15 +327,17 @@ static size_t SymTable_hash(const char *pcKey, size_t uBucketCount)
 /* Expand oSymTable to the next bucket size if adding one more
 binding would make the load factor exceed 1, provided it is not 
 already at its maximum size and memory for a new bucket array is 
-available */
+available. A large table is rehashed by oSymTable->rehashThreads
+threads */
 
 static void SymTable_tryExpand(SymTable_T oSymTable) {
 
     struct Binding *curr, *next;
     struct Binding **newBuckets;
+    struct RehashWorker asWorkers[MAX_WORKER_THREADS];
     size_t curBucketCount, newBucketCount;
     size_t newBucketSizeIndex, hashSlot;
-    size_t i;
+    size_t i, uThreadCount;
 
     /* Handle case where symbol table is already at its maximum size */
     if (oSymTable->bucketSizeIndex >= BUCKET_COUNTS_LEN - 1) return;
@@ -94,26 +352,45 @@ static void SymTable_tryExpand(SymTable_T oSymTable) {
     newBuckets = calloc(newBucketCount, sizeof(struct Binding *));
     if(newBuckets == NULL) return; 
 
-    /* Rehash all existing bindings into new buckets array */
-    for (i = 0; i < curBucketCount; i++) {
+    /* Split the old buckets evenly across threads if the table is
+    large enough to be worth it */
+    uThreadCount = oSymTable->rehashThreads;
+    if (uThreadCount > 1 &&
+        oSymTable->bindingsCount >= PARALLEL_REHASH_MIN)
+    {
+        for (i = 0; i < uThreadCount; i++)
+        {
+            asWorkers[i].oldBuckets = oSymTable->buckets;
+            asWorkers[i].begin = curBucketCount * i / uThreadCount;
+            asWorkers[i].end = curBucketCount * (i + 1) / uThreadCount;
+            asWorkers[i].newBuckets = newBuckets;
+            asWorkers[i].newBucketCount = newBucketCount;
+        }
+        SymTable_runWorkers(asWorkers, sizeof(struct RehashWorker),
+                            uThreadCount, SymTable_rehashRange);
+    }
+    else
+    {
+        /* Rehash all existing bindings into new buckets array */
+        for (i = 0; i < curBucketCount; i++) {
         
-        /* Initialize curr to first binding in bucket */
-        curr = oSymTable->buckets[i];
+            /* Initialize curr to first binding in bucket */
+            curr = oSymTable->buckets[i];
         
-        /* Traverse through all the bindings in hash bucket */
-        while (curr != NULL)
-        {
-            next = curr->next;
+            /* Traverse through all the bindings in hash bucket */
+            while (curr != NULL)
+            {
+                next = curr->next;
 
-            /* Computes new hash key */
-            hashSlot = SymTable_hash(curr->key,
-                                            newBucketCount);
+                /* Computes new hash key from the saved hash code */
+                hashSlot = curr->hash % newBucketCount;
 
-            /* Insert binding at the front of new bucket */
-            curr->next = newBuckets[hashSlot];
-            newBuckets[hashSlot] = curr;
+                /* Insert binding at the front of new bucket */
+                curr->next = newBuckets[hashSlot];
+                newBuckets[hashSlot] = curr;
 
-            curr = next;
+                curr = next;
+            }
         }
     }
 
@@ -126,6 +403,132 @@ static void SymTable_tryExpand(SymTable_T oSymTable) {
 
 /*--------------------------------------------------------------------*/
 
+/* Return a binding for oSymTable whose key is a copy of pcKey, taken
+from the free bindings of oSymTable if there are any, or NULL if
+insufficient memory is available. The key copy of a free binding is
+reused if pcKey fits in it */
+
+static struct Binding *SymTable_takeBinding(SymTable_T oSymTable,
+                                            const char *pcKey)
+{
+    struct Binding *psBinding;
+
+    /* Take a free binding, or allocate one */
+    psBinding = oSymTable->freeBindings;
+    if (psBinding != NULL)
+        oSymTable->freeBindings = psBinding->next;
+    else
+    {
+        psBinding = malloc(sizeof(struct Binding));
+        if (psBinding == NULL)
+            return NULL;
+        psBinding->key = NULL;
+    }
+
+    /* Overwrite the old key copy if it is long enough. Its capacity,
+    rather than the length of the key last stored in it, decides, so
+    that a short key does not shrink it for the keys after */
+    if (psBinding->key != NULL)
+    {
+        if (psBinding->keyCapacity > strlen(pcKey))
+        {
+            strcpy((char *)psBinding->key, pcKey);
+            return psBinding;
+        }
+        SymTable_freeKey(oSymTable, psBinding->key);
+    }
+
+    /* Otherwise make a new one */
+    psBinding->key = SymTable_copyKey(oSymTable, pcKey);
+    if (psBinding->key == NULL)
+    {
+        free(psBinding);
+        return NULL;
+    }
+    psBinding->keyCapacity = strlen(pcKey) + 1;
+    return psBinding;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Give psBinding, a binding of oSymTable, a slot. Return 1 (TRUE) if
+successful, or 0 (FALSE) if insufficient memory is available */
+
+static int SymTable_takeSlot(SymTable_T oSymTable,
+                             struct Binding *psBinding)
+{
+    struct Slot *newSlots;
+    size_t newCapacity;
+    size_t slot;
+
+    /* Reuse a free slot if there is one */
+    slot = oSymTable->freeSlot;
+    if (slot != NO_SLOT)
+        oSymTable->freeSlot = oSymTable->slots[slot].nextFree;
+    else
+    {
+        /* Otherwise grow the array of slots if it is full */
+        if (oSymTable->slotsCount == oSymTable->slotsCapacity)
+        {
+            newCapacity = oSymTable->slotsCapacity > 0
+                              ? oSymTable->slotsCapacity * 2
+                              : BUCKET_COUNTS[0];
+            newSlots = realloc(oSymTable->slots,
+                               newCapacity * sizeof(struct Slot));
+            if (newSlots == NULL)
+                return 0;
+            oSymTable->slots = newSlots;
+            oSymTable->slotsCapacity = newCapacity;
+        }
+
+        /* Generations start at 1 so that a zeroed handle is invalid */
+        slot = oSymTable->slotsCount++;
+        oSymTable->slots[slot].generation = 1;
+    }
+
+    oSymTable->slots[slot].binding = psBinding;
+    psBinding->slot = slot;
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the slot of psBinding, a binding of oSymTable, invalidating
+every handle to it */
+
+static void SymTable_releaseSlot(SymTable_T oSymTable,
+                                 struct Binding *psBinding)
+{
+    struct Slot *psSlot = &oSymTable->slots[psBinding->slot];
+
+    psSlot->binding = NULL;
+    psSlot->generation++;
+    if (psSlot->generation == 0)
+        psSlot->generation = 1;
+    psSlot->nextFree = oSymTable->freeSlot;
+    oSymTable->freeSlot = psBinding->slot;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the binding of oSymTable named by sHandle, or NULL if the
+handle is not valid */
+
+static struct Binding *SymTable_resolve(SymTable_T oSymTable,
+                                        SymTable_Handle sHandle)
+{
+    struct Slot *psSlot;
+
+    if (sHandle.index >= oSymTable->slotsCount)
+        return NULL;
+    psSlot = &oSymTable->slots[sHandle.index];
+    if (psSlot->generation != sHandle.generation)
+        return NULL;
+    return psSlot->binding;
+}
+
+/*--------------------------------------------------------------------*/
+
 SymTable_T SymTable_new(void)
 {
     SymTable_T oSymTable;
@@ -142,6 +545,15 @@ SymTable_T SymTable_new(void)
     /* Initialize fields for new symbol table */
     oSymTable->bucketSizeIndex = 0;
     oSymTable->bindingsCount = 0;
+    oSymTable->log = NULL;
+    oSymTable->slots = NULL;
+    oSymTable->slotsCount = 0;
+    oSymTable->slotsCapacity = 0;
+    oSymTable->freeSlot = NO_SLOT;
+    oSymTable->keys = NULL;
+    oSymTable->rehashThreads = 1;
+    oSymTable->freeBindings = NULL;
+    oSymTable->saves = NULL;
     oSymTable->buckets = calloc(BUCKET_COUNTS
                                     [oSymTable->bucketSizeIndex],
                                 sizeof(struct Binding *));
@@ -159,6 +571,49 @@ SymTable_T SymTable_new(void)
 
 /*--------------------------------------------------------------------*/
 
+SymTable_T SymTable_newWithKeys(SymTableKeys_T oKeys)
+{
+    SymTable_T oSymTable;
+
+    assert(oKeys != NULL);
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL)
+        return NULL;
+    oSymTable->keys = oKeys;
+    return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_setRehashThreads(SymTable_T oSymTable,
+                               size_t uThreadCount)
+{
+    assert(oSymTable != NULL);
+
+    if (uThreadCount > MAX_WORKER_THREADS)
+        uThreadCount = MAX_WORKER_THREADS;
+    if (uThreadCount == 0)
+        uThreadCount = 1;
+    oSymTable->rehashThreads = uThreadCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Let the unfinished saves of oSymTable outlive it. Each can still be
+waited for, but is no longer tied to the table */
+
+static void SymTable_detachSaves(SymTable_T oSymTable)
+{
+    SymTableSave_T oSave;
+
+    for (oSave = oSymTable->saves; oSave != NULL; oSave = oSave->next)
+        oSave->table = NULL;
+    oSymTable->saves = NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
 void SymTable_free(SymTable_T oSymTable)
 {
     size_t i;
@@ -180,7 +635,7 @@ void SymTable_free(SymTable_T oSymTable)
             next = curr->next;
 
             /* Free the key copy */
-            free(((void *)curr->key));
+            SymTable_freeKey(oSymTable, curr->key);
             /* Free the current binding node */
             free(curr);
 
@@ -189,14 +644,115 @@ void SymTable_free(SymTable_T oSymTable)
         }
     }
 
-    /* Free the bucket array */
+    /* Free the bindings left by SymTable_clear */
+    for (curr = oSymTable->freeBindings; curr != NULL; curr = next)
+    {
+        next = curr->next;
+        if (curr->key != NULL)
+            SymTable_freeKey(oSymTable, curr->key);
+        free(curr);
+    }
+
+    /* Force outstanding log records to disk and close the log */
+    if (oSymTable->log != NULL)
+        SymTableLog_free(oSymTable->log);
+    SymTable_detachSaves(oSymTable);
+
+    /* Free the bucket array and the slot array */
     free(oSymTable->buckets);
+    free(oSymTable->slots);
     /* Free the symbol table structure */
     free(oSymTable);
 }
 
 /*--------------------------------------------------------------------*/
 
+/* Free pvSymTable, a SymTable, on a background thread */
+
+static void *SymTable_reclaim(void *pvSymTable)
+{
+    SymTable_free(pvSymTable);
+    return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_freeAsync(SymTable_T oSymTable)
+{
+    pthread_attr_t sAttr;
+    pthread_t thread;
+    int iStarted = 0;
+
+    assert(oSymTable != NULL);
+
+    /* Close the log now, so that its files may be reopened as soon as
+    this returns, and let the caller wait for its saves meanwhile */
+    if (oSymTable->log != NULL)
+    {
+        SymTableLog_free(oSymTable->log);
+        oSymTable->log = NULL;
+    }
+    SymTable_detachSaves(oSymTable);
+
+    /* Free the rest on a detached thread, unless the keys belong to a
+    shared store, which only the caller's thread may update */
+    if (oSymTable->keys == NULL && pthread_attr_init(&sAttr) == 0)
+    {
+        iStarted =
+            pthread_attr_setdetachstate(&sAttr,
+                                        PTHREAD_CREATE_DETACHED) == 0 &&
+            pthread_create(&thread, &sAttr, SymTable_reclaim,
+                           oSymTable) == 0;
+        (void)pthread_attr_destroy(&sAttr);
+    }
+
+    /* Otherwise free it on this thread */
+    if (!iStarted)
+        SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_clear(SymTable_T oSymTable)
+{
+    size_t i;
+    struct Binding *curr;
+    struct Binding *next;
+
+    assert(oSymTable != NULL);
+
+    /* Move every binding in every bucket to the free bindings */
+    for (i = 0; i < BUCKET_COUNTS[oSymTable->bucketSizeIndex]; i++)
+    {
+        for (curr = oSymTable->buckets[i]; curr != NULL; curr = next)
+        {
+            next = curr->next;
+
+            /* Log the removal and invalidate every handle to it */
+            if (oSymTable->log != NULL)
+                (void)SymTableLog_append(oSymTable->log,
+                                         SYMTABLELOG_REMOVE,
+                                         curr->key, NULL);
+            SymTable_releaseSlot(oSymTable, curr);
+
+            /* A key from a shared store goes back to the store */
+            if (oSymTable->keys != NULL)
+            {
+                SymTableKeys_release(oSymTable->keys, curr->key);
+                curr->key = NULL;
+            }
+
+            curr->next = oSymTable->freeBindings;
+            oSymTable->freeBindings = curr;
+        }
+        oSymTable->buckets[i] = NULL;
+    }
+
+    oSymTable->bindingsCount = 0;
+}
+
+/*--------------------------------------------------------------------*/
+
 size_t SymTable_getLength(SymTable_T oSymTable)
 {
     assert(oSymTable != NULL);
@@ -210,22 +766,21 @@ int SymTable_put(SymTable_T oSymTable,
 {
 
     struct Binding *curr, *newBinding;
-    size_t bucketIndex, curBucketCount;
-    char *keyCopy;
+    size_t bucketIndex, curBucketCount, hashCode;
 
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
 
     /* Compute the current bucket index for pcKey */
-    bucketIndex = SymTable_hash(pcKey,
-    BUCKET_COUNTS[oSymTable->bucketSizeIndex]);
+    hashCode = SymTable_hashCode(pcKey);
+    bucketIndex = hashCode % BUCKET_COUNTS[oSymTable->bucketSizeIndex];
 
     /* Traverse through all bindings to check if key already exists */
     curr = oSymTable->buckets[bucketIndex];
     while (curr != NULL)
     {
         /* Handle condition where binding with pcKey already exists */
-        if (strcmp(curr->key, pcKey) == 0)
+        if (SymTable_keyEquals(curr->key, pcKey))
             return 0;
 
         /* Otherwise, move on to the next binding */
@@ -241,38 +796,37 @@ int SymTable_put(SymTable_T oSymTable,
     }
 
     /* Compute bucket index again in case symbol table was resized */
-    bucketIndex = SymTable_hash(pcKey,
-    BUCKET_COUNTS[oSymTable->bucketSizeIndex]);
+    bucketIndex = hashCode % BUCKET_COUNTS[oSymTable->bucketSizeIndex];
 
-    /* Allocate memory for new binding */
-    newBinding = malloc(sizeof(struct Binding));
+    /* Get a binding holding a defensive copy of the key string */
+    newBinding = SymTable_takeBinding(oSymTable, pcKey);
 
-    /* Handle condition of insufficient memory for new binding */
+    /* Handle condition of insufficient memory for new binding or
+    for defensive copy of key string */
     if (newBinding == NULL)
         return 0;
 
-    /* Copy the key string defensively */
-    keyCopy = malloc(strlen(pcKey) + 1);
-
-    /* Handle condition of insufficient memory for defensive copy
-    of key string */
-    if (keyCopy == NULL)
+    /* Handle condition of insufficient memory for a slot */
+    if (!SymTable_takeSlot(oSymTable, newBinding))
     {
+        SymTable_freeKey(oSymTable, newBinding->key);
         free(newBinding);
         return 0;
     }
 
-    /* Copy string into newly allocated memory */
-    strcpy(keyCopy, pcKey);
-
     /* Insert new binding at the front of the bucket chain */
-    newBinding->key = keyCopy;
     newBinding->value = pvValue;
+    newBinding->hash = hashCode;
     newBinding->next = oSymTable->buckets[bucketIndex];
     oSymTable->buckets[bucketIndex] = newBinding;
 
     oSymTable->bindingsCount++;
 
+    /* Log the insertion; a failure is reported by SymTable_sync */
+    if (oSymTable->log != NULL)
+        (void)SymTableLog_append(oSymTable->log, SYMTABLELOG_SET,
+                                 pcKey, pvValue);
+
     /* Successful insertion*/
     return 1;
 }
@@ -299,12 +853,17 @@ void *SymTable_replace(SymTable_T oSymTable,
     while (curr != NULL)
     {
         /* Handle condition where binding with pcKey exists */
-        if (strcmp(curr->key, pcKey) == 0)
+        if (SymTable_keyEquals(curr->key, pcKey))
         {
             /* Save old value */
             void *oldValue = (void *)curr->value;
             /* Replace with new value */
             curr->value = pvValue;
+            /* Log the replacement */
+            if (oSymTable->log != NULL)
+                (void)SymTableLog_append(oSymTable->log,
+                                         SYMTABLELOG_SET, pcKey,
+                                         pvValue);
             /* Return previous old value */
             return oldValue;
         }
@@ -339,7 +898,7 @@ int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
     while (curr != NULL)
     {
         /* Handle condition where binding with pcKey exists */
-        if (strcmp(curr->key, pcKey) == 0)
+        if (SymTable_keyEquals(curr->key, pcKey))
             return 1;
 
         /* Otherwise, move on to the next binding */
@@ -372,7 +931,7 @@ void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
     while (curr != NULL)
     {
         /* Handle condition where binding with pcKey exists */
-        if (strcmp(curr->key, pcKey) == 0)
+        if (SymTable_keyEquals(curr->key, pcKey))
             return (void *)curr->value;
             
         /* Otherwise, move on to the next binding */  
@@ -405,13 +964,17 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
         return NULL;
 
     /* Check if first binding of the bucket chain matches pcKey */
-    if (strcmp(curr->key, pcKey) == 0)
+    if (SymTable_keyEquals(curr->key, pcKey))
     {
         bindingValue = (void *)curr->value;
         oSymTable->buckets[bucketIndex] = curr->next;
-        free((void *)curr->key);
+        SymTable_releaseSlot(oSymTable, curr);
+        SymTable_freeKey(oSymTable, curr->key);
         free(curr);
         oSymTable->bindingsCount--;
+        if (oSymTable->log != NULL)
+            (void)SymTableLog_append(oSymTable->log,
+                                     SYMTABLELOG_REMOVE, pcKey, NULL);
         return bindingValue;
     }
 
@@ -419,14 +982,19 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
     while (curr->next != NULL)
     {
         /* Handle condition where binding with pcKey exists */
-        if (strcmp(curr->next->key, pcKey) == 0)
+        if (SymTable_keyEquals(curr->next->key, pcKey))
         {
             nodeRemoved = curr->next;
             bindingValue = (void *)nodeRemoved->value;
             curr->next = nodeRemoved->next;
-            free((void *)nodeRemoved->key);
+            SymTable_releaseSlot(oSymTable, nodeRemoved);
+            SymTable_freeKey(oSymTable, nodeRemoved->key);
             free((void *)nodeRemoved);
             oSymTable->bindingsCount--;
+            if (oSymTable->log != NULL)
+                (void)SymTableLog_append(oSymTable->log,
+                                         SYMTABLELOG_REMOVE, pcKey,
+                                         NULL);
             return bindingValue;
         }
 
@@ -440,6 +1008,153 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
 
 /*--------------------------------------------------------------------*/
 
+int SymTable_find(SymTable_T oSymTable, const char *pcKey,
+                  SymTable_Handle *psHandle)
+{
+    size_t hashCode, bucketIndex;
+    struct Binding *curr;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(psHandle != NULL);
+
+    /* Find hash key for pcKey */
+    hashCode = SymTable_hashCode(pcKey);
+    bucketIndex = hashCode % BUCKET_COUNTS[oSymTable->bucketSizeIndex];
+    curr = oSymTable->buckets[bucketIndex];
+
+    /* Traverse through all the bindings in hash bucket, comparing
+    saved hash codes before keys */
+    while (curr != NULL)
+    {
+        /* Handle condition where binding with pcKey exists */
+        if (curr->hash == hashCode &&
+            SymTable_keyEquals(curr->key, pcKey))
+        {
+            psHandle->index = curr->slot;
+            psHandle->generation =
+                oSymTable->slots[curr->slot].generation;
+            return 1;
+        }
+
+        /* Otherwise, move on to the next binding */
+        curr = curr->next;
+    }
+
+    /* Handle condition where no binding with pcKey exists */
+    return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_isValidHandle(SymTable_T oSymTable,
+                           SymTable_Handle sHandle)
+{
+    assert(oSymTable != NULL);
+
+    return SymTable_resolve(oSymTable, sHandle) != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+const char *SymTable_getKeyByHandle(SymTable_T oSymTable,
+                                    SymTable_Handle sHandle)
+{
+    struct Binding *binding;
+
+    assert(oSymTable != NULL);
+
+    binding = SymTable_resolve(oSymTable, sHandle);
+    if (binding == NULL)
+        return NULL;
+    return binding->key;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_getByHandle(SymTable_T oSymTable,
+                           SymTable_Handle sHandle)
+{
+    struct Binding *binding;
+
+    assert(oSymTable != NULL);
+
+    binding = SymTable_resolve(oSymTable, sHandle);
+    if (binding == NULL)
+        return NULL;
+    return (void *)binding->value;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replaceByHandle(SymTable_T oSymTable,
+                               SymTable_Handle sHandle,
+                               const void *pvValue)
+{
+    struct Binding *binding;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+
+    /* Handle condition where the handle is stale */
+    binding = SymTable_resolve(oSymTable, sHandle);
+    if (binding == NULL)
+        return NULL;
+
+    /* Save old value and replace it with new value */
+    oldValue = (void *)binding->value;
+    binding->value = pvValue;
+
+    /* Log the replacement */
+    if (oSymTable->log != NULL)
+        (void)SymTableLog_append(oSymTable->log, SYMTABLELOG_SET,
+                                 binding->key, pvValue);
+    return oldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_removeByHandle(SymTable_T oSymTable,
+                              SymTable_Handle sHandle)
+{
+    struct Binding *binding;
+    struct Binding **link;
+    size_t bucketIndex;
+    void *bindingValue;
+
+    assert(oSymTable != NULL);
+
+    /* Handle condition where the handle is stale */
+    binding = SymTable_resolve(oSymTable, sHandle);
+    if (binding == NULL)
+        return NULL;
+
+    /* Find the link to the binding in its bucket chain, comparing
+    only addresses */
+    bucketIndex = binding->hash %
+                  BUCKET_COUNTS[oSymTable->bucketSizeIndex];
+    link = &oSymTable->buckets[bucketIndex];
+    while (*link != binding)
+    {
+        assert(*link != NULL);
+        link = &(*link)->next;
+    }
+
+    /* Unlink the binding, log its removal and free it */
+    *link = binding->next;
+    oSymTable->bindingsCount--;
+    SymTable_releaseSlot(oSymTable, binding);
+    if (oSymTable->log != NULL)
+        (void)SymTableLog_append(oSymTable->log, SYMTABLELOG_REMOVE,
+                                 binding->key, NULL);
+    bindingValue = (void *)binding->value;
+    SymTable_freeKey(oSymTable, binding->key);
+    free(binding);
+    return bindingValue;
+}
+
+/*--------------------------------------------------------------------*/
+
 void SymTable_map(SymTable_T oSymTable,
                   void (*pfApply)(const char *pcKey, void *pvValue,
                                   void *pvExtra),
@@ -469,4 +1184,476 @@ void SymTable_map(SymTable_T oSymTable,
             curr = curr->next;
         }
     }
-}
\ No newline at end of file
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the first input position of slice uSlice of psBuild */
+
+static size_t SymTable_sliceStart(const struct Build *psBuild,
+                                  size_t uSlice)
+{
+    return psBuild->count * uSlice / psBuild->threadCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the partition of the bucket array of psBuild that holds the
+bucket of hash code uHash. Each partition is a range of buckets */
+
+static size_t SymTable_partition(const struct Build *psBuild,
+                                 size_t uHash)
+{
+    size_t uBucketCount =
+        BUCKET_COUNTS[psBuild->table->bucketSizeIndex];
+
+    return uHash % uBucketCount * psBuild->threadCount / uBucketCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Hash the keys of the slice of pvWorker, a BuildWorker, and count
+them by partition */
+
+static void *SymTable_countSlice(void *pvWorker)
+{
+    struct BuildWorker *psWorker = pvWorker;
+    struct Build *psBuild = psWorker->build;
+    size_t *puCounts;
+    size_t i, uEnd;
+
+    puCounts = psBuild->offsets +
+        psWorker->index * psBuild->threadCount;
+    uEnd = SymTable_sliceStart(psBuild, psWorker->index + 1);
+    for (i = SymTable_sliceStart(psBuild, psWorker->index); i < uEnd;
+         i++)
+    {
+        psBuild->hashes[i] = SymTable_hashCode(psBuild->keys[i]);
+        puCounts[SymTable_partition(psBuild, psBuild->hashes[i])]++;
+    }
+    return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Place the index of each key of the slice of pvWorker, a
+BuildWorker, at the next position of its partition */
+
+static void *SymTable_scatterSlice(void *pvWorker)
+{
+    struct BuildWorker *psWorker = pvWorker;
+    struct Build *psBuild = psWorker->build;
+    size_t *puOffsets;
+    size_t i, uEnd;
+
+    puOffsets = psBuild->offsets +
+        psWorker->index * psBuild->threadCount;
+    uEnd = SymTable_sliceStart(psBuild, psWorker->index + 1);
+    for (i = SymTable_sliceStart(psBuild, psWorker->index); i < uEnd;
+         i++)
+        psBuild->order[puOffsets[SymTable_partition(
+            psBuild, psBuild->hashes[i])]++] = i;
+    return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Insert the keys of the partition of pvWorker, a BuildWorker, into
+the buckets of that partition, giving the key at position j of the
+order array slot j. A slot whose key is a duplicate is left free */
+
+static void *SymTable_insertPartition(void *pvWorker)
+{
+    struct BuildWorker *psWorker = pvWorker;
+    struct Build *psBuild = psWorker->build;
+    SymTable_T oSymTable = psBuild->table;
+    size_t uBucketCount = BUCKET_COUNTS[oSymTable->bucketSizeIndex];
+    struct Binding *curr, *newBinding;
+    struct Slot *psSlot;
+    const char *pcKey;
+    size_t i, j, hashCode, bucketIndex;
+
+    for (j = psWorker->begin; j < psWorker->end; j++)
+    {
+        i = psBuild->order[j];
+        pcKey = psBuild->keys[i];
+        hashCode = psBuild->hashes[i];
+        bucketIndex = hashCode % uBucketCount;
+        psSlot = &oSymTable->slots[j];
+        psSlot->generation = 1;
+        psSlot->binding = NULL;
+
+        /* Keep only the first binding of a key, as SymTable_put
+        would */
+        curr = oSymTable->buckets[bucketIndex];
+        while (curr != NULL && (curr->hash != hashCode ||
+                                !SymTable_keyEquals(curr->key, pcKey)))
+            curr = curr->next;
+
+        if (curr == NULL)
+        {
+            /* Allocate the binding and its key copy on this thread */
+            newBinding = malloc(sizeof(struct Binding));
+            if (newBinding == NULL)
+            {
+                psWorker->failed = 1;
+                return NULL;
+            }
+            newBinding->key = SymTable_copyKey(oSymTable, pcKey);
+            if (newBinding->key == NULL)
+            {
+                free(newBinding);
+                psWorker->failed = 1;
+                return NULL;
+            }
+            newBinding->keyCapacity = strlen(pcKey) + 1;
+
+            /* Insert it at the front of its bucket chain */
+            newBinding->value = psBuild->values[i];
+            newBinding->hash = hashCode;
+            newBinding->slot = j;
+            newBinding->next = oSymTable->buckets[bucketIndex];
+            oSymTable->buckets[bucketIndex] = newBinding;
+            psSlot->binding = newBinding;
+            psWorker->bindingsCount++;
+            continue;
+        }
+
+        /* Otherwise append the slot to the free slots of the
+        partition */
+        psSlot->nextFree = NO_SLOT;
+        if (psWorker->freeTail == NO_SLOT)
+            psWorker->freeHead = j;
+        else
+            oSymTable->slots[psWorker->freeTail].nextFree = j;
+        psWorker->freeTail = j;
+    }
+    return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_buildParallel(const char *const ppcKeys[],
+                                  const void *const ppvValues[],
+                                  size_t uCount, size_t uThreadCount)
+{
+    SymTable_T oSymTable;
+    struct Build sBuild;
+    struct BuildWorker *psWorkers;
+    struct Binding **newBuckets;
+    size_t uSizeIndex, uNext, uKeysHere, t, p;
+    int iFailed = 0;
+
+    assert(ppcKeys != NULL);
+    assert(ppvValues != NULL);
+
+    /* Make an empty table whose bucket array is already large enough
+    for uCount bindings */
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL)
+        return NULL;
+    uSizeIndex = 0;
+    while (uSizeIndex < BUCKET_COUNTS_LEN - 1 &&
+           BUCKET_COUNTS[uSizeIndex] < uCount)
+        uSizeIndex++;
+    if (uSizeIndex > 0)
+    {
+        newBuckets = calloc(BUCKET_COUNTS[uSizeIndex],
+                            sizeof(struct Binding *));
+        if (newBuckets == NULL)
+        {
+            SymTable_free(oSymTable);
+            return NULL;
+        }
+        free(oSymTable->buckets);
+        oSymTable->buckets = newBuckets;
+        oSymTable->bucketSizeIndex = uSizeIndex;
+    }
+    if (uCount == 0)
+        return oSymTable;
+
+    /* Use at least one thread and at most one per key */
+    if (uThreadCount > MAX_WORKER_THREADS)
+        uThreadCount = MAX_WORKER_THREADS;
+    if (uThreadCount > uCount)
+        uThreadCount = uCount;
+    if (uThreadCount == 0)
+        uThreadCount = 1;
+
+    /* Allocate the shared work, the workers and one slot per key */
+    sBuild.table = oSymTable;
+    sBuild.keys = ppcKeys;
+    sBuild.values = ppvValues;
+    sBuild.count = uCount;
+    sBuild.threadCount = uThreadCount;
+    sBuild.hashes = malloc(uCount * sizeof(size_t));
+    sBuild.order = malloc(uCount * sizeof(size_t));
+    sBuild.offsets = calloc(uThreadCount * uThreadCount,
+                            sizeof(size_t));
+    psWorkers = calloc(uThreadCount, sizeof(struct BuildWorker));
+    oSymTable->slots = malloc(uCount * sizeof(struct Slot));
+    if (sBuild.hashes == NULL || sBuild.order == NULL ||
+        sBuild.offsets == NULL || psWorkers == NULL ||
+        oSymTable->slots == NULL)
+    {
+        free(sBuild.hashes);
+        free(sBuild.order);
+        free(sBuild.offsets);
+        free(psWorkers);
+        SymTable_free(oSymTable);
+        return NULL;
+    }
+    oSymTable->slotsCount = uCount;
+    oSymTable->slotsCapacity = uCount;
+    for (t = 0; t < uThreadCount; t++)
+    {
+        psWorkers[t].build = &sBuild;
+        psWorkers[t].index = t;
+        psWorkers[t].freeHead = NO_SLOT;
+        psWorkers[t].freeTail = NO_SLOT;
+    }
+
+    /* Hash the keys and count them by slice and partition */
+    SymTable_runWorkers(psWorkers, sizeof(struct BuildWorker),
+                        uThreadCount, SymTable_countSlice);
+
+    /* Turn the counts into positions in the order array, partition
+    by partition and, within a partition, slice by slice, so that
+    each partition keeps the input order of its keys */
+    uNext = 0;
+    for (p = 0; p < uThreadCount; p++)
+    {
+        psWorkers[p].begin = uNext;
+        for (t = 0; t < uThreadCount; t++)
+        {
+            uKeysHere = sBuild.offsets[t * uThreadCount + p];
+            sBuild.offsets[t * uThreadCount + p] = uNext;
+            uNext += uKeysHere;
+        }
+        psWorkers[p].end = uNext;
+    }
+
+    /* Group the keys by partition, then build each partition */
+    SymTable_runWorkers(psWorkers, sizeof(struct BuildWorker),
+                        uThreadCount, SymTable_scatterSlice);
+    SymTable_runWorkers(psWorkers, sizeof(struct BuildWorker),
+                        uThreadCount, SymTable_insertPartition);
+
+    /* Total the bindings and chain the free slots of every partition
+    together */
+    for (p = uThreadCount; p-- > 0;)
+    {
+        if (psWorkers[p].failed)
+            iFailed = 1;
+        oSymTable->bindingsCount += psWorkers[p].bindingsCount;
+        if (psWorkers[p].freeHead != NO_SLOT)
+        {
+            oSymTable->slots[psWorkers[p].freeTail].nextFree =
+                oSymTable->freeSlot;
+            oSymTable->freeSlot = psWorkers[p].freeHead;
+        }
+    }
+
+    free(sBuild.hashes);
+    free(sBuild.order);
+    free(sBuild.offsets);
+    free(psWorkers);
+    if (iFailed)
+    {
+        SymTable_free(oSymTable);
+        return NULL;
+    }
+    return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_recover(const char *pcSnapshotPath,
+                            const char *pcLogPath,
+                            const struct SymTable_Codec *psCodec,
+                            size_t uGroupSize)
+{
+    SymTable_T oSymTable;
+    SymTableLog_T oLog;
+
+    assert(pcSnapshotPath != NULL);
+    assert(pcLogPath != NULL);
+    assert(psCodec != NULL);
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL)
+        return NULL;
+
+    oLog = SymTableLog_new(pcSnapshotPath, pcLogPath, psCodec,
+                           uGroupSize);
+    if (oLog == NULL)
+    {
+        SymTable_free(oSymTable);
+        return NULL;
+    }
+
+    /* Replay the files before logging starts, so that replaying does
+    not append to the log */
+    if (!SymTableLog_recover(oLog, oSymTable))
+    {
+        SymTableLog_free(oLog);
+        SymTable_free(oSymTable);
+        return NULL;
+    }
+
+    oSymTable->log = oLog;
+    return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_sync(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+
+    if (oSymTable->log == NULL)
+        return 1;
+    return SymTableLog_sync(oSymTable->log);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Mark oSave finished, and remove it from the unfinished saves of its
+table, if any */
+
+static void SymTable_endSave(SymTableSave_T oSave)
+{
+    SymTableSave_T *poSave;
+
+    oSave->finished = 1;
+    if (oSave->table == NULL)
+        return;
+
+    poSave = &oSave->table->saves;
+    while (*poSave != oSave)
+        poSave = &(*poSave)->next;
+    *poSave = oSave->next;
+    oSave->table = NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Record in oSave the exit status iStatus of its child */
+
+static void SymTable_finishSave(SymTableSave_T oSave, int iStatus)
+{
+    oSave->successful = WIFEXITED(iStatus) && WEXITSTATUS(iStatus) == 0;
+    SymTable_endSave(oSave);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Wait until the child of oSave has exited, without freeing oSave */
+
+static void SymTable_awaitSave(SymTableSave_T oSave)
+{
+    pid_t pid;
+    int iStatus;
+
+    while (!oSave->finished)
+    {
+        pid = waitpid(oSave->pid, &iStatus, 0);
+        if (pid == oSave->pid)
+            SymTable_finishSave(oSave, iStatus);
+        else if (pid < 0 && errno != EINTR)
+            SymTable_endSave(oSave);
+    }
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_checkpoint(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    assert(oSymTable->log != NULL);
+
+    /* Wait for the snapshots that children are still writing from
+    older copies of the table, so that none of them can replace the
+    newer snapshot written here after the log has been emptied */
+    while (oSymTable->saves != NULL)
+        SymTable_awaitSave(oSymTable->saves);
+
+    return SymTableLog_checkpoint(oSymTable->log, oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTableSave_T SymTable_saveAsync(SymTable_T oSymTable,
+                                  const char *pcPath,
+                                  const struct SymTable_Codec *psCodec)
+{
+    SymTableSave_T oSave;
+
+    assert(oSymTable != NULL);
+    assert(pcPath != NULL);
+    assert(psCodec != NULL);
+
+    oSave = malloc(sizeof(struct SymTableSave));
+    if (oSave == NULL)
+        return NULL;
+    oSave->finished = 0;
+    oSave->successful = 0;
+    oSave->table = NULL;
+    oSave->next = NULL;
+
+    oSave->pid = fork();
+    if (oSave->pid < 0)
+    {
+        free(oSave);
+        return NULL;
+    }
+
+    /* The child writes its copy of the table and exits without
+    running exit handlers or flushing the caller's stdio buffers */
+    if (oSave->pid == 0)
+        _exit(SymTableLog_writeSnapshot(pcPath, oSymTable, psCodec) ? 0
+                                                                    : 1);
+
+    /* Until it finishes, the save holds up checkpoints of the table */
+    oSave->table = oSymTable;
+    oSave->next = oSymTable->saves;
+    oSymTable->saves = oSave;
+    return oSave;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_isSaveDone(SymTableSave_T oSave)
+{
+    pid_t pid;
+    int iStatus;
+
+    assert(oSave != NULL);
+
+    if (oSave->finished)
+        return 1;
+
+    pid = waitpid(oSave->pid, &iStatus, WNOHANG);
+    if (pid == oSave->pid)
+        SymTable_finishSave(oSave, iStatus);
+
+    /* Handle case where the child can no longer be waited for */
+    else if (pid < 0 && errno != EINTR)
+        SymTable_endSave(oSave);
+
+    return oSave->finished;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_waitSave(SymTableSave_T oSave)
+{
+    int iSuccessful;
+
+    assert(oSave != NULL);
+
+    SymTable_awaitSave(oSave);
+    iSuccessful = oSave->successful;
+    free(oSave);
+    return iSuccessful;
+}
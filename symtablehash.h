@@ -0,0 +1,192 @@
+/*--------------------------------------------------------------------*/
+/* symtablehash.h                                                     */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+# ifndef SYMTABLEHASH
+# define SYMTABLEHASH
+
+#include "symtable.h"
+#include "symtablecodec.h"
+#include "symtablekeys.h"
+
+/*--------------------------------------------------------------------*/
+/* Return a new SymTable object that contains no bindings and that
+takes the copy of each key it stores from oKeys, so that the key is
+stored once however many tables sharing oKeys contain it, and a key
+passed to the table that came from oKeys is compared by address
+first. oKeys must not be freed before the table. Return NULL if
+insufficient memory is available */
+
+SymTable_T SymTable_newWithKeys(SymTableKeys_T oKeys);
+
+/*--------------------------------------------------------------------*/
+/* Return a new SymTable object that contains a binding of ppcKeys[i]
+to ppvValues[i] for each i less than uCount, built by up to
+uThreadCount threads at once. Where a key occurs more than once, only
+its first binding is kept, as if the bindings had been added in order
+by SymTable_put. Return NULL if insufficient memory is available */
+
+SymTable_T SymTable_buildParallel(const char *const ppcKeys[],
+                                  const void *const ppvValues[],
+                                  size_t uCount, size_t uThreadCount);
+
+/*--------------------------------------------------------------------*/
+/* Make each later rehash of oSymTable that holds many bindings move
+them with uThreadCount threads at once, so that the pause of the
+SymTable_put that grows the table shrinks with the number of cores. A
+uThreadCount of 1, the default, rehashes on the calling thread */
+
+void SymTable_setRehashThreads(SymTable_T oSymTable,
+                               size_t uThreadCount);
+
+/*--------------------------------------------------------------------*/
+/* Free all memory occupied by oSymTable as SymTable_free does, but on
+a background thread, so that the call returns without visiting each
+binding. The log of a table made by SymTable_recover is closed before
+the call returns. A table made by SymTable_newWithKeys, or one whose
+thread cannot be started, is freed at once instead. oSymTable must not
+be used after the call */
+
+void SymTable_freeAsync(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+/* Remove every binding from oSymTable, invalidating every handle to
+them. The bucket array keeps its size, and the memory of the bindings
+and of their key copies is kept for the bindings added next, so that
+refilling the table allocates and rehashes little. That memory is
+freed by SymTable_free */
+
+void SymTable_clear(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+/* A SymTable_Handle names one binding of a SymTable, so that the
+binding can be read, replaced or removed without looking its key up
+again. It is the index of a slot in a dense array of slots, one per
+binding, and the generation of that slot, which changes whenever its
+binding is removed. A handle therefore remains valid, however the
+table grows, until its binding is removed, and a handle to a removed
+binding is detected as invalid even after its slot is reused. A
+zeroed handle is never valid */
+typedef struct SymTable_Handle
+{
+    /* Index of the slot of the binding */
+    size_t index;
+    /* Generation of the slot when the handle was made */
+    size_t generation;
+} SymTable_Handle;
+
+/*--------------------------------------------------------------------*/
+/* If oSymTable contains a binding whose key is pcKey, store a handle
+to it in *psHandle and return 1 (TRUE). Otherwise return 0 (FALSE) */
+
+int SymTable_find(SymTable_T oSymTable, const char *pcKey,
+                  SymTable_Handle *psHandle);
+
+/*--------------------------------------------------------------------*/
+/* Return 1 (TRUE) if sHandle names a binding of oSymTable, or 0
+(FALSE) if that binding has been removed */
+
+int SymTable_isValidHandle(SymTable_T oSymTable,
+                           SymTable_Handle sHandle);
+
+/*--------------------------------------------------------------------*/
+/* Return the key of the binding of oSymTable named by sHandle, or
+NULL if sHandle is not valid */
+
+const char *SymTable_getKeyByHandle(SymTable_T oSymTable,
+                                    SymTable_Handle sHandle);
+
+/*--------------------------------------------------------------------*/
+/* Return the value of the binding of oSymTable named by sHandle, or
+NULL if sHandle is not valid */
+
+void *SymTable_getByHandle(SymTable_T oSymTable,
+                           SymTable_Handle sHandle);
+
+/*--------------------------------------------------------------------*/
+/* Replace the value of the binding of oSymTable named by sHandle with
+pvValue, and return the old value. Return NULL and change nothing if
+sHandle is not valid */
+
+void *SymTable_replaceByHandle(SymTable_T oSymTable,
+                               SymTable_Handle sHandle,
+                               const void *pvValue);
+
+/*--------------------------------------------------------------------*/
+/* Remove from oSymTable the binding named by sHandle, which becomes
+invalid, and return the binding's value. Return NULL and change
+nothing if sHandle is not valid */
+
+void *SymTable_removeByHandle(SymTable_T oSymTable,
+                              SymTable_Handle sHandle);
+
+/*--------------------------------------------------------------------*/
+/* Return a new SymTable object that holds the bindings saved in
+snapshot file pcSnapshotPath and log file pcLogPath, either of which
+may be missing, and that appends every later SymTable_put,
+SymTable_replace and SymTable_remove to the log file. Values are
+written and read through *psCodec; recovered values are decoded by it
+and owned by the caller. Log records are forced to disk in groups of
+uGroupSize records, so a crash loses at most the last incomplete group
+unless SymTable_sync is called. Return NULL if insufficient memory is
+available or a file cannot be read or opened */
+
+SymTable_T SymTable_recover(const char *pcSnapshotPath,
+                            const char *pcLogPath,
+                            const struct SymTable_Codec *psCodec,
+                            size_t uGroupSize);
+
+/*--------------------------------------------------------------------*/
+/* Force every update of oSymTable to its log file. Return 1 (TRUE) if
+successful or if oSymTable was not made by SymTable_recover, or 0
+(FALSE) if an update could not be logged now or at any earlier time */
+
+int SymTable_sync(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+/* Wait for every snapshot of oSymTable that SymTable_saveAsync is
+still writing, then write every binding of oSymTable, which must have
+been made by SymTable_recover, to its snapshot file and empty its log
+file. Return 1 (TRUE) if successful, or 0 (FALSE) otherwise, in which
+case the previous snapshot and the log remain valid */
+
+int SymTable_checkpoint(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+/* A SymTableSave_T is a pointer to a snapshot being written in the
+background by SymTable_saveAsync */
+typedef struct SymTableSave *SymTableSave_T;
+
+/*--------------------------------------------------------------------*/
+/* Start writing every binding of oSymTable, with values encoded by
+*psCodec, to a snapshot file named pcPath, replacing any previous file
+of that name atomically once it is complete. The snapshot is written
+by a forked child process from its copy of the table as it is now, so
+the caller may keep updating oSymTable meanwhile; only the pages that
+the caller modifies before the child finishes are copied. The file can
+be read by SymTable_recover, and may be the snapshot file of oSymTable
+if it was made by SymTable_recover: replaying its log over the newer
+snapshot gives the same bindings, and SymTable_checkpoint waits for
+the save to finish before it writes a newer snapshot and empties the
+log. Return a SymTableSave object, or NULL if insufficient memory is
+available or the child process cannot be started */
+
+SymTableSave_T SymTable_saveAsync(SymTable_T oSymTable,
+                                  const char *pcPath,
+                                  const struct SymTable_Codec *psCodec);
+
+/*--------------------------------------------------------------------*/
+/* Return 1 (TRUE) if the snapshot being written for oSave is
+complete, or 0 (FALSE) if it is still being written. Never waits */
+
+int SymTable_isSaveDone(SymTableSave_T oSave);
+
+/*--------------------------------------------------------------------*/
+/* Wait until the snapshot being written for oSave is complete, and
+free oSave. Return 1 (TRUE) if the file was written, or 0 (FALSE)
+otherwise, in which case any previous file of that name remains */
+
+int SymTable_waitSave(SymTableSave_T oSave);
+
+# endif
@@ -0,0 +1,69 @@
+/*--------------------------------------------------------------------*/
+/* symtablehashcode.h                                                 */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+# ifndef SYMTABLEHASHCODE
+# define SYMTABLEHASHCODE
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+The string hash shared by the implementations, for their own use
+only. Each character is added to the code multiplied by 65599, so the
+raw code of a key is decided mostly by its last few characters, and
+its low bits by them alone. Every table reduces the code to a slot or
+bucket by masking its low bits, or takes a tag or directory index
+from some of its bits, so SymTableHashCode_mix folds the high bits
+into the low ones and spreads every character over the whole code;
+without it, keys that differ only in their last characters would
+crowd into neighbouring slots. The codes are 64 bits wide on every
+platform, since the shared memory and log-structured tables store
+them. The functions are static inline so that each table inlines
+them into its probe loops.
+*/
+
+/*--------------------------------------------------------------------*/
+/* Return the raw hash code for pcKey, and store its length in
+*puLength unless puLength is NULL */
+
+static inline uint64_t SymTableHashCode_string(const char *pcKey,
+                                               size_t *puLength)
+{
+    const uint64_t HASH_MULTIPLIER = 65599;
+    uint64_t uHash = 0;
+    size_t u;
+
+    assert(pcKey != NULL);
+
+    for (u = 0; pcKey[u] != '\0'; u++)
+        uHash = uHash * HASH_MULTIPLIER + (uint64_t)pcKey[u];
+    if (puLength != NULL)
+        *puLength = u;
+
+    return uHash;
+}
+
+/*--------------------------------------------------------------------*/
+/* Return uHash, a raw hash code, with its high bits folded into its
+low bits */
+
+static inline uint64_t SymTableHashCode_mix(uint64_t uHash)
+{
+    uHash ^= uHash >> 16;
+    uHash *= (uint64_t)0x9E3779B97F4A7C15ULL;
+    uHash ^= uHash >> 29;
+    return uHash;
+}
+
+/*--------------------------------------------------------------------*/
+/* Return the full hash code for pcKey: its raw code, mixed */
+
+static inline uint64_t SymTableHashCode_full(const char *pcKey)
+{
+    return SymTableHashCode_mix(SymTableHashCode_string(pcKey, NULL));
+}
+
+# endif
@@ -0,0 +1,835 @@
+/*--------------------------------------------------------------------*/
+/* symtablehopscotch.c                                                */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+/* Hopscotch hash implementation of symbol table that maps string keys
+to void* values. Each key is stored with defensive copy to ensure
+ownership by symbol table. Every binding lives within a neighborhood
+of NEIGHBORHOOD_SIZE slots starting at its home slot, and the home
+slot keeps a bitmap of which slots in its neighborhood hold bindings
+that hash to it. A lookup therefore only visits the handful of slots
+named by one bitmap. An insertion that finds its free slot outside
+the neighborhood hops bindings closer to their homes until the free
+slot moves inside it; if that fails the slot array is doubled.
+
+A table made by SymTable_newConcurrent lets readers run without a
+lock. Writers serialize on a mutex and bump a sequence number before
+and after every update, and a reader retries whenever the sequence
+number it saw at the start has changed by the end. Keys and slot
+arrays that a writer discards are retired rather than freed. Readers
+count themselves in one of two counters, chosen by the parity of an
+epoch number. Once a batch of retired pointers is complete, a writer
+advances the epoch, so that new readers count themselves in the other
+counter, and frees the batch when the counter of the old epoch drops
+to zero. Writers never wait for readers, and since readers that
+arrive later cannot hold up the old counter, each batch is freed after
+the lookups that were running when it was retired */
+
+#include "symtablehopscotch.h"
+#include "symtablehashcode.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Number of slots in the neighborhood of a home slot, which is also
+the number of bits in a hop bitmap */
+enum {NEIGHBORHOOD_SIZE = 32};
+
+/* Initial number of slots. Must be a power of two so that a hash code
+can be reduced to a slot index with a mask */
+static const size_t INITIAL_SLOT_COUNT = 512;
+
+/* Maximum distance from the home slot that an insertion searches for
+a free slot before giving up and expanding the table */
+static const size_t MAX_PROBE_DIST = 4096;
+
+/* The slot array is doubled when adding one more binding would make
+the load factor exceed MAX_LOAD_NUMER / MAX_LOAD_DENOM */
+static const size_t MAX_LOAD_NUMER = 9;
+static const size_t MAX_LOAD_DENOM = 10;
+
+/* Each Slot holds at most one key-value pair, plus the hop bitmap of
+the bindings whose home is this slot */
+struct Slot
+{
+    /* Bit i is set if slot (this + i) holds a binding whose home slot
+    is this slot */
+    uint32_t hopInfo;
+    /* Pointer to the key string (defensive copy), or NULL if the
+    slot is empty */
+    const char *key;
+    /* Pointer to the associated value */
+    const void *value;
+    /* Full hash code of key */
+    size_t hash;
+};
+
+/* A SlotArray is the slot array together with its size, so that a
+reader always sees a matching pointer and size */
+struct SlotArray
+{
+    /* Number of slots (a power of two) */
+    size_t slotCount;
+    /* The slots */
+    struct Slot slots[];
+};
+
+/* SymTable structure represents overall hash table */
+struct SymTable
+{
+    /* Pointer to current slot array */
+    struct SlotArray *array;
+    /* Stores total number of bindings in SymTable */
+    size_t bindingsCount;
+    /* 1 (TRUE) if SymTable was made by SymTable_newConcurrent */
+    int isConcurrent;
+    /* Sequence number, odd while a writer is updating SymTable */
+    unsigned long seq;
+    /* Epoch number, advanced when a batch of retired pointers is
+    complete */
+    unsigned long epoch;
+    /* Number of readers currently looking up a key, counted by the
+    parity of the epoch in which they started */
+    unsigned long readers[2];
+    /* Lock held by writers */
+    pthread_mutex_t writeLock;
+    /* Array of keys and slot arrays retired in the current epoch */
+    void **retired;
+    /* Number of pointers in retired */
+    size_t retiredCount;
+    /* Number of pointers retired has room for */
+    size_t retiredCapacity;
+    /* Array of pointers retired in the previous epoch, freed once its
+    readers are done */
+    void **expired;
+    /* Number of pointers in expired */
+    size_t expiredCount;
+    /* Number of pointers expired has room for */
+    size_t expiredCapacity;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the full hash code for pcKey */
+
+static size_t SymTable_hash(const char *pcKey)
+{
+    return (size_t)SymTableHashCode_full(pcKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new slot array of uSlotCount empty slots, or NULL if
+insufficient memory is available */
+
+static struct SlotArray *SymTable_newArray(size_t uSlotCount)
+{
+    struct SlotArray *psArray;
+
+    /* Handle case where size of array would overflow */
+    if (uSlotCount > ((size_t)-1 - sizeof(struct SlotArray)) /
+                         sizeof(struct Slot))
+        return NULL;
+
+    psArray = calloc(1, sizeof(struct SlotArray) +
+                            uSlotCount * sizeof(struct Slot));
+    if (psArray != NULL)
+        psArray->slotCount = uSlotCount;
+    return psArray;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the index of the slot in psArray that holds key pcKey whose
+hash code is uHash, or psArray->slotCount if no such slot exists. The
+fields of a slot are loaded atomically because a concurrent reader may
+run while a writer changes them, and the key is loaded with acquire
+ordering so that the characters of a key just added are seen too */
+
+static size_t SymTable_findSlot(struct SlotArray *psArray,
+                                const char *pcKey, size_t uHash)
+{
+    size_t mask = psArray->slotCount - 1;
+    size_t home = uHash & mask;
+    size_t i, s;
+    uint32_t hopInfo;
+    const char *key;
+
+    hopInfo = __atomic_load_n(&psArray->slots[home].hopInfo,
+                              __ATOMIC_RELAXED);
+
+    /* Visit only the slots named by the home slot's bitmap */
+    for (i = 0; hopInfo != 0; i++, hopInfo >>= 1)
+    {
+        if ((hopInfo & 1) == 0)
+            continue;
+
+        s = (home + i) & mask;
+        key = __atomic_load_n(&psArray->slots[s].key, __ATOMIC_ACQUIRE);
+
+        /* Handle condition where binding with pcKey exists */
+        if (key != NULL &&
+            __atomic_load_n(&psArray->slots[s].hash,
+                            __ATOMIC_RELAXED) == uHash &&
+            strcmp(key, pcKey) == 0)
+            return s;
+    }
+
+    /* Handle condition where no binding with pcKey exists */
+    return psArray->slotCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store key pcKey with hash code uHash and value pvValue in slot s of
+psArray, and record it in the bitmap of its home slot */
+
+static void SymTable_fill(struct SlotArray *psArray, size_t s,
+                          const char *pcKey, const void *pvValue,
+                          size_t uHash)
+{
+    size_t mask = psArray->slotCount - 1;
+    size_t home = uHash & mask;
+    struct Slot *psSlot = &psArray->slots[s];
+
+    __atomic_store_n(&psSlot->hash, uHash, __ATOMIC_RELAXED);
+    __atomic_store_n(&psSlot->value, pvValue, __ATOMIC_RELAXED);
+    __atomic_store_n(&psSlot->key, pcKey, __ATOMIC_RELEASE);
+    __atomic_store_n(&psArray->slots[home].hopInfo,
+                     psArray->slots[home].hopInfo |
+                         ((uint32_t)1 << ((s - home) & mask)),
+                     __ATOMIC_RELAXED);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Empty slot s of psArray and remove it from the bitmap of the home
+slot of its binding */
+
+static void SymTable_clearSlot(struct SlotArray *psArray, size_t s)
+{
+    size_t mask = psArray->slotCount - 1;
+    struct Slot *psSlot = &psArray->slots[s];
+    size_t home = psSlot->hash & mask;
+
+    __atomic_store_n(&psArray->slots[home].hopInfo,
+                     psArray->slots[home].hopInfo &
+                         ~((uint32_t)1 << ((s - home) & mask)),
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&psSlot->key, NULL, __ATOMIC_RELAXED);
+    __atomic_store_n(&psSlot->value, NULL, __ATOMIC_RELAXED);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Insert the binding of key pcKey, whose hash code is uHash, and value
+pvValue into psArray. Return 1 (TRUE) if successful, or 0 (FALSE) if
+no free slot could be brought into the key's neighborhood */
+
+static int SymTable_place(struct SlotArray *psArray, const char *pcKey,
+                          const void *pvValue, size_t uHash)
+{
+    size_t mask = psArray->slotCount - 1;
+    size_t home = uHash & mask;
+    size_t dist, freeSlot, base, baseSlot, off, s;
+    size_t maxDist = MAX_PROBE_DIST;
+    uint32_t hopInfo;
+    int moved;
+
+    if (maxDist > psArray->slotCount)
+        maxDist = psArray->slotCount;
+
+    /* Find the nearest free slot by linear probing */
+    for (dist = 0; dist < maxDist; dist++)
+    {
+        if (psArray->slots[(home + dist) & mask].key == NULL)
+            break;
+    }
+    if (dist == maxDist)
+        return 0;
+    freeSlot = (home + dist) & mask;
+
+    /* Hop the free slot towards home until it is in the neighborhood */
+    while (dist >= NEIGHBORHOOD_SIZE)
+    {
+        moved = 0;
+
+        /* Look for a binding in the NEIGHBORHOOD_SIZE - 1 slots before
+        the free slot that could move into it without leaving its own
+        neighborhood, starting with the farthest home */
+        for (base = NEIGHBORHOOD_SIZE - 1; base > 0 && !moved; base--)
+        {
+            baseSlot = (freeSlot - base) & mask;
+            hopInfo = psArray->slots[baseSlot].hopInfo;
+            for (off = 0; off < base; off++)
+            {
+                if ((hopInfo & ((uint32_t)1 << off)) == 0)
+                    continue;
+
+                /* Move the binding at baseSlot + off into freeSlot */
+                s = (baseSlot + off) & mask;
+                SymTable_fill(psArray, freeSlot, psArray->slots[s].key,
+                              psArray->slots[s].value,
+                              psArray->slots[s].hash);
+                SymTable_clearSlot(psArray, s);
+                dist -= base - off;
+                freeSlot = s;
+                moved = 1;
+                break;
+            }
+        }
+
+        /* Handle condition where no binding can be moved */
+        if (!moved)
+            return 0;
+    }
+
+    SymTable_fill(psArray, freeSlot, pcKey, pvValue, uHash);
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of readers of oSymTable that started in an epoch
+of parity uParity */
+
+static unsigned long SymTable_readersOf(SymTable_T oSymTable,
+                                        unsigned long uParity)
+{
+    return __atomic_load_n(&oSymTable->readers[uParity],
+                           __ATOMIC_SEQ_CST);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Hand pointer p, which is no longer reachable from oSymTable, over
+to be freed. A concurrent table keeps it until no reader can still be
+looking at it */
+
+static void SymTable_retire(SymTable_T oSymTable, void *p)
+{
+    void **newRetired;
+    size_t newCapacity;
+
+    if (!oSymTable->isConcurrent)
+    {
+        free(p);
+        return;
+    }
+
+    /* Grow the retired array if it is full */
+    if (oSymTable->retiredCount == oSymTable->retiredCapacity)
+    {
+        newCapacity = oSymTable->retiredCapacity * 2 + 16;
+        newRetired = realloc(oSymTable->retired,
+                             newCapacity * sizeof(void *));
+
+        /* Without memory to defer the free, wait for the readers. A
+        reader only counts itself once it has seen an even sequence
+        number, so none can be waiting for this update to finish */
+        if (newRetired == NULL)
+        {
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            while (SymTable_readersOf(oSymTable, 0) != 0 ||
+                   SymTable_readersOf(oSymTable, 1) != 0)
+                ;
+            free(p);
+            return;
+        }
+        oSymTable->retired = newRetired;
+        oSymTable->retiredCapacity = newCapacity;
+    }
+
+    oSymTable->retired[oSymTable->retiredCount++] = p;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Start an update of oSymTable: take the writer lock and make the
+sequence number odd so that readers will retry */
+
+static void SymTable_writeBegin(SymTable_T oSymTable)
+{
+    if (!oSymTable->isConcurrent)
+        return;
+
+    (void)pthread_mutex_lock(&oSymTable->writeLock);
+    __atomic_store_n(&oSymTable->seq, oSymTable->seq + 1,
+                     __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the pointers that oSymTable retired in the previous epoch if
+no reader that started in that epoch is still running */
+
+static void SymTable_freeExpired(SymTable_T oSymTable)
+{
+    size_t i;
+
+    if (oSymTable->expiredCount == 0 ||
+        SymTable_readersOf(oSymTable, (oSymTable->epoch - 1) & 1) != 0)
+        return;
+
+    for (i = 0; i < oSymTable->expiredCount; i++)
+        free(oSymTable->expired[i]);
+    oSymTable->expiredCount = 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Finish an update of oSymTable: make the sequence number even again,
+free or expire retired pointers as the readers allow, and release the
+writer lock */
+
+static void SymTable_writeEnd(SymTable_T oSymTable)
+{
+    void **swap;
+    size_t uCapacity;
+
+    if (!oSymTable->isConcurrent)
+        return;
+
+    __atomic_store_n(&oSymTable->seq, oSymTable->seq + 1,
+                     __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    SymTable_freeExpired(oSymTable);
+
+    /* Advance the epoch once the previous batch is freed and no reader
+    still counts itself in the counter that the next epoch reuses. A
+    reader that starts after this sees the table without the retired
+    pointers, so only readers of the epoch just ended can reach them */
+    if (oSymTable->retiredCount > 0 && oSymTable->expiredCount == 0 &&
+        SymTable_readersOf(oSymTable, (oSymTable->epoch + 1) & 1) == 0)
+    {
+        swap = oSymTable->expired;
+        uCapacity = oSymTable->expiredCapacity;
+        oSymTable->expired = oSymTable->retired;
+        oSymTable->expiredCount = oSymTable->retiredCount;
+        oSymTable->expiredCapacity = oSymTable->retiredCapacity;
+        oSymTable->retired = swap;
+        oSymTable->retiredCount = 0;
+        oSymTable->retiredCapacity = uCapacity;
+        __atomic_store_n(&oSymTable->epoch, oSymTable->epoch + 1,
+                         __ATOMIC_SEQ_CST);
+        SymTable_freeExpired(oSymTable);
+    }
+
+    (void)pthread_mutex_unlock(&oSymTable->writeLock);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look up key pcKey in oSymTable. Return 1 (TRUE) and store the value
+of its binding in *ppvValue if it exists, or 0 (FALSE) otherwise. A
+concurrent table is read without the writer lock, retrying until a
+lookup runs without overlapping an update */
+
+static int SymTable_lookup(SymTable_T oSymTable, const char *pcKey,
+                           void **ppvValue)
+{
+    struct SlotArray *psArray;
+    unsigned long seq, epoch;
+    size_t uHash, s;
+    int iFound;
+
+    uHash = SymTable_hash(pcKey);
+
+    if (!oSymTable->isConcurrent)
+    {
+        psArray = oSymTable->array;
+        s = SymTable_findSlot(psArray, pcKey, uHash);
+        if (s == psArray->slotCount)
+            return 0;
+        *ppvValue = (void *)psArray->slots[s].value;
+        return 1;
+    }
+
+    do
+    {
+        /* Wait for any update in progress to finish before counting
+        this reader, so that a writer waiting for the readers never
+        waits for one that is waiting for it */
+        do
+            seq = __atomic_load_n(&oSymTable->seq, __ATOMIC_ACQUIRE);
+        while (seq & 1);
+
+        /* Count this reader in the current epoch, retrying if the
+        epoch advances before the count is seen */
+        for (;;)
+        {
+            epoch = __atomic_load_n(&oSymTable->epoch,
+                                    __ATOMIC_SEQ_CST);
+            __atomic_add_fetch(&oSymTable->readers[epoch & 1], 1,
+                               __ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&oSymTable->epoch, __ATOMIC_SEQ_CST) ==
+                epoch)
+                break;
+            __atomic_sub_fetch(&oSymTable->readers[epoch & 1], 1,
+                               __ATOMIC_SEQ_CST);
+        }
+
+        psArray = __atomic_load_n(&oSymTable->array, __ATOMIC_ACQUIRE);
+        s = SymTable_findSlot(psArray, pcKey, uHash);
+        iFound = s != psArray->slotCount;
+        if (iFound)
+            *ppvValue = (void *)__atomic_load_n(
+                &psArray->slots[s].value, __ATOMIC_RELAXED);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        __atomic_sub_fetch(&oSymTable->readers[epoch & 1], 1,
+                           __ATOMIC_SEQ_CST);
+    } while (__atomic_load_n(&oSymTable->seq, __ATOMIC_RELAXED) != seq);
+
+    return iFound;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Move every binding of oSymTable into a slot array with at least
+twice as many slots. Return 1 (TRUE) if successful, or 0 (FALSE) if
+insufficient memory is available, in which case oSymTable is left
+unchanged */
+
+static int SymTable_tryExpand(SymTable_T oSymTable)
+{
+    struct SlotArray *psOld = oSymTable->array;
+    struct SlotArray *psNew;
+    size_t newSlotCount = psOld->slotCount;
+    size_t i;
+    int iFits;
+
+    /* Keep doubling until every binding finds a neighborhood slot */
+    do
+    {
+        /* Handle case where slot count would overflow */
+        if (newSlotCount * 2 < newSlotCount)
+            return 0;
+        newSlotCount *= 2;
+
+        psNew = SymTable_newArray(newSlotCount);
+        if (psNew == NULL)
+            return 0;
+
+        iFits = 1;
+        for (i = 0; iFits && i < psOld->slotCount; i++)
+        {
+            if (psOld->slots[i].key != NULL)
+                iFits = SymTable_place(psNew, psOld->slots[i].key,
+                                       psOld->slots[i].value,
+                                       psOld->slots[i].hash);
+        }
+
+        if (!iFits)
+            free(psNew);
+    } while (!iFits);
+
+    /* Publish the new array, and retire the old one */
+    __atomic_store_n(&oSymTable->array, psNew, __ATOMIC_RELEASE);
+    SymTable_retire(oSymTable, psOld);
+
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If oSymTable does not contain a binding with key pcKey, add a new
+binding with key pcKey and value pvValue and return 1 (TRUE).
+Otherwise, or if insufficient memory is available, leave oSymTable
+unchanged and return 0 (FALSE). The caller holds the writer lock */
+
+static int SymTable_insert(SymTable_T oSymTable,
+                           const char *pcKey, const void *pvValue)
+{
+    struct SlotArray *psArray = oSymTable->array;
+    size_t uHash;
+    char *keyCopy;
+
+    uHash = SymTable_hash(pcKey);
+
+    /* Handle condition where binding with pcKey already exists */
+    if (SymTable_findSlot(psArray, pcKey, uHash) != psArray->slotCount)
+        return 0;
+
+    /* Attempt to expand hash table if adding one more binding would
+    exceed the maximum load factor */
+    if ((oSymTable->bindingsCount + 1) * MAX_LOAD_DENOM >
+        psArray->slotCount * MAX_LOAD_NUMER)
+        (void)SymTable_tryExpand(oSymTable);
+
+    /* Copy the key string defensively */
+    keyCopy = malloc(strlen(pcKey) + 1);
+
+    /* Handle condition of insufficient memory for defensive copy
+    of key string */
+    if (keyCopy == NULL)
+        return 0;
+
+    /* Copy string into newly allocated memory */
+    strcpy(keyCopy, pcKey);
+
+    /* Insert new binding, expanding the table if its neighborhood
+    cannot make room */
+    while (!SymTable_place(oSymTable->array, keyCopy, pvValue, uHash))
+    {
+        if (!SymTable_tryExpand(oSymTable))
+        {
+            free(keyCopy);
+            return 0;
+        }
+    }
+
+    __atomic_store_n(&oSymTable->bindingsCount,
+                     oSymTable->bindingsCount + 1, __ATOMIC_RELAXED);
+
+    /* Successful insertion*/
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new SymTable object that contains no bindings, which may
+be shared among threads if iConcurrent is 1 (TRUE), or NULL if
+insufficient memory is available */
+
+static SymTable_T SymTable_create(int iConcurrent)
+{
+    SymTable_T oSymTable;
+
+    /* Allocate memory for a new symbol table */
+    oSymTable = malloc(sizeof(struct SymTable));
+
+    /* Handle case if allocation of memory to symTable pointer fails */
+    if (oSymTable == NULL)
+    {
+        return NULL;
+    }
+
+    /* Initialize fields for new symbol table */
+    oSymTable->bindingsCount = 0;
+    oSymTable->isConcurrent = iConcurrent;
+    oSymTable->seq = 0;
+    oSymTable->epoch = 0;
+    oSymTable->readers[0] = 0;
+    oSymTable->readers[1] = 0;
+    oSymTable->retired = NULL;
+    oSymTable->retiredCount = 0;
+    oSymTable->retiredCapacity = 0;
+    oSymTable->expired = NULL;
+    oSymTable->expiredCount = 0;
+    oSymTable->expiredCapacity = 0;
+    oSymTable->array = SymTable_newArray(INITIAL_SLOT_COUNT);
+
+    /* Handle case where allocation of memory for array of slots
+    fails */
+    if (oSymTable->array == NULL)
+    {
+        free(oSymTable);
+        return NULL;
+    }
+
+    if (iConcurrent &&
+        pthread_mutex_init(&oSymTable->writeLock, NULL) != 0)
+    {
+        free(oSymTable->array);
+        free(oSymTable);
+        return NULL;
+    }
+
+    return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+    return SymTable_create(0);
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newConcurrent(void)
+{
+    return SymTable_create(1);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    struct SlotArray *psArray;
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    psArray = oSymTable->array;
+
+    /* Free the key copy held in every occupied slot */
+    for (i = 0; i < psArray->slotCount; i++)
+        free((void *)psArray->slots[i].key);
+
+    /* Free the retired pointers and the slot array */
+    for (i = 0; i < oSymTable->retiredCount; i++)
+        free(oSymTable->retired[i]);
+    free(oSymTable->retired);
+    for (i = 0; i < oSymTable->expiredCount; i++)
+        free(oSymTable->expired[i]);
+    free(oSymTable->expired);
+    free(psArray);
+
+    if (oSymTable->isConcurrent)
+        (void)pthread_mutex_destroy(&oSymTable->writeLock);
+
+    /* Free the symbol table structure */
+    free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    return __atomic_load_n(&oSymTable->bindingsCount, __ATOMIC_RELAXED);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable,
+                 const char *pcKey, const void *pvValue)
+{
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SymTable_writeBegin(oSymTable);
+    iSuccessful = SymTable_insert(oSymTable, pcKey, pvValue);
+    SymTable_writeEnd(oSymTable);
+
+    return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable,
+                       const char *pcKey, const void *pvValue)
+{
+    struct SlotArray *psArray;
+    size_t s;
+    void *oldValue = NULL;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SymTable_writeBegin(oSymTable);
+    psArray = oSymTable->array;
+    s = SymTable_findSlot(psArray, pcKey, SymTable_hash(pcKey));
+
+    /* Save old value, then replace with new value */
+    if (s != psArray->slotCount)
+    {
+        oldValue = (void *)psArray->slots[s].value;
+        __atomic_store_n(&psArray->slots[s].value, pvValue,
+                         __ATOMIC_RELAXED);
+    }
+
+    SymTable_writeEnd(oSymTable);
+    return oldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_lookup(oSymTable, pcKey, &pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* Handle condition where no binding with pcKey exists */
+    if (!SymTable_lookup(oSymTable, pcKey, &pvValue))
+        return NULL;
+
+    return pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    struct SlotArray *psArray;
+    size_t s;
+    const char *key;
+    void *bindingValue = NULL;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SymTable_writeBegin(oSymTable);
+    psArray = oSymTable->array;
+    s = SymTable_findSlot(psArray, pcKey, SymTable_hash(pcKey));
+
+    /* Handle condition where binding with pcKey exists */
+    if (s != psArray->slotCount)
+    {
+        key = psArray->slots[s].key;
+        bindingValue = (void *)psArray->slots[s].value;
+        SymTable_clearSlot(psArray, s);
+        SymTable_retire(oSymTable, (void *)key);
+        __atomic_store_n(&oSymTable->bindingsCount,
+                         oSymTable->bindingsCount - 1, __ATOMIC_RELAXED);
+    }
+
+    SymTable_writeEnd(oSymTable);
+    return bindingValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue,
+                                  void *pvExtra),
+                  const void *pvExtra)
+{
+    struct SlotArray *psArray;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /* Hold the writer lock so no binding changes during the walk; the
+    sequence number stays even, so readers are not held up */
+    if (oSymTable->isConcurrent)
+        (void)pthread_mutex_lock(&oSymTable->writeLock);
+
+    psArray = oSymTable->array;
+
+    /* Iterate over all occupied slots */
+    for (i = 0; i < psArray->slotCount; i++)
+    {
+        /* Apply the function on each key/value */
+        if (psArray->slots[i].key != NULL)
+            (void)(*pfApply)(psArray->slots[i].key,
+                             (void *)psArray->slots[i].value,
+                             (void *)pvExtra);
+    }
+
+    if (oSymTable->isConcurrent)
+        (void)pthread_mutex_unlock(&oSymTable->writeLock);
+}
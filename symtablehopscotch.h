@@ -0,0 +1,25 @@
+/*--------------------------------------------------------------------*/
+/* symtablehopscotch.h                                                */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+# ifndef SYMTABLEHOPSCOTCH
+# define SYMTABLEHOPSCOTCH
+
+#include "symtable.h"
+
+/*--------------------------------------------------------------------*/
+/* Return a new SymTable object that contains no bindings and that
+may be shared among threads, or NULL if insufficient memory is
+available. SymTable_get, SymTable_contains and SymTable_getLength may
+be called from any number of threads at once without taking a lock,
+even while another thread updates oSymTable. SymTable_put,
+SymTable_replace, SymTable_remove and SymTable_map serialize on a lock
+held by oSymTable, so *pfApply must not update oSymTable. Values
+returned by SymTable_remove and SymTable_replace may still be returned
+to readers that started before the update. SymTable_free must only be
+called once no other thread uses oSymTable */
+
+SymTable_T SymTable_newConcurrent(void);
+
+# endif
@@ -0,0 +1,227 @@
+/*--------------------------------------------------------------------*/
+/* symtablekeys.c                                                     */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+/* Hash-table-based implementation of a shared store of key strings.
+Each distinct string is stored once, in an Entry that also holds its
+hash code and reference count, and the strings handed out are the
+copies inside the entries, so releasing a string finds its entry by
+address without hashing or comparing it. Collisions handled via
+separate chaining; the bucket array doubles when the average chain
+would grow longer than one */
+
+#include "symtablekeys.h"
+#include "symtablehashcode.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Initial number of buckets. Must be a power of two so that a hash
+code can be reduced to a bucket index with a mask */
+static const size_t INITIAL_BUCKET_COUNT = 512;
+
+/* Each Entry holds one distinct string */
+struct Entry
+{
+    /* Pointer to next entry in bucket chain */
+    struct Entry *next;
+    /* Full hash code of the string */
+    size_t hash;
+    /* Number of references to the string */
+    size_t refCount;
+    /* The string */
+    char string[];
+};
+
+/* SymTableKeys structure represents the store */
+struct SymTableKeys
+{
+    /* Array of bucket heads */
+    struct Entry **buckets;
+    /* Number of buckets (a power of two) */
+    size_t bucketCount;
+    /* Number of distinct strings */
+    size_t entriesCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the full hash code for pcKey */
+
+static size_t SymTableKeys_hash(const char *pcKey)
+{
+    return (size_t)SymTableHashCode_full(pcKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the entry whose string is pcKey, which must have been
+returned by SymTableKeys_intern */
+
+static struct Entry *SymTableKeys_entry(const char *pcKey)
+{
+    return (struct Entry *)(void *)(pcKey -
+                                    offsetof(struct Entry, string));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Double the bucket array of oKeys, doing nothing if insufficient
+memory is available */
+
+static void SymTableKeys_tryExpand(SymTableKeys_T oKeys)
+{
+    struct Entry **newBuckets;
+    struct Entry *curr, *next;
+    size_t newBucketCount, u, hashSlot;
+
+    newBucketCount = oKeys->bucketCount * 2;
+    newBuckets = calloc(newBucketCount, sizeof(struct Entry *));
+    if (newBuckets == NULL)
+        return;
+
+    /* Relink every entry, using its saved hash code */
+    for (u = 0; u < oKeys->bucketCount; u++)
+    {
+        for (curr = oKeys->buckets[u]; curr != NULL; curr = next)
+        {
+            next = curr->next;
+            hashSlot = curr->hash & (newBucketCount - 1);
+            curr->next = newBuckets[hashSlot];
+            newBuckets[hashSlot] = curr;
+        }
+    }
+
+    /* Swaps in the new bucket array and records new size */
+    free(oKeys->buckets);
+    oKeys->buckets = newBuckets;
+    oKeys->bucketCount = newBucketCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTableKeys_T SymTableKeys_new(void)
+{
+    SymTableKeys_T oKeys;
+
+    oKeys = malloc(sizeof(struct SymTableKeys));
+    if (oKeys == NULL)
+        return NULL;
+
+    oKeys->bucketCount = INITIAL_BUCKET_COUNT;
+    oKeys->entriesCount = 0;
+    oKeys->buckets = calloc(INITIAL_BUCKET_COUNT,
+                            sizeof(struct Entry *));
+    if (oKeys->buckets == NULL)
+    {
+        free(oKeys);
+        return NULL;
+    }
+
+    return oKeys;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTableKeys_free(SymTableKeys_T oKeys)
+{
+    struct Entry *curr, *next;
+    size_t u;
+
+    assert(oKeys != NULL);
+
+    for (u = 0; u < oKeys->bucketCount; u++)
+    {
+        for (curr = oKeys->buckets[u]; curr != NULL; curr = next)
+        {
+            next = curr->next;
+            free(curr);
+        }
+    }
+
+    free(oKeys->buckets);
+    free(oKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTableKeys_getLength(SymTableKeys_T oKeys)
+{
+    assert(oKeys != NULL);
+    return oKeys->entriesCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+const char *SymTableKeys_intern(SymTableKeys_T oKeys, const char *pcKey)
+{
+    struct Entry *curr;
+    size_t uHash, bucketIndex, uLength;
+
+    assert(oKeys != NULL);
+    assert(pcKey != NULL);
+
+    /* Handle condition where the string is already held */
+    uHash = SymTableKeys_hash(pcKey);
+    bucketIndex = uHash & (oKeys->bucketCount - 1);
+    for (curr = oKeys->buckets[bucketIndex]; curr != NULL;
+         curr = curr->next)
+    {
+        if (curr->hash == uHash && strcmp(curr->string, pcKey) == 0)
+        {
+            curr->refCount++;
+            return curr->string;
+        }
+    }
+
+    /* Attempt to expand the store if adding one more string warrants
+    an expansion */
+    if (oKeys->entriesCount + 1 > oKeys->bucketCount)
+    {
+        SymTableKeys_tryExpand(oKeys);
+        bucketIndex = uHash & (oKeys->bucketCount - 1);
+    }
+
+    /* Add a new entry at the front of the bucket chain */
+    uLength = strlen(pcKey);
+    curr = malloc(offsetof(struct Entry, string) + uLength + 1);
+    if (curr == NULL)
+        return NULL;
+    memcpy(curr->string, pcKey, uLength + 1);
+    curr->hash = uHash;
+    curr->refCount = 1;
+    curr->next = oKeys->buckets[bucketIndex];
+    oKeys->buckets[bucketIndex] = curr;
+    oKeys->entriesCount++;
+
+    return curr->string;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTableKeys_release(SymTableKeys_T oKeys, const char *pcKey)
+{
+    struct Entry *entry;
+    struct Entry **link;
+
+    assert(oKeys != NULL);
+    assert(pcKey != NULL);
+
+    entry = SymTableKeys_entry(pcKey);
+    assert(entry->refCount > 0);
+    if (--entry->refCount > 0)
+        return;
+
+    /* Unlink the entry from its bucket chain, comparing only
+    addresses, and free it */
+    link = &oKeys->buckets[entry->hash & (oKeys->bucketCount - 1)];
+    while (*link != entry)
+    {
+        assert(*link != NULL);
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+    free(entry);
+    oKeys->entriesCount--;
+}
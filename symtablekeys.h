@@ -0,0 +1,53 @@
+/*--------------------------------------------------------------------*/
+/* symtablekeys.h                                                     */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+# ifndef SYMTABLEKEYS
+# define SYMTABLEKEYS
+
+#include <stddef.h>
+
+/*
+A SymTableKeys_T is a pointer to a store of key strings that may be
+shared by several symbol tables. The store holds one copy of each
+distinct string, with a count of the references to it, so that tables
+holding the same keys share their storage, and two strings returned
+by the same store are equal exactly when their addresses are.
+*/
+typedef struct SymTableKeys *SymTableKeys_T;
+
+/*--------------------------------------------------------------------*/
+/* Return a new SymTableKeys object that holds no strings, or NULL if
+insufficient memory is available */
+
+SymTableKeys_T SymTableKeys_new(void);
+
+/*--------------------------------------------------------------------*/
+/* Free oKeys and every string it holds. No string returned by oKeys
+may be used afterwards, so every table sharing oKeys must be freed
+first */
+
+void SymTableKeys_free(SymTableKeys_T oKeys);
+
+/*--------------------------------------------------------------------*/
+/* Return the number of distinct strings held by oKeys */
+
+size_t SymTableKeys_getLength(SymTableKeys_T oKeys);
+
+/*--------------------------------------------------------------------*/
+/* Return the copy of pcKey held by oKeys, adding one if there is
+none, and count one more reference to it. Return NULL if insufficient
+memory is available */
+
+const char *SymTableKeys_intern(SymTableKeys_T oKeys,
+                                const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* Count one less reference to pcKey, which must have been returned by
+SymTableKeys_intern for oKeys, and free it once no reference is
+left */
+
+void SymTableKeys_release(SymTableKeys_T oKeys, const char *pcKey);
+
+# endif
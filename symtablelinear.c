@@ -0,0 +1,493 @@
+/*--------------------------------------------------------------------*/
+/* symtablelinear.c                                                   */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+/* Linear-hashing implementation of symbol table that maps string keys
+to void* values. Each key is stored with defensive copy to ensure
+ownership by symbol table. Collisions handled via separate chaining
+with linked lists within each bucket. Instead of rehashing every
+binding into a bigger bucket array at once, the table grows by one
+bucket at a time: whenever the load factor would exceed 1, the bucket
+at the split pointer is split into itself and one new bucket at the
+end, so each insertion does a bounded amount of growth work. Buckets
+live in fixed-size segments reached through a small directory, so no
+bucket is ever moved and no large array is ever reallocated */
+
+#include "symtable.h"
+#include "symtablehashcode.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Number of buckets in each segment. Must be a power of two */
+enum {SEGMENT_SIZE = 512};
+
+/* Number of buckets before the first split. Must be a power of two
+that is a multiple of SEGMENT_SIZE */
+static const size_t INITIAL_BUCKET_COUNT = 512;
+
+/* Number of directory entries allocated when the table is created */
+static const size_t INITIAL_DIRECTORY_SIZE = 16;
+
+/* Each Binding represents a key-value pair in hash table bucket */
+struct Binding
+{
+    /* Pointer to the key string (defensive copy) */
+    const char *key;
+    /* Pointer to the associated value */
+    const void *value;
+    /* Full hash code of key, kept so that a split never has to
+    rehash a key */
+    size_t hash;
+    /* Pointer to next binding in bucket chain */
+    struct Binding *next;
+};
+
+/* A Segment is a fixed-size block of bucket heads */
+struct Segment
+{
+    /* Array of bucket heads */
+    struct Binding *buckets[SEGMENT_SIZE];
+};
+
+/* SymTable structure represents overall hash table */
+struct SymTable
+{
+    /* Directory of pointers to segments */
+    struct Segment **directory;
+    /* Number of entries directory has room for */
+    size_t directorySize;
+    /* Number of buckets in use */
+    size_t bucketCount;
+    /* Number of buckets at the start of the current round of splits.
+    Bucket addresses are taken modulo twice this for buckets that have
+    already been split in this round */
+    size_t roundSize;
+    /* Index of the next bucket to be split */
+    size_t splitIndex;
+    /* Stores total number of bindings in SymTable */
+    size_t bindingsCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the full hash code for pcKey */
+
+static size_t SymTable_hash(const char *pcKey)
+{
+    return (size_t)SymTableHashCode_full(pcKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the index of the bucket of oSymTable in which a key whose
+hash code is uHash belongs */
+
+static size_t SymTable_address(SymTable_T oSymTable, size_t uHash)
+{
+    size_t i = uHash & (oSymTable->roundSize - 1);
+
+    /* Buckets before the split pointer have already been split, so
+    use one more bit of the hash code for them */
+    if (i < oSymTable->splitIndex)
+        i = uHash & (oSymTable->roundSize * 2 - 1);
+
+    return i;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a pointer to the head of bucket uIndex of oSymTable */
+
+static struct Binding **SymTable_bucket(SymTable_T oSymTable,
+                                        size_t uIndex)
+{
+    return &oSymTable->directory[uIndex / SEGMENT_SIZE]
+                ->buckets[uIndex % SEGMENT_SIZE];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Split the bucket at the split pointer of oSymTable, moving the
+bindings that now belong to a new last bucket into it. Do nothing if
+memory for a new segment or a larger directory is not available */
+
+static void SymTable_split(SymTable_T oSymTable)
+{
+    struct Segment **newDirectory;
+    struct Binding *curr, *next;
+    struct Binding **oldBucket, **newBucket;
+    size_t newIndex, segment, newDirectorySize;
+
+    newIndex = oSymTable->bucketCount;
+    segment = newIndex / SEGMENT_SIZE;
+
+    /* Handle case where the new bucket starts a new segment */
+    if (newIndex % SEGMENT_SIZE == 0)
+    {
+        /* Grow the directory if it is full */
+        if (segment == oSymTable->directorySize)
+        {
+            newDirectorySize = oSymTable->directorySize * 2;
+            newDirectory = realloc(oSymTable->directory,
+                                   newDirectorySize *
+                                       sizeof(struct Segment *));
+            if (newDirectory == NULL)
+                return;
+            oSymTable->directory = newDirectory;
+            oSymTable->directorySize = newDirectorySize;
+        }
+
+        oSymTable->directory[segment] =
+            calloc(1, sizeof(struct Segment));
+        if (oSymTable->directory[segment] == NULL)
+            return;
+    }
+
+    oldBucket = SymTable_bucket(oSymTable, oSymTable->splitIndex);
+    newBucket = SymTable_bucket(oSymTable, newIndex);
+
+    /* Advance the split pointer first, so that SymTable_address
+    distinguishes the two halves of the split bucket */
+    oSymTable->bucketCount++;
+    oSymTable->splitIndex++;
+
+    /* Redistribute the bindings of the old bucket */
+    curr = *oldBucket;
+    *oldBucket = NULL;
+    while (curr != NULL)
+    {
+        next = curr->next;
+
+        if (SymTable_address(oSymTable, curr->hash) == newIndex)
+        {
+            curr->next = *newBucket;
+            *newBucket = curr;
+        }
+        else
+        {
+            curr->next = *oldBucket;
+            *oldBucket = curr;
+        }
+
+        curr = next;
+    }
+
+    /* Start a new round once every bucket of this one has split */
+    if (oSymTable->splitIndex == oSymTable->roundSize)
+    {
+        oSymTable->roundSize *= 2;
+        oSymTable->splitIndex = 0;
+    }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the binding of oSymTable whose key is pcKey and whose hash
+code is uHash, or NULL if no such binding exists */
+
+static struct Binding *SymTable_find(SymTable_T oSymTable,
+                                     const char *pcKey, size_t uHash)
+{
+    struct Binding *curr;
+
+    /* Initialize curr to first binding in hash bucket */
+    curr = *SymTable_bucket(oSymTable,
+                            SymTable_address(oSymTable, uHash));
+
+    /* Traverse through all the bindings in hash bucket */
+    while (curr != NULL)
+    {
+        /* Handle condition where binding with pcKey exists */
+        if (curr->hash == uHash && strcmp(curr->key, pcKey) == 0)
+            return curr;
+
+        /* Otherwise, move on to the next binding */
+        curr = curr->next;
+    }
+
+    /* Handle condition where no binding with pcKey exists */
+    return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+    SymTable_T oSymTable;
+    size_t i;
+
+    /* Allocate memory for a new symbol table */
+    oSymTable = malloc(sizeof(struct SymTable));
+
+    /* Handle case if allocation of memory to symTable pointer fails */
+    if (oSymTable == NULL)
+    {
+        return NULL;
+    }
+
+    /* Initialize fields for new symbol table */
+    oSymTable->directorySize = INITIAL_DIRECTORY_SIZE;
+    oSymTable->bucketCount = INITIAL_BUCKET_COUNT;
+    oSymTable->roundSize = INITIAL_BUCKET_COUNT;
+    oSymTable->splitIndex = 0;
+    oSymTable->bindingsCount = 0;
+    oSymTable->directory = calloc(oSymTable->directorySize,
+                                  sizeof(struct Segment *));
+
+    /* Handle case where allocation of memory for directory fails */
+    if (oSymTable->directory == NULL)
+    {
+        free(oSymTable);
+        return NULL;
+    }
+
+    /* Allocate the segments holding the initial buckets */
+    for (i = 0; i < INITIAL_BUCKET_COUNT / SEGMENT_SIZE; i++)
+    {
+        oSymTable->directory[i] = calloc(1, sizeof(struct Segment));
+        if (oSymTable->directory[i] == NULL)
+        {
+            while (i > 0)
+                free(oSymTable->directory[--i]);
+            free(oSymTable->directory);
+            free(oSymTable);
+            return NULL;
+        }
+    }
+
+    return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    size_t i;
+    struct Binding *curr;
+    struct Binding *next;
+
+    assert(oSymTable != NULL);
+
+    /* Free every binding in every bucket */
+    for (i = 0; i < oSymTable->bucketCount; i++)
+    {
+        /* Initialize curr to first binding in bucket */
+        curr = *SymTable_bucket(oSymTable, i);
+
+        /* Traverse through all the bindings in bucket */
+        while (curr != NULL)
+        {
+            /* Save pointer to next before freeing curr */
+            next = curr->next;
+
+            /* Free the key copy */
+            free((void *)curr->key);
+            /* Free the current binding node */
+            free(curr);
+
+            /* Move to the next binding in bucket */
+            curr = next;
+        }
+    }
+
+    /* Free every segment in use, then the directory */
+    for (i = 0; i * SEGMENT_SIZE < oSymTable->bucketCount; i++)
+        free(oSymTable->directory[i]);
+    free(oSymTable->directory);
+    /* Free the symbol table structure */
+    free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    return oSymTable->bindingsCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable,
+                 const char *pcKey, const void *pvValue)
+{
+    struct Binding *newBinding;
+    struct Binding **bucket;
+    size_t uHash;
+    char *keyCopy;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uHash = SymTable_hash(pcKey);
+
+    /* Handle condition where binding with pcKey already exists */
+    if (SymTable_find(oSymTable, pcKey, uHash) != NULL)
+        return 0;
+
+    /* Split one bucket if adding one more binding would make the load
+    factor exceed 1 */
+    if (oSymTable->bindingsCount + 1 > oSymTable->bucketCount)
+        SymTable_split(oSymTable);
+
+    /* Allocate memory for new binding */
+    newBinding = malloc(sizeof(struct Binding));
+
+    /* Handle condition of insufficient memory for new binding */
+    if (newBinding == NULL)
+        return 0;
+
+    /* Copy the key string defensively */
+    keyCopy = malloc(strlen(pcKey) + 1);
+
+    /* Handle condition of insufficient memory for defensive copy
+    of key string */
+    if (keyCopy == NULL)
+    {
+        free(newBinding);
+        return 0;
+    }
+
+    /* Copy string into newly allocated memory */
+    strcpy(keyCopy, pcKey);
+
+    /* Insert new binding at the front of the bucket chain */
+    bucket = SymTable_bucket(oSymTable,
+                             SymTable_address(oSymTable, uHash));
+    newBinding->key = keyCopy;
+    newBinding->value = pvValue;
+    newBinding->hash = uHash;
+    newBinding->next = *bucket;
+    *bucket = newBinding;
+
+    oSymTable->bindingsCount++;
+
+    /* Successful insertion*/
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable,
+                       const char *pcKey, const void *pvValue)
+{
+    struct Binding *curr;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    curr = SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey));
+
+    /* Handle condition where no binding with pcKey exists */
+    if (curr == NULL)
+        return NULL;
+
+    /* Save old value, then replace with new value */
+    oldValue = (void *)curr->value;
+    curr->value = pvValue;
+    return oldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey))
+        != NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    struct Binding *curr;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    curr = SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey));
+
+    /* Handle condition where no binding with pcKey exists */
+    if (curr == NULL)
+        return NULL;
+
+    return (void *)curr->value;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    struct Binding **link;
+    struct Binding *nodeRemoved;
+    size_t uHash;
+    void *bindingValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uHash = SymTable_hash(pcKey);
+    link = SymTable_bucket(oSymTable,
+                           SymTable_address(oSymTable, uHash));
+
+    /* Search through bindings in bucket chain, keeping a pointer to
+    the link that refers to the current binding */
+    while (*link != NULL)
+    {
+        /* Handle condition where binding with pcKey exists */
+        if ((*link)->hash == uHash && strcmp((*link)->key, pcKey) == 0)
+        {
+            nodeRemoved = *link;
+            bindingValue = (void *)nodeRemoved->value;
+            *link = nodeRemoved->next;
+            free((void *)nodeRemoved->key);
+            free(nodeRemoved);
+            oSymTable->bindingsCount--;
+            return bindingValue;
+        }
+
+        /* Otherwise, move on to the next binding */
+        link = &(*link)->next;
+    }
+
+    /* Handle condition where no binding with pcKey exists */
+    return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue,
+                                  void *pvExtra),
+                  const void *pvExtra)
+{
+    size_t i;
+    struct Binding *curr;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /* Iterate over all buckets and bindings */
+    for (i = 0; i < oSymTable->bucketCount; i++)
+    {
+        /* Initialize curr to first binding in bucket */
+        curr = *SymTable_bucket(oSymTable, i);
+
+        /* Traverse through all the bindings in bucket */
+        while (curr != NULL)
+        {
+            /* Apply the function on each key/value */
+            (void)(*pfApply)(curr->key, (void *)curr->value,
+                             (void *)pvExtra);
+
+            /* Move to the next binding */
+            curr = curr->next;
+        }
+    }
+}
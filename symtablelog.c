@@ -0,0 +1,721 @@
+/*--------------------------------------------------------------------*/
+/* symtablelog.c                                                      */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+/* Snapshot and write-ahead log files for symbol tables. Log records
+are collected in a memory buffer and written and forced to disk one
+group at a time, so a burst of updates costs one fsync per group
+instead of one per update. Snapshots are written to a temporary file,
+named after the writing process, that is renamed over the old snapshot
+once it is safely on disk.
+Each file starts with a record of its generation, which a checkpoint
+advances, so that a log left behind by a crash during a checkpoint is
+recognized as older than the snapshot and not replayed over it */
+
+#define _XOPEN_SOURCE 700
+
+#include "symtablelog.h"
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Byte offsets of the fields of a record. A record consists of a
+checksum of the rest of the record, its kind, the length of its key
+(without the null character), the length of its encoded value, the
+key, and the encoded value */
+enum {REC_CHECKSUM = 0, REC_KIND = 4, REC_KEYLEN = 5, REC_VALUELEN = 9,
+      REC_KEY = 13};
+
+/* Kind of the record that gives the generation of a file in its key,
+as a decimal number */
+enum {SYMTABLELOG_GENERATION = 3};
+
+/* Largest key or encoded value accepted when reading a record, so that
+a corrupt length cannot cause a huge allocation */
+static const uint32_t MAX_FIELD_LENGTH = (uint32_t)1 << 30;
+
+/* Number of bytes of pending records that forces a group to disk even
+if it is not complete */
+static const size_t MAX_PENDING_BYTES = 1024 * 1024;
+
+/* SymTableLog structure represents the durability files of a table */
+struct SymTableLog
+{
+    /* Name of the snapshot file */
+    char *snapshotPath;
+    /* Name of the log file */
+    char *logPath;
+    /* File descriptor of the log file, or -1 if it is not open */
+    int fd;
+    /* Functions that encode and decode values */
+    const struct SymTable_Codec *codec;
+    /* Number of records in a group */
+    size_t groupSize;
+    /* Number of records in buffer */
+    size_t pendingCount;
+    /* Buffer of records not yet written to the log file */
+    unsigned char *buffer;
+    /* Number of bytes used in buffer */
+    size_t bufferUsed;
+    /* Number of bytes buffer has room for */
+    size_t bufferCapacity;
+    /* 1 (TRUE) if a write to the log file has failed */
+    int failed;
+    /* Generation of the log file, that of the last snapshot */
+    unsigned long generation;
+};
+
+/* A SnapshotWriter holds the state of a snapshot being written by
+SymTable_map */
+struct SnapshotWriter
+{
+    /* Temporary snapshot file */
+    FILE *fp;
+    /* Functions that encode values */
+    const struct SymTable_Codec *codec;
+    /* Buffer in which each record is built */
+    unsigned char *buffer;
+    /* Number of bytes buffer has room for */
+    size_t bufferCapacity;
+    /* 1 (TRUE) if building or writing a record has failed */
+    int failed;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the 32-bit FNV-1a checksum of the uLength bytes at pucData */
+
+static uint32_t SymTableLog_checksum(const unsigned char *pucData,
+                                     size_t uLength)
+{
+    uint32_t uiSum = 2166136261U;
+    size_t u;
+
+    for (u = 0; u < uLength; u++)
+    {
+        uiSum ^= pucData[u];
+        uiSum *= 16777619U;
+    }
+
+    return uiSum;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a newly allocated copy of string pcString, or NULL if
+insufficient memory is available */
+
+static char *SymTableLog_copyString(const char *pcString)
+{
+    char *pcCopy = malloc(strlen(pcString) + 1);
+
+    if (pcCopy != NULL)
+        strcpy(pcCopy, pcString);
+    return pcCopy;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make *ppucBuf, which has room for *puCapacity bytes, large enough
+for uNeeded bytes, preserving its contents. Return 1 (TRUE) if
+successful, or 0 (FALSE) if insufficient memory is available */
+
+static int SymTableLog_reserve(unsigned char **ppucBuf,
+                               size_t *puCapacity, size_t uNeeded)
+{
+    unsigned char *pucNew;
+    size_t uNewCapacity;
+
+    if (uNeeded <= *puCapacity)
+        return 1;
+
+    uNewCapacity = *puCapacity * 2;
+    if (uNewCapacity < uNeeded)
+        uNewCapacity = uNeeded;
+
+    pucNew = realloc(*ppucBuf, uNewCapacity);
+    if (pucNew == NULL)
+        return 0;
+
+    *ppucBuf = pucNew;
+    *puCapacity = uNewCapacity;
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Build at offset uOffset of *ppucBuf, which has room for *puCapacity
+bytes and is grown as needed, a record of kind iKind for key pcKey and
+value pvValue encoded by *psCodec. Store the length of the record in
+*puLength. Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient
+memory is available */
+
+static int SymTableLog_build(unsigned char **ppucBuf, size_t *puCapacity,
+                             size_t uOffset, int iKind, const char *pcKey,
+                             const void *pvValue,
+                             const struct SymTable_Codec *psCodec,
+                             size_t *puLength)
+{
+    size_t uKeyLength, uValueLength, uRoom;
+    uint32_t uiField;
+    unsigned char *pucRec;
+
+    uKeyLength = strlen(pcKey);
+    if (!SymTableLog_reserve(ppucBuf, puCapacity,
+                             uOffset + REC_KEY + uKeyLength))
+        return 0;
+
+    /* Encode the value into the room left, growing the buffer and
+    encoding again if the room was too small */
+    uValueLength = 0;
+    if (iKind == SYMTABLELOG_SET)
+    {
+        uRoom = *puCapacity - uOffset - REC_KEY - uKeyLength;
+        uValueLength = (*psCodec->pfEncode)(
+            pvValue, *ppucBuf + uOffset + REC_KEY + uKeyLength, uRoom);
+        if (uValueLength > uRoom)
+        {
+            if (!SymTableLog_reserve(ppucBuf, puCapacity,
+                                     uOffset + REC_KEY + uKeyLength +
+                                         uValueLength))
+                return 0;
+            (void)(*psCodec->pfEncode)(
+                pvValue, *ppucBuf + uOffset + REC_KEY + uKeyLength,
+                uValueLength);
+        }
+    }
+
+    /* Fill in the header and key, then checksum the record */
+    pucRec = *ppucBuf + uOffset;
+    pucRec[REC_KIND] = (unsigned char)iKind;
+    uiField = (uint32_t)uKeyLength;
+    memcpy(pucRec + REC_KEYLEN, &uiField, sizeof(uiField));
+    uiField = (uint32_t)uValueLength;
+    memcpy(pucRec + REC_VALUELEN, &uiField, sizeof(uiField));
+    memcpy(pucRec + REC_KEY, pcKey, uKeyLength);
+    uiField = SymTableLog_checksum(pucRec + REC_KIND,
+                                   REC_KEY - REC_KIND + uKeyLength +
+                                       uValueLength);
+    memcpy(pucRec + REC_CHECKSUM, &uiField, sizeof(uiField));
+
+    *puLength = REC_KEY + uKeyLength + uValueLength;
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Build at the start of *ppucBuf, which has room for *puCapacity bytes
+and is grown as needed, a record of generation ulGeneration. Store the
+length of the record in *puLength. Return 1 (TRUE) if successful, or 0
+(FALSE) if insufficient memory is available */
+
+static int SymTableLog_buildGeneration(
+    unsigned char **ppucBuf, size_t *puCapacity,
+    unsigned long ulGeneration, const struct SymTable_Codec *psCodec,
+    size_t *puLength)
+{
+    char acGeneration[32];
+
+    sprintf(acGeneration, "%lu", ulGeneration);
+    return SymTableLog_build(ppucBuf, puCapacity, 0,
+                             SYMTABLELOG_GENERATION, acGeneration, NULL,
+                             psCodec, puLength);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Apply to oSymTable a record of kind iKind for key pcKey and value
+pvValue decoded by *psCodec, freeing through *psCodec any value that
+is replaced or removed. Return 1 (TRUE) if successful, or 0 (FALSE) if
+insufficient memory is available */
+
+static int SymTableLog_apply(SymTable_T oSymTable, int iKind,
+                             const char *pcKey, void *pvValue,
+                             const struct SymTable_Codec *psCodec)
+{
+    void *pvOld;
+    int iSuccessful = 1;
+
+    if (iKind == SYMTABLELOG_REMOVE)
+        pvOld = SymTable_remove(oSymTable, pcKey);
+    else if (SymTable_contains(oSymTable, pcKey))
+        pvOld = SymTable_replace(oSymTable, pcKey, pvValue);
+    else if (SymTable_put(oSymTable, pcKey, pvValue))
+        pvOld = NULL;
+    else
+    {
+        /* Handle case where the binding cannot be added */
+        pvOld = pvValue;
+        iSuccessful = 0;
+    }
+
+    if (psCodec->pfFree != NULL && pvOld != NULL)
+        (*psCodec->pfFree)(pvOld);
+
+    return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Apply to oSymTable the records of the file named pcPath, decoding
+values with *psCodec, and store in *puValidLength the length of the
+file up to the first record that is incomplete or corrupt. Store the
+generation of the file in *pulGeneration, unless it is older than
+ulOldest, in which case the file is stale and is treated as empty, as
+is a missing file. Return 1 (TRUE) if successful, or 0 (FALSE) if
+insufficient memory is available or the file cannot be read */
+
+static int SymTableLog_replay(const char *pcPath, SymTable_T oSymTable,
+                              const struct SymTable_Codec *psCodec,
+                              unsigned long ulOldest,
+                              unsigned long *pulGeneration,
+                              size_t *puValidLength)
+{
+    FILE *fp;
+    unsigned char aucHeader[REC_KEY];
+    unsigned char *pucBody = NULL;
+    size_t uBodyCapacity = 0;
+    uint32_t uiChecksum, uiKeyLength, uiValueLength, uiSum;
+    int iKind;
+    int iSuccessful = 1;
+    unsigned long ulGeneration;
+    void *pvValue;
+
+    *puValidLength = 0;
+
+    fp = fopen(pcPath, "rb");
+    if (fp == NULL)
+        return errno == ENOENT;
+
+    /* Read records until the end of the file or a bad record */
+    while (fread(aucHeader, 1, REC_KEY, fp) == REC_KEY)
+    {
+        memcpy(&uiChecksum, aucHeader + REC_CHECKSUM, sizeof(uint32_t));
+        memcpy(&uiKeyLength, aucHeader + REC_KEYLEN, sizeof(uint32_t));
+        memcpy(&uiValueLength, aucHeader + REC_VALUELEN,
+               sizeof(uint32_t));
+        iKind = aucHeader[REC_KIND];
+
+        /* Handle condition where the header is corrupt */
+        if ((iKind != SYMTABLELOG_SET && iKind != SYMTABLELOG_REMOVE &&
+             iKind != SYMTABLELOG_GENERATION) ||
+            uiKeyLength > MAX_FIELD_LENGTH ||
+            uiValueLength > MAX_FIELD_LENGTH)
+            break;
+
+        /* Read the key and value after a copy of the header, leaving
+        room for the key's null character */
+        if (!SymTableLog_reserve(&pucBody, &uBodyCapacity,
+                                 REC_KEY + (size_t)uiKeyLength +
+                                     uiValueLength + 1))
+        {
+            iSuccessful = 0;
+            break;
+        }
+        memcpy(pucBody, aucHeader, REC_KEY);
+        if (fread(pucBody + REC_KEY, 1,
+                  (size_t)uiKeyLength + uiValueLength, fp) !=
+            (size_t)uiKeyLength + uiValueLength)
+            break;
+
+        /* Handle condition where the record is torn or corrupt */
+        uiSum = SymTableLog_checksum(pucBody + REC_KIND,
+                                     REC_KEY - REC_KIND +
+                                         (size_t)uiKeyLength +
+                                         uiValueLength);
+        if (uiSum != uiChecksum)
+            break;
+
+        /* Move the value up one byte to terminate the key */
+        memmove(pucBody + REC_KEY + uiKeyLength + 1,
+                pucBody + REC_KEY + uiKeyLength, uiValueLength);
+        pucBody[REC_KEY + uiKeyLength] = '\0';
+
+        /* Stop at the generation of a stale file, whose records are
+        already in the snapshot */
+        if (iKind == SYMTABLELOG_GENERATION)
+        {
+            ulGeneration = strtoul((const char *)(pucBody + REC_KEY),
+                                   NULL, 10);
+            if (ulGeneration < ulOldest)
+                break;
+            *pulGeneration = ulGeneration;
+            *puValidLength += REC_KEY + (size_t)uiKeyLength;
+            continue;
+        }
+
+        pvValue = NULL;
+        if (iKind == SYMTABLELOG_SET)
+            pvValue = (*psCodec->pfDecode)(
+                pucBody + REC_KEY + uiKeyLength + 1, uiValueLength);
+        if (!SymTableLog_apply(oSymTable, iKind,
+                               (const char *)(pucBody + REC_KEY),
+                               pvValue, psCodec))
+        {
+            iSuccessful = 0;
+            break;
+        }
+
+        *puValidLength += REC_KEY + (size_t)uiKeyLength + uiValueLength;
+    }
+
+    if (ferror(fp))
+        iSuccessful = 0;
+    free(pucBody);
+    (void)fclose(fp);
+    return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the uLength bytes at pucData to file descriptor fd. Return 1
+(TRUE) if successful, or 0 (FALSE) otherwise */
+
+static int SymTableLog_writeAll(int fd, const unsigned char *pucData,
+                                size_t uLength)
+{
+    ssize_t iWritten;
+
+    while (uLength > 0)
+    {
+        iWritten = write(fd, pucData, uLength);
+        if (iWritten < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return 0;
+        }
+        pucData += iWritten;
+        uLength -= (size_t)iWritten;
+    }
+
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Force the directory that contains the file named pcPath to disk, so
+that a file just created or renamed in it survives a crash. Return 1
+(TRUE) if successful, or 0 (FALSE) otherwise */
+
+static int SymTableLog_syncDirectory(const char *pcPath)
+{
+    char *pcDir;
+    char *pcSlash;
+    int fd;
+    int iSuccessful;
+
+    pcDir = SymTableLog_copyString(pcPath);
+    if (pcDir == NULL)
+        return 0;
+
+    pcSlash = strrchr(pcDir, '/');
+    if (pcSlash == NULL)
+        strcpy(pcDir, ".");
+    else if (pcSlash == pcDir)
+        pcDir[1] = '\0';
+    else
+        *pcSlash = '\0';
+
+    fd = open(pcDir, O_RDONLY);
+    free(pcDir);
+    if (fd < 0)
+        return 0;
+
+    iSuccessful = fsync(fd) == 0;
+    (void)close(fd);
+    return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Append to the snapshot described by pvExtra a record setting key
+pcKey to value pvValue */
+
+static void SymTableLog_writeBinding(const char *pcKey, void *pvValue,
+                                     void *pvExtra)
+{
+    struct SnapshotWriter *psWriter = pvExtra;
+    size_t uLength;
+
+    assert(pcKey != NULL);
+    assert(psWriter != NULL);
+
+    if (psWriter->failed)
+        return;
+
+    if (!SymTableLog_build(&psWriter->buffer, &psWriter->bufferCapacity,
+                           0, SYMTABLELOG_SET, pcKey, pvValue,
+                           psWriter->codec, &uLength) ||
+        fwrite(psWriter->buffer, 1, uLength, psWriter->fp) != uLength)
+        psWriter->failed = 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the empty log file of oLog, whose buffer must hold no pending
+records, a record of its generation, and force it to disk. Return 1
+(TRUE) if successful, or 0 (FALSE) otherwise */
+
+static int SymTableLog_startLog(SymTableLog_T oLog)
+{
+    size_t uLength;
+
+    return SymTableLog_buildGeneration(&oLog->buffer,
+                                       &oLog->bufferCapacity,
+                                       oLog->generation, oLog->codec,
+                                       &uLength) &&
+           SymTableLog_writeAll(oLog->fd, oLog->buffer, uLength) &&
+           fsync(oLog->fd) == 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write every binding of oSymTable, with values encoded by *psCodec,
+to a snapshot file of generation ulGeneration named pcPath, replacing
+any previous file of that name atomically. Return 1 (TRUE) if
+successful, or 0 (FALSE) otherwise */
+
+static int SymTableLog_saveSnapshot(
+    const char *pcPath, SymTable_T oSymTable,
+    const struct SymTable_Codec *psCodec, unsigned long ulGeneration)
+{
+    struct SnapshotWriter writer;
+    char *pcTempPath;
+    size_t uLength;
+    int iSuccessful;
+
+    assert(pcPath != NULL);
+    assert(oSymTable != NULL);
+    assert(psCodec != NULL);
+
+    /* Write the snapshot next to its final name, in a file named
+    after this process so that two writers never share one */
+    pcTempPath = malloc(strlen(pcPath) + sizeof(".tmp.") +
+                        3 * sizeof(long));
+    if (pcTempPath == NULL)
+        return 0;
+    sprintf(pcTempPath, "%s.tmp.%ld", pcPath, (long)getpid());
+
+    writer.fp = fopen(pcTempPath, "wb");
+    if (writer.fp == NULL)
+    {
+        free(pcTempPath);
+        return 0;
+    }
+    writer.codec = psCodec;
+    writer.buffer = NULL;
+    writer.bufferCapacity = 0;
+    writer.failed = 0;
+
+    if (!SymTableLog_buildGeneration(&writer.buffer,
+                                     &writer.bufferCapacity,
+                                     ulGeneration, psCodec, &uLength) ||
+        fwrite(writer.buffer, 1, uLength, writer.fp) != uLength)
+        writer.failed = 1;
+    SymTable_map(oSymTable, SymTableLog_writeBinding, &writer);
+    free(writer.buffer);
+
+    /* Force the file to disk before it replaces the old snapshot */
+    iSuccessful = !writer.failed && fflush(writer.fp) == 0 &&
+                  fsync(fileno(writer.fp)) == 0;
+    if (fclose(writer.fp) != 0)
+        iSuccessful = 0;
+    if (iSuccessful)
+        iSuccessful = rename(pcTempPath, pcPath) == 0 &&
+                      SymTableLog_syncDirectory(pcPath);
+    if (!iSuccessful)
+        (void)unlink(pcTempPath);
+
+    free(pcTempPath);
+    return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableLog_writeSnapshot(const char *pcPath, SymTable_T oSymTable,
+                              const struct SymTable_Codec *psCodec)
+{
+    assert(pcPath != NULL);
+    assert(oSymTable != NULL);
+    assert(psCodec != NULL);
+
+    /* A snapshot of generation 0 is older than every log, so a log
+    kept with it is always replayed over it */
+    return SymTableLog_saveSnapshot(pcPath, oSymTable, psCodec, 0);
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTableLog_T SymTableLog_new(const char *pcSnapshotPath,
+                              const char *pcLogPath,
+                              const struct SymTable_Codec *psCodec,
+                              size_t uGroupSize)
+{
+    SymTableLog_T oLog;
+
+    assert(pcLogPath != NULL);
+    assert(psCodec != NULL);
+
+    oLog = calloc(1, sizeof(struct SymTableLog));
+    if (oLog == NULL)
+        return NULL;
+
+    oLog->fd = -1;
+    oLog->codec = psCodec;
+    oLog->groupSize = uGroupSize > 0 ? uGroupSize : 1;
+    if (pcSnapshotPath != NULL)
+        oLog->snapshotPath = SymTableLog_copyString(pcSnapshotPath);
+    oLog->logPath = SymTableLog_copyString(pcLogPath);
+
+    /* Handle case where copying either file name fails */
+    if ((pcSnapshotPath != NULL && oLog->snapshotPath == NULL) ||
+        oLog->logPath == NULL)
+    {
+        SymTableLog_free(oLog);
+        return NULL;
+    }
+
+    return oLog;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableLog_recover(SymTableLog_T oLog, SymTable_T oSymTable)
+{
+    size_t uValidLength;
+
+    assert(oLog != NULL);
+    assert(oSymTable != NULL);
+    assert(oLog->fd < 0);
+
+    /* Rebuild the table from the snapshot, if any, then from the log
+    unless it is older than the snapshot */
+    oLog->generation = 0;
+    if (oLog->snapshotPath != NULL &&
+        !SymTableLog_replay(oLog->snapshotPath, oSymTable, oLog->codec,
+                            0, &oLog->generation, &uValidLength))
+        return 0;
+    if (!SymTableLog_replay(oLog->logPath, oSymTable, oLog->codec,
+                            oLog->generation, &oLog->generation,
+                            &uValidLength))
+        return 0;
+
+    /* Cut off any torn record, so that new records follow the last
+    good one, and start an empty or stale log afresh */
+    oLog->fd = open(oLog->logPath, O_WRONLY | O_CREAT | O_APPEND, 0666);
+    if (oLog->fd < 0)
+        return 0;
+    if (ftruncate(oLog->fd, (off_t)uValidLength) != 0 ||
+        fsync(oLog->fd) != 0 ||
+        (uValidLength == 0 && !SymTableLog_startLog(oLog)))
+    {
+        (void)close(oLog->fd);
+        oLog->fd = -1;
+        return 0;
+    }
+
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableLog_append(SymTableLog_T oLog, int iKind,
+                       const char *pcKey, const void *pvValue)
+{
+    size_t uLength;
+
+    assert(oLog != NULL);
+    assert(pcKey != NULL);
+    assert(oLog->fd >= 0);
+
+    if (!SymTableLog_build(&oLog->buffer, &oLog->bufferCapacity,
+                           oLog->bufferUsed, iKind, pcKey, pvValue,
+                           oLog->codec, &uLength))
+    {
+        oLog->failed = 1;
+        return 0;
+    }
+    oLog->bufferUsed += uLength;
+    oLog->pendingCount++;
+
+    /* Force the group to disk once it is complete */
+    if (oLog->pendingCount >= oLog->groupSize ||
+        oLog->bufferUsed >= MAX_PENDING_BYTES)
+        return SymTableLog_sync(oLog);
+
+    return !oLog->failed;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableLog_sync(SymTableLog_T oLog)
+{
+    assert(oLog != NULL);
+
+    if (oLog->fd < 0 || oLog->bufferUsed == 0)
+        return !oLog->failed;
+
+    if (!SymTableLog_writeAll(oLog->fd, oLog->buffer, oLog->bufferUsed) ||
+        fsync(oLog->fd) != 0)
+        oLog->failed = 1;
+
+    oLog->bufferUsed = 0;
+    oLog->pendingCount = 0;
+    return !oLog->failed;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableLog_checkpoint(SymTableLog_T oLog, SymTable_T oSymTable)
+{
+    assert(oLog != NULL);
+    assert(oSymTable != NULL);
+    assert(oLog->snapshotPath != NULL);
+
+    /* The snapshot covers every pending record, so they need not be
+    written. It belongs to the next generation, so that if a crash
+    leaves the log unemptied, recovery skips the log instead of
+    replaying it, records written before the snapshot and all, over
+    the newer bindings */
+    if (!SymTableLog_saveSnapshot(oLog->snapshotPath, oSymTable,
+                                  oLog->codec, oLog->generation + 1))
+        return 0;
+
+    oLog->generation++;
+    oLog->bufferUsed = 0;
+    oLog->pendingCount = 0;
+    oLog->failed = 0;
+    if (oLog->fd >= 0 &&
+        (ftruncate(oLog->fd, 0) != 0 || !SymTableLog_startLog(oLog)))
+    {
+        oLog->failed = 1;
+        return 0;
+    }
+
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTableLog_free(SymTableLog_T oLog)
+{
+    assert(oLog != NULL);
+
+    if (oLog->fd >= 0)
+    {
+        (void)SymTableLog_sync(oLog);
+        (void)close(oLog->fd);
+    }
+
+    free(oLog->buffer);
+    free(oLog->snapshotPath);
+    free(oLog->logPath);
+    free(oLog);
+}
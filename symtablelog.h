@@ -0,0 +1,92 @@
+/*--------------------------------------------------------------------*/
+/* symtablelog.h                                                      */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+# ifndef SYMTABLELOG
+# define SYMTABLELOG
+
+#include "symtable.h"
+#include "symtablecodec.h"
+
+/*
+A SymTableLog_T is a pointer to the durability files of a symbol
+table: a snapshot file holding every binding as of the last
+checkpoint, and a write-ahead log file holding every update since.
+Both files consist of records, each of which either sets the value of
+a key or removes a key, protected by a checksum so that a record torn
+by a crash is recognized and ignored. Values are written through a
+SymTable_Codec. Both files also record the generation of the last
+checkpoint, so that a log that a crash left behind after its snapshot
+was replaced is known to be stale.
+*/
+typedef struct SymTableLog *SymTableLog_T;
+
+/* Kinds of log records */
+enum {SYMTABLELOG_SET = 1, SYMTABLELOG_REMOVE = 2};
+
+/*--------------------------------------------------------------------*/
+/* Return a new SymTableLog object for snapshot file pcSnapshotPath and
+log file pcLogPath, whose values are written through *psCodec and
+whose log records are forced to disk in groups of uGroupSize records,
+or NULL if insufficient memory is available. pcSnapshotPath may be
+NULL for a log that is never checkpointed. The files are not touched
+until SymTableLog_recover is called */
+
+SymTableLog_T SymTableLog_new(const char *pcSnapshotPath,
+                              const char *pcLogPath,
+                              const struct SymTable_Codec *psCodec,
+                              size_t uGroupSize);
+
+/*--------------------------------------------------------------------*/
+/* Apply to oSymTable, which must not be logged to oLog yet, the
+records of the snapshot file and then of the log file of oLog, either
+of which may be missing. Values are decoded by the codec of oLog, and
+values that are replaced or removed are freed by it. Then discard any
+torn record at the end of the log file and open it for appending.
+Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+available or a file cannot be read or opened */
+
+int SymTableLog_recover(SymTableLog_T oLog, SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+/* Append to oLog a record of kind iKind for key pcKey and value
+pvValue, which is ignored for SYMTABLELOG_REMOVE records. Force the
+log to disk if this completes a group. Return 1 (TRUE) if successful,
+or 0 (FALSE) if the log could not be written */
+
+int SymTableLog_append(SymTableLog_T oLog, int iKind,
+                       const char *pcKey, const void *pvValue);
+
+/*--------------------------------------------------------------------*/
+/* Force every record appended to oLog to disk. Return 1 (TRUE) if
+successful, or 0 (FALSE) if the log could not be written now or at
+any earlier time */
+
+int SymTableLog_sync(SymTableLog_T oLog);
+
+/*--------------------------------------------------------------------*/
+/* Write every binding of oSymTable to the snapshot file of oLog,
+which must have one, replacing the previous snapshot atomically, and
+then empty the log file. Return 1 (TRUE) if successful, or 0 (FALSE)
+otherwise, in which case the previous snapshot and the log remain
+valid */
+
+int SymTableLog_checkpoint(SymTableLog_T oLog, SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+/* Write every binding of oSymTable, with values encoded by *psCodec,
+to a snapshot file named pcPath, replacing any previous file of that
+name atomically. Return 1 (TRUE) if successful, or 0 (FALSE)
+otherwise */
+
+int SymTableLog_writeSnapshot(const char *pcPath, SymTable_T oSymTable,
+                              const struct SymTable_Codec *psCodec);
+
+/*--------------------------------------------------------------------*/
+/* Force every record appended to oLog to disk, close its files, and
+free all memory occupied by oLog */
+
+void SymTableLog_free(SymTableLog_T oLog);
+
+# endif
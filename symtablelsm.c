@@ -0,0 +1,1871 @@
+/*--------------------------------------------------------------------*/
+/* symtablelsm.c                                                      */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+/* Log-structured store built from hash-table symbol tables. Updates
+are put into a memtable, a symtablehash.c table whose values are
+encoded entries, and appended to the memtable's write-ahead log. When
+the memtable is full it is frozen and a new one is started; a
+flushing thread sorts the frozen memtable by key and writes it to a
+run file, then deletes its log. A run consists of blocks of about 4 KB
+of records, a sparse index holding the first key of each block, a
+Bloom filter of its keys, and a footer that locates the index and the
+filter. The index and filter of every run are kept in memory, so a
+lookup reads at most one block of each run whose filter admits the
+key.
+
+A merging thread merges runs as they accumulate, while the flushing
+thread goes on writing memtables, so that a long merge does not hold
+up the writer. The newest runs are
+merged as long as each older run is not much larger than the newer
+ones combined, which keeps the number of runs logarithmic in the size
+of the store while rewriting each binding a logarithmic number of
+times. Removals are recorded as tombstones, which are dropped when the
+oldest run takes part in a merge.
+
+A run file is named after the range of memtable sequence numbers it
+covers, and a log file after the sequence number of its memtable.
+Files are written under temporary names and renamed when complete, so
+on reopening, runs covered by a merged run and logs covered by a run
+are leftovers of an interrupted operation and are deleted, and the
+remaining logs are replayed and written to runs */
+
+#define _XOPEN_SOURCE 700
+
+#include "symtablelsm.h"
+#include "symtablehash.h"
+#include "symtablehashcode.h"
+#include "symtablelog.h"
+#include <assert.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Kinds of entries and run records, and the kind reported for a run
+that cannot be read */
+enum {KIND_VALUE = 1, KIND_TOMBSTONE = 2, KIND_ERROR = 3};
+
+/* Number of bytes of records after which a run starts a new block */
+enum {BLOCK_BYTES = 4096};
+
+/* Bloom filter bits per key and number of probes per key, which give a
+false positive rate of about 1% */
+enum {BLOOM_BITS_PER_KEY = 10, BLOOM_HASH_COUNT = 7};
+
+/* Number of runs at which the merging thread merges runs */
+enum {COMPACTION_TRIGGER = 4};
+
+/* An older run is merged with the newer runs only if it is at most
+MERGE_RATIO times as large as all of them together */
+enum {MERGE_RATIO = 2};
+
+/* Number of log records forced to disk at a time */
+enum {WAL_GROUP_SIZE = 4096};
+
+/* Bytes charged to the memtable for each binding besides its key and
+value, approximating the memory used by the hash table */
+enum {ENTRY_OVERHEAD = 64};
+
+/* Byte offsets of the fields of a run record: the length of its key
+including the null character, the length of its value, its kind, and
+then the key and the value */
+enum {REC_KEYLEN = 0, REC_VALUELEN = 4, REC_KIND = 8, REC_KEY = 9};
+
+/* Byte offsets of the fields of an index record: the length of its key
+including the null character, the offset of its block, and the key */
+enum {IDX_KEYLEN = 0, IDX_OFFSET = 4, IDX_KEY = 12};
+
+/* Byte offsets of the fields of a run footer, and its length */
+enum {FTR_INDEX_OFFSET = 0, FTR_INDEX_COUNT = 8, FTR_BLOOM_OFFSET = 16,
+      FTR_BLOOM_BITS = 24, FTR_RECORD_COUNT = 32, FTR_HASH_COUNT = 40,
+      FTR_MAGIC = 44, FOOTER_BYTES = 48};
+
+/* Number that ends every run file */
+static const uint32_t RUN_MAGIC = 0x4C534D31U;
+
+/* Size of the stdio buffer of a run being written, and of the buffer
+through which a run is read during a merge */
+enum {WRITE_BUFFER_BYTES = 1024 * 1024, READ_BUFFER_BYTES = 64 * 1024};
+
+/* An Entry is the value of a binding in a memtable: its kind and the
+encoding of its value */
+struct Entry
+{
+    /* Number of bytes in bytes */
+    size_t length;
+    /* KIND_VALUE or KIND_TOMBSTONE */
+    unsigned char kind;
+    /* Encoded value */
+    unsigned char bytes[];
+};
+
+/* An IndexEntry gives the first key of a block of a run */
+struct IndexEntry
+{
+    /* First key of the block */
+    char *key;
+    /* Offset of the block within the run file */
+    uint64_t offset;
+};
+
+/* A Run is an open run file */
+struct Run
+{
+    /* Name of the file */
+    char *path;
+    /* File descriptor of the file */
+    int fd;
+    /* Sequence numbers of the oldest and newest memtables covered */
+    unsigned long minSeq;
+    unsigned long maxSeq;
+    /* Number of bytes of records, which start the file */
+    uint64_t dataBytes;
+    /* Number of bytes in the file */
+    uint64_t fileBytes;
+    /* Sparse index, one entry per block in key order */
+    struct IndexEntry *index;
+    /* Number of entries in index */
+    size_t indexCount;
+    /* Bloom filter of the keys of the run */
+    unsigned char *bloom;
+    /* Number of bits in bloom */
+    uint64_t bloomBits;
+    /* Number of probes per key in bloom */
+    unsigned int hashCount;
+};
+
+/* A RunWriter holds the state of a run being written */
+struct RunWriter
+{
+    /* Temporary file being written */
+    FILE *fp;
+    /* Name of the temporary file */
+    char *tempPath;
+    /* Number of bytes written so far */
+    uint64_t offset;
+    /* Offset at which the current block started */
+    uint64_t blockStart;
+    /* Index entries of the blocks written so far */
+    struct IndexEntry *index;
+    size_t indexCount;
+    size_t indexCapacity;
+    /* Hash codes of the keys written so far */
+    uint64_t *hashes;
+    size_t hashCount;
+    size_t hashCapacity;
+    /* 1 (TRUE) if writing has failed */
+    int failed;
+};
+
+/* A RunReader reads the records of a run in order during a merge */
+struct RunReader
+{
+    /* Run being read */
+    struct Run *run;
+    /* Offset in the file of the first byte not yet read into buffer */
+    uint64_t offset;
+    /* Bytes read from the file */
+    unsigned char *buffer;
+    size_t bufferCapacity;
+    /* Position in buffer of the current record */
+    size_t position;
+    /* Number of bytes of buffer holding data */
+    size_t length;
+    /* Fields of the current record, valid while valid is 1 (TRUE) */
+    const char *key;
+    int kind;
+    const unsigned char *value;
+    size_t valueLength;
+    int valid;
+    /* 1 (TRUE) if reading has failed */
+    int failed;
+};
+
+/* A Pair is a binding of a memtable being sorted */
+struct Pair
+{
+    const char *key;
+    struct Entry *entry;
+};
+
+/* A PairList collects the bindings of a memtable through
+SymTable_map */
+struct PairList
+{
+    struct Pair *pairs;
+    size_t count;
+};
+
+/* SymTableLsm structure represents the store */
+struct SymTableLsm
+{
+    /* Directory holding the files */
+    char *dir;
+    /* Functions that encode and decode values */
+    const struct SymTable_Codec *codec;
+    /* Number of bytes at which the memtable is frozen */
+    size_t memtableLimit;
+
+    /* Memtable receiving updates, used only by the caller's thread */
+    SymTable_T active;
+    SymTableLog_T activeLog;
+    unsigned long activeSeq;
+    size_t activeBytes;
+    /* Sequence number of the next memtable */
+    unsigned long nextSeq;
+
+    /* Fields below are guarded by mutex. The frozen memtable is
+    cleared only by the flushing thread, which may therefore read it
+    without the mutex; a run is freed only by the merging thread, which
+    may therefore read its inputs without the mutex */
+    pthread_mutex_t mutex;
+    /* Signaled when there is work for a background thread and when
+    the frozen memtable has been written */
+    pthread_cond_t cond;
+    /* Frozen memtable being written to a run, or NULL */
+    SymTable_T frozen;
+    SymTableLog_T frozenLog;
+    unsigned long frozenSeq;
+    /* Runs, newest first */
+    struct Run **runs;
+    size_t runCount;
+    size_t runCapacity;
+    /* 1 (TRUE) if writing a run has failed */
+    int failed;
+    /* 1 (TRUE) if the background threads are to stop */
+    int stopping;
+
+    /* Background threads, and the number of them started */
+    pthread_t flusher;
+    pthread_t merger;
+    int threadCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a hash code for pcKey */
+
+static uint64_t SymTableLsm_hash(const char *pcKey)
+{
+    return SymTableHashCode_full(pcKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the uProbe-th bit of a Bloom filter of uBits bits for a key
+whose hash code is uHash, by double hashing */
+
+static uint64_t SymTableLsm_bloomBit(uint64_t uHash, unsigned int uProbe,
+                                     uint64_t uBits)
+{
+    uint64_t uFirst = uHash & 0xFFFFFFFFU;
+    uint64_t uStep = (uHash >> 32) | 1;
+
+    return (uFirst + uProbe * uStep) % uBits;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a newly allocated string consisting of directory pcDir, a
+slash, and pcName, or NULL if insufficient memory is available */
+
+static char *SymTableLsm_joinPath(const char *pcDir, const char *pcName)
+{
+    char *pcPath = malloc(strlen(pcDir) + strlen(pcName) + 2);
+
+    if (pcPath != NULL)
+        sprintf(pcPath, "%s/%s", pcDir, pcName);
+    return pcPath;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the name of the run file of oLsm covering sequence numbers
+ulMinSeq through ulMaxSeq, or NULL if insufficient memory is
+available */
+
+static char *SymTableLsm_runPath(SymTableLsm_T oLsm,
+                                 unsigned long ulMinSeq,
+                                 unsigned long ulMaxSeq)
+{
+    char acName[64];
+
+    sprintf(acName, "run-%lu-%lu.sst", ulMinSeq, ulMaxSeq);
+    return SymTableLsm_joinPath(oLsm->dir, acName);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the name of the log file of oLsm for memtable ulSeq, or NULL
+if insufficient memory is available */
+
+static char *SymTableLsm_walPath(SymTableLsm_T oLsm, unsigned long ulSeq)
+{
+    char acName[64];
+
+    sprintf(acName, "wal-%lu.log", ulSeq);
+    return SymTableLsm_joinPath(oLsm->dir, acName);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Force the directory of oLsm to disk, so that files just created,
+renamed or removed in it stay so after a crash. Return 1 (TRUE) if
+successful, or 0 (FALSE) otherwise */
+
+static int SymTableLsm_syncDirectory(SymTableLsm_T oLsm)
+{
+    int fd;
+    int iSuccessful;
+
+    fd = open(oLsm->dir, O_RDONLY);
+    if (fd < 0)
+        return 0;
+    iSuccessful = fsync(fd) == 0;
+    (void)close(fd);
+    return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read uLength bytes at offset uOffset of file descriptor fd into
+pvBuf. Return 1 (TRUE) if successful, or 0 (FALSE) otherwise */
+
+static int SymTableLsm_readAt(int fd, void *pvBuf, size_t uLength,
+                              uint64_t uOffset)
+{
+    unsigned char *pucBuf = pvBuf;
+    ssize_t iRead;
+
+    while (uLength > 0)
+    {
+        iRead = pread(fd, pucBuf, uLength, (off_t)uOffset);
+        if (iRead < 0 && errno == EINTR)
+            continue;
+        if (iRead <= 0)
+            return 0;
+        pucBuf += iRead;
+        uLength -= (size_t)iRead;
+        uOffset += (uint64_t)iRead;
+    }
+
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Entries are logged through this codec: an encoded entry is its
+kind followed by its bytes. Write the encoding of entry pvValue to
+pvBuf if uBufSize bytes are enough, and return its length */
+
+static size_t SymTableLsm_encodeEntry(const void *pvValue, void *pvBuf,
+                                      size_t uBufSize)
+{
+    const struct Entry *psEntry = pvValue;
+    unsigned char *pucBuf = pvBuf;
+
+    assert(psEntry != NULL);
+
+    if (uBufSize >= psEntry->length + 1)
+    {
+        pucBuf[0] = psEntry->kind;
+        memcpy(pucBuf + 1, psEntry->bytes, psEntry->length);
+    }
+    return psEntry->length + 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new entry whose encoding is the uLength bytes at pvBuf, or
+NULL if insufficient memory is available */
+
+static void *SymTableLsm_decodeEntry(const void *pvBuf, size_t uLength)
+{
+    const unsigned char *pucBuf = pvBuf;
+    struct Entry *psEntry;
+
+    if (uLength == 0)
+        return NULL;
+
+    psEntry = malloc(sizeof(struct Entry) + uLength - 1);
+    if (psEntry == NULL)
+        return NULL;
+    psEntry->kind = pucBuf[0];
+    psEntry->length = uLength - 1;
+    memcpy(psEntry->bytes, pucBuf + 1, uLength - 1);
+    return psEntry;
+}
+
+/* Codec of the write-ahead logs */
+static const struct SymTable_Codec ENTRY_CODEC =
+{
+    SymTableLsm_encodeEntry, SymTableLsm_decodeEntry, free
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new entry of kind iKind for value pvValue, which is ignored
+for KIND_TOMBSTONE, encoded by *psCodec, or NULL if insufficient
+memory is available */
+
+static struct Entry *SymTableLsm_newEntry(
+    const struct SymTable_Codec *psCodec, int iKind, const void *pvValue)
+{
+    struct Entry *psEntry;
+    size_t uLength = 0;
+
+    if (iKind == KIND_VALUE)
+        uLength = (*psCodec->pfEncode)(pvValue, NULL, 0);
+
+    psEntry = malloc(sizeof(struct Entry) + uLength);
+    if (psEntry == NULL)
+        return NULL;
+
+    psEntry->kind = (unsigned char)iKind;
+    psEntry->length = uLength;
+    if (iKind == KIND_VALUE)
+        (void)(*psCodec->pfEncode)(pvValue, psEntry->bytes, uLength);
+    return psEntry;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free entry pvValue of the binding whose key is pcKey. pvExtra is
+unused */
+
+static void SymTableLsm_freeEntry(const char *pcKey, void *pvValue,
+                                  void *pvExtra)
+{
+    assert(pcKey != NULL);
+    (void)pvExtra;
+    free(pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free memtable oMemtable with all of its entries, and close its log
+oLog, forcing it to disk, if oLog is not NULL */
+
+static void SymTableLsm_freeMemtable(SymTable_T oMemtable,
+                                     SymTableLog_T oLog)
+{
+    if (oLog != NULL)
+        SymTableLog_free(oLog);
+    if (oMemtable != NULL)
+    {
+        SymTable_map(oMemtable, SymTableLsm_freeEntry, NULL);
+        SymTable_free(oMemtable);
+    }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store in *poMemtable and *poLog the memtable of oLsm with sequence
+number ulSeq and its log, replaying the log if it exists and creating
+it otherwise. Return 1 (TRUE) if successful, or 0 (FALSE) if
+insufficient memory is available or the log cannot be read or
+created */
+
+static int SymTableLsm_openMemtable(SymTableLsm_T oLsm,
+                                    unsigned long ulSeq,
+                                    SymTable_T *poMemtable,
+                                    SymTableLog_T *poLog)
+{
+    char *pcPath;
+
+    pcPath = SymTableLsm_walPath(oLsm, ulSeq);
+    if (pcPath == NULL)
+        return 0;
+
+    *poMemtable = SymTable_new();
+    *poLog = SymTableLog_new(NULL, pcPath, &ENTRY_CODEC, WAL_GROUP_SIZE);
+    free(pcPath);
+
+    /* Handle case where the table or log cannot be made or replayed */
+    if (*poMemtable == NULL || *poLog == NULL ||
+        !SymTableLog_recover(*poLog, *poMemtable))
+    {
+        if (*poLog != NULL)
+            SymTableLog_free(*poLog);
+        if (*poMemtable != NULL)
+            SymTableLsm_freeMemtable(*poMemtable, NULL);
+        return 0;
+    }
+
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Delete the log file of oLsm for memtable ulSeq */
+
+static void SymTableLsm_removeWal(SymTableLsm_T oLsm, unsigned long ulSeq)
+{
+    char *pcPath = SymTableLsm_walPath(oLsm, ulSeq);
+
+    if (pcPath != NULL)
+    {
+        (void)unlink(pcPath);
+        free(pcPath);
+    }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Close run psRun, delete its file if iUnlink is 1 (TRUE), and free
+all memory occupied by it */
+
+static void SymTableLsm_freeRun(struct Run *psRun, int iUnlink)
+{
+    size_t u;
+
+    if (psRun->fd >= 0)
+        (void)close(psRun->fd);
+    if (iUnlink)
+        (void)unlink(psRun->path);
+
+    for (u = 0; u < psRun->indexCount; u++)
+        free(psRun->index[u].key);
+    free(psRun->index);
+    free(psRun->bloom);
+    free(psRun->path);
+    free(psRun);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the run in file pcPath, which covers sequence numbers
+ulMinSeq through ulMaxSeq, with its index and Bloom filter loaded, or
+NULL if insufficient memory is available or the file cannot be read or
+is not a complete run */
+
+static struct Run *SymTableLsm_openRun(const char *pcPath,
+                                       unsigned long ulMinSeq,
+                                       unsigned long ulMaxSeq)
+{
+    struct Run *psRun;
+    struct stat sStat;
+    unsigned char aucFooter[FOOTER_BYTES];
+    unsigned char *pucIndex = NULL;
+    uint64_t uIndexOffset, uIndexCount, uBloomOffset, uBloomBytes;
+    uint64_t uPos;
+    uint32_t uiField;
+    size_t u;
+    int iSuccessful = 0;
+
+    psRun = calloc(1, sizeof(struct Run));
+    if (psRun == NULL)
+        return NULL;
+    psRun->minSeq = ulMinSeq;
+    psRun->maxSeq = ulMaxSeq;
+    psRun->path = malloc(strlen(pcPath) + 1);
+    psRun->fd = -1;
+    if (psRun->path == NULL)
+    {
+        SymTableLsm_freeRun(psRun, 0);
+        return NULL;
+    }
+    strcpy(psRun->path, pcPath);
+
+    /* Read and check the footer */
+    psRun->fd = open(pcPath, O_RDONLY);
+    if (psRun->fd < 0 || fstat(psRun->fd, &sStat) != 0 ||
+        sStat.st_size < FOOTER_BYTES ||
+        !SymTableLsm_readAt(psRun->fd, aucFooter, FOOTER_BYTES,
+                            (uint64_t)sStat.st_size - FOOTER_BYTES))
+    {
+        SymTableLsm_freeRun(psRun, 0);
+        return NULL;
+    }
+    psRun->fileBytes = (uint64_t)sStat.st_size;
+    memcpy(&uIndexOffset, aucFooter + FTR_INDEX_OFFSET, 8);
+    memcpy(&uIndexCount, aucFooter + FTR_INDEX_COUNT, 8);
+    memcpy(&uBloomOffset, aucFooter + FTR_BLOOM_OFFSET, 8);
+    memcpy(&psRun->bloomBits, aucFooter + FTR_BLOOM_BITS, 8);
+    memcpy(&uiField, aucFooter + FTR_HASH_COUNT, 4);
+    psRun->hashCount = uiField;
+    memcpy(&uiField, aucFooter + FTR_MAGIC, 4);
+    uBloomBytes = (psRun->bloomBits + 7) / 8;
+    psRun->dataBytes = uIndexOffset;
+
+    if (uiField != RUN_MAGIC || uIndexOffset > uBloomOffset ||
+        psRun->bloomBits == 0 ||
+        uBloomOffset + uBloomBytes + FOOTER_BYTES != psRun->fileBytes ||
+        uIndexCount > uBloomOffset - uIndexOffset)
+    {
+        SymTableLsm_freeRun(psRun, 0);
+        return NULL;
+    }
+
+    /* Read the index and the Bloom filter */
+    pucIndex = malloc((size_t)(uBloomOffset - uIndexOffset) + 1);
+    psRun->index = calloc((size_t)uIndexCount + 1,
+                          sizeof(struct IndexEntry));
+    psRun->bloom = malloc((size_t)uBloomBytes);
+    if (pucIndex != NULL && psRun->index != NULL && psRun->bloom != NULL &&
+        SymTableLsm_readAt(psRun->fd, pucIndex,
+                           (size_t)(uBloomOffset - uIndexOffset),
+                           uIndexOffset) &&
+        SymTableLsm_readAt(psRun->fd, psRun->bloom, (size_t)uBloomBytes,
+                           uBloomOffset))
+    {
+        /* Parse the index records */
+        iSuccessful = 1;
+        uPos = 0;
+        for (u = 0; u < (size_t)uIndexCount && iSuccessful; u++)
+        {
+            memcpy(&uiField, pucIndex + uPos + IDX_KEYLEN, 4);
+            if (uPos + IDX_KEY + uiField > uBloomOffset - uIndexOffset ||
+                uiField == 0 ||
+                pucIndex[uPos + IDX_KEY + uiField - 1] != '\0')
+            {
+                iSuccessful = 0;
+                break;
+            }
+            memcpy(&psRun->index[u].offset, pucIndex + uPos + IDX_OFFSET,
+                   8);
+            psRun->index[u].key = malloc(uiField);
+            if (psRun->index[u].key == NULL)
+            {
+                iSuccessful = 0;
+                break;
+            }
+            memcpy(psRun->index[u].key, pucIndex + uPos + IDX_KEY,
+                   uiField);
+            psRun->indexCount++;
+            uPos += IDX_KEY + uiField;
+        }
+    }
+
+    free(pucIndex);
+    if (!iSuccessful)
+    {
+        SymTableLsm_freeRun(psRun, 0);
+        return NULL;
+    }
+    return psRun;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Start writing a run to temporary file pcTempPath through writer
+*psWriter. Return 1 (TRUE) if successful, or 0 (FALSE) otherwise */
+
+static int SymTableLsm_startRun(struct RunWriter *psWriter,
+                                const char *pcTempPath)
+{
+    memset(psWriter, 0, sizeof(struct RunWriter));
+
+    psWriter->tempPath = malloc(strlen(pcTempPath) + 1);
+    if (psWriter->tempPath == NULL)
+        return 0;
+    strcpy(psWriter->tempPath, pcTempPath);
+
+    psWriter->fp = fopen(pcTempPath, "wb");
+    if (psWriter->fp == NULL)
+    {
+        free(psWriter->tempPath);
+        return 0;
+    }
+    (void)setvbuf(psWriter->fp, NULL, _IOFBF, WRITE_BUFFER_BYTES);
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Append to the run of *psWriter a record of kind iKind for key pcKey,
+which must follow the key of the previous record, with the uLength
+bytes at pucValue as its value */
+
+static void SymTableLsm_addRecord(struct RunWriter *psWriter,
+                                  const char *pcKey, int iKind,
+                                  const unsigned char *pucValue,
+                                  size_t uLength)
+{
+    unsigned char aucHeader[REC_KEY];
+    struct IndexEntry *psNewIndex;
+    uint64_t *puNewHashes;
+    size_t uKeyLength;
+    uint32_t uiField;
+
+    if (psWriter->failed)
+        return;
+
+    uKeyLength = strlen(pcKey) + 1;
+
+    /* Start a new block, recording its first key in the index */
+    if (psWriter->indexCount == 0 ||
+        psWriter->offset - psWriter->blockStart >= BLOCK_BYTES)
+    {
+        if (psWriter->indexCount == psWriter->indexCapacity)
+        {
+            psWriter->indexCapacity = psWriter->indexCapacity * 2 + 64;
+            psNewIndex = realloc(psWriter->index,
+                                 psWriter->indexCapacity *
+                                     sizeof(struct IndexEntry));
+            if (psNewIndex == NULL)
+            {
+                psWriter->failed = 1;
+                return;
+            }
+            psWriter->index = psNewIndex;
+        }
+        psWriter->index[psWriter->indexCount].key = malloc(uKeyLength);
+        if (psWriter->index[psWriter->indexCount].key == NULL)
+        {
+            psWriter->failed = 1;
+            return;
+        }
+        memcpy(psWriter->index[psWriter->indexCount].key, pcKey,
+               uKeyLength);
+        psWriter->index[psWriter->indexCount].offset = psWriter->offset;
+        psWriter->indexCount++;
+        psWriter->blockStart = psWriter->offset;
+    }
+
+    /* Remember the hash code of the key for the Bloom filter */
+    if (psWriter->hashCount == psWriter->hashCapacity)
+    {
+        psWriter->hashCapacity = psWriter->hashCapacity * 2 + 1024;
+        puNewHashes = realloc(psWriter->hashes,
+                              psWriter->hashCapacity * sizeof(uint64_t));
+        if (puNewHashes == NULL)
+        {
+            psWriter->failed = 1;
+            return;
+        }
+        psWriter->hashes = puNewHashes;
+    }
+    psWriter->hashes[psWriter->hashCount++] = SymTableLsm_hash(pcKey);
+
+    /* Write the record */
+    uiField = (uint32_t)uKeyLength;
+    memcpy(aucHeader + REC_KEYLEN, &uiField, 4);
+    uiField = (uint32_t)uLength;
+    memcpy(aucHeader + REC_VALUELEN, &uiField, 4);
+    aucHeader[REC_KIND] = (unsigned char)iKind;
+    if (fwrite(aucHeader, 1, REC_KEY, psWriter->fp) != REC_KEY ||
+        fwrite(pcKey, 1, uKeyLength, psWriter->fp) != uKeyLength ||
+        fwrite(pucValue, 1, uLength, psWriter->fp) != uLength)
+        psWriter->failed = 1;
+    psWriter->offset += REC_KEY + uKeyLength + uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free the memory held by writer *psWriter, closing and deleting its
+temporary file if it is still open */
+
+static void SymTableLsm_abandonRun(struct RunWriter *psWriter)
+{
+    size_t u;
+
+    if (psWriter->fp != NULL)
+    {
+        (void)fclose(psWriter->fp);
+        (void)unlink(psWriter->tempPath);
+    }
+    for (u = 0; u < psWriter->indexCount; u++)
+        free(psWriter->index[u].key);
+    free(psWriter->index);
+    free(psWriter->hashes);
+    free(psWriter->tempPath);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Append the index, Bloom filter and footer to the run of *psWriter,
+force it to disk, rename it to the run file of oLsm covering sequence
+numbers ulMinSeq through ulMaxSeq, and free *psWriter. Return the
+run, opened, or NULL if insufficient memory is available or the file
+cannot be written */
+
+static struct Run *SymTableLsm_finishRun(SymTableLsm_T oLsm,
+                                         struct RunWriter *psWriter,
+                                         unsigned long ulMinSeq,
+                                         unsigned long ulMaxSeq)
+{
+    unsigned char aucField[FOOTER_BYTES];
+    unsigned char *pucBloom;
+    uint64_t uIndexOffset, uBloomOffset, uBloomBits, uValue, uBit;
+    uint32_t uiField;
+    size_t u;
+    unsigned int uProbe;
+    char *pcPath;
+    struct Run *psRun;
+    int iSuccessful;
+
+    if (psWriter->failed)
+    {
+        SymTableLsm_abandonRun(psWriter);
+        return NULL;
+    }
+
+    /* Write the index */
+    uIndexOffset = psWriter->offset;
+    for (u = 0; u < psWriter->indexCount; u++)
+    {
+        uiField = (uint32_t)(strlen(psWriter->index[u].key) + 1);
+        memcpy(aucField + IDX_KEYLEN, &uiField, 4);
+        memcpy(aucField + IDX_OFFSET, &psWriter->index[u].offset, 8);
+        if (fwrite(aucField, 1, IDX_KEY, psWriter->fp) != IDX_KEY ||
+            fwrite(psWriter->index[u].key, 1, uiField, psWriter->fp) !=
+                uiField)
+            psWriter->failed = 1;
+        psWriter->offset += IDX_KEY + uiField;
+    }
+
+    /* Build and write the Bloom filter */
+    uBloomOffset = psWriter->offset;
+    uBloomBits = (uint64_t)psWriter->hashCount * BLOOM_BITS_PER_KEY;
+    if (uBloomBits < 64)
+        uBloomBits = 64;
+    pucBloom = calloc((size_t)((uBloomBits + 7) / 8), 1);
+    if (pucBloom == NULL)
+    {
+        SymTableLsm_abandonRun(psWriter);
+        return NULL;
+    }
+    for (u = 0; u < psWriter->hashCount; u++)
+        for (uProbe = 0; uProbe < BLOOM_HASH_COUNT; uProbe++)
+        {
+            uBit = SymTableLsm_bloomBit(psWriter->hashes[u], uProbe,
+                                        uBloomBits);
+            pucBloom[uBit / 8] |= (unsigned char)(1U << (uBit % 8));
+        }
+    if (fwrite(pucBloom, 1, (size_t)((uBloomBits + 7) / 8),
+               psWriter->fp) != (size_t)((uBloomBits + 7) / 8))
+        psWriter->failed = 1;
+    free(pucBloom);
+
+    /* Write the footer */
+    memcpy(aucField + FTR_INDEX_OFFSET, &uIndexOffset, 8);
+    uValue = psWriter->indexCount;
+    memcpy(aucField + FTR_INDEX_COUNT, &uValue, 8);
+    memcpy(aucField + FTR_BLOOM_OFFSET, &uBloomOffset, 8);
+    memcpy(aucField + FTR_BLOOM_BITS, &uBloomBits, 8);
+    uValue = psWriter->hashCount;
+    memcpy(aucField + FTR_RECORD_COUNT, &uValue, 8);
+    uiField = BLOOM_HASH_COUNT;
+    memcpy(aucField + FTR_HASH_COUNT, &uiField, 4);
+    memcpy(aucField + FTR_MAGIC, &RUN_MAGIC, 4);
+    if (fwrite(aucField, 1, FOOTER_BYTES, psWriter->fp) != FOOTER_BYTES)
+        psWriter->failed = 1;
+
+    /* Force the file to disk and give it its final name */
+    iSuccessful = !psWriter->failed && fflush(psWriter->fp) == 0 &&
+                  fsync(fileno(psWriter->fp)) == 0;
+    if (fclose(psWriter->fp) != 0)
+        iSuccessful = 0;
+    psWriter->fp = NULL;
+    pcPath = SymTableLsm_runPath(oLsm, ulMinSeq, ulMaxSeq);
+    if (pcPath == NULL || !iSuccessful ||
+        rename(psWriter->tempPath, pcPath) != 0 ||
+        !SymTableLsm_syncDirectory(oLsm))
+    {
+        (void)unlink(psWriter->tempPath);
+        free(pcPath);
+        SymTableLsm_abandonRun(psWriter);
+        return NULL;
+    }
+    SymTableLsm_abandonRun(psWriter);
+
+    psRun = SymTableLsm_openRun(pcPath, ulMinSeq, ulMaxSeq);
+    free(pcPath);
+    return psRun;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a temporary name for the run file of oLsm covering sequence
+numbers ulMinSeq through ulMaxSeq, or NULL if insufficient memory is
+available */
+
+static char *SymTableLsm_tempRunPath(SymTableLsm_T oLsm,
+                                     unsigned long ulMinSeq,
+                                     unsigned long ulMaxSeq)
+{
+    char acName[64];
+
+    sprintf(acName, "run-%lu-%lu.sst.tmp", ulMinSeq, ulMaxSeq);
+    return SymTableLsm_joinPath(oLsm->dir, acName);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add the binding whose key is pcKey and whose entry is pvValue to the
+PairList pvExtra */
+
+static void SymTableLsm_collectPair(const char *pcKey, void *pvValue,
+                                    void *pvExtra)
+{
+    struct PairList *psList = pvExtra;
+
+    psList->pairs[psList->count].key = pcKey;
+    psList->pairs[psList->count].entry = pvValue;
+    psList->count++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return negative, zero or positive as the key of Pair pvFirst is
+less than, equal to or greater than the key of Pair pvSecond */
+
+static int SymTableLsm_comparePairs(const void *pvFirst,
+                                    const void *pvSecond)
+{
+    const struct Pair *psFirst = pvFirst;
+    const struct Pair *psSecond = pvSecond;
+
+    return strcmp(psFirst->key, psSecond->key);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write memtable oMemtable, whose sequence number is ulSeq, to a run of
+oLsm. Return the run, or NULL if insufficient memory is available or
+the file cannot be written */
+
+static struct Run *SymTableLsm_writeMemtable(SymTableLsm_T oLsm,
+                                             SymTable_T oMemtable,
+                                             unsigned long ulSeq)
+{
+    struct PairList list;
+    struct RunWriter writer;
+    char *pcTempPath;
+    size_t u;
+
+    /* Sort the bindings by key */
+    list.count = 0;
+    list.pairs = malloc((SymTable_getLength(oMemtable) + 1) *
+                        sizeof(struct Pair));
+    if (list.pairs == NULL)
+        return NULL;
+    SymTable_map(oMemtable, SymTableLsm_collectPair, &list);
+    qsort(list.pairs, list.count, sizeof(struct Pair),
+          SymTableLsm_comparePairs);
+
+    pcTempPath = SymTableLsm_tempRunPath(oLsm, ulSeq, ulSeq);
+    if (pcTempPath == NULL || !SymTableLsm_startRun(&writer, pcTempPath))
+    {
+        free(pcTempPath);
+        free(list.pairs);
+        return NULL;
+    }
+    free(pcTempPath);
+
+    for (u = 0; u < list.count; u++)
+        SymTableLsm_addRecord(&writer, list.pairs[u].key,
+                              list.pairs[u].entry->kind,
+                              list.pairs[u].entry->bytes,
+                              list.pairs[u].entry->length);
+    free(list.pairs);
+
+    return SymTableLsm_finishRun(oLsm, &writer, ulSeq, ulSeq);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make the next record of the run of *psReader its current record, or
+mark *psReader as not valid if there is none. Set psReader->failed if
+the run cannot be read */
+
+static void SymTableLsm_advance(struct RunReader *psReader)
+{
+    unsigned char *pucNew;
+    uint32_t uiKeyLength, uiValueLength;
+    size_t uNeeded, uRoom;
+    uint64_t uLeft;
+
+    psReader->valid = 0;
+    uNeeded = REC_KEY;
+    for (;;)
+    {
+        /* Use the record at position once all of it is in buffer */
+        if (psReader->length - psReader->position >= REC_KEY)
+        {
+            memcpy(&uiKeyLength,
+                   psReader->buffer + psReader->position + REC_KEYLEN, 4);
+            memcpy(&uiValueLength,
+                   psReader->buffer + psReader->position + REC_VALUELEN,
+                   4);
+            uNeeded = REC_KEY + (size_t)uiKeyLength + uiValueLength;
+            if (psReader->length - psReader->position >= uNeeded)
+                break;
+        }
+
+        /* Handle condition where the run has no more records */
+        uLeft = psReader->run->dataBytes - psReader->offset;
+        if (uLeft == 0)
+        {
+            if (psReader->length != psReader->position)
+                psReader->failed = 1;
+            return;
+        }
+
+        /* Move the partial record to the front of buffer, grow buffer
+        if the record does not fit, and read more of the run */
+        memmove(psReader->buffer, psReader->buffer + psReader->position,
+                psReader->length - psReader->position);
+        psReader->length -= psReader->position;
+        psReader->position = 0;
+        if (uNeeded > psReader->bufferCapacity)
+        {
+            pucNew = realloc(psReader->buffer, uNeeded);
+            if (pucNew == NULL)
+            {
+                psReader->failed = 1;
+                return;
+            }
+            psReader->buffer = pucNew;
+            psReader->bufferCapacity = uNeeded;
+        }
+        uRoom = psReader->bufferCapacity - psReader->length;
+        if (uRoom > uLeft)
+            uRoom = (size_t)uLeft;
+        if (!SymTableLsm_readAt(psReader->run->fd,
+                                psReader->buffer + psReader->length,
+                                uRoom, psReader->offset))
+        {
+            psReader->failed = 1;
+            return;
+        }
+        psReader->length += uRoom;
+        psReader->offset += uRoom;
+    }
+
+    psReader->key =
+        (const char *)(psReader->buffer + psReader->position + REC_KEY);
+    psReader->kind = psReader->buffer[psReader->position + REC_KIND];
+    psReader->value = psReader->buffer + psReader->position + REC_KEY +
+                      uiKeyLength;
+    psReader->valueLength = uiValueLength;
+    psReader->position += uNeeded;
+    psReader->valid = 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Merge the uCount runs ppsInputs of oLsm, which are consecutive and
+newest first, into one run, dropping tombstones if iDropTombstones is
+1 (TRUE). Return the merged run, or NULL if insufficient memory is
+available or a file cannot be read or written */
+
+static struct Run *SymTableLsm_mergeRuns(SymTableLsm_T oLsm,
+                                         struct Run **ppsInputs,
+                                         size_t uCount,
+                                         int iDropTombstones)
+{
+    struct RunReader *psReaders;
+    struct RunWriter writer;
+    struct RunReader *psBest;
+    char *pcTempPath;
+    unsigned long ulMinSeq, ulMaxSeq;
+    size_t u;
+    int iFailed = 0;
+
+    ulMinSeq = ppsInputs[uCount - 1]->minSeq;
+    ulMaxSeq = ppsInputs[0]->maxSeq;
+
+    psReaders = calloc(uCount, sizeof(struct RunReader));
+    if (psReaders == NULL)
+        return NULL;
+    pcTempPath = SymTableLsm_tempRunPath(oLsm, ulMinSeq, ulMaxSeq);
+    if (pcTempPath == NULL || !SymTableLsm_startRun(&writer, pcTempPath))
+    {
+        free(pcTempPath);
+        free(psReaders);
+        return NULL;
+    }
+    free(pcTempPath);
+
+    /* Position each reader at the first record of its run */
+    for (u = 0; u < uCount; u++)
+    {
+        psReaders[u].run = ppsInputs[u];
+        psReaders[u].buffer = malloc(READ_BUFFER_BYTES);
+        psReaders[u].bufferCapacity = READ_BUFFER_BYTES;
+        if (psReaders[u].buffer == NULL)
+            iFailed = 1;
+        else
+            SymTableLsm_advance(&psReaders[u]);
+    }
+
+    /* Repeatedly copy the smallest current key, taking it from the
+    newest run that has it and skipping it in the older runs */
+    while (!iFailed && !writer.failed)
+    {
+        psBest = NULL;
+        for (u = 0; u < uCount; u++)
+        {
+            if (psReaders[u].failed)
+                iFailed = 1;
+            if (psReaders[u].valid &&
+                (psBest == NULL ||
+                 strcmp(psReaders[u].key, psBest->key) < 0))
+                psBest = &psReaders[u];
+        }
+        if (psBest == NULL || iFailed)
+            break;
+
+        if (!(iDropTombstones && psBest->kind == KIND_TOMBSTONE))
+            SymTableLsm_addRecord(&writer, psBest->key, psBest->kind,
+                                  psBest->value, psBest->valueLength);
+        for (u = 0; u < uCount; u++)
+            if (&psReaders[u] != psBest && psReaders[u].valid &&
+                strcmp(psReaders[u].key, psBest->key) == 0)
+                SymTableLsm_advance(&psReaders[u]);
+        SymTableLsm_advance(psBest);
+    }
+
+    for (u = 0; u < uCount; u++)
+        free(psReaders[u].buffer);
+    free(psReaders);
+
+    if (iFailed)
+    {
+        SymTableLsm_abandonRun(&writer);
+        return NULL;
+    }
+    return SymTableLsm_finishRun(oLsm, &writer, ulMinSeq, ulMaxSeq);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look pcKey up in run psRun. If it has a value record for pcKey and
+ppvValue is not NULL, store the value decoded by *psCodec in
+*ppvValue. Return the kind of the record for pcKey, 0 if psRun has
+none, or KIND_ERROR if psRun cannot be read */
+
+static int SymTableLsm_searchRun(struct Run *psRun, const char *pcKey,
+                                 const struct SymTable_Codec *psCodec,
+                                 void **ppvValue)
+{
+    unsigned char *pucBlock;
+    uint64_t uHash, uBit, uEnd;
+    uint32_t uiKeyLength, uiValueLength;
+    size_t uLow, uHigh, uMid, uPos, uBlockLength;
+    unsigned int uProbe;
+    int iCompare;
+    int iKind = 0;
+
+    /* Consult the Bloom filter */
+    uHash = SymTableLsm_hash(pcKey);
+    for (uProbe = 0; uProbe < psRun->hashCount; uProbe++)
+    {
+        uBit = SymTableLsm_bloomBit(uHash, uProbe, psRun->bloomBits);
+        if ((psRun->bloom[uBit / 8] & (1U << (uBit % 8))) == 0)
+            return 0;
+    }
+
+    /* Find the last block whose first key is at most pcKey */
+    uLow = 0;
+    uHigh = psRun->indexCount;
+    while (uLow < uHigh)
+    {
+        uMid = uLow + (uHigh - uLow) / 2;
+        if (strcmp(psRun->index[uMid].key, pcKey) <= 0)
+            uLow = uMid + 1;
+        else
+            uHigh = uMid;
+    }
+    if (uLow == 0)
+        return 0;
+
+    /* Read the block and scan its records */
+    uEnd = uLow < psRun->indexCount ? psRun->index[uLow].offset
+                                    : psRun->dataBytes;
+    uBlockLength = (size_t)(uEnd - psRun->index[uLow - 1].offset);
+    pucBlock = malloc(uBlockLength);
+    if (pucBlock == NULL)
+        return KIND_ERROR;
+    if (!SymTableLsm_readAt(psRun->fd, pucBlock, uBlockLength,
+                            psRun->index[uLow - 1].offset))
+    {
+        free(pucBlock);
+        return KIND_ERROR;
+    }
+
+    uPos = 0;
+    while (uPos + REC_KEY <= uBlockLength)
+    {
+        memcpy(&uiKeyLength, pucBlock + uPos + REC_KEYLEN, 4);
+        memcpy(&uiValueLength, pucBlock + uPos + REC_VALUELEN, 4);
+        if (uPos + REC_KEY + (size_t)uiKeyLength + uiValueLength >
+            uBlockLength)
+            break;
+
+        iCompare = strcmp((const char *)(pucBlock + uPos + REC_KEY),
+                          pcKey);
+        if (iCompare > 0)
+            break;
+        if (iCompare == 0)
+        {
+            iKind = pucBlock[uPos + REC_KIND];
+            if (iKind == KIND_VALUE && ppvValue != NULL)
+                *ppvValue = (*psCodec->pfDecode)(
+                    pucBlock + uPos + REC_KEY + uiKeyLength,
+                    uiValueLength);
+            break;
+        }
+        uPos += REC_KEY + (size_t)uiKeyLength + uiValueLength;
+    }
+
+    free(pucBlock);
+    return iKind;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the kind of entry psEntry, storing its value decoded by
+*psCodec in *ppvValue if it is a value entry and ppvValue is not
+NULL */
+
+static int SymTableLsm_resolveEntry(const struct Entry *psEntry,
+                                    const struct SymTable_Codec *psCodec,
+                                    void **ppvValue)
+{
+    if (psEntry->kind == KIND_VALUE && ppvValue != NULL)
+        *ppvValue = (*psCodec->pfDecode)(psEntry->bytes, psEntry->length);
+    return psEntry->kind;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look pcKey up in oLsm, newest data first. If it is bound and
+ppvValue is not NULL, store its decoded value in *ppvValue. Return 1
+(TRUE) if pcKey is bound, or 0 (FALSE) if it is not or if a run that
+may hold it cannot be read. Older runs are never consulted past such
+a run, since their records for pcKey may be out of date */
+
+static int SymTableLsm_lookup(SymTableLsm_T oLsm, const char *pcKey,
+                              void **ppvValue)
+{
+    struct Entry *psEntry;
+    size_t u;
+    int iKind = 0;
+
+    assert(oLsm != NULL);
+    assert(pcKey != NULL);
+
+    psEntry = SymTable_get(oLsm->active, pcKey);
+    if (psEntry != NULL)
+        return SymTableLsm_resolveEntry(psEntry, oLsm->codec, ppvValue) ==
+               KIND_VALUE;
+
+    pthread_mutex_lock(&oLsm->mutex);
+    if (oLsm->frozen != NULL)
+    {
+        psEntry = SymTable_get(oLsm->frozen, pcKey);
+        if (psEntry != NULL)
+            iKind = SymTableLsm_resolveEntry(psEntry, oLsm->codec,
+                                             ppvValue);
+    }
+    for (u = 0; u < oLsm->runCount && iKind == 0; u++)
+        iKind = SymTableLsm_searchRun(oLsm->runs[u], pcKey, oLsm->codec,
+                                      ppvValue);
+    pthread_mutex_unlock(&oLsm->mutex);
+
+    return iKind == KIND_VALUE;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add psRun to the runs of oLsm, keeping them newest first. Return 1
+(TRUE) if successful, or 0 (FALSE) if insufficient memory is
+available */
+
+static int SymTableLsm_insertRun(SymTableLsm_T oLsm, struct Run *psRun)
+{
+    struct Run **ppsNew;
+    size_t u;
+
+    if (oLsm->runCount == oLsm->runCapacity)
+    {
+        ppsNew = realloc(oLsm->runs, (oLsm->runCapacity * 2 + 8) *
+                                         sizeof(struct Run *));
+        if (ppsNew == NULL)
+            return 0;
+        oLsm->runs = ppsNew;
+        oLsm->runCapacity = oLsm->runCapacity * 2 + 8;
+    }
+
+    u = oLsm->runCount;
+    while (u > 0 && oLsm->runs[u - 1]->maxSeq < psRun->maxSeq)
+    {
+        oLsm->runs[u] = oLsm->runs[u - 1];
+        u--;
+    }
+    oLsm->runs[u] = psRun;
+    oLsm->runCount++;
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of newest runs of oLsm to merge: the newest runs
+for as long as the next older run is at most MERGE_RATIO times as large
+as they are together, and at least two */
+
+static size_t SymTableLsm_chooseMerge(SymTableLsm_T oLsm)
+{
+    uint64_t uTotal;
+    size_t u;
+
+    uTotal = oLsm->runs[0]->fileBytes;
+    for (u = 1; u < oLsm->runCount; u++)
+    {
+        if (u >= 2 && oLsm->runs[u]->fileBytes > MERGE_RATIO * uTotal)
+            break;
+        uTotal += oLsm->runs[u]->fileBytes;
+    }
+    return u;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the frozen memtable of oLsm to a run and install the run. Called
+by the flushing thread with the mutex held, which is released while
+the run is written */
+
+static void SymTableLsm_flushFrozen(SymTableLsm_T oLsm)
+{
+    SymTable_T oMemtable = oLsm->frozen;
+    SymTableLog_T oLog;
+    unsigned long ulSeq = oLsm->frozenSeq;
+    struct Run *psRun;
+
+    pthread_mutex_unlock(&oLsm->mutex);
+    psRun = SymTableLsm_writeMemtable(oLsm, oMemtable, ulSeq);
+    pthread_mutex_lock(&oLsm->mutex);
+
+    if (psRun == NULL || !SymTableLsm_insertRun(oLsm, psRun))
+    {
+        if (psRun != NULL)
+            SymTableLsm_freeRun(psRun, 1);
+        oLsm->failed = 1;
+        pthread_cond_broadcast(&oLsm->cond);
+        return;
+    }
+
+    /* The run now holds the memtable, so its log is not needed */
+    oLog = oLsm->frozenLog;
+    oLsm->frozen = NULL;
+    oLsm->frozenLog = NULL;
+    pthread_cond_broadcast(&oLsm->cond);
+
+    pthread_mutex_unlock(&oLsm->mutex);
+    SymTableLsm_freeMemtable(oMemtable, oLog);
+    SymTableLsm_removeWal(oLsm, ulSeq);
+    pthread_mutex_lock(&oLsm->mutex);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Merge the newest runs of oLsm and install the merged run. Called by
+the merging thread with the mutex held, which is released while the
+run is written */
+
+static void SymTableLsm_compact(SymTableLsm_T oLsm)
+{
+    struct Run **ppsInputs;
+    struct Run *psRun;
+    size_t uCount, uFirst, u;
+    int iDropTombstones;
+
+    /* Tombstones can go once the oldest run takes part */
+    uCount = SymTableLsm_chooseMerge(oLsm);
+    iDropTombstones = uCount == oLsm->runCount;
+    ppsInputs = malloc(uCount * sizeof(struct Run *));
+    if (ppsInputs == NULL)
+    {
+        oLsm->failed = 1;
+        return;
+    }
+    memcpy(ppsInputs, oLsm->runs, uCount * sizeof(struct Run *));
+
+    pthread_mutex_unlock(&oLsm->mutex);
+    psRun = SymTableLsm_mergeRuns(oLsm, ppsInputs, uCount,
+                                  iDropTombstones);
+    pthread_mutex_lock(&oLsm->mutex);
+
+    if (psRun == NULL)
+    {
+        free(ppsInputs);
+        oLsm->failed = 1;
+        return;
+    }
+
+    /* Replace the inputs by the merged run. Runs flushed meanwhile are
+    newer, so the inputs are still consecutive */
+    uFirst = 0;
+    while (oLsm->runs[uFirst] != ppsInputs[0])
+        uFirst++;
+    oLsm->runs[uFirst] = psRun;
+    memmove(oLsm->runs + uFirst + 1, oLsm->runs + uFirst + uCount,
+            (oLsm->runCount - uFirst - uCount) * sizeof(struct Run *));
+    oLsm->runCount -= uCount - 1;
+
+    pthread_mutex_unlock(&oLsm->mutex);
+    for (u = 0; u < uCount; u++)
+        SymTableLsm_freeRun(ppsInputs[u], 1);
+    (void)SymTableLsm_syncDirectory(oLsm);
+    free(ppsInputs);
+    pthread_mutex_lock(&oLsm->mutex);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Body of the flushing thread of store pvLsm: write frozen memtables
+to runs until told to stop, finishing a frozen memtable first. Return
+NULL */
+
+static void *SymTableLsm_flushWork(void *pvLsm)
+{
+    SymTableLsm_T oLsm = pvLsm;
+
+    pthread_mutex_lock(&oLsm->mutex);
+    for (;;)
+    {
+        if (oLsm->frozen != NULL && !oLsm->failed)
+            SymTableLsm_flushFrozen(oLsm);
+        else if (oLsm->stopping)
+            break;
+        else
+            pthread_cond_wait(&oLsm->cond, &oLsm->mutex);
+    }
+    pthread_mutex_unlock(&oLsm->mutex);
+
+    return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Body of the merging thread of store pvLsm: merge runs whenever there
+are COMPACTION_TRIGGER of them, until told to stop. Return NULL */
+
+static void *SymTableLsm_mergeWork(void *pvLsm)
+{
+    SymTableLsm_T oLsm = pvLsm;
+
+    pthread_mutex_lock(&oLsm->mutex);
+    for (;;)
+    {
+        if (oLsm->stopping)
+            break;
+        else if (oLsm->runCount >= COMPACTION_TRIGGER && !oLsm->failed)
+            SymTableLsm_compact(oLsm);
+        else
+            pthread_cond_wait(&oLsm->cond, &oLsm->mutex);
+    }
+    pthread_mutex_unlock(&oLsm->mutex);
+
+    return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Hand the active memtable of oLsm to the flushing thread and start
+a new one, waiting for the previous frozen memtable to be written
+first. Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient
+memory is available or a file cannot be written */
+
+static int SymTableLsm_rotate(SymTableLsm_T oLsm)
+{
+    SymTable_T oMemtable;
+    SymTableLog_T oLog;
+
+    /* Log records of the frozen memtable stay on disk until its run
+    is written */
+    if (!SymTableLog_sync(oLsm->activeLog))
+        return 0;
+    if (!SymTableLsm_openMemtable(oLsm, oLsm->nextSeq, &oMemtable, &oLog))
+        return 0;
+
+    pthread_mutex_lock(&oLsm->mutex);
+    while (oLsm->frozen != NULL && !oLsm->failed)
+        pthread_cond_wait(&oLsm->cond, &oLsm->mutex);
+    if (oLsm->failed)
+    {
+        pthread_mutex_unlock(&oLsm->mutex);
+        SymTableLsm_freeMemtable(oMemtable, oLog);
+        SymTableLsm_removeWal(oLsm, oLsm->nextSeq);
+        return 0;
+    }
+    oLsm->frozen = oLsm->active;
+    oLsm->frozenLog = oLsm->activeLog;
+    oLsm->frozenSeq = oLsm->activeSeq;
+    pthread_cond_broadcast(&oLsm->cond);
+    pthread_mutex_unlock(&oLsm->mutex);
+
+    oLsm->active = oMemtable;
+    oLsm->activeLog = oLog;
+    oLsm->activeSeq = oLsm->nextSeq++;
+    oLsm->activeBytes = 0;
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Bind pcKey to entry psEntry in the active memtable of oLsm and log
+it, freeing psEntry on failure. Return 1 (TRUE) if successful, or 0
+(FALSE) otherwise */
+
+static int SymTableLsm_update(SymTableLsm_T oLsm, const char *pcKey,
+                              struct Entry *psEntry)
+{
+    struct Entry *psOld;
+
+    if (psEntry == NULL)
+        return 0;
+
+    /* Freeze a full memtable */
+    if (oLsm->activeBytes >= oLsm->memtableLimit &&
+        !SymTableLsm_rotate(oLsm))
+    {
+        free(psEntry);
+        return 0;
+    }
+
+    /* Entries are never NULL, so NULL means pcKey is not bound */
+    psOld = SymTable_replace(oLsm->active, pcKey, psEntry);
+    if (psOld != NULL)
+    {
+        oLsm->activeBytes -= psOld->length;
+        free(psOld);
+    }
+    else if (SymTable_put(oLsm->active, pcKey, psEntry))
+        oLsm->activeBytes += strlen(pcKey) + 1 + ENTRY_OVERHEAD;
+    else
+    {
+        free(psEntry);
+        return 0;
+    }
+    oLsm->activeBytes += psEntry->length;
+
+    return SymTableLog_append(oLsm->activeLog, SYMTABLELOG_SET, pcKey,
+                              psEntry);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free all memory occupied by oLsm, whose background threads must not
+be running, leaving its files in place */
+
+static void SymTableLsm_destroy(SymTableLsm_T oLsm)
+{
+    size_t u;
+
+    SymTableLsm_freeMemtable(oLsm->active, oLsm->activeLog);
+    SymTableLsm_freeMemtable(oLsm->frozen, oLsm->frozenLog);
+    for (u = 0; u < oLsm->runCount; u++)
+        SymTableLsm_freeRun(oLsm->runs[u], 0);
+    free(oLsm->runs);
+
+    pthread_mutex_destroy(&oLsm->mutex);
+    pthread_cond_destroy(&oLsm->cond);
+    free(oLsm->dir);
+    free(oLsm);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare unsigned longs pvFirst and pvSecond for qsort */
+
+static int SymTableLsm_compareSeqs(const void *pvFirst,
+                                   const void *pvSecond)
+{
+    unsigned long ulFirst = *(const unsigned long *)pvFirst;
+    unsigned long ulSecond = *(const unsigned long *)pvSecond;
+
+    return (ulFirst > ulSecond) - (ulFirst < ulSecond);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Open the runs in the directory of oLsm, delete leftover files, and
+write the memtables of the remaining logs to runs. Return 1 (TRUE) if
+successful, or 0 (FALSE) otherwise */
+
+static int SymTableLsm_load(SymTableLsm_T oLsm)
+{
+    DIR *psDir;
+    struct dirent *psEntry;
+    unsigned long ulMin, ulMax;
+    unsigned long *pulWals = NULL, *pulNew;
+    size_t uWalCount = 0, uWalCapacity = 0;
+    size_t u, v;
+    int iEnd, iCovered;
+    char *pcPath;
+    struct Run *psRun;
+    SymTable_T oMemtable;
+    SymTableLog_T oLog;
+    int iSuccessful = 1;
+
+    psDir = opendir(oLsm->dir);
+    if (psDir == NULL)
+        return 0;
+
+    /* Open each run, note each log, and delete temporary files */
+    while (iSuccessful && (psEntry = readdir(psDir)) != NULL)
+    {
+        iEnd = 0;
+        if (sscanf(psEntry->d_name, "run-%lu-%lu.sst%n", &ulMin, &ulMax,
+                   &iEnd) == 2 &&
+            iEnd > 0 && psEntry->d_name[iEnd] == '\0')
+        {
+            pcPath = SymTableLsm_joinPath(oLsm->dir, psEntry->d_name);
+            psRun = pcPath == NULL
+                        ? NULL
+                        : SymTableLsm_openRun(pcPath, ulMin, ulMax);
+            free(pcPath);
+            if (psRun == NULL || !SymTableLsm_insertRun(oLsm, psRun))
+            {
+                if (psRun != NULL)
+                    SymTableLsm_freeRun(psRun, 0);
+                iSuccessful = 0;
+            }
+            if (ulMax >= oLsm->nextSeq)
+                oLsm->nextSeq = ulMax + 1;
+        }
+        else if (sscanf(psEntry->d_name, "wal-%lu.log%n", &ulMin,
+                        &iEnd) == 1 &&
+                 iEnd > 0 && psEntry->d_name[iEnd] == '\0')
+        {
+            if (uWalCount == uWalCapacity)
+            {
+                uWalCapacity = uWalCapacity * 2 + 8;
+                pulNew = realloc(pulWals,
+                                 uWalCapacity * sizeof(unsigned long));
+                if (pulNew == NULL)
+                {
+                    iSuccessful = 0;
+                    break;
+                }
+                pulWals = pulNew;
+            }
+            pulWals[uWalCount++] = ulMin;
+            if (ulMin >= oLsm->nextSeq)
+                oLsm->nextSeq = ulMin + 1;
+        }
+        else if (strlen(psEntry->d_name) > 4 &&
+                 strcmp(psEntry->d_name + strlen(psEntry->d_name) - 4,
+                        ".tmp") == 0)
+        {
+            pcPath = SymTableLsm_joinPath(oLsm->dir, psEntry->d_name);
+            if (pcPath != NULL)
+                (void)unlink(pcPath);
+            free(pcPath);
+        }
+    }
+    (void)closedir(psDir);
+
+    /* Delete runs whose memtables are covered by a merged run */
+    for (u = 0; iSuccessful && u < oLsm->runCount; u++)
+        for (v = 0; v < oLsm->runCount; v++)
+            if (v != u && oLsm->runs[v]->minSeq <= oLsm->runs[u]->minSeq &&
+                oLsm->runs[u]->maxSeq <= oLsm->runs[v]->maxSeq)
+            {
+                SymTableLsm_freeRun(oLsm->runs[u], 1);
+                memmove(oLsm->runs + u, oLsm->runs + u + 1,
+                        (oLsm->runCount - u - 1) * sizeof(struct Run *));
+                oLsm->runCount--;
+                u--;
+                break;
+            }
+
+    /* Write the memtable of each log not yet covered by a run */
+    if (pulWals != NULL)
+        qsort(pulWals, uWalCount, sizeof(unsigned long),
+              SymTableLsm_compareSeqs);
+    for (u = 0; iSuccessful && u < uWalCount; u++)
+    {
+        iCovered = 0;
+        for (v = 0; v < oLsm->runCount; v++)
+            if (oLsm->runs[v]->minSeq <= pulWals[u] &&
+                pulWals[u] <= oLsm->runs[v]->maxSeq)
+                iCovered = 1;
+
+        if (!iCovered)
+        {
+            if (!SymTableLsm_openMemtable(oLsm, pulWals[u], &oMemtable,
+                                          &oLog))
+            {
+                iSuccessful = 0;
+                break;
+            }
+            psRun = NULL;
+            if (SymTable_getLength(oMemtable) > 0)
+            {
+                psRun = SymTableLsm_writeMemtable(oLsm, oMemtable,
+                                                  pulWals[u]);
+                if (psRun == NULL || !SymTableLsm_insertRun(oLsm, psRun))
+                {
+                    if (psRun != NULL)
+                        SymTableLsm_freeRun(psRun, 1);
+                    iSuccessful = 0;
+                }
+            }
+            SymTableLsm_freeMemtable(oMemtable, oLog);
+        }
+        if (iSuccessful)
+            SymTableLsm_removeWal(oLsm, pulWals[u]);
+    }
+
+    free(pulWals);
+    return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTableLsm_T SymTableLsm_new(const char *pcDir, size_t uMemtableBytes,
+                              const struct SymTable_Codec *psCodec)
+{
+    SymTableLsm_T oLsm;
+
+    assert(pcDir != NULL);
+    assert(psCodec != NULL);
+
+    oLsm = calloc(1, sizeof(struct SymTableLsm));
+    if (oLsm == NULL)
+        return NULL;
+
+    oLsm->dir = malloc(strlen(pcDir) + 1);
+    if (oLsm->dir == NULL)
+    {
+        free(oLsm);
+        return NULL;
+    }
+    strcpy(oLsm->dir, pcDir);
+    oLsm->codec = psCodec;
+    oLsm->memtableLimit = uMemtableBytes;
+    oLsm->nextSeq = 1;
+    pthread_mutex_init(&oLsm->mutex, NULL);
+    pthread_cond_init(&oLsm->cond, NULL);
+
+    /* Recover the files, start the active memtable and start the
+    background threads */
+    if (!SymTableLsm_load(oLsm) ||
+        !SymTableLsm_openMemtable(oLsm, oLsm->nextSeq, &oLsm->active,
+                                  &oLsm->activeLog))
+    {
+        SymTableLsm_destroy(oLsm);
+        return NULL;
+    }
+    oLsm->activeSeq = oLsm->nextSeq++;
+
+    if (pthread_create(&oLsm->flusher, NULL, SymTableLsm_flushWork,
+                       oLsm) == 0)
+        oLsm->threadCount++;
+    if (oLsm->threadCount == 1 &&
+        pthread_create(&oLsm->merger, NULL, SymTableLsm_mergeWork,
+                       oLsm) == 0)
+        oLsm->threadCount++;
+    if (oLsm->threadCount < 2)
+    {
+        SymTableLsm_free(oLsm);
+        return NULL;
+    }
+
+    return oLsm;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTableLsm_free(SymTableLsm_T oLsm)
+{
+    assert(oLsm != NULL);
+
+    /* Let the flushing thread finish writing a frozen memtable, and
+    the merging thread finish its merge */
+    pthread_mutex_lock(&oLsm->mutex);
+    oLsm->stopping = 1;
+    pthread_cond_broadcast(&oLsm->cond);
+    pthread_mutex_unlock(&oLsm->mutex);
+    if (oLsm->threadCount >= 1)
+        pthread_join(oLsm->flusher, NULL);
+    if (oLsm->threadCount >= 2)
+        pthread_join(oLsm->merger, NULL);
+
+    SymTableLsm_destroy(oLsm);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableLsm_put(SymTableLsm_T oLsm, const char *pcKey,
+                    const void *pvValue)
+{
+    assert(oLsm != NULL);
+    assert(pcKey != NULL);
+
+    return SymTableLsm_update(
+        oLsm, pcKey, SymTableLsm_newEntry(oLsm->codec, KIND_VALUE,
+                                          pvValue));
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableLsm_contains(SymTableLsm_T oLsm, const char *pcKey)
+{
+    return SymTableLsm_lookup(oLsm, pcKey, NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTableLsm_get(SymTableLsm_T oLsm, const char *pcKey)
+{
+    void *pvValue = NULL;
+
+    (void)SymTableLsm_lookup(oLsm, pcKey, &pvValue);
+    return pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableLsm_remove(SymTableLsm_T oLsm, const char *pcKey)
+{
+    assert(oLsm != NULL);
+    assert(pcKey != NULL);
+
+    return SymTableLsm_update(
+        oLsm, pcKey, SymTableLsm_newEntry(oLsm->codec, KIND_TOMBSTONE,
+                                          NULL));
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableLsm_sync(SymTableLsm_T oLsm)
+{
+    int iFailed;
+
+    assert(oLsm != NULL);
+
+    pthread_mutex_lock(&oLsm->mutex);
+    iFailed = oLsm->failed;
+    pthread_mutex_unlock(&oLsm->mutex);
+
+    return SymTableLog_sync(oLsm->activeLog) && !iFailed;
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTableLsm_getRunCount(SymTableLsm_T oLsm)
+{
+    size_t uCount;
+
+    assert(oLsm != NULL);
+
+    pthread_mutex_lock(&oLsm->mutex);
+    uCount = oLsm->runCount;
+    pthread_mutex_unlock(&oLsm->mutex);
+
+    return uCount;
+}
@@ -0,0 +1,85 @@
+/*--------------------------------------------------------------------*/
+/* symtablelsm.h                                                      */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+# ifndef SYMTABLELSM
+# define SYMTABLELSM
+
+#include "symtablecodec.h"
+#include <stddef.h>
+
+/*
+A SymTableLsm_T is a pointer to a persistent log-structured store that
+maps string keys to values. Updates go to an in-memory symbol table,
+the memtable, and to a write-ahead log. A full memtable is written by
+a background thread to an immutable file of bindings sorted by key, a
+run, and runs are merged by a second thread as they accumulate. Values
+are stored through a SymTable_Codec, so SymTableLsm_get returns values
+decoded by it, which the caller owns.
+
+Unlike a SymTable, the store does not look a key up before updating
+it: SymTableLsm_put sets the value of a key whether or not it is
+already bound, and SymTableLsm_remove records the removal of a key
+whether or not it is bound. A store is used by one thread at a time.
+*/
+typedef struct SymTableLsm *SymTableLsm_T;
+
+/*--------------------------------------------------------------------*/
+/* Return a new SymTableLsm object that keeps its files in existing
+directory pcDir, holding any bindings left there by an earlier store,
+and that writes its memtable to a run when it holds about
+uMemtableBytes bytes. Values are stored through *psCodec. Return NULL
+if insufficient memory is available or the files cannot be read or
+created */
+
+SymTableLsm_T SymTableLsm_new(const char *pcDir, size_t uMemtableBytes,
+                              const struct SymTable_Codec *psCodec);
+
+/*--------------------------------------------------------------------*/
+/* Force every update to disk, stop the background threads, and free
+all memory occupied by oLsm. The files remain and can be opened again
+by SymTableLsm_new */
+
+void SymTableLsm_free(SymTableLsm_T oLsm);
+
+/*--------------------------------------------------------------------*/
+/* Set the value of key pcKey in oLsm to pvValue. Return 1 (TRUE) if
+successful, or 0 (FALSE) if insufficient memory is available or the
+store has failed to write a file */
+
+int SymTableLsm_put(SymTableLsm_T oLsm, const char *pcKey,
+                    const void *pvValue);
+
+/*--------------------------------------------------------------------*/
+/* Return 1 (TRUE) if oLsm contains a binding whose key is pcKey, and
+0 (FALSE) otherwise or if a run that may hold it cannot be read */
+
+int SymTableLsm_contains(SymTableLsm_T oLsm, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* Return the value of the binding within oLsm whose key is pcKey,
+decoded by the codec of oLsm, or NULL if no such binding exists or if
+a run that may hold it cannot be read */
+
+void *SymTableLsm_get(SymTableLsm_T oLsm, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* Remove from oLsm the binding whose key is pcKey, if any. Return 1
+(TRUE) if successful, or 0 (FALSE) if insufficient memory is available
+or the store has failed to write a file */
+
+int SymTableLsm_remove(SymTableLsm_T oLsm, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* Force every update of oLsm to its write-ahead log. Return 1 (TRUE)
+if successful, or 0 (FALSE) if the store has failed to write a file */
+
+int SymTableLsm_sync(SymTableLsm_T oLsm);
+
+/*--------------------------------------------------------------------*/
+/* Return the number of runs that oLsm currently keeps on disk */
+
+size_t SymTableLsm_getRunCount(SymTableLsm_T oLsm);
+
+# endif
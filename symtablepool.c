@@ -0,0 +1,417 @@
+/*--------------------------------------------------------------------*/
+/* symtablepool.c                                                     */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+/* Hash-table-based implementation of symbol table that maps string
+keys to void* values, laid out like symtablehash.c but with every
+binding in one pool array instead of its own allocation. Bucket heads
+and chain links are 32-bit indices into the pool rather than
+pointers, so the bucket array and the links take half the memory of
+pointers on a 64-bit host and bindings carry no allocator headers.
+Each key is stored with defensive copy to ensure ownership by symbol
+table. Collisions handled via separate chaining. Removed bindings are
+kept on a free list in the pool and reused. Pool index 0 is never
+used, so that a zeroed bucket array holds empty chains */
+
+#include "symtable.h"
+#include "symtablehashcode.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* List of prime numbers used for hash table sizes. Each number
+represents number of buckets for particular binding counts. When hash
+table grows, moves to the next prime count */
+static const size_t BUCKET_COUNTS[] = {509, 1021, 2039, 4093, 8191,
+                                       16381, 32749, 65521};
+
+/* Number of hash table sizes */
+static const size_t BUCKET_COUNTS_LEN =
+    sizeof(BUCKET_COUNTS) / sizeof(BUCKET_COUNTS[0]);
+
+/* Pool index that ends a chain */
+static const uint32_t NIL = 0;
+
+/* Greatest number of bindings in the pool, including index 0 */
+static const size_t MAX_POOL_SIZE = (size_t)UINT32_MAX;
+
+/* Each Binding represents a key-value pair in hash table bucket */
+struct Binding
+{
+    /* Pointer to the key string (defensive copy), or NULL if the
+    binding is on the free list */
+    const char *key;
+    /* Pointer to the associated value */
+    const void *value;
+    /* Pool index of next binding in bucket chain or free list */
+    uint32_t next;
+    /* Hash code of key, kept so that resizing never has to rehash a
+    key and most mismatches skip the strcmp */
+    uint32_t hash;
+};
+
+/* SymTable structure represents overall hash table */
+struct SymTable
+{
+    /* Array of pool indices of bucket heads */
+    uint32_t *buckets;
+    /* Stores index into BUCKET_COUNTS array */
+    size_t bucketSizeIndex;
+    /* Pool of bindings */
+    struct Binding *pool;
+    /* Number of bindings of the pool in use or free, including index
+    0, and number allocated */
+    size_t poolUsed;
+    size_t poolCapacity;
+    /* Pool index of the first free binding, or NIL */
+    uint32_t freeList;
+    /* Stores total number of bindings in SymTable */
+    size_t bindingsCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a hash code for pcKey */
+
+static uint32_t SymTable_hash(const char *pcKey)
+{
+    return (uint32_t)SymTableHashCode_string(pcKey, NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the number of buckets of oSymTable */
+
+static size_t SymTable_bucketCount(SymTable_T oSymTable)
+{
+    return BUCKET_COUNTS[oSymTable->bucketSizeIndex];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the pool index of the binding of oSymTable whose key is
+pcKey and whose hash code is uHash, or NIL if no such binding
+exists */
+
+static uint32_t SymTable_find(SymTable_T oSymTable, const char *pcKey,
+                              uint32_t uHash)
+{
+    struct Binding *curr;
+    uint32_t i;
+
+    i = oSymTable->buckets[uHash % SymTable_bucketCount(oSymTable)];
+    while (i != NIL)
+    {
+        curr = &oSymTable->pool[i];
+
+        /* Handle condition where binding with pcKey exists */
+        if (curr->hash == uHash && strcmp(curr->key, pcKey) == 0)
+            return i;
+
+        /* Otherwise, move on to the next binding */
+        i = curr->next;
+    }
+    return NIL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Expand oSymTable to the next bucket size, provided it is not
+already at its maximum size and memory for a new bucket array is
+available */
+
+static void SymTable_tryExpand(SymTable_T oSymTable)
+{
+    uint32_t *newBuckets;
+    size_t newBucketCount, hashSlot;
+    struct Binding *curr;
+    size_t u;
+
+    /* Handle case where symbol table is already at its maximum size */
+    if (oSymTable->bucketSizeIndex >= BUCKET_COUNTS_LEN - 1)
+        return;
+
+    newBucketCount = BUCKET_COUNTS[oSymTable->bucketSizeIndex + 1];
+    newBuckets = calloc(newBucketCount, sizeof(uint32_t));
+    if (newBuckets == NULL)
+        return;
+
+    /* Relink every binding in use, walking the pool in order */
+    for (u = 1; u < oSymTable->poolUsed; u++)
+    {
+        curr = &oSymTable->pool[u];
+        if (curr->key == NULL)
+            continue;
+        hashSlot = curr->hash % newBucketCount;
+        curr->next = newBuckets[hashSlot];
+        newBuckets[hashSlot] = (uint32_t)u;
+    }
+
+    /* Swaps in the new buckets array and records new size index */
+    free(oSymTable->buckets);
+    oSymTable->buckets = newBuckets;
+    oSymTable->bucketSizeIndex++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the pool index of a binding of oSymTable that is not in use,
+or NIL if insufficient memory is available */
+
+static uint32_t SymTable_allocate(SymTable_T oSymTable)
+{
+    struct Binding *newPool;
+    size_t newCapacity;
+    uint32_t i;
+
+    /* Reuse a free binding if there is one */
+    i = oSymTable->freeList;
+    if (i != NIL)
+    {
+        oSymTable->freeList = oSymTable->pool[i].next;
+        return i;
+    }
+
+    /* Otherwise grow the pool if it is full */
+    if (oSymTable->poolUsed == oSymTable->poolCapacity)
+    {
+        if (oSymTable->poolCapacity >= MAX_POOL_SIZE)
+            return NIL;
+        newCapacity = oSymTable->poolCapacity * 2;
+        if (newCapacity > MAX_POOL_SIZE)
+            newCapacity = MAX_POOL_SIZE;
+        newPool = realloc(oSymTable->pool,
+                          newCapacity * sizeof(struct Binding));
+        if (newPool == NULL)
+            return NIL;
+        oSymTable->pool = newPool;
+        oSymTable->poolCapacity = newCapacity;
+    }
+
+    return (uint32_t)oSymTable->poolUsed++;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+    SymTable_T oSymTable;
+
+    /* Allocate memory for a new symbol table */
+    oSymTable = malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+        return NULL;
+
+    /* Initialize fields for new symbol table, with a pool as large as
+    the first bucket array and index 0 set aside */
+    oSymTable->bucketSizeIndex = 0;
+    oSymTable->bindingsCount = 0;
+    oSymTable->freeList = NIL;
+    oSymTable->poolUsed = 1;
+    oSymTable->poolCapacity = BUCKET_COUNTS[0];
+    oSymTable->buckets = calloc(BUCKET_COUNTS[0], sizeof(uint32_t));
+    oSymTable->pool = malloc(oSymTable->poolCapacity *
+                             sizeof(struct Binding));
+
+    /* Handle case where allocation of either array fails */
+    if (oSymTable->buckets == NULL || oSymTable->pool == NULL)
+    {
+        free(oSymTable->buckets);
+        free(oSymTable->pool);
+        free(oSymTable);
+        return NULL;
+    }
+    oSymTable->pool[NIL].key = NULL;
+
+    return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    size_t u;
+
+    assert(oSymTable != NULL);
+
+    /* Free the key copy of every binding in use */
+    for (u = 1; u < oSymTable->poolUsed; u++)
+        free((void *)oSymTable->pool[u].key);
+
+    free(oSymTable->buckets);
+    free(oSymTable->pool);
+    free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    return oSymTable->bindingsCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable,
+                 const char *pcKey, const void *pvValue)
+{
+    struct Binding *newBinding;
+    size_t bucketIndex;
+    uint32_t uHash;
+    uint32_t i;
+    char *keyCopy;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* Handle condition where binding with pcKey already exists */
+    uHash = SymTable_hash(pcKey);
+    if (SymTable_find(oSymTable, pcKey, uHash) != NIL)
+        return 0;
+
+    /* Attempt to expand hash table if adding one more binding warrants
+    an expansion */
+    if (oSymTable->bindingsCount + 1 > SymTable_bucketCount(oSymTable))
+        SymTable_tryExpand(oSymTable);
+
+    /* Copy the key string defensively */
+    keyCopy = malloc(strlen(pcKey) + 1);
+    if (keyCopy == NULL)
+        return 0;
+    strcpy(keyCopy, pcKey);
+
+    /* Handle condition of insufficient memory for new binding */
+    i = SymTable_allocate(oSymTable);
+    if (i == NIL)
+    {
+        free(keyCopy);
+        return 0;
+    }
+
+    /* Insert new binding at the front of the bucket chain */
+    bucketIndex = uHash % SymTable_bucketCount(oSymTable);
+    newBinding = &oSymTable->pool[i];
+    newBinding->key = keyCopy;
+    newBinding->value = pvValue;
+    newBinding->hash = uHash;
+    newBinding->next = oSymTable->buckets[bucketIndex];
+    oSymTable->buckets[bucketIndex] = i;
+
+    oSymTable->bindingsCount++;
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable,
+                       const char *pcKey, const void *pvValue)
+{
+    struct Binding *curr;
+    void *oldValue;
+    uint32_t i;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* Handle condition where no binding with pcKey exists */
+    i = SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey));
+    if (i == NIL)
+        return NULL;
+
+    curr = &oSymTable->pool[i];
+    oldValue = (void *)curr->value;
+    curr->value = pvValue;
+    return oldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey)) != NIL;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    uint32_t i;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    i = SymTable_find(oSymTable, pcKey, SymTable_hash(pcKey));
+    if (i == NIL)
+        return NULL;
+    return (void *)oSymTable->pool[i].value;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    struct Binding *curr;
+    uint32_t *link;
+    uint32_t uHash;
+    uint32_t i;
+    void *bindingValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* Find the link that holds the binding with pcKey */
+    uHash = SymTable_hash(pcKey);
+    link = &oSymTable->buckets[uHash % SymTable_bucketCount(oSymTable)];
+    while (*link != NIL)
+    {
+        curr = &oSymTable->pool[*link];
+        if (curr->hash == uHash && strcmp(curr->key, pcKey) == 0)
+            break;
+        link = &curr->next;
+    }
+
+    /* Handle condition where no binding with pcKey exists */
+    i = *link;
+    if (i == NIL)
+        return NULL;
+
+    /* Unlink the binding and put it on the free list */
+    curr = &oSymTable->pool[i];
+    *link = curr->next;
+    bindingValue = (void *)curr->value;
+    free((void *)curr->key);
+    curr->key = NULL;
+    curr->next = oSymTable->freeList;
+    oSymTable->freeList = i;
+    oSymTable->bindingsCount--;
+
+    return bindingValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue,
+                                  void *pvExtra),
+                  const void *pvExtra)
+{
+    struct Binding *curr;
+    size_t u;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /* Walk the pool in order, which touches memory sequentially */
+    for (u = 1; u < oSymTable->poolUsed; u++)
+    {
+        curr = &oSymTable->pool[u];
+        if (curr->key != NULL)
+            (*pfApply)(curr->key, (void *)curr->value, (void *)pvExtra);
+    }
+}
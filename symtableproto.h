@@ -0,0 +1,48 @@
+/*--------------------------------------------------------------------*/
+/* symtableproto.h                                                    */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+# ifndef SYMTABLEPROTO
+# define SYMTABLEPROTO
+
+/*
+The protocol spoken by symtableserver over a Unix domain socket. A
+client sends requests and the server answers each with one response,
+in the order the requests were sent, so a client may send many
+requests before reading any response. Integers are in the byte order
+of the host, which both ends share.
+
+A request is a header of SYMTABLEPROTO_REQUEST_HEADER bytes, holding a
+one-byte operation, a four-byte key length and a four-byte value
+length, followed by the key and then the value. A key must not contain
+a zero byte. Only SYMTABLEPROTO_PUT sends a value; the value length of
+other requests is 0.
+
+A response is a header of SYMTABLEPROTO_RESPONSE_HEADER bytes, holding
+a one-byte status and a four-byte value length, followed by the value.
+Only a successful SYMTABLEPROTO_GET returns a value.
+
+A request whose lengths exceed the limits below is answered with
+SYMTABLEPROTO_BAD_REQUEST, after which the server closes the
+connection.
+*/
+
+/* Operations */
+enum {SYMTABLEPROTO_GET = 1, SYMTABLEPROTO_PUT = 2,
+      SYMTABLEPROTO_REMOVE = 3};
+
+/* Statuses. SYMTABLEPROTO_GET and SYMTABLEPROTO_REMOVE return
+SYMTABLEPROTO_NOT_FOUND if the key is not bound. SYMTABLEPROTO_PUT
+binds the key whether or not it was already bound */
+enum {SYMTABLEPROTO_OK = 0, SYMTABLEPROTO_NOT_FOUND = 1,
+      SYMTABLEPROTO_BAD_REQUEST = 2, SYMTABLEPROTO_NO_MEMORY = 3};
+
+/* Number of bytes of each header */
+enum {SYMTABLEPROTO_REQUEST_HEADER = 9, SYMTABLEPROTO_RESPONSE_HEADER = 5};
+
+/* Greatest numbers of bytes of a key and of a value */
+enum {SYMTABLEPROTO_MAX_KEY = 64 * 1024,
+      SYMTABLEPROTO_MAX_VALUE = 16 * 1024 * 1024};
+
+# endif
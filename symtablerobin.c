@@ -0,0 +1,410 @@
+/*--------------------------------------------------------------------*/
+/* symtablerobin.c                                                    */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+/* Open-addressing implementation of symbol table that maps string
+keys to void* values. Each key is stored with defensive copy to
+ensure ownership by symbol table. Collisions handled via Robin Hood
+linear probing: every slot records how far its binding lies from its
+home slot, and an inserted binding takes over any slot whose binding
+is closer to home than itself. Removal shifts the following bindings
+back by one slot instead of leaving tombstones. Because probe lengths
+stay short and even, the table is allowed to fill up to a load factor
+of 0.9 before it doubles its slot array */
+
+#include "symtable.h"
+#include "symtablehashcode.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Initial number of slots. Must be a power of two so that a hash code
+can be reduced to a slot index with a mask */
+static const size_t INITIAL_SLOT_COUNT = 512;
+
+/* The slot array is doubled when adding one more binding would make
+the load factor exceed MAX_LOAD_NUMER / MAX_LOAD_DENOM */
+static const size_t MAX_LOAD_NUMER = 9;
+static const size_t MAX_LOAD_DENOM = 10;
+
+/* Each Slot holds at most one key-value pair of the hash table */
+struct Slot
+{
+    /* Pointer to the key string (defensive copy), or NULL if the
+    slot is empty */
+    const char *key;
+    /* Pointer to the associated value */
+    const void *value;
+    /* Full hash code of key, kept so that resizing never has to
+    rehash a key and most mismatches skip the strcmp */
+    size_t hash;
+    /* Number of slots between the slot and the key's home slot */
+    size_t dist;
+};
+
+/* SymTable structure represents overall hash table */
+struct SymTable
+{
+    /* Pointer to array of slots */
+    struct Slot *slots;
+    /* Number of slots in slots array (a power of two) */
+    size_t slotCount;
+    /* Stores total number of bindings in SymTable */
+    size_t bindingsCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the full hash code for pcKey */
+
+static size_t SymTable_hash(const char *pcKey)
+{
+    return (size_t)SymTableHashCode_full(pcKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the index of the slot in oSymTable that holds key pcKey
+whose hash code is uHash, or oSymTable->slotCount if no such slot
+exists. The probe stops as soon as it reaches an empty slot or a slot
+whose binding is closer to home than pcKey would be, since Robin Hood
+insertion guarantees pcKey cannot lie beyond it */
+
+static size_t SymTable_findSlot(SymTable_T oSymTable,
+                                const char *pcKey, size_t uHash)
+{
+    size_t mask = oSymTable->slotCount - 1;
+    size_t i = uHash & mask;
+    size_t dist = 0;
+    struct Slot *curr;
+
+    for (;;)
+    {
+        curr = &oSymTable->slots[i];
+
+        /* Handle condition where pcKey cannot be further along */
+        if (curr->key == NULL || curr->dist < dist)
+            return oSymTable->slotCount;
+
+        /* Handle condition where binding with pcKey exists */
+        if (curr->hash == uHash && strcmp(curr->key, pcKey) == 0)
+            return i;
+
+        /* Otherwise, move on to the next slot */
+        i = (i + 1) & mask;
+        dist++;
+    }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Place the binding held in *psSlot into the slot array aSlots of
+uSlotCount slots, displacing bindings that are closer to their home
+slot than the binding being placed */
+
+static void SymTable_place(struct Slot *aSlots, size_t uSlotCount,
+                           struct Slot *psSlot)
+{
+    size_t mask = uSlotCount - 1;
+    size_t i;
+    struct Slot carried, swap;
+
+    carried = *psSlot;
+    carried.dist = 0;
+    i = carried.hash & mask;
+
+    for (;;)
+    {
+        /* Handle condition where an empty slot has been reached */
+        if (aSlots[i].key == NULL)
+        {
+            aSlots[i] = carried;
+            return;
+        }
+
+        /* Take the slot from a binding that is closer to home, and
+        carry that binding forward instead */
+        if (aSlots[i].dist < carried.dist)
+        {
+            swap = aSlots[i];
+            aSlots[i] = carried;
+            carried = swap;
+        }
+
+        i = (i + 1) & mask;
+        carried.dist++;
+    }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Double the slot array of oSymTable and reinsert every binding. Return
+1 (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+available, in which case oSymTable is left unchanged */
+
+static int SymTable_tryExpand(SymTable_T oSymTable)
+{
+    struct Slot *newSlots;
+    size_t newSlotCount;
+    size_t i;
+
+    newSlotCount = oSymTable->slotCount * 2;
+
+    /* Handle case where slot count would overflow */
+    if (newSlotCount < oSymTable->slotCount)
+        return 0;
+
+    /* Allocate memory for new slots array */
+    newSlots = calloc(newSlotCount, sizeof(struct Slot));
+    if (newSlots == NULL)
+        return 0;
+
+    /* Reinsert all existing bindings into new slots array */
+    for (i = 0; i < oSymTable->slotCount; i++)
+    {
+        if (oSymTable->slots[i].key != NULL)
+            SymTable_place(newSlots, newSlotCount,
+                           &oSymTable->slots[i]);
+    }
+
+    /* Swaps in the new slots array and records new size */
+    free(oSymTable->slots);
+    oSymTable->slots = newSlots;
+    oSymTable->slotCount = newSlotCount;
+
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+    SymTable_T oSymTable;
+
+    /* Allocate memory for a new symbol table */
+    oSymTable = malloc(sizeof(struct SymTable));
+
+    /* Handle case if allocation of memory to symTable pointer fails */
+    if (oSymTable == NULL)
+    {
+        return NULL;
+    }
+
+    /* Initialize fields for new symbol table */
+    oSymTable->slotCount = INITIAL_SLOT_COUNT;
+    oSymTable->bindingsCount = 0;
+    oSymTable->slots = calloc(oSymTable->slotCount,
+                              sizeof(struct Slot));
+
+    /* Handle case where allocation of memory for array of slots
+    fails */
+    if (oSymTable->slots == NULL)
+    {
+        free(oSymTable);
+        return NULL;
+    }
+
+    return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    /* Free the key copy held in every occupied slot */
+    for (i = 0; i < oSymTable->slotCount; i++)
+    {
+        if (oSymTable->slots[i].key != NULL)
+            free((void *)oSymTable->slots[i].key);
+    }
+
+    /* Free the slot array */
+    free(oSymTable->slots);
+    /* Free the symbol table structure */
+    free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    return oSymTable->bindingsCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable,
+                 const char *pcKey, const void *pvValue)
+{
+    struct Slot newSlot;
+    size_t uHash;
+    char *keyCopy;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uHash = SymTable_hash(pcKey);
+
+    /* Handle condition where binding with pcKey already exists */
+    if (SymTable_findSlot(oSymTable, pcKey, uHash)
+        != oSymTable->slotCount)
+        return 0;
+
+    /* Attempt to expand hash table if adding one more binding would
+    exceed the maximum load factor. If that fails, keep filling the
+    current array as long as one slot stays empty to end probes */
+    if ((oSymTable->bindingsCount + 1) * MAX_LOAD_DENOM >
+        oSymTable->slotCount * MAX_LOAD_NUMER)
+    {
+        if (!SymTable_tryExpand(oSymTable) &&
+            oSymTable->bindingsCount + 1 >= oSymTable->slotCount)
+            return 0;
+    }
+
+    /* Copy the key string defensively */
+    keyCopy = malloc(strlen(pcKey) + 1);
+
+    /* Handle condition of insufficient memory for defensive copy
+    of key string */
+    if (keyCopy == NULL)
+        return 0;
+
+    /* Copy string into newly allocated memory */
+    strcpy(keyCopy, pcKey);
+
+    /* Insert new binding, displacing richer bindings as needed */
+    newSlot.key = keyCopy;
+    newSlot.value = pvValue;
+    newSlot.hash = uHash;
+    newSlot.dist = 0;
+    SymTable_place(oSymTable->slots, oSymTable->slotCount, &newSlot);
+
+    oSymTable->bindingsCount++;
+
+    /* Successful insertion*/
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable,
+                       const char *pcKey, const void *pvValue)
+{
+    size_t i;
+    void *oldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    i = SymTable_findSlot(oSymTable, pcKey, SymTable_hash(pcKey));
+
+    /* Handle condition where no binding with pcKey exists */
+    if (i == oSymTable->slotCount)
+        return NULL;
+
+    /* Save old value, then replace with new value */
+    oldValue = (void *)oSymTable->slots[i].value;
+    oSymTable->slots[i].value = pvValue;
+    return oldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_findSlot(oSymTable, pcKey, SymTable_hash(pcKey))
+        != oSymTable->slotCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    i = SymTable_findSlot(oSymTable, pcKey, SymTable_hash(pcKey));
+
+    /* Handle condition where no binding with pcKey exists */
+    if (i == oSymTable->slotCount)
+        return NULL;
+
+    return (void *)oSymTable->slots[i].value;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t i, next, mask;
+    void *bindingValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    i = SymTable_findSlot(oSymTable, pcKey, SymTable_hash(pcKey));
+
+    /* Handle condition where no binding with pcKey exists */
+    if (i == oSymTable->slotCount)
+        return NULL;
+
+    bindingValue = (void *)oSymTable->slots[i].value;
+    free((void *)oSymTable->slots[i].key);
+
+    /* Shift each following binding back by one slot until reaching an
+    empty slot or a binding that already sits in its home slot */
+    mask = oSymTable->slotCount - 1;
+    next = (i + 1) & mask;
+    while (oSymTable->slots[next].key != NULL &&
+           oSymTable->slots[next].dist > 0)
+    {
+        oSymTable->slots[i] = oSymTable->slots[next];
+        oSymTable->slots[i].dist--;
+        i = next;
+        next = (next + 1) & mask;
+    }
+
+    /* The last slot vacated by the shift becomes empty */
+    oSymTable->slots[i].key = NULL;
+    oSymTable->slots[i].value = NULL;
+    oSymTable->slots[i].dist = 0;
+
+    oSymTable->bindingsCount--;
+    return bindingValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue,
+                                  void *pvExtra),
+                  const void *pvExtra)
+{
+    size_t i;
+    struct Slot *curr;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /* Iterate over all occupied slots */
+    for (i = 0; i < oSymTable->slotCount; i++)
+    {
+        curr = &oSymTable->slots[i];
+
+        /* Apply the function on each key/value */
+        if (curr->key != NULL)
+            (void)(*pfApply)(curr->key, (void *)curr->value,
+                             (void *)pvExtra);
+    }
+}
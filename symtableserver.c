@@ -0,0 +1,739 @@
+/*--------------------------------------------------------------------*/
+/* symtableserver.c                                                   */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+/* Server that shares one table among the processes that connect to
+it over a Unix domain socket, speaking the protocol of symtableproto.h.
+The table is split into shards, each a hash-table SymTable guarded by
+a readers-writer lock, so that workers rarely wait for each other. The
+main thread accepts connections and hands each to one of a fixed pool
+of worker threads, which waits on its connections with epoll. A worker
+reads whatever requests have arrived on a connection, answers them
+all, and sends the answers together. A connection whose answers cannot
+be sent is not read again until they are, so a client that sends
+without reading cannot make the server buffer without limit */
+
+#define _XOPEN_SOURCE 700
+
+#include "symtable.h"
+#include "symtableproto.h"
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* Number of shards of the table, a power of two */
+enum {SHARD_COUNT = 64};
+
+/* Least number of free bytes in an input buffer for each read */
+enum {READ_BYTES = 64 * 1024};
+
+/* Greatest number of events handled per wait */
+enum {MAX_EVENTS = 64};
+
+/* Each Value is the value of a binding, as sent by a client */
+struct Value
+{
+    /* Number of bytes of the value */
+    uint32_t length;
+    /* Bytes of the value */
+    unsigned char bytes[];
+};
+
+/* Each Shard is a part of the table and its lock */
+struct Shard
+{
+    /* Guards table */
+    pthread_rwlock_t lock;
+    /* Bindings of keys that hash to this shard */
+    SymTable_T table;
+};
+
+/* Each Connection is a client connected to a worker */
+struct Connection
+{
+    /* Socket connected to the client */
+    int fd;
+    /* 1 (TRUE) while waiting for the socket to become writable */
+    int writeBlocked;
+    /* Requests received but not yet answered */
+    unsigned char *in;
+    /* Number of bytes in in, and bytes allocated for it */
+    size_t inUsed;
+    size_t inCapacity;
+    /* Responses not yet sent */
+    unsigned char *out;
+    /* Number of bytes in out, and number of them already sent */
+    size_t outUsed;
+    size_t outSent;
+    /* Number of bytes allocated for out */
+    size_t outCapacity;
+    /* Neighbours in the list of connections of the worker */
+    struct Connection *prev;
+    struct Connection *next;
+};
+
+/* Each Worker is a thread serving some of the connections */
+struct Worker
+{
+    /* The thread */
+    pthread_t thread;
+    /* Waits on the connections and on handoff */
+    int epollFd;
+    /* Pipe over which the main thread sends new sockets, or -1 to
+    stop */
+    int handoff[2];
+    /* Connections served by the worker */
+    struct Connection *connections;
+    /* NUL-terminated copy of the key of the current request */
+    char key[SYMTABLEPROTO_MAX_KEY + 1];
+};
+
+/* Shards of the table */
+static struct Shard asShards[SHARD_COUNT];
+
+/* Pipe written by the signal handler to stop the server */
+static int aiStopPipe[2];
+
+/*--------------------------------------------------------------------*/
+
+/* Handle a request to stop the server. iSignal is unused */
+
+static void handleStop(int iSignal)
+{
+    int iSavedErrno = errno;
+
+    (void)iSignal;
+    (void)write(aiStopPipe[1], "", 1);
+    errno = iSavedErrno;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the shard that holds key pcKey */
+
+static struct Shard *shardOf(const char *pcKey)
+{
+    uint32_t uHash = 2166136261U;
+    size_t u;
+
+    /* FNV-1a, unrelated to the hash used within each shard */
+    for (u = 0; pcKey[u] != '\0'; u++)
+    {
+        uHash ^= (unsigned char)pcKey[u];
+        uHash *= 16777619U;
+    }
+    return &asShards[uHash & (SHARD_COUNT - 1)];
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Make room for at least uBytes more bytes in the buffer *ppucBuffer
+holding uUsed of its *puCapacity bytes. Return 1 (TRUE) if successful,
+or 0 (FALSE) if insufficient memory is available */
+
+static int reserve(unsigned char **ppucBuffer, size_t *puCapacity,
+                   size_t uUsed, size_t uBytes)
+{
+    unsigned char *pucNew;
+    size_t uCapacity;
+
+    if (*puCapacity - uUsed >= uBytes)
+        return 1;
+
+    uCapacity = *puCapacity > 0 ? *puCapacity : READ_BYTES;
+    while (uCapacity - uUsed < uBytes)
+        uCapacity *= 2;
+    pucNew = realloc(*ppucBuffer, uCapacity);
+    if (pucNew == NULL)
+        return 0;
+    *ppucBuffer = pucNew;
+    *puCapacity = uCapacity;
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Append to the responses of psConnection one with status iStatus and
+the uLength bytes at pvValue. Return 1 (TRUE) if successful, or 0
+(FALSE) if insufficient memory is available */
+
+static int respond(struct Connection *psConnection, int iStatus,
+                   const void *pvValue, size_t uLength)
+{
+    unsigned char *pucHeader;
+    uint32_t uLength32 = (uint32_t)uLength;
+
+    if (!reserve(&psConnection->out, &psConnection->outCapacity,
+                 psConnection->outUsed,
+                 SYMTABLEPROTO_RESPONSE_HEADER + uLength))
+        return 0;
+
+    pucHeader = psConnection->out + psConnection->outUsed;
+    pucHeader[0] = (unsigned char)iStatus;
+    memcpy(pucHeader + 1, &uLength32, sizeof(uint32_t));
+    if (uLength > 0)
+        memcpy(pucHeader + SYMTABLEPROTO_RESPONSE_HEADER, pvValue,
+               uLength);
+    psConnection->outUsed += SYMTABLEPROTO_RESPONSE_HEADER + uLength;
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Answer the request for the value of key pcKey on psConnection.
+Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory is
+available */
+
+static int doGet(struct Connection *psConnection, const char *pcKey)
+{
+    struct Shard *psShard = shardOf(pcKey);
+    struct Value *psValue;
+    int iSuccessful;
+
+    /* Copy the value out while no writer can free it */
+    (void)pthread_rwlock_rdlock(&psShard->lock);
+    psValue = SymTable_get(psShard->table, pcKey);
+    if (psValue == NULL)
+        iSuccessful = respond(psConnection, SYMTABLEPROTO_NOT_FOUND,
+                              NULL, 0);
+    else
+        iSuccessful = respond(psConnection, SYMTABLEPROTO_OK,
+                              psValue->bytes, psValue->length);
+    (void)pthread_rwlock_unlock(&psShard->lock);
+
+    return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Answer the request on psConnection to bind key pcKey to the
+uLength bytes at pvValue. Return 1 (TRUE) if successful, or 0 (FALSE)
+if insufficient memory is available */
+
+static int doPut(struct Connection *psConnection, const char *pcKey,
+                 const void *pvValue, size_t uLength)
+{
+    struct Shard *psShard = shardOf(pcKey);
+    struct Value *psValue;
+    struct Value *psOld;
+    int iStatus = SYMTABLEPROTO_OK;
+
+    /* Copy the value before taking the lock */
+    psValue = malloc(sizeof(struct Value) + uLength);
+    if (psValue == NULL)
+        return respond(psConnection, SYMTABLEPROTO_NO_MEMORY, NULL, 0);
+    psValue->length = (uint32_t)uLength;
+    if (uLength > 0)
+        memcpy(psValue->bytes, pvValue, uLength);
+
+    /* Values are never NULL, so a NULL old value means no binding */
+    (void)pthread_rwlock_wrlock(&psShard->lock);
+    psOld = SymTable_replace(psShard->table, pcKey, psValue);
+    if (psOld == NULL && !SymTable_put(psShard->table, pcKey, psValue))
+        iStatus = SYMTABLEPROTO_NO_MEMORY;
+    (void)pthread_rwlock_unlock(&psShard->lock);
+
+    free(psOld);
+    if (iStatus != SYMTABLEPROTO_OK)
+        free(psValue);
+    return respond(psConnection, iStatus, NULL, 0);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Answer the request on psConnection to remove the binding of key
+pcKey. Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient
+memory is available */
+
+static int doRemove(struct Connection *psConnection, const char *pcKey)
+{
+    struct Shard *psShard = shardOf(pcKey);
+    struct Value *psOld;
+
+    (void)pthread_rwlock_wrlock(&psShard->lock);
+    psOld = SymTable_remove(psShard->table, pcKey);
+    (void)pthread_rwlock_unlock(&psShard->lock);
+
+    free(psOld);
+    return respond(psConnection,
+                   psOld != NULL ? SYMTABLEPROTO_OK
+                                 : SYMTABLEPROTO_NOT_FOUND,
+                   NULL, 0);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Answer every complete request in the input buffer of psConnection,
+using the key buffer of psWorker, and drop them from the buffer.
+Return 1 (TRUE) if successful, or 0 (FALSE) if the connection must be
+closed */
+
+static int answer(struct Worker *psWorker,
+                  struct Connection *psConnection)
+{
+    const unsigned char *pucRequest;
+    uint32_t uKeyLength, uLength;
+    size_t uOffset = 0;
+    size_t uSize;
+    int iSuccessful = 1;
+
+    while (iSuccessful && psConnection->inUsed - uOffset >=
+                              SYMTABLEPROTO_REQUEST_HEADER)
+    {
+        pucRequest = psConnection->in + uOffset;
+        memcpy(&uKeyLength, pucRequest + 1, sizeof(uint32_t));
+        memcpy(&uLength, pucRequest + 5, sizeof(uint32_t));
+
+        /* Handle a request whose length cannot be trusted */
+        if (uKeyLength > SYMTABLEPROTO_MAX_KEY ||
+            uLength > SYMTABLEPROTO_MAX_VALUE)
+        {
+            (void)respond(psConnection, SYMTABLEPROTO_BAD_REQUEST, NULL,
+                          0);
+            return 0;
+        }
+
+        /* Wait for the rest of the request */
+        uSize = SYMTABLEPROTO_REQUEST_HEADER + uKeyLength + uLength;
+        if (psConnection->inUsed - uOffset < uSize)
+            break;
+
+        memcpy(psWorker->key, pucRequest + SYMTABLEPROTO_REQUEST_HEADER,
+               uKeyLength);
+        psWorker->key[uKeyLength] = '\0';
+
+        if (strlen(psWorker->key) != uKeyLength)
+            iSuccessful = respond(psConnection, SYMTABLEPROTO_BAD_REQUEST,
+                                  NULL, 0);
+        else if (pucRequest[0] == SYMTABLEPROTO_GET && uLength == 0)
+            iSuccessful = doGet(psConnection, psWorker->key);
+        else if (pucRequest[0] == SYMTABLEPROTO_PUT)
+            iSuccessful = doPut(psConnection, psWorker->key,
+                                pucRequest + SYMTABLEPROTO_REQUEST_HEADER +
+                                    uKeyLength,
+                                uLength);
+        else if (pucRequest[0] == SYMTABLEPROTO_REMOVE && uLength == 0)
+            iSuccessful = doRemove(psConnection, psWorker->key);
+        else
+            iSuccessful = respond(psConnection, SYMTABLEPROTO_BAD_REQUEST,
+                                  NULL, 0);
+        uOffset += uSize;
+    }
+
+    /* Keep only the incomplete request, if any */
+    memmove(psConnection->in, psConnection->in + uOffset,
+            psConnection->inUsed - uOffset);
+    psConnection->inUsed -= uOffset;
+    return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Send as many of the responses of psConnection as the socket takes
+now. Return 1 (TRUE) if successful, or 0 (FALSE) if the connection
+must be closed */
+
+static int sendResponses(struct Connection *psConnection)
+{
+    ssize_t iSent;
+
+    while (psConnection->outSent < psConnection->outUsed)
+    {
+        iSent = send(psConnection->fd,
+                     psConnection->out + psConnection->outSent,
+                     psConnection->outUsed - psConnection->outSent,
+                     MSG_NOSIGNAL);
+        if (iSent > 0)
+            psConnection->outSent += (size_t)iSent;
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return 1;
+        else if (errno != EINTR)
+            return 0;
+    }
+    psConnection->outSent = psConnection->outUsed = 0;
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Watch psConnection, within psWorker, for readability if all of its
+responses have been sent, or for writability otherwise. Return 1
+(TRUE) if successful, or 0 (FALSE) otherwise */
+
+static int watch(struct Worker *psWorker,
+                 struct Connection *psConnection)
+{
+    struct epoll_event sEvent;
+    int iWriteBlocked = psConnection->outUsed > 0;
+
+    if (iWriteBlocked == psConnection->writeBlocked)
+        return 1;
+
+    sEvent.events = iWriteBlocked ? EPOLLOUT : EPOLLIN;
+    sEvent.data.ptr = psConnection;
+    psConnection->writeBlocked = iWriteBlocked;
+    return epoll_ctl(psWorker->epollFd, EPOLL_CTL_MOD, psConnection->fd,
+                     &sEvent) == 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Close psConnection and remove it from psWorker */
+
+static void closeConnection(struct Worker *psWorker,
+                            struct Connection *psConnection)
+{
+    (void)close(psConnection->fd);
+    if (psConnection->prev != NULL)
+        psConnection->prev->next = psConnection->next;
+    else
+        psWorker->connections = psConnection->next;
+    if (psConnection->next != NULL)
+        psConnection->next->prev = psConnection->prev;
+    free(psConnection->in);
+    free(psConnection->out);
+    free(psConnection);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Start serving the client connected to socket fd in psWorker, or
+close the socket if that fails */
+
+static void openConnection(struct Worker *psWorker, int fd)
+{
+    struct Connection *psConnection;
+    struct epoll_event sEvent;
+
+    psConnection = calloc(1, sizeof(struct Connection));
+    if (psConnection == NULL)
+    {
+        (void)close(fd);
+        return;
+    }
+    psConnection->fd = fd;
+    psConnection->next = psWorker->connections;
+    if (psWorker->connections != NULL)
+        psWorker->connections->prev = psConnection;
+    psWorker->connections = psConnection;
+
+    sEvent.events = EPOLLIN;
+    sEvent.data.ptr = psConnection;
+    if (fcntl(fd, F_SETFL, O_NONBLOCK) != 0 ||
+        epoll_ctl(psWorker->epollFd, EPOLL_CTL_ADD, fd, &sEvent) != 0)
+        closeConnection(psWorker, psConnection);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Serve psConnection of psWorker, whose socket is ready. Return 1
+(TRUE) if the connection remains open, or 0 (FALSE) if it must be
+closed */
+
+static int serve(struct Worker *psWorker,
+                 struct Connection *psConnection)
+{
+    ssize_t iRead;
+
+    /* Finish sending earlier responses before reading more */
+    if (psConnection->writeBlocked)
+    {
+        if (!sendResponses(psConnection))
+            return 0;
+        if (psConnection->outUsed > 0)
+            return 1;
+
+        /* Answer requests that arrived while sending was blocked */
+        if (!answer(psWorker, psConnection) ||
+            !sendResponses(psConnection))
+            return 0;
+        return watch(psWorker, psConnection);
+    }
+
+    if (!reserve(&psConnection->in, &psConnection->inCapacity,
+                 psConnection->inUsed, READ_BYTES))
+        return 0;
+    iRead = read(psConnection->fd, psConnection->in + psConnection->inUsed,
+                 psConnection->inCapacity - psConnection->inUsed);
+    if (iRead < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    if (iRead == 0)
+        return 0;
+    psConnection->inUsed += (size_t)iRead;
+
+    /* Answer every complete request and send the answers together */
+    if (!answer(psWorker, psConnection))
+    {
+        (void)sendResponses(psConnection);
+        return 0;
+    }
+    if (!sendResponses(psConnection))
+        return 0;
+    return watch(psWorker, psConnection);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Serve the connections handed to pvWorker, a Worker, until told to
+stop. Return NULL */
+
+static void *runWorker(void *pvWorker)
+{
+    struct Worker *psWorker = pvWorker;
+    struct epoll_event asEvents[MAX_EVENTS];
+    struct Connection *psConnection;
+    int iEventCount;
+    int iRunning = 1;
+    int fd;
+    int i;
+
+    while (iRunning)
+    {
+        iEventCount = epoll_wait(psWorker->epollFd, asEvents, MAX_EVENTS,
+                                 -1);
+        for (i = 0; i < iEventCount; i++)
+        {
+            psConnection = asEvents[i].data.ptr;
+
+            /* Handle a new socket or a request to stop */
+            if (psConnection == NULL)
+            {
+                if (read(psWorker->handoff[0], &fd, sizeof(int)) !=
+                        (ssize_t)sizeof(int) ||
+                    fd < 0)
+                    iRunning = 0;
+                else
+                    openConnection(psWorker, fd);
+            }
+            else if (!serve(psWorker, psConnection))
+                closeConnection(psWorker, psConnection);
+        }
+    }
+
+    while (psWorker->connections != NULL)
+        closeConnection(psWorker, psWorker->connections);
+    return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free pvValue, a Value. pcKey and pvExtra are unused */
+
+static void freeValue(const char *pcKey, void *pvValue, void *pvExtra)
+{
+    (void)pcKey;
+    (void)pvExtra;
+    free(pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a socket listening on the Unix domain socket named pcPath,
+replacing any existing socket of that name, or -1 if that fails */
+
+static int listenOn(const char *pcPath)
+{
+    struct sockaddr_un sAddress;
+    int fd;
+
+    if (strlen(pcPath) >= sizeof(sAddress.sun_path))
+        return -1;
+    memset(&sAddress, 0, sizeof(sAddress));
+    sAddress.sun_family = AF_UNIX;
+    strcpy(sAddress.sun_path, pcPath);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    (void)unlink(pcPath);
+    if (bind(fd, (struct sockaddr *)&sAddress, sizeof(sAddress)) != 0 ||
+        listen(fd, SOMAXCONN) != 0)
+    {
+        (void)close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Start psWorker. Return 1 (TRUE) if successful, or 0 (FALSE)
+otherwise */
+
+static int startWorker(struct Worker *psWorker)
+{
+    struct epoll_event sEvent;
+
+    psWorker->connections = NULL;
+    psWorker->epollFd = epoll_create1(0);
+    if (psWorker->epollFd < 0)
+        return 0;
+    if (pipe(psWorker->handoff) != 0)
+    {
+        (void)close(psWorker->epollFd);
+        return 0;
+    }
+
+    sEvent.events = EPOLLIN;
+    sEvent.data.ptr = NULL;
+    if (epoll_ctl(psWorker->epollFd, EPOLL_CTL_ADD, psWorker->handoff[0],
+                  &sEvent) != 0 ||
+        pthread_create(&psWorker->thread, NULL, runWorker, psWorker) != 0)
+    {
+        (void)close(psWorker->handoff[0]);
+        (void)close(psWorker->handoff[1]);
+        (void)close(psWorker->epollFd);
+        return 0;
+    }
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Accept connections on socket iListenFd and hand them to the
+uWorkerCount workers of apsWorkers in turn, until a stop is requested
+over aiStopPipe */
+
+static void acceptConnections(int iListenFd, struct Worker *psWorkers,
+                              size_t uWorkerCount)
+{
+    struct pollfd asPoll[2];
+    size_t uNext = 0;
+    int fd;
+
+    asPoll[0].fd = iListenFd;
+    asPoll[0].events = POLLIN;
+    asPoll[1].fd = aiStopPipe[0];
+    asPoll[1].events = POLLIN;
+
+    for (;;)
+    {
+        if (poll(asPoll, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        if (asPoll[1].revents != 0)
+            return;
+        if (asPoll[0].revents == 0)
+            continue;
+
+        fd = accept(iListenFd, NULL, NULL);
+        if (fd < 0)
+            continue;
+        if (write(psWorkers[uNext].handoff[1], &fd, sizeof(int)) !=
+            (ssize_t)sizeof(int))
+            (void)close(fd);
+        uNext = (uNext + 1) % uWorkerCount;
+    }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Serve the table on the Unix domain socket named argv[1] with the
+number of worker threads given by argv[2], or one per processor if it
+is omitted, until SIGINT or SIGTERM arrives. Return 0 if the server
+stopped normally, or 1 otherwise */
+
+int main(int argc, char *argv[])
+{
+    struct sigaction sAction;
+    struct Worker *psWorkers;
+    size_t uWorkerCount;
+    size_t uStarted = 0;
+    size_t u;
+    int iListenFd;
+    int iStop = -1;
+    int iStatus = 0;
+
+    if (argc != 2 && argc != 3)
+    {
+        fprintf(stderr, "Usage: %s socketpath [workercount]\n", argv[0]);
+        return 1;
+    }
+    if (argc == 3)
+        uWorkerCount = (size_t)atoi(argv[2]);
+    else
+        uWorkerCount = (size_t)sysconf(_SC_NPROCESSORS_ONLN);
+    if (uWorkerCount < 1)
+        uWorkerCount = 1;
+
+    /* Make the empty shards */
+    for (u = 0; u < SHARD_COUNT; u++)
+    {
+        asShards[u].table = SymTable_new();
+        if (asShards[u].table == NULL ||
+            pthread_rwlock_init(&asShards[u].lock, NULL) != 0)
+        {
+            fprintf(stderr, "%s: insufficient memory\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* Stop cleanly on SIGINT and SIGTERM */
+    if (pipe(aiStopPipe) != 0)
+    {
+        perror(argv[0]);
+        return 1;
+    }
+    memset(&sAction, 0, sizeof(sAction));
+    sAction.sa_handler = handleStop;
+    (void)sigemptyset(&sAction.sa_mask);
+    (void)sigaction(SIGINT, &sAction, NULL);
+    (void)sigaction(SIGTERM, &sAction, NULL);
+
+    iListenFd = listenOn(argv[1]);
+    if (iListenFd < 0)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    psWorkers = calloc(uWorkerCount, sizeof(struct Worker));
+    if (psWorkers != NULL)
+        while (uStarted < uWorkerCount &&
+               startWorker(&psWorkers[uStarted]))
+            uStarted++;
+
+    if (uStarted == uWorkerCount)
+        acceptConnections(iListenFd, psWorkers, uWorkerCount);
+    else
+    {
+        fprintf(stderr, "%s: cannot start workers\n", argv[0]);
+        iStatus = 1;
+    }
+
+    /* Stop the workers, which close their connections */
+    (void)close(iListenFd);
+    (void)unlink(argv[1]);
+    for (u = 0; u < uStarted; u++)
+    {
+        (void)write(psWorkers[u].handoff[1], &iStop, sizeof(int));
+        (void)pthread_join(psWorkers[u].thread, NULL);
+        (void)close(psWorkers[u].handoff[0]);
+        (void)close(psWorkers[u].handoff[1]);
+        (void)close(psWorkers[u].epollFd);
+    }
+    free(psWorkers);
+
+    for (u = 0; u < SHARD_COUNT; u++)
+    {
+        SymTable_map(asShards[u].table, freeValue, NULL);
+        SymTable_free(asShards[u].table);
+        (void)pthread_rwlock_destroy(&asShards[u].lock);
+    }
+    return iStatus;
+}
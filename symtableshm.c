@@ -0,0 +1,806 @@
+/*--------------------------------------------------------------------*/
+/* symtableshm.c                                                      */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+/* Hash-table-based implementation of symbol table whose buckets,
+bindings and keys live in a region of memory shared among processes.
+Every link within the region is an offset from its start, so the
+region works at any address. The region begins with a header holding
+the table's fields, a sequence number for lock-free readers, a
+process-shared mutex for writers, and the free lists of a small
+allocator that carves the rest of the region into chunks. Collisions
+are handled via separate chaining, and each binding holds its key
+inline. Readers check every offset they follow against the size of
+the region, so a lookup that overlaps an update reads garbage at
+worst, never memory outside the region, and is then retried.
+
+The writer mutex is robust, so a process that dies holding it does not
+lock out the others forever. The next process to take the lock makes
+the sequence number even again, so that readers stop waiting for the
+dead writer, and marks the mutex consistent. Whatever the dead writer
+had done of its update stays as it was: a binding it was adding or
+removing may or may not be in the table, and a chunk may be lost to
+the allocator, but every link still points within the region. Each
+binding has two links, and an expansion chains the bindings into the
+new bucket array through the link that the old array does not use, so
+the old chains stay whole until a single store replaces the old array
+with the new one; a writer that dies during an expansion loses no
+binding */
+
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+
+#include "symtableshm.h"
+#include "symtablehashcode.h"
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Number that starts every region */
+static const uint32_t REGION_MAGIC = 0x53594D53U;
+
+/* Initial number of buckets, a power of two */
+enum {INITIAL_BUCKET_COUNT = 512};
+
+/* Chunks of up to SMALL_LIMIT bytes come in multiples of CHUNK_ALIGN
+bytes; larger chunks come in powers of two. Each size of chunk has its
+own free list */
+enum {CHUNK_ALIGN = 16, SMALL_LIMIT = 256,
+      SMALL_CLASS_COUNT = SMALL_LIMIT / CHUNK_ALIGN, CLASS_COUNT = 72};
+
+/* Number of bytes before each chunk's payload, holding its size
+class */
+enum {CHUNK_HEADER = 8};
+
+/* Region structure is the header at the start of a shared region */
+struct Region
+{
+    /* REGION_MAGIC */
+    uint32_t magic;
+    /* Number of bytes taken by this header */
+    uint32_t headerBytes;
+    /* Number of bytes in the region */
+    uint64_t regionBytes;
+    /* Offset of the first byte never allocated */
+    uint64_t top;
+    /* Offset of the current Buckets */
+    uint64_t buckets;
+    /* Stores total number of bindings in SymTable */
+    uint64_t bindingsCount;
+    /* Odd while an update is in progress */
+    unsigned long seq;
+    /* Offsets of the first free chunk of each size class */
+    uint64_t freeLists[CLASS_COUNT];
+    /* Serializes updates among processes */
+    pthread_mutex_t writeLock;
+};
+
+/* Buckets structure is an array of bucket heads, kept in one chunk
+together with its size so that both are replaced in one store */
+struct Buckets
+{
+    /* Number of buckets, a power of two */
+    uint64_t count;
+    /* Index of the link of each binding that the chains use, 0 or 1 */
+    uint64_t link;
+    /* Offset of the first binding of each bucket chain, or 0 */
+    uint64_t heads[];
+};
+
+/* Each Binding represents a key-value pair in a bucket chain */
+struct Binding
+{
+    /* Offsets of next binding in bucket chain, or 0, through either
+    link. The current Buckets says which link its chains use */
+    uint64_t next[2];
+    /* Hash code of key */
+    uint64_t hash;
+    /* Bits of the associated value */
+    uint64_t value;
+    /* Key string */
+    char key[];
+};
+
+/* SymTable structure represents one process's view of a region */
+struct SymTable
+{
+    /* Address at which the region is mapped */
+    unsigned char *base;
+    /* Header of the region, at base */
+    struct Region *region;
+    /* Number of bytes mapped */
+    size_t regionBytes;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a hash code for pcKey */
+
+static uint64_t SymTable_hash(const char *pcKey)
+{
+    return SymTableHashCode_full(pcKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the address within oSymTable's mapping of offset uOffset */
+
+static void *SymTable_at(SymTable_T oSymTable, uint64_t uOffset)
+{
+    return oSymTable->base + uOffset;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current Buckets of oSymTable. Called with the writer
+lock held */
+
+static struct Buckets *SymTable_buckets(SymTable_T oSymTable)
+{
+    return SymTable_at(oSymTable, oSymTable->region->buckets);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if the uLength bytes at offset uOffset lie within
+the allocatable part of the region of oSymTable, or 0 (FALSE)
+otherwise */
+
+static int SymTable_inRegion(SymTable_T oSymTable, uint64_t uOffset,
+                             uint64_t uLength)
+{
+    return uOffset >= oSymTable->region->headerBytes &&
+           uLength <= oSymTable->regionBytes &&
+           uOffset <= oSymTable->regionBytes - uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the size class of a chunk with room for uBytes bytes of
+payload, and store the size of such a chunk in *puChunkBytes */
+
+static size_t SymTable_sizeClass(uint64_t uBytes, uint64_t *puChunkBytes)
+{
+    uint64_t uChunkBytes;
+    size_t uClass;
+
+    uBytes += CHUNK_HEADER;
+    if (uBytes <= SMALL_LIMIT)
+    {
+        uChunkBytes = (uBytes + CHUNK_ALIGN - 1) & ~(uint64_t)(CHUNK_ALIGN - 1);
+        *puChunkBytes = uChunkBytes;
+        return (size_t)(uChunkBytes / CHUNK_ALIGN - 1);
+    }
+
+    uChunkBytes = (uint64_t)SMALL_LIMIT * 2;
+    uClass = SMALL_CLASS_COUNT;
+    while (uChunkBytes < uBytes)
+    {
+        uChunkBytes <<= 1;
+        uClass++;
+    }
+    *puChunkBytes = uChunkBytes;
+    return uClass;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the offset of a new chunk in the region of oSymTable with
+room for uBytes bytes, or 0 if the region has no room. Called with the
+writer lock held */
+
+static uint64_t SymTable_allocate(SymTable_T oSymTable, uint64_t uBytes)
+{
+    struct Region *psRegion = oSymTable->region;
+    uint64_t uChunkBytes, uOffset;
+    size_t uClass;
+
+    uClass = SymTable_sizeClass(uBytes, &uChunkBytes);
+    if (uClass >= CLASS_COUNT)
+        return 0;
+
+    /* Reuse a free chunk of the same size, whose payload holds the
+    offset of the next free chunk */
+    uOffset = psRegion->freeLists[uClass];
+    if (uOffset != 0)
+    {
+        memcpy(&psRegion->freeLists[uClass],
+               SymTable_at(oSymTable, uOffset), sizeof(uint64_t));
+        return uOffset;
+    }
+
+    /* Otherwise carve a new chunk from the unused end of the region */
+    if (uChunkBytes > psRegion->regionBytes - psRegion->top)
+        return 0;
+    uOffset = psRegion->top + CHUNK_HEADER;
+    psRegion->top += uChunkBytes;
+    memcpy(SymTable_at(oSymTable, uOffset - CHUNK_HEADER), &uChunkBytes,
+           sizeof(uint64_t));
+    return uOffset;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put the chunk at offset uOffset of the region of oSymTable on the
+free list of its size class. Called with the writer lock held */
+
+static void SymTable_release(SymTable_T oSymTable, uint64_t uOffset)
+{
+    struct Region *psRegion = oSymTable->region;
+    uint64_t uChunkBytes, uIgnored;
+    size_t uClass;
+
+    memcpy(&uChunkBytes, SymTable_at(oSymTable, uOffset - CHUNK_HEADER),
+           sizeof(uint64_t));
+    uClass = SymTable_sizeClass(uChunkBytes - CHUNK_HEADER, &uIgnored);
+
+    memcpy(SymTable_at(oSymTable, uOffset), &psRegion->freeLists[uClass],
+           sizeof(uint64_t));
+    psRegion->freeLists[uClass] = uOffset;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Take the writer lock of oSymTable, recovering it if its owner died
+while holding it */
+
+static void SymTable_lock(SymTable_T oSymTable)
+{
+    struct Region *psRegion = oSymTable->region;
+
+    if (pthread_mutex_lock(&psRegion->writeLock) != EOWNERDEAD)
+        return;
+
+    /* Handle case where the owner died in the middle of an update */
+    if (psRegion->seq & 1)
+        __atomic_store_n(&psRegion->seq, psRegion->seq + 1,
+                         __ATOMIC_RELEASE);
+    (void)pthread_mutex_consistent(&psRegion->writeLock);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Start an update of oSymTable: take the writer lock and make the
+sequence number odd so that readers will retry */
+
+static void SymTable_writeBegin(SymTable_T oSymTable)
+{
+    struct Region *psRegion = oSymTable->region;
+
+    SymTable_lock(oSymTable);
+    __atomic_store_n(&psRegion->seq, psRegion->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Finish an update of oSymTable: make the sequence number even again
+and release the writer lock */
+
+static void SymTable_writeEnd(SymTable_T oSymTable)
+{
+    struct Region *psRegion = oSymTable->region;
+
+    __atomic_store_n(&psRegion->seq, psRegion->seq + 1, __ATOMIC_RELEASE);
+    (void)pthread_mutex_unlock(&psRegion->writeLock);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if the key of the binding at offset uOffset of
+oSymTable equals pcKey, or 0 (FALSE) otherwise, reading no further
+than the end of the region */
+
+static int SymTable_keyEquals(SymTable_T oSymTable, uint64_t uOffset,
+                              const char *pcKey)
+{
+    const char *pcStored;
+    uint64_t uRoom;
+    uint64_t u;
+
+    pcStored = ((struct Binding *)SymTable_at(oSymTable, uOffset))->key;
+    uRoom = oSymTable->regionBytes - uOffset - sizeof(struct Binding);
+    for (u = 0; u < uRoom; u++)
+    {
+        if (pcStored[u] != pcKey[u])
+            return 0;
+        if (pcKey[u] == '\0')
+            return 1;
+    }
+    return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look up key pcKey in oSymTable without the writer lock. Return 1
+(TRUE) and store the value of its binding in *ppvValue if it exists,
+or 0 (FALSE) otherwise. A lookup that overlaps an update is retried */
+
+static int SymTable_lookup(SymTable_T oSymTable, const char *pcKey,
+                           void **ppvValue)
+{
+    struct Region *psRegion = oSymTable->region;
+    struct Buckets *psBuckets;
+    struct Binding *psBinding;
+    uint64_t uHash, uBuckets, uBucketCount, uLink, uOffset, uSteps;
+    unsigned long seq;
+    int iFound;
+
+    uHash = SymTable_hash(pcKey);
+
+    do
+    {
+        /* Wait for any update in progress to finish */
+        do
+            seq = __atomic_load_n(&psRegion->seq, __ATOMIC_ACQUIRE);
+        while (seq & 1);
+
+        iFound = 0;
+        uOffset = 0;
+        uLink = 0;
+        uBuckets = __atomic_load_n(&psRegion->buckets, __ATOMIC_ACQUIRE);
+        if (SymTable_inRegion(oSymTable, uBuckets,
+                              sizeof(struct Buckets)))
+        {
+            psBuckets = SymTable_at(oSymTable, uBuckets);
+            uBucketCount = __atomic_load_n(&psBuckets->count,
+                                           __ATOMIC_RELAXED);
+            uLink = __atomic_load_n(&psBuckets->link,
+                                    __ATOMIC_RELAXED) & 1;
+            if (uBucketCount > 0 &&
+                uBucketCount <= oSymTable->regionBytes /
+                                    sizeof(uint64_t) &&
+                SymTable_inRegion(oSymTable, uBuckets,
+                                  sizeof(struct Buckets) +
+                                      uBucketCount * sizeof(uint64_t)))
+                uOffset = __atomic_load_n(
+                    &psBuckets->heads[uHash & (uBucketCount - 1)],
+                    __ATOMIC_RELAXED);
+        }
+
+        /* Walk the chain, giving up on a chain that is being changed
+        and so may be cyclic */
+        for (uSteps = 0; uOffset != 0 && uSteps < oSymTable->regionBytes /
+                                                      CHUNK_ALIGN;
+             uSteps++)
+        {
+            if (!SymTable_inRegion(oSymTable, uOffset,
+                                   sizeof(struct Binding)))
+                break;
+            psBinding = SymTable_at(oSymTable, uOffset);
+            if (__atomic_load_n(&psBinding->hash, __ATOMIC_RELAXED) ==
+                    uHash &&
+                SymTable_keyEquals(oSymTable, uOffset, pcKey))
+            {
+                *ppvValue = (void *)(uintptr_t)__atomic_load_n(
+                    &psBinding->value, __ATOMIC_RELAXED);
+                iFound = 1;
+                break;
+            }
+            uOffset = __atomic_load_n(&psBinding->next[uLink],
+                                      __ATOMIC_RELAXED);
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (__atomic_load_n(&psRegion->seq, __ATOMIC_RELAXED) != seq);
+
+    return iFound;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the address of the link, either a bucket head or the next
+field of a binding, that holds the offset of the binding of oSymTable
+whose key is pcKey and whose hash code is uHash, or of the link that
+ends its bucket chain if there is no such binding. Called with the
+writer lock held */
+
+static uint64_t *SymTable_findLink(SymTable_T oSymTable,
+                                   const char *pcKey, uint64_t uHash)
+{
+    struct Buckets *psBuckets = SymTable_buckets(oSymTable);
+    struct Binding *psBinding;
+    uint64_t *puLink;
+
+    puLink = &psBuckets->heads[uHash & (psBuckets->count - 1)];
+    while (*puLink != 0)
+    {
+        psBinding = SymTable_at(oSymTable, *puLink);
+        if (psBinding->hash == uHash && strcmp(psBinding->key, pcKey) == 0)
+            break;
+        puLink = &psBinding->next[psBuckets->link];
+    }
+    return puLink;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Move every binding of oSymTable into a bucket array twice as large,
+if the region has room for it. Called with the writer lock held */
+
+static void SymTable_tryExpand(SymTable_T oSymTable)
+{
+    struct Region *psRegion = oSymTable->region;
+    struct Buckets *psOld, *psNew;
+    struct Binding *psBinding;
+    uint64_t *puHead;
+    uint64_t uOld, uNew, uNewCount, uNewLink, uOffset, u;
+
+    uOld = psRegion->buckets;
+    psOld = SymTable_buckets(oSymTable);
+    uNewCount = psOld->count * 2;
+    uNewLink = psOld->link ^ 1;
+    uNew = SymTable_allocate(oSymTable, sizeof(struct Buckets) +
+                                            uNewCount * sizeof(uint64_t));
+    if (uNew == 0)
+        return;
+    psNew = SymTable_at(oSymTable, uNew);
+    psNew->count = uNewCount;
+    psNew->link = uNewLink;
+    memset(psNew->heads, 0, uNewCount * sizeof(uint64_t));
+
+    /* Rehash all existing bindings into the new bucket array through
+    their other link, so that the old chains stay whole */
+    for (u = 0; u < psOld->count; u++)
+    {
+        for (uOffset = psOld->heads[u]; uOffset != 0;
+             uOffset = psBinding->next[psOld->link])
+        {
+            psBinding = SymTable_at(oSymTable, uOffset);
+            puHead = &psNew->heads[psBinding->hash & (uNewCount - 1)];
+            __atomic_store_n(&psBinding->next[uNewLink], *puHead,
+                             __ATOMIC_RELAXED);
+            *puHead = uOffset;
+        }
+    }
+
+    /* Swap in the new bucket array with one store, after every store
+    that built it */
+    __atomic_store_n(&psRegion->buckets, uNew, __ATOMIC_RELEASE);
+    SymTable_release(oSymTable, uOld);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a SymTable object for the region of uRegionBytes bytes
+mapped at pvBase */
+
+static SymTable_T SymTable_wrap(void *pvBase, size_t uRegionBytes)
+{
+    SymTable_T oSymTable;
+
+    oSymTable = malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+    {
+        (void)munmap(pvBase, uRegionBytes);
+        return NULL;
+    }
+    oSymTable->base = pvBase;
+    oSymTable->region = pvBase;
+    oSymTable->regionBytes = uRegionBytes;
+    return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_newShared(const char *pcPath, size_t uRegionBytes)
+{
+    SymTable_T oSymTable;
+    struct Region *psRegion;
+    pthread_mutexattr_t attr;
+    void *pvBase;
+    int fd;
+
+    if (uRegionBytes < sizeof(struct Region))
+        return NULL;
+
+    /* Map the region, which starts out filled with zeros */
+    if (pcPath == NULL)
+        pvBase = mmap(NULL, uRegionBytes, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    else
+    {
+        fd = open(pcPath, O_RDWR | O_CREAT | O_EXCL, 0666);
+        if (fd < 0)
+            return NULL;
+        pvBase = MAP_FAILED;
+        if (ftruncate(fd, (off_t)uRegionBytes) == 0)
+            pvBase = mmap(NULL, uRegionBytes, PROT_READ | PROT_WRITE,
+                          MAP_SHARED, fd, 0);
+        (void)close(fd);
+    }
+    if (pvBase == MAP_FAILED)
+        return NULL;
+
+    oSymTable = SymTable_wrap(pvBase, uRegionBytes);
+    if (oSymTable == NULL)
+        return NULL;
+
+    /* Initialize the header, rounding it up to a whole cache line */
+    psRegion = oSymTable->region;
+    psRegion->headerBytes =
+        (uint32_t)((sizeof(struct Region) + 63) & ~(size_t)63);
+    psRegion->regionBytes = uRegionBytes;
+    psRegion->top = psRegion->headerBytes;
+    psRegion->buckets = SymTable_allocate(
+        oSymTable, sizeof(struct Buckets) +
+                       INITIAL_BUCKET_COUNT * sizeof(uint64_t));
+    if (psRegion->buckets == 0 || pthread_mutexattr_init(&attr) != 0)
+    {
+        SymTable_free(oSymTable);
+        return NULL;
+    }
+    SymTable_buckets(oSymTable)->count = INITIAL_BUCKET_COUNT;
+    (void)pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    (void)pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    (void)pthread_mutex_init(&psRegion->writeLock, &attr);
+    (void)pthread_mutexattr_destroy(&attr);
+
+    /* Mark the region complete for processes that attach to it */
+    __atomic_store_n(&psRegion->magic, REGION_MAGIC, __ATOMIC_RELEASE);
+    return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_attachShared(const char *pcPath)
+{
+    struct stat sStat;
+    struct Region *psRegion;
+    void *pvBase;
+    int fd;
+
+    assert(pcPath != NULL);
+
+    fd = open(pcPath, O_RDWR);
+    if (fd < 0)
+        return NULL;
+    pvBase = MAP_FAILED;
+    if (fstat(fd, &sStat) == 0 &&
+        (size_t)sStat.st_size >= sizeof(struct Region))
+        pvBase = mmap(NULL, (size_t)sStat.st_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+    (void)close(fd);
+    if (pvBase == MAP_FAILED)
+        return NULL;
+
+    /* Handle case where the file does not hold a complete region */
+    psRegion = pvBase;
+    if (__atomic_load_n(&psRegion->magic, __ATOMIC_ACQUIRE) !=
+            REGION_MAGIC ||
+        psRegion->regionBytes != (uint64_t)sStat.st_size)
+    {
+        (void)munmap(pvBase, (size_t)sStat.st_size);
+        return NULL;
+    }
+
+    return SymTable_wrap(pvBase, (size_t)sStat.st_size);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getRegionBytesUsed(SymTable_T oSymTable)
+{
+    size_t uUsed;
+
+    assert(oSymTable != NULL);
+
+    SymTable_lock(oSymTable);
+    uUsed = (size_t)oSymTable->region->top;
+    (void)pthread_mutex_unlock(&oSymTable->region->writeLock);
+    return uUsed;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+    return SymTable_newShared(NULL, SYMTABLESHM_DEFAULT_REGION_BYTES);
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+
+    /* The bindings belong to the region, which other processes may
+    still be using, so only this process's mapping goes away */
+    (void)munmap(oSymTable->base, oSymTable->regionBytes);
+    free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    return (size_t)__atomic_load_n(&oSymTable->region->bindingsCount,
+                                   __ATOMIC_RELAXED);
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable,
+                 const char *pcKey, const void *pvValue)
+{
+    struct Region *psRegion;
+    struct Buckets *psBuckets;
+    struct Binding *psBinding;
+    uint64_t *puLink;
+    uint64_t uHash, uOffset;
+    size_t uKeyLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psRegion = oSymTable->region;
+    uHash = SymTable_hash(pcKey);
+    SymTable_writeBegin(oSymTable);
+
+    /* Handle condition where binding with pcKey already exists */
+    if (*SymTable_findLink(oSymTable, pcKey, uHash) != 0)
+    {
+        SymTable_writeEnd(oSymTable);
+        return 0;
+    }
+
+    /* Attempt to expand if adding one more binding warrants it */
+    if (psRegion->bindingsCount + 1 > SymTable_buckets(oSymTable)->count)
+        SymTable_tryExpand(oSymTable);
+
+    /* Allocate the binding with its key inline */
+    uKeyLength = strlen(pcKey);
+    uOffset = SymTable_allocate(oSymTable,
+                                sizeof(struct Binding) + uKeyLength + 1);
+    if (uOffset == 0)
+    {
+        SymTable_writeEnd(oSymTable);
+        return 0;
+    }
+
+    /* Fill in the binding and insert it at the front of its chain */
+    psBinding = SymTable_at(oSymTable, uOffset);
+    memcpy(psBinding->key, pcKey, uKeyLength + 1);
+    __atomic_store_n(&psBinding->hash, uHash, __ATOMIC_RELAXED);
+    __atomic_store_n(&psBinding->value, (uint64_t)(uintptr_t)pvValue,
+                     __ATOMIC_RELAXED);
+    psBuckets = SymTable_buckets(oSymTable);
+    puLink = &psBuckets->heads[uHash & (psBuckets->count - 1)];
+    __atomic_store_n(&psBinding->next[psBuckets->link], *puLink,
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(puLink, uOffset, __ATOMIC_RELAXED);
+    __atomic_store_n(&psRegion->bindingsCount, psRegion->bindingsCount + 1,
+                     __ATOMIC_RELAXED);
+
+    SymTable_writeEnd(oSymTable);
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable,
+                       const char *pcKey, const void *pvValue)
+{
+    struct Binding *psBinding;
+    uint64_t *puLink;
+    void *pvOld = NULL;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SymTable_writeBegin(oSymTable);
+    puLink = SymTable_findLink(oSymTable, pcKey, SymTable_hash(pcKey));
+
+    /* Handle condition where binding with pcKey exists */
+    if (*puLink != 0)
+    {
+        psBinding = SymTable_at(oSymTable, *puLink);
+        pvOld = (void *)(uintptr_t)psBinding->value;
+        __atomic_store_n(&psBinding->value, (uint64_t)(uintptr_t)pvValue,
+                         __ATOMIC_RELAXED);
+    }
+
+    SymTable_writeEnd(oSymTable);
+    return pvOld;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_lookup(oSymTable, pcKey, &pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    void *pvValue = NULL;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    (void)SymTable_lookup(oSymTable, pcKey, &pvValue);
+    return pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    struct Region *psRegion;
+    struct Binding *psBinding;
+    uint64_t *puLink;
+    uint64_t uOffset, uLink;
+    void *pvOld = NULL;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psRegion = oSymTable->region;
+    SymTable_writeBegin(oSymTable);
+    puLink = SymTable_findLink(oSymTable, pcKey, SymTable_hash(pcKey));
+
+    /* Handle condition where binding with pcKey exists: unlink it and
+    return its chunk to the allocator */
+    uOffset = *puLink;
+    if (uOffset != 0)
+    {
+        psBinding = SymTable_at(oSymTable, uOffset);
+        pvOld = (void *)(uintptr_t)psBinding->value;
+        uLink = SymTable_buckets(oSymTable)->link;
+        __atomic_store_n(puLink, psBinding->next[uLink], __ATOMIC_RELAXED);
+        SymTable_release(oSymTable, uOffset);
+        __atomic_store_n(&psRegion->bindingsCount,
+                         psRegion->bindingsCount - 1, __ATOMIC_RELAXED);
+    }
+
+    SymTable_writeEnd(oSymTable);
+    return pvOld;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue,
+                                  void *pvExtra),
+                  const void *pvExtra)
+{
+    struct Region *psRegion;
+    struct Buckets *psBuckets;
+    struct Binding *psBinding;
+    uint64_t u, uOffset;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /* Hold the writer lock so that no binding changes underneath */
+    psRegion = oSymTable->region;
+    SymTable_lock(oSymTable);
+
+    psBuckets = SymTable_buckets(oSymTable);
+    for (u = 0; u < psBuckets->count; u++)
+        for (uOffset = psBuckets->heads[u]; uOffset != 0;
+             uOffset = psBinding->next[psBuckets->link])
+        {
+            psBinding = SymTable_at(oSymTable, uOffset);
+            (*pfApply)(psBinding->key, (void *)(uintptr_t)psBinding->value,
+                       (void *)pvExtra);
+        }
+
+    (void)pthread_mutex_unlock(&psRegion->writeLock);
+}
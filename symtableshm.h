@@ -0,0 +1,65 @@
+/*--------------------------------------------------------------------*/
+/* symtableshm.h                                                      */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+# ifndef SYMTABLESHM
+# define SYMTABLESHM
+
+#include "symtable.h"
+
+/*
+A shared SymTable keeps its buckets, bindings and keys in one region
+of memory mapped with MAP_SHARED, linked by offsets within the region
+rather than by pointers, so that every process that maps the region
+uses the same table without copying it, wherever the region is mapped.
+A process that forks after creating the table, or that attaches to a
+region kept in a file, sees every update made by any other process.
+
+SymTable_get, SymTable_contains and SymTable_getLength take no lock:
+they retry until a lookup runs without overlapping an update, which is
+detected by a sequence number in the region. SymTable_put,
+SymTable_replace, SymTable_remove and SymTable_map serialize on a
+process-shared mutex in the region, so *pfApply must not update the
+table. If a process dies holding the mutex, the next process to take
+it recovers it; an update the dead process left unfinished may be
+lost, but every other binding stays, and the table stays usable.
+Values are stored as given, so they must mean the same thing in every
+process that reads them: pointers to memory allocated before a fork,
+for example, or integers cast to pointers. SymTable_free unmaps the
+region from the calling process only; other processes keep using it,
+and a region kept in a file stays there.
+*/
+
+/*--------------------------------------------------------------------*/
+/* Return a new SymTable object that contains no bindings and keeps
+them in a shared region of uRegionBytes bytes, or NULL if the region
+cannot be created. The region is kept in the file named pcPath, which
+must not exist yet, so that a region still in use by other processes
+is never cut short under them, or is anonymous and shared only with
+child processes if pcPath is NULL. Bindings that would not fit in the
+region cannot be added.
+
+SymTable_new is equivalent to SymTable_newShared(NULL,
+SYMTABLESHM_DEFAULT_REGION_BYTES) */
+
+SymTable_T SymTable_newShared(const char *pcPath, size_t uRegionBytes);
+
+/*--------------------------------------------------------------------*/
+/* Return a SymTable object for the shared region kept in the file
+named pcPath by SymTable_newShared, or NULL if the file cannot be
+mapped or does not hold a shared region */
+
+SymTable_T SymTable_attachShared(const char *pcPath);
+
+/*--------------------------------------------------------------------*/
+/* Return the number of bytes of the region of oSymTable in use */
+
+size_t SymTable_getRegionBytesUsed(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+/* Number of bytes of the region of a table made by SymTable_new. The
+region is reserved, not allocated, so unused bytes cost nothing */
+enum {SYMTABLESHM_DEFAULT_REGION_BYTES = 1024 * 1024 * 1024};
+
+# endif
@@ -0,0 +1,480 @@
+/*--------------------------------------------------------------------*/
+/* symtablesoa.c                                                      */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+/* Open-addressing implementation of symbol table that maps string
+keys to void* values, stored as a structure of arrays. Each key is
+stored with defensive copy to ensure ownership by symbol table: a key
+shorter than KEY_BYTES bytes is copied into its slot itself, zero
+padded, and compared as two machine words, while a longer key is
+copied to its own allocation. Collisions handled via linear probing.
+Slot i of the table is split across three parallel arrays: a 32-bit
+tag taken from the key's hash code, the key, and the value. A probe
+walks the dense tag array alone, sixteen slots to a cache line, and
+loads a key only when its tag matches and a value only once its key
+does, so a lookup that misses usually touches nothing but tag memory.
+Removal shifts the following bindings back instead of leaving
+tombstones */
+
+#include "symtable.h"
+#include "symtablehashcode.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Initial number of slots. Must be a power of two so that a tag can
+be reduced to a slot index with a mask */
+static const size_t INITIAL_SLOT_COUNT = 512;
+
+/* Greatest number of slots. Slot indices are taken from 32-bit tags */
+static const size_t MAX_SLOT_COUNT = (size_t)1 << 31;
+
+/* The slot arrays are doubled when adding one more binding would make
+the load factor exceed MAX_LOAD_NUMER / MAX_LOAD_DENOM */
+static const size_t MAX_LOAD_NUMER = 3;
+static const size_t MAX_LOAD_DENOM = 4;
+
+/* Tag of an empty slot */
+static const uint32_t EMPTY = 0;
+
+/* Number of bytes of a key held in a slot. A key whose length is less
+than KEY_BYTES is stored inline */
+enum {KEY_BYTES = 16};
+
+/* Value of the last byte of a Key that holds a pointer to a long key.
+The last byte of an inline key is always its padding, '\0' */
+static const char LONG_KEY = (char)0xFF;
+
+/* A Key holds either a short key inline, zero padded, or a pointer to
+a long key (defensive copy) in its first bytes and LONG_KEY in its
+last byte */
+union Key
+{
+    /* The inline key string */
+    char bytes[KEY_BYTES];
+    /* The same bytes as machine words, for comparing inline keys */
+    uint64_t words[KEY_BYTES / 8];
+    /* Pointer to the long key string */
+    char *pointer;
+};
+
+/* SymTable structure represents overall hash table */
+struct SymTable
+{
+    /* Array of tags, EMPTY where the slot is empty */
+    uint32_t *tags;
+    /* Array of keys */
+    union Key *keys;
+    /* Array of pointers to the associated values */
+    const void **values;
+    /* Number of slots in each array (a power of two) */
+    size_t slotCount;
+    /* Stores total number of bindings in SymTable */
+    size_t bindingsCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return the tag for pcKey: the low 32 bits of its full hash code,
+never EMPTY, and store the length of pcKey in *puLength */
+
+static uint32_t SymTable_tag(const char *pcKey, size_t *puLength)
+{
+    uint64_t uHash;
+
+    uHash = SymTableHashCode_mix(
+        SymTableHashCode_string(pcKey, puLength));
+    if ((uint32_t)uHash == EMPTY)
+        return 1;
+    return (uint32_t)uHash;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store in *puKey the Key for pcKey, whose length is uLength. If
+pcKey is long, *puKey points to pcKey itself. Every byte of *puKey is
+set, since an inline key is compared word by word with keys of either
+kind */
+
+static void SymTable_makeKey(union Key *puKey, const char *pcKey,
+                             size_t uLength)
+{
+    memset(puKey, 0, sizeof(union Key));
+    if (uLength < KEY_BYTES)
+        memcpy(puKey->bytes, pcKey, uLength);
+    else
+    {
+        puKey->pointer = (char *)pcKey;
+        puKey->bytes[KEY_BYTES - 1] = LONG_KEY;
+    }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if *puKey is a long key */
+
+static int SymTable_isLong(const union Key *puKey)
+{
+    return puKey->bytes[KEY_BYTES - 1] == LONG_KEY;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the key string held in *puKey */
+
+static const char *SymTable_keyString(const union Key *puKey)
+{
+    if (SymTable_isLong(puKey))
+        return puKey->pointer;
+    return puKey->bytes;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the index of the slot of oSymTable holding the binding whose
+key is *puKey and whose tag is uTag, or slotCount if no such binding
+exists */
+
+static size_t SymTable_findSlot(SymTable_T oSymTable,
+                                const union Key *puKey, uint32_t uTag)
+{
+    const uint32_t *tags = oSymTable->tags;
+    const union Key *keys = oSymTable->keys;
+    size_t mask = oSymTable->slotCount - 1;
+    size_t i = uTag & mask;
+
+    /* Walk the tags until reaching an empty slot, looking at a key
+    only when its tag matches. Inline keys are equal exactly when
+    their words are; an inline key never equals a long one */
+    if (!SymTable_isLong(puKey))
+    {
+        while (tags[i] != EMPTY)
+        {
+            if (tags[i] == uTag &&
+                keys[i].words[0] == puKey->words[0] &&
+                keys[i].words[1] == puKey->words[1])
+                return i;
+            i = (i + 1) & mask;
+        }
+    }
+    else
+    {
+        while (tags[i] != EMPTY)
+        {
+            if (tags[i] == uTag && SymTable_isLong(&keys[i]) &&
+                strcmp(keys[i].pointer, puKey->pointer) == 0)
+                return i;
+            i = (i + 1) & mask;
+        }
+    }
+    return oSymTable->slotCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the index of the slot of oSymTable holding the binding whose
+key is pcKey, or slotCount if no such binding exists */
+
+static size_t SymTable_lookup(SymTable_T oSymTable, const char *pcKey)
+{
+    union Key uKey;
+    uint32_t uTag;
+    size_t uLength;
+
+    uTag = SymTable_tag(pcKey, &uLength);
+    SymTable_makeKey(&uKey, pcKey, uLength);
+    return SymTable_findSlot(oSymTable, &uKey, uTag);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Double the slot arrays of oSymTable and reinsert every binding.
+Return 1 (TRUE) if successful, or 0 (FALSE) if the table is at its
+maximum size or insufficient memory is available, in which case
+oSymTable is left unchanged */
+
+static int SymTable_tryExpand(SymTable_T oSymTable)
+{
+    uint32_t *newTags;
+    union Key *newKeys;
+    const void **newValues;
+    size_t newSlotCount, mask;
+    size_t i, j;
+
+    /* Handle case where symbol table is already at its maximum size */
+    if (oSymTable->slotCount >= MAX_SLOT_COUNT)
+        return 0;
+    newSlotCount = oSymTable->slotCount * 2;
+    mask = newSlotCount - 1;
+
+    /* Allocate memory for new slot arrays */
+    newTags = calloc(newSlotCount, sizeof(uint32_t));
+    newKeys = malloc(newSlotCount * sizeof(union Key));
+    newValues = malloc(newSlotCount * sizeof(const void *));
+    if (newTags == NULL || newKeys == NULL || newValues == NULL)
+    {
+        free(newTags);
+        free(newKeys);
+        free(newValues);
+        return 0;
+    }
+
+    /* Reinsert all existing bindings into new slot arrays */
+    for (i = 0; i < oSymTable->slotCount; i++)
+    {
+        if (oSymTable->tags[i] == EMPTY)
+            continue;
+        j = oSymTable->tags[i] & mask;
+        while (newTags[j] != EMPTY)
+            j = (j + 1) & mask;
+        newTags[j] = oSymTable->tags[i];
+        newKeys[j] = oSymTable->keys[i];
+        newValues[j] = oSymTable->values[i];
+    }
+
+    /* Swaps in the new slot arrays and records new size */
+    free(oSymTable->tags);
+    free(oSymTable->keys);
+    free(oSymTable->values);
+    oSymTable->tags = newTags;
+    oSymTable->keys = newKeys;
+    oSymTable->values = newValues;
+    oSymTable->slotCount = newSlotCount;
+
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void)
+{
+    SymTable_T oSymTable;
+
+    /* Allocate memory for a new symbol table */
+    oSymTable = malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+        return NULL;
+
+    /* Initialize fields for new symbol table */
+    oSymTable->slotCount = INITIAL_SLOT_COUNT;
+    oSymTable->bindingsCount = 0;
+    oSymTable->tags = calloc(INITIAL_SLOT_COUNT, sizeof(uint32_t));
+    oSymTable->keys = malloc(INITIAL_SLOT_COUNT * sizeof(union Key));
+    oSymTable->values = malloc(INITIAL_SLOT_COUNT *
+                               sizeof(const void *));
+
+    /* Handle case where allocation of any slot array fails */
+    if (oSymTable->tags == NULL || oSymTable->keys == NULL ||
+        oSymTable->values == NULL)
+    {
+        free(oSymTable->tags);
+        free(oSymTable->keys);
+        free(oSymTable->values);
+        free(oSymTable);
+        return NULL;
+    }
+
+    return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    /* Free the key copy of every occupied slot with a long key */
+    for (i = 0; i < oSymTable->slotCount; i++)
+    {
+        if (oSymTable->tags[i] != EMPTY &&
+            SymTable_isLong(&oSymTable->keys[i]))
+            free(oSymTable->keys[i].pointer);
+    }
+
+    free(oSymTable->tags);
+    free(oSymTable->keys);
+    free(oSymTable->values);
+    free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTable_getLength(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    return oSymTable->bindingsCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_put(SymTable_T oSymTable,
+                 const char *pcKey, const void *pvValue)
+{
+    union Key uKey;
+    uint32_t uTag;
+    size_t uLength, mask, i;
+    char *keyCopy;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* Handle condition where binding with pcKey already exists */
+    uTag = SymTable_tag(pcKey, &uLength);
+    SymTable_makeKey(&uKey, pcKey, uLength);
+    if (SymTable_findSlot(oSymTable, &uKey, uTag) !=
+        oSymTable->slotCount)
+        return 0;
+
+    /* Expand the table if adding one more binding would exceed the
+    maximum load factor; fail if it is full and cannot expand */
+    if ((oSymTable->bindingsCount + 1) * MAX_LOAD_DENOM >
+        oSymTable->slotCount * MAX_LOAD_NUMER)
+    {
+        if (!SymTable_tryExpand(oSymTable) &&
+            oSymTable->bindingsCount + 1 >= oSymTable->slotCount)
+            return 0;
+    }
+
+    /* Copy a long key string defensively; a short one is already
+    copied into uKey */
+    if (SymTable_isLong(&uKey))
+    {
+        keyCopy = malloc(uLength + 1);
+        if (keyCopy == NULL)
+            return 0;
+        strcpy(keyCopy, pcKey);
+        uKey.pointer = keyCopy;
+    }
+
+    /* Place the binding in the first empty slot of its probe run */
+    mask = oSymTable->slotCount - 1;
+    i = uTag & mask;
+    while (oSymTable->tags[i] != EMPTY)
+        i = (i + 1) & mask;
+    oSymTable->tags[i] = uTag;
+    oSymTable->keys[i] = uKey;
+    oSymTable->values[i] = pvValue;
+
+    oSymTable->bindingsCount++;
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_replace(SymTable_T oSymTable,
+                       const char *pcKey, const void *pvValue)
+{
+    void *oldValue;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    i = SymTable_lookup(oSymTable, pcKey);
+
+    /* Handle condition where no binding with pcKey exists */
+    if (i == oSymTable->slotCount)
+        return NULL;
+
+    oldValue = (void *)oSymTable->values[i];
+    oSymTable->values[i] = pvValue;
+    return oldValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_lookup(oSymTable, pcKey) != oSymTable->slotCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    i = SymTable_lookup(oSymTable, pcKey);
+
+    /* Handle condition where no binding with pcKey exists */
+    if (i == oSymTable->slotCount)
+        return NULL;
+
+    return (void *)oSymTable->values[i];
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t i, next, home, mask;
+    void *bindingValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    i = SymTable_lookup(oSymTable, pcKey);
+
+    /* Handle condition where no binding with pcKey exists */
+    if (i == oSymTable->slotCount)
+        return NULL;
+
+    bindingValue = (void *)oSymTable->values[i];
+    if (SymTable_isLong(&oSymTable->keys[i]))
+        free(oSymTable->keys[i].pointer);
+
+    /* Walk the rest of the probe run, moving back into the hole at i
+    each binding whose home slot does not lie cyclically after the
+    hole, so that no binding ends up before its home slot */
+    mask = oSymTable->slotCount - 1;
+    next = (i + 1) & mask;
+    while (oSymTable->tags[next] != EMPTY)
+    {
+        home = oSymTable->tags[next] & mask;
+        if (((next - home) & mask) >= ((next - i) & mask))
+        {
+            oSymTable->tags[i] = oSymTable->tags[next];
+            oSymTable->keys[i] = oSymTable->keys[next];
+            oSymTable->values[i] = oSymTable->values[next];
+            i = next;
+        }
+        next = (next + 1) & mask;
+    }
+
+    /* The last slot vacated by the shift becomes empty */
+    oSymTable->tags[i] = EMPTY;
+
+    oSymTable->bindingsCount--;
+    return bindingValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey, void *pvValue,
+                                  void *pvExtra),
+                  const void *pvExtra)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /* Iterate over all occupied slots */
+    for (i = 0; i < oSymTable->slotCount; i++)
+    {
+        if (oSymTable->tags[i] != EMPTY)
+            (*pfApply)(SymTable_keyString(&oSymTable->keys[i]),
+                       (void *)oSymTable->values[i], (void *)pvExtra);
+    }
+}
@@ -0,0 +1,355 @@
+/*--------------------------------------------------------------------*/
+/* symtablestatic.c                                                   */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+/* Read-only symbol table in Eytzinger layout. The bindings are sorted
+by key and placed in the nodes of a complete binary search tree that
+is stored breadth first: node k, counting from 1, has children 2k and
+2k+1. Each node is split across three arrays: a prefix holding the
+first PREFIX_BYTES bytes of the key in two 64-bit words, most
+significant byte first and zero padded, so that comparing prefixes as
+pairs of integers orders keys as strcmp does; the key itself; and the
+value. Only keys that agree in all of their prefix bytes need the key
+array. A lookup descends the tree by computing the next node from the
+comparison instead of branching on it, and since the four descendants
+two levels below a node share a cache line of the prefix array, it
+prefetches them while it works on the level in between. The descent
+always runs to the bottom of the tree, and the last node at which it
+went left then holds the least key not less than the one looked up */
+
+#define _XOPEN_SOURCE 700
+
+#include "symtablestatic.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Number of leading key bytes held in a prefix */
+enum {PREFIX_BYTES = 16};
+
+/* Number of bytes of a cache line, to which the prefixes are
+aligned */
+enum {CACHE_LINE = 64};
+
+/* Number of levels below a node whose prefixes are prefetched */
+enum {PREFETCH_LEVELS = 2};
+
+/* A Prefix holds the leading bytes of a key */
+struct Prefix
+{
+    /* Bytes 0 to 7, the first in the most significant byte */
+    uint64_t high;
+    /* Bytes 8 to 15, likewise */
+    uint64_t low;
+};
+
+/* Each Pair is a binding of the symbol table being copied */
+struct Pair
+{
+    /* Pointer to the key string, owned by the symbol table */
+    const char *key;
+    /* Pointer to the associated value */
+    const void *value;
+};
+
+/* A Collector gathers the bindings of a symbol table into an array */
+struct Collector
+{
+    /* Array of pairs */
+    struct Pair *pairs;
+    /* Number of pairs gathered so far */
+    size_t count;
+    /* Total number of bytes of the keys, counting their '\0' */
+    size_t keyBytes;
+};
+
+/* SymTableStatic structure represents a static table. Each array has
+a node 0 that is not used, so that node k is at index k */
+struct SymTableStatic
+{
+    /* Prefix of the key of each node, aligned to a cache line */
+    struct Prefix *prefixes;
+    /* Key of each node, pointing into keyArena */
+    const char **keys;
+    /* Value of each node */
+    const void **values;
+    /* Copies of every key, one after another */
+    char *keyArena;
+    /* Stores total number of bindings in SymTableStatic */
+    size_t bindingsCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Add the binding of pcKey to pvValue to pvCollector, a Collector */
+
+static void SymTableStatic_collect(const char *pcKey, void *pvValue,
+                                   void *pvCollector)
+{
+    struct Collector *psCollector = pvCollector;
+
+    psCollector->pairs[psCollector->count].key = pcKey;
+    psCollector->pairs[psCollector->count].value = pvValue;
+    psCollector->count++;
+    psCollector->keyBytes += strlen(pcKey) + 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the keys of the Pairs at pvFirst and pvSecond for qsort */
+
+static int SymTableStatic_comparePairs(const void *pvFirst,
+                                       const void *pvSecond)
+{
+    return strcmp(((const struct Pair *)pvFirst)->key,
+                  ((const struct Pair *)pvSecond)->key);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the prefix of pcKey */
+
+static struct Prefix SymTableStatic_prefix(const char *pcKey)
+{
+    struct Prefix sPrefix = {0, 0};
+    uint64_t uByte;
+    size_t u;
+
+    for (u = 0; u < PREFIX_BYTES && pcKey[u] != '\0'; u++)
+    {
+        uByte = (unsigned char)pcKey[u];
+        if (u < PREFIX_BYTES / 2)
+            sPrefix.high |= uByte << (8 * (PREFIX_BYTES / 2 - 1 - u));
+        else
+            sPrefix.low |= uByte << (8 * (PREFIX_BYTES - 1 - u));
+    }
+    return sPrefix;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the key of node k of oStatic with pcKey, whose prefix is
+sPrefix. Return a negative number, zero or a positive number as the
+node's key is less than, equal to or greater than pcKey */
+
+static int SymTableStatic_compare(SymTableStatic_T oStatic, size_t k,
+                                  const char *pcKey,
+                                  struct Prefix sPrefix)
+{
+    struct Prefix sNodePrefix = oStatic->prefixes[k];
+
+    if (sNodePrefix.high != sPrefix.high)
+        return sNodePrefix.high < sPrefix.high ? -1 : 1;
+    if (sNodePrefix.low != sPrefix.low)
+        return sNodePrefix.low < sPrefix.low ? -1 : 1;
+
+    /* Equal prefixes whose last byte is zero are whole equal keys.
+    Otherwise both keys are longer than the prefix */
+    if ((sPrefix.low & 0xFF) == 0)
+        return 0;
+    return strcmp(oStatic->keys[k] + PREFIX_BYTES,
+                  pcKey + PREFIX_BYTES);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Place the pairs from apsPairs[uNext] onward into the subtree of
+oStatic rooted at node k, in order. Return the index of the first
+pair not placed */
+
+static size_t SymTableStatic_fill(SymTableStatic_T oStatic,
+                                  const struct Pair *apsPairs,
+                                  size_t uNext, size_t k)
+{
+    if (k > oStatic->bindingsCount)
+        return uNext;
+
+    uNext = SymTableStatic_fill(oStatic, apsPairs, uNext, 2 * k);
+    oStatic->keys[k] = apsPairs[uNext].key;
+    oStatic->values[k] = apsPairs[uNext].value;
+    oStatic->prefixes[k] = SymTableStatic_prefix(apsPairs[uNext].key);
+    uNext++;
+    return SymTableStatic_fill(oStatic, apsPairs, uNext, 2 * k + 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the node of oStatic whose key is pcKey, or 0 if no such
+binding exists */
+
+static size_t SymTableStatic_find(SymTableStatic_T oStatic,
+                                  const char *pcKey)
+{
+    const size_t n = oStatic->bindingsCount;
+    const size_t ahead = (size_t)1 << PREFETCH_LEVELS;
+    struct Prefix sPrefix;
+    size_t k = 1;
+
+    sPrefix = SymTableStatic_prefix(pcKey);
+
+    /* Descend to the bottom, going right wherever the node's key is
+    less than pcKey */
+    while (k <= n)
+    {
+        __builtin_prefetch(oStatic->prefixes +
+                           (k * ahead <= n ? k * ahead : 0));
+        k = 2 * k +
+            (SymTableStatic_compare(oStatic, k, pcKey, sPrefix) < 0);
+    }
+
+    /* Climb back past the trailing right turns and one left turn, to
+    the last node at which the descent went left */
+    while (k & 1)
+        k >>= 1;
+    k >>= 1;
+
+    if (k == 0 || SymTableStatic_compare(oStatic, k, pcKey,
+                                         sPrefix) != 0)
+        return 0;
+    return k;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Apply *pfApply to every node of the subtree of oStatic rooted at
+node k, in order, passing pvExtra */
+
+static void SymTableStatic_walk(SymTableStatic_T oStatic, size_t k,
+                                void (*pfApply)(const char *pcKey,
+                                                void *pvValue,
+                                                void *pvExtra),
+                                const void *pvExtra)
+{
+    if (k > oStatic->bindingsCount)
+        return;
+
+    SymTableStatic_walk(oStatic, 2 * k, pfApply, pvExtra);
+    (*pfApply)(oStatic->keys[k], (void *)oStatic->values[k],
+               (void *)pvExtra);
+    SymTableStatic_walk(oStatic, 2 * k + 1, pfApply, pvExtra);
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTableStatic_T SymTable_buildStatic(SymTable_T oSymTable)
+{
+    SymTableStatic_T oStatic;
+    struct Collector sCollector;
+    void *pvPrefixes;
+    char *pcArena;
+    size_t uLength, n, i;
+
+    assert(oSymTable != NULL);
+
+    /* Gather the bindings and sort them by key */
+    sCollector.count = 0;
+    sCollector.keyBytes = 0;
+    sCollector.pairs = malloc((SymTable_getLength(oSymTable) + 1) *
+                              sizeof(struct Pair));
+    if (sCollector.pairs == NULL)
+        return NULL;
+    SymTable_map(oSymTable, SymTableStatic_collect, &sCollector);
+    qsort(sCollector.pairs, sCollector.count, sizeof(struct Pair),
+          SymTableStatic_comparePairs);
+    n = sCollector.count;
+
+    /* Allocate memory for the static table */
+    oStatic = calloc(1, sizeof(struct SymTableStatic));
+    if (oStatic == NULL)
+    {
+        free(sCollector.pairs);
+        return NULL;
+    }
+    oStatic->bindingsCount = n;
+    if (posix_memalign(&pvPrefixes, CACHE_LINE,
+                       (n + 1) * sizeof(struct Prefix)) == 0)
+        oStatic->prefixes = pvPrefixes;
+    oStatic->keys = malloc((n + 1) * sizeof(const char *));
+    oStatic->values = malloc((n + 1) * sizeof(const void *));
+    oStatic->keyArena = malloc(sCollector.keyBytes + 1);
+    if (oStatic->prefixes == NULL || oStatic->keys == NULL ||
+        oStatic->values == NULL || oStatic->keyArena == NULL)
+    {
+        free(sCollector.pairs);
+        SymTableStatic_free(oStatic);
+        return NULL;
+    }
+
+    /* Copy the keys into the arena, in order */
+    pcArena = oStatic->keyArena;
+    for (i = 0; i < n; i++)
+    {
+        uLength = strlen(sCollector.pairs[i].key) + 1;
+        memcpy(pcArena, sCollector.pairs[i].key, uLength);
+        sCollector.pairs[i].key = pcArena;
+        pcArena += uLength;
+    }
+
+    /* Place the bindings in the nodes of the tree */
+    (void)SymTableStatic_fill(oStatic, sCollector.pairs, 0, 1);
+
+    free(sCollector.pairs);
+    return oStatic;
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTableStatic_free(SymTableStatic_T oStatic)
+{
+    assert(oStatic != NULL);
+
+    free(oStatic->prefixes);
+    free(oStatic->keys);
+    free(oStatic->values);
+    free(oStatic->keyArena);
+    free(oStatic);
+}
+
+/*--------------------------------------------------------------------*/
+
+size_t SymTableStatic_getLength(SymTableStatic_T oStatic)
+{
+    assert(oStatic != NULL);
+    return oStatic->bindingsCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+int SymTableStatic_contains(SymTableStatic_T oStatic,
+                            const char *pcKey)
+{
+    assert(oStatic != NULL);
+    assert(pcKey != NULL);
+
+    return SymTableStatic_find(oStatic, pcKey) != 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+void *SymTableStatic_get(SymTableStatic_T oStatic, const char *pcKey)
+{
+    size_t k;
+
+    assert(oStatic != NULL);
+    assert(pcKey != NULL);
+
+    k = SymTableStatic_find(oStatic, pcKey);
+    if (k == 0)
+        return NULL;
+    return (void *)oStatic->values[k];
+}
+
+/*--------------------------------------------------------------------*/
+
+void SymTableStatic_map(SymTableStatic_T oStatic,
+                        void (*pfApply)(const char *pcKey,
+                                        void *pvValue, void *pvExtra),
+                        const void *pvExtra)
+{
+    assert(oStatic != NULL);
+    assert(pfApply != NULL);
+
+    SymTableStatic_walk(oStatic, 1, pfApply, pvExtra);
+}
@@ -0,0 +1,63 @@
+/*--------------------------------------------------------------------*/
+/* symtablestatic.h                                                   */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+# ifndef SYMTABLESTATIC
+# define SYMTABLESTATIC
+
+#include "symtable.h"
+
+/*
+A SymTableStatic_T is a pointer to a read-only copy of the bindings of
+a symbol table, sorted by key and stored in the breadth-first order of
+a complete binary search tree (the Eytzinger layout), with the first
+sixteen bytes of each key kept in a dense array of their own. A lookup
+walks down the tree comparing mostly those prefixes, and because the
+nodes a walk can visit next are stored together, it fetches them ahead
+of time. Every lookup thus does the same number of steps, about log2
+of the number of bindings. Values are the void* values of the symbol
+table, still owned by the caller.
+*/
+typedef struct SymTableStatic *SymTableStatic_T;
+
+/*--------------------------------------------------------------------*/
+/* Return a new SymTableStatic object holding a copy of every binding
+of oSymTable as it is now, or NULL if insufficient memory is
+available. Later changes to oSymTable do not affect the copy */
+
+SymTableStatic_T SymTable_buildStatic(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+/* Free all memory occupied by oStatic */
+
+void SymTableStatic_free(SymTableStatic_T oStatic);
+
+/*--------------------------------------------------------------------*/
+/* Return the number of bindings in oStatic */
+
+size_t SymTableStatic_getLength(SymTableStatic_T oStatic);
+
+/*--------------------------------------------------------------------*/
+/* Return 1 (TRUE) if oStatic contains a binding whose key is pcKey,
+and 0 (FALSE) otherwise */
+
+int SymTableStatic_contains(SymTableStatic_T oStatic,
+                            const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* Return the value of the binding within oStatic whose key is pcKey,
+or NULL if no such binding exists */
+
+void *SymTableStatic_get(SymTableStatic_T oStatic, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+/* Apply function *pfApply to each binding in oStatic, in increasing
+order of key, passing pvExtra as an extra parameter */
+
+void SymTableStatic_map(SymTableStatic_T oStatic,
+                        void (*pfApply)(const char *pcKey,
+                                        void *pvValue, void *pvExtra),
+                        const void *pvExtra);
+
+# endif
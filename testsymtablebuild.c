@@ -0,0 +1,287 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablebuild.c                                                */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+#include "symtablehash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test building small tables, with and without duplicate keys, and
+   updating them afterward. */
+
+static void testBasics(void)
+{
+   const char *apcKeys[] = {"Ruth", "Gehrig", "Mantle", "Ruth", "",
+      "Gehrig", "Maris"};
+   const void *apvValues[] = {"RF", "1B", "CF", "LF", "P", "SS",
+      "RF"};
+   SymTable_T oSymTable;
+   SymTable_Handle sHandle;
+   size_t uThreadCount;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing small built tables.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* An empty input builds an empty table. */
+   oSymTable = SymTable_buildParallel(apcKeys, apvValues, 0, 4);
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   ASSURE(SymTable_put(oSymTable, "Ruth", "RF"));
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+   SymTable_free(oSymTable);
+
+   /* The first binding of each key is kept, whatever the number of
+      threads, including more threads than keys. */
+   for (uThreadCount = 0; uThreadCount <= 10; uThreadCount++)
+   {
+      oSymTable = SymTable_buildParallel(apcKeys, apvValues, 7,
+         uThreadCount);
+      ASSURE(oSymTable != NULL);
+      if (oSymTable == NULL)
+         return;
+      ASSURE(SymTable_getLength(oSymTable) == 5);
+      ASSURE(strcmp(SymTable_get(oSymTable, "Ruth"), "RF") == 0);
+      ASSURE(strcmp(SymTable_get(oSymTable, "Gehrig"), "1B") == 0);
+      ASSURE(strcmp(SymTable_get(oSymTable, "Mantle"), "CF") == 0);
+      ASSURE(strcmp(SymTable_get(oSymTable, ""), "P") == 0);
+      ASSURE(strcmp(SymTable_get(oSymTable, "Maris"), "RF") == 0);
+      ASSURE(! SymTable_contains(oSymTable, "Berra"));
+
+      /* The built table behaves as any other, handles included. */
+      ASSURE(SymTable_find(oSymTable, "Mantle", &sHandle));
+      ASSURE(strcmp(SymTable_getByHandle(oSymTable, sHandle), "CF")
+         == 0);
+      ASSURE(! SymTable_put(oSymTable, "Ruth", "C"));
+      ASSURE(SymTable_put(oSymTable, "Berra", "C"));
+      ASSURE(SymTable_put(oSymTable, "Ford", "P"));
+      ASSURE(SymTable_put(oSymTable, "Jeter", "SS"));
+      ASSURE(strcmp(SymTable_remove(oSymTable, "Gehrig"), "1B") == 0);
+      ASSURE(SymTable_isValidHandle(oSymTable, sHandle));
+      ASSURE(strcmp(SymTable_removeByHandle(oSymTable, sHandle), "CF")
+         == 0);
+      ASSURE(! SymTable_contains(oSymTable, "Mantle"));
+      ASSURE(SymTable_getLength(oSymTable) == 6);
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test building a table of iBindingCount bindings, in which every
+   tenth key repeats an earlier one, on several numbers of threads. */
+
+static void testLargeTable(int iBindingCount)
+{
+   const char **ppcKeys;
+   const void **ppvValues;
+   char *pcKeys;
+   SymTable_T oSymTable;
+   SymTable_Handle sHandle;
+   size_t uThreadCount;
+   int iAllFound;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing large built tables.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   ppcKeys = malloc(((size_t)iBindingCount + 1) * sizeof(char *));
+   ppvValues = malloc(((size_t)iBindingCount + 1) * sizeof(void *));
+   pcKeys = malloc(((size_t)iBindingCount + 1) * 16);
+   ASSURE(ppcKeys != NULL && ppvValues != NULL && pcKeys != NULL);
+   if (ppcKeys == NULL || ppvValues == NULL || pcKeys == NULL)
+      return;
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(pcKeys + 16 * i, "%d", i % 10 == 9 ? i - 5 : i);
+      ppcKeys[i] = pcKeys + 16 * i;
+      ppvValues[i] = (void *)(size_t)(i + 1);
+   }
+
+   for (uThreadCount = 1; uThreadCount <= 16; uThreadCount *= 2)
+   {
+      oSymTable = SymTable_buildParallel(ppcKeys, ppvValues,
+         (size_t)iBindingCount, uThreadCount);
+      ASSURE(oSymTable != NULL);
+      if (oSymTable == NULL)
+         return;
+      ASSURE(SymTable_getLength(oSymTable) ==
+         (size_t)(iBindingCount - iBindingCount / 10));
+
+      /* Each key maps to the value of its first occurrence. */
+      iAllFound = 1;
+      for (i = 0; i < iBindingCount; i++)
+      {
+         if (i % 10 == 9)
+            continue;
+         if (SymTable_get(oSymTable, ppcKeys[i]) !=
+             (void *)(size_t)(i + 1))
+            iAllFound = 0;
+      }
+      ASSURE(iAllFound);
+
+      /* Removing and adding bindings reuses the slots left by the
+         duplicates and by the removals. */
+      for (i = 0; i < iBindingCount; i += 3)
+         if (i % 10 != 9)
+            ASSURE(SymTable_remove(oSymTable, ppcKeys[i]) ==
+               (void *)(size_t)(i + 1));
+      for (i = 0; i < iBindingCount; i += 3)
+         if (i % 10 != 9)
+            ASSURE(SymTable_put(oSymTable, ppcKeys[i], ppcKeys[i]));
+      ASSURE(SymTable_getLength(oSymTable) ==
+         (size_t)(iBindingCount - iBindingCount / 10));
+      if (iBindingCount > 0)
+      {
+         ASSURE(SymTable_find(oSymTable, ppcKeys[0], &sHandle));
+         ASSURE(SymTable_getByHandle(oSymTable, sHandle) ==
+            ppcKeys[0]);
+      }
+      SymTable_free(oSymTable);
+   }
+
+   free(ppcKeys);
+   free(ppvValues);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test growing a table through several parallel rehashes. */
+
+static void testParallelRehash(void)
+{
+   enum {BINDING_COUNT = 300000};
+   SymTable_T oSymTable;
+   char acKey[16];
+   int iAllFound = 1;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing parallel rehashes.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   SymTable_setRehashThreads(oSymTable, 4);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, (void *)(size_t)(i + 1)));
+   }
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (SymTable_get(oSymTable, acKey) != (void *)(size_t)(i + 1))
+         iAllFound = 0;
+   }
+   ASSURE(iAllFound);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test freeing tables of iBindingCount bindings in the background,
+   including one whose keys come from a shared store, which is freed
+   at once so that the store can be freed right after. */
+
+static void testFreeAsync(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   SymTable_T oShared;
+   SymTableKeys_T oKeys;
+   char acKey[16];
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing freeing in the background.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   oKeys = SymTableKeys_new();
+   ASSURE(oSymTable != NULL && oKeys != NULL);
+   if (oSymTable == NULL || oKeys == NULL)
+      return;
+   oShared = SymTable_newWithKeys(oKeys);
+   ASSURE(oShared != NULL);
+   if (oShared == NULL)
+      return;
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, acKey));
+      ASSURE(SymTable_put(oShared, acKey, acKey));
+   }
+
+   SymTable_freeAsync(oSymTable);
+   SymTable_freeAsync(oShared);
+   ASSURE(SymTableKeys_getLength(oKeys) == 0);
+   SymTableKeys_free(oKeys);
+
+   /* An empty table is freed as well. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   SymTable_freeAsync(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_buildParallel, parallel rehashing and freeing in the
+   background. As with testsymtable, argv[1] is the
+   number of bindings for the large test. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      return 1;
+   }
+   iBindingCount = atoi(argv[1]);
+
+   testBasics();
+   testLargeTable(iBindingCount);
+   testParallelRehash();
+   testFreeAsync(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
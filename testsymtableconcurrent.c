@@ -0,0 +1,191 @@
+/*--------------------------------------------------------------------*/
+/* testsymtableconcurrent.c                                           */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+#define _XOPEN_SOURCE 700
+
+#include "symtablehopscotch.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* Number of reader threads */
+enum {READER_COUNT = 4};
+
+/* Number of times the writer adds, replaces and removes every
+   changing binding */
+enum {ROUND_COUNT = 4};
+
+/* A Shared holds the state shared by the writer and the readers */
+struct Shared
+{
+   /* The table under test */
+   SymTable_T table;
+   /* Number of keys of each kind */
+   int keyCount;
+   /* 1 (TRUE) once the writer is done */
+   int done;
+   /* Number of wrong values seen by the readers */
+   int errors;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look up every key of the Shared at pvShared until the writer is
+   done, counting wrong values. A steady key "sI" is always bound to
+   I + 1, and a changing key "cI" is unbound or bound to I + 1 or to
+   I + 1 + the key count. Return NULL. */
+
+static void *readKeys(void *pvShared)
+{
+   struct Shared *psShared = pvShared;
+   char acKey[32];
+   size_t uValue;
+   int i;
+
+   while (! __atomic_load_n(&psShared->done, __ATOMIC_ACQUIRE))
+   {
+      for (i = 0; i < psShared->keyCount; i++)
+      {
+         sprintf(acKey, "s%d", i);
+         if (SymTable_get(psShared->table, acKey) !=
+             (void *)(size_t)(i + 1))
+            __atomic_add_fetch(&psShared->errors, 1, __ATOMIC_RELAXED);
+
+         sprintf(acKey, "c%d", i);
+         uValue = (size_t)SymTable_get(psShared->table, acKey);
+         if (uValue != 0 && uValue != (size_t)(i + 1) &&
+             uValue != (size_t)(i + 1 + psShared->keyCount))
+            __atomic_add_fetch(&psShared->errors, 1, __ATOMIC_RELAXED);
+      }
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a table made by SymTable_newConcurrent with iKeyCount steady
+   keys, read by several threads while the main thread adds, replaces
+   and removes iKeyCount other keys, growing the table and retiring
+   many keys and slot arrays. */
+
+static void testReadersAndWriter(int iKeyCount)
+{
+   struct Shared sShared;
+   pthread_t aThreads[READER_COUNT];
+   int aiStarted[READER_COUNT];
+   char acKey[32];
+   int iRound;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing readers running alongside a writer.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   sShared.table = SymTable_newConcurrent();
+   ASSURE(sShared.table != NULL);
+   if (sShared.table == NULL)
+      return;
+   sShared.keyCount = iKeyCount;
+   sShared.done = 0;
+   sShared.errors = 0;
+   for (i = 0; i < iKeyCount; i++)
+   {
+      sprintf(acKey, "s%d", i);
+      ASSURE(SymTable_put(sShared.table, acKey,
+         (void *)(size_t)(i + 1)));
+   }
+
+   for (i = 0; i < READER_COUNT; i++)
+   {
+      aiStarted[i] = pthread_create(&aThreads[i], NULL, readKeys,
+         &sShared) == 0;
+      ASSURE(aiStarted[i]);
+   }
+
+   for (iRound = 0; iRound < ROUND_COUNT; iRound++)
+   {
+      for (i = 0; i < iKeyCount; i++)
+      {
+         sprintf(acKey, "c%d", i);
+         ASSURE(SymTable_put(sShared.table, acKey,
+            (void *)(size_t)(i + 1)));
+      }
+      for (i = 0; i < iKeyCount; i++)
+      {
+         sprintf(acKey, "c%d", i);
+         ASSURE(SymTable_replace(sShared.table, acKey,
+            (void *)(size_t)(i + 1 + iKeyCount)) ==
+            (void *)(size_t)(i + 1));
+      }
+      ASSURE(SymTable_getLength(sShared.table) ==
+         (size_t)(2 * iKeyCount));
+      for (i = 0; i < iKeyCount; i++)
+      {
+         sprintf(acKey, "c%d", i);
+         ASSURE(SymTable_remove(sShared.table, acKey) ==
+            (void *)(size_t)(i + 1 + iKeyCount));
+      }
+   }
+
+   __atomic_store_n(&sShared.done, 1, __ATOMIC_RELEASE);
+   for (i = 0; i < READER_COUNT; i++)
+      if (aiStarted[i])
+         (void)pthread_join(aThreads[i], NULL);
+
+   ASSURE(sShared.errors == 0);
+   ASSURE(SymTable_getLength(sShared.table) == (size_t)iKeyCount);
+   ASSURE(SymTable_get(sShared.table, "s0") ==
+      (iKeyCount > 0 ? (void *)1 : NULL));
+   ASSURE(! SymTable_contains(sShared.table, "c0"));
+   SymTable_free(sShared.table);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_newConcurrent with several threads. As with
+   testsymtable, argv[1] is the number of bindings for the large
+   test. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      return 1;
+   }
+   iBindingCount = atoi(argv[1]);
+
+   testReadersAndWriter(100);
+   testReadersAndWriter(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
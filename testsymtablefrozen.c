@@ -0,0 +1,234 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablefrozen.c                                               */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+#include "symtablefrozen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* A Walk records what SymTableFrozen_map has passed to checkOrder. */
+
+struct Walk
+{
+   /* The previous key, and whether there was one. */
+   char acPrevious[128];
+   int iStarted;
+   /* The number of bindings seen, and whether they were in order. */
+   size_t uCount;
+   int iInOrder;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Check that pcKey follows the previous key of pvWalk, a Walk, and
+   count it. pvValue is unused. */
+
+static void checkOrder(const char *pcKey, void *pvValue, void *pvWalk)
+{
+   struct Walk *psWalk = pvWalk;
+
+   (void)pvValue;
+   if (psWalk->iStarted && strcmp(psWalk->acPrevious, pcKey) >= 0)
+      psWalk->iInOrder = 0;
+   strncpy(psWalk->acPrevious, pcKey, sizeof(psWalk->acPrevious) - 1);
+   psWalk->acPrevious[sizeof(psWalk->acPrevious) - 1] = '\0';
+   psWalk->iStarted = 1;
+   psWalk->uCount++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test lookups of keys that are prefixes of one another, the empty
+   key, and keys with bytes above 127. */
+
+static void testBasics(void)
+{
+   SymTable_T oSymTable;
+   SymTableFrozen_T oFrozen;
+   struct Walk sWalk = {"", 0, 0, 1};
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a small frozen table.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+
+   /* An empty table freezes to an empty table. */
+   oFrozen = SymTableFrozen_new(oSymTable);
+   ASSURE(oFrozen != NULL);
+   if (oFrozen == NULL)
+      return;
+   ASSURE(SymTableFrozen_getLength(oFrozen) == 0);
+   ASSURE(! SymTableFrozen_contains(oFrozen, ""));
+   ASSURE(SymTableFrozen_get(oFrozen, "Ruth") == NULL);
+   SymTableFrozen_free(oFrozen);
+
+   ASSURE(SymTable_put(oSymTable, "Ruth", "RF"));
+   ASSURE(SymTable_put(oSymTable, "Ru", "1B"));
+   ASSURE(SymTable_put(oSymTable, "Ruthless", "CF"));
+   ASSURE(SymTable_put(oSymTable, "", "P"));
+   ASSURE(SymTable_put(oSymTable, "R\xc3\xbc", "C"));
+   ASSURE(SymTable_put(oSymTable, "Rut", "SS"));
+
+   oFrozen = SymTableFrozen_new(oSymTable);
+   ASSURE(oFrozen != NULL);
+   if (oFrozen == NULL)
+      return;
+
+   /* Later changes to the table do not affect the frozen copy. */
+   ASSURE(SymTable_remove(oSymTable, "Ruth") != NULL);
+   ASSURE(SymTable_put(oSymTable, "Mantle", "CF"));
+   SymTable_free(oSymTable);
+
+   ASSURE(SymTableFrozen_getLength(oFrozen) == 6);
+   ASSURE(strcmp(SymTableFrozen_get(oFrozen, "Ruth"), "RF") == 0);
+   ASSURE(strcmp(SymTableFrozen_get(oFrozen, "Ru"), "1B") == 0);
+   ASSURE(strcmp(SymTableFrozen_get(oFrozen, "Ruthless"), "CF") == 0);
+   ASSURE(strcmp(SymTableFrozen_get(oFrozen, ""), "P") == 0);
+   ASSURE(strcmp(SymTableFrozen_get(oFrozen, "R\xc3\xbc"), "C") == 0);
+   ASSURE(strcmp(SymTableFrozen_get(oFrozen, "Rut"), "SS") == 0);
+   ASSURE(! SymTableFrozen_contains(oFrozen, "R"));
+   ASSURE(! SymTableFrozen_contains(oFrozen, "Ruthl"));
+   ASSURE(! SymTableFrozen_contains(oFrozen, "Ruthlessly"));
+   ASSURE(! SymTableFrozen_contains(oFrozen, "Mantle"));
+   ASSURE(! SymTableFrozen_contains(oFrozen, "Ruu"));
+   ASSURE(! SymTableFrozen_contains(oFrozen, "\xff"));
+   ASSURE(SymTableFrozen_get(oFrozen, "Rus") == NULL);
+
+   /* Map visits every binding in increasing order of key. */
+   SymTableFrozen_map(oFrozen, checkOrder, &sWalk);
+   ASSURE(sWalk.uCount == 6);
+   ASSURE(sWalk.iInOrder);
+
+   SymTableFrozen_free(oFrozen);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to pcKey the key of binding iIndex of the large test, which
+   shares a long prefix with many other keys. */
+
+static void makeKey(char *pcKey, int iIndex)
+{
+   sprintf(pcKey, "service%d.region%d.cluster%d.metric%d",
+      iIndex % 7, iIndex % 3, iIndex % 11, iIndex);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a frozen table of iBindingCount bindings whose keys share
+   long prefixes. */
+
+static void testLargeTable(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   SymTableFrozen_T oFrozen;
+   struct Walk sWalk = {"", 0, 0, 1};
+   char acKey[128];
+   int iAllFound = 1;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a large frozen table.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   for (i = 0; i < iBindingCount; i++)
+   {
+      makeKey(acKey, i);
+      ASSURE(SymTable_put(oSymTable, acKey, (void *)(size_t)(i + 1)));
+   }
+
+   oFrozen = SymTableFrozen_new(oSymTable);
+   SymTable_free(oSymTable);
+   ASSURE(oFrozen != NULL);
+   if (oFrozen == NULL)
+      return;
+   ASSURE(SymTableFrozen_getLength(oFrozen) == (size_t)iBindingCount);
+
+   /* Every key is found, and nearby keys that were never added are
+      not. */
+   for (i = 0; i < iBindingCount; i++)
+   {
+      makeKey(acKey, i);
+      if (SymTableFrozen_get(oFrozen, acKey) != (void *)(size_t)(i + 1))
+         iAllFound = 0;
+      strcat(acKey, "0");
+      if (SymTableFrozen_contains(oFrozen, acKey) &&
+          SymTableFrozen_get(oFrozen, acKey) ==
+             (void *)(size_t)(i + 1))
+         iAllFound = 0;
+      acKey[strlen(acKey) - 2] = '\0';
+      if (SymTableFrozen_contains(oFrozen, acKey) &&
+          SymTableFrozen_get(oFrozen, acKey) ==
+             (void *)(size_t)(i + 1))
+         iAllFound = 0;
+   }
+   ASSURE(iAllFound);
+   makeKey(acKey, iBindingCount);
+   ASSURE(! SymTableFrozen_contains(oFrozen, acKey));
+   ASSURE(! SymTableFrozen_contains(oFrozen, "service"));
+   ASSURE(! SymTableFrozen_contains(oFrozen, "zzz"));
+
+   SymTableFrozen_map(oFrozen, checkOrder, &sWalk);
+   ASSURE(sWalk.uCount == (size_t)iBindingCount);
+   ASSURE(sWalk.iInOrder);
+
+   SymTableFrozen_free(oFrozen);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the frozen table, built from the hash table implementation.
+   As with testsymtable, argv[1] is the number of bindings for the
+   large test. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      return 1;
+   }
+   iBindingCount = atoi(argv[1]);
+
+   testBasics();
+   testLargeTable(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,487 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablehandle.c                                               */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+#define _XOPEN_SOURCE 700
+
+#include "symtablehash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test each handle function on a small table. */
+
+static void testBasics(void)
+{
+   SymTable_T oSymTable;
+   SymTable_Handle sHandle;
+   SymTable_Handle sZero = {0, 0};
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the handle functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+
+   ASSURE(! SymTable_find(oSymTable, "Ruth", &sHandle));
+   ASSURE(! SymTable_isValidHandle(oSymTable, sZero));
+   ASSURE(SymTable_put(oSymTable, "Ruth", "RF"));
+   ASSURE(SymTable_put(oSymTable, "Gehrig", "1B"));
+   ASSURE(SymTable_put(oSymTable, "Mantle", "CF"));
+   ASSURE(! SymTable_isValidHandle(oSymTable, sZero));
+
+   ASSURE(SymTable_find(oSymTable, "Gehrig", &sHandle));
+   ASSURE(SymTable_isValidHandle(oSymTable, sHandle));
+   ASSURE(strcmp(SymTable_getKeyByHandle(oSymTable, sHandle),
+      "Gehrig") == 0);
+   ASSURE(strcmp(SymTable_getByHandle(oSymTable, sHandle), "1B") == 0);
+
+   /* Replacing by handle is seen by key, and the reverse. */
+   ASSURE(strcmp(SymTable_replaceByHandle(oSymTable, sHandle, "DH"),
+      "1B") == 0);
+   ASSURE(strcmp(SymTable_get(oSymTable, "Gehrig"), "DH") == 0);
+   ASSURE(strcmp(SymTable_replace(oSymTable, "Gehrig", "C"),
+      "DH") == 0);
+   ASSURE(strcmp(SymTable_getByHandle(oSymTable, sHandle), "C") == 0);
+
+   ASSURE(strcmp(SymTable_removeByHandle(oSymTable, sHandle),
+      "C") == 0);
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+   ASSURE(! SymTable_contains(oSymTable, "Gehrig"));
+   ASSURE(! SymTable_find(oSymTable, "Gehrig", &sHandle));
+   ASSURE(SymTable_contains(oSymTable, "Ruth"));
+   ASSURE(SymTable_contains(oSymTable, "Mantle"));
+
+   /* A handle to a removed binding stays invalid when its slot is
+      reused, and changes nothing. */
+   ASSURE(! SymTable_isValidHandle(oSymTable, sHandle));
+   ASSURE(SymTable_put(oSymTable, "Berra", "C"));
+   ASSURE(! SymTable_isValidHandle(oSymTable, sHandle));
+   ASSURE(SymTable_getByHandle(oSymTable, sHandle) == NULL);
+   ASSURE(SymTable_getKeyByHandle(oSymTable, sHandle) == NULL);
+   ASSURE(SymTable_replaceByHandle(oSymTable, sHandle, "1B") == NULL);
+   ASSURE(SymTable_removeByHandle(oSymTable, sHandle) == NULL);
+   ASSURE(strcmp(SymTable_get(oSymTable, "Berra"), "C") == 0);
+   ASSURE(SymTable_getLength(oSymTable) == 3);
+
+   /* Removing by key invalidates handles too. */
+   ASSURE(SymTable_find(oSymTable, "Ruth", &sHandle));
+   ASSURE(strcmp(SymTable_remove(oSymTable, "Ruth"), "RF") == 0);
+   ASSURE(! SymTable_isValidHandle(oSymTable, sHandle));
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test handles taken before a table of iBindingCount bindings grows,
+   used after it has, removal by handle from every position of the
+   bucket chains, and handles to removed bindings. */
+
+static void testLargeTable(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   SymTable_Handle *psHandles;
+   SymTable_Handle sHandle;
+   char acKey[32];
+   int iAllFound = 1;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing handles in a large table.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   psHandles = calloc((size_t)iBindingCount + 1,
+      sizeof(SymTable_Handle));
+   ASSURE(oSymTable != NULL && psHandles != NULL);
+   if (oSymTable == NULL || psHandles == NULL)
+      return;
+
+   /* Take a handle to each binding as soon as it is added. */
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, (void *)(size_t)i));
+      ASSURE(SymTable_find(oSymTable, acKey, &psHandles[i]));
+   }
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (! SymTable_find(oSymTable, acKey, &sHandle) ||
+          sHandle.index != psHandles[i].index ||
+          sHandle.generation != psHandles[i].generation ||
+          SymTable_getByHandle(oSymTable, psHandles[i]) !=
+             (void *)(size_t)i)
+         iAllFound = 0;
+   }
+   ASSURE(iAllFound);
+
+   /* Remove every other binding by handle. */
+   for (i = 0; i < iBindingCount; i += 2)
+      if (SymTable_removeByHandle(oSymTable, psHandles[i]) !=
+             (void *)(size_t)i)
+         iAllFound = 0;
+   ASSURE(iAllFound);
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount / 2);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (SymTable_contains(oSymTable, acKey) != (i % 2 == 1) ||
+          SymTable_isValidHandle(oSymTable, psHandles[i]) !=
+             (i % 2 == 1))
+         iAllFound = 0;
+   }
+   ASSURE(iAllFound);
+
+   /* Bindings added again get new handles; the old ones stay
+      invalid. */
+   for (i = 0; i < iBindingCount; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, (void *)(size_t)i));
+      if (SymTable_isValidHandle(oSymTable, psHandles[i]))
+         iAllFound = 0;
+   }
+   ASSURE(iAllFound);
+
+   free(psHandles);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that updates by handle are logged. */
+
+static void testLogging(void)
+{
+   char acDir[] = "/tmp/testsymtablehandleXXXXXX";
+   char acSnapshot[sizeof(acDir) + 16];
+   char acLog[sizeof(acDir) + 16];
+   SymTable_T oSymTable;
+   SymTable_Handle sHandle;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing updates by handle to a logged table.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   ASSURE(mkdtemp(acDir) != NULL);
+   sprintf(acSnapshot, "%s/snapshot", acDir);
+   sprintf(acLog, "%s/log", acDir);
+
+   oSymTable = SymTable_recover(acSnapshot, acLog,
+      &SymTable_pointerCodec, 1);
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   ASSURE(SymTable_put(oSymTable, "Ruth", (void *)1));
+   ASSURE(SymTable_put(oSymTable, "Gehrig", (void *)2));
+   ASSURE(SymTable_find(oSymTable, "Ruth", &sHandle));
+   (void)SymTable_replaceByHandle(oSymTable, sHandle, (void *)3);
+   ASSURE(SymTable_find(oSymTable, "Gehrig", &sHandle));
+   (void)SymTable_removeByHandle(oSymTable, sHandle);
+   ASSURE(SymTable_sync(oSymTable));
+   SymTable_free(oSymTable);
+
+   oSymTable = SymTable_recover(acSnapshot, acLog,
+      &SymTable_pointerCodec, 1);
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+   ASSURE(SymTable_get(oSymTable, "Ruth") == (void *)3);
+   ASSURE(! SymTable_contains(oSymTable, "Gehrig"));
+   SymTable_free(oSymTable);
+
+   (void)unlink(acSnapshot);
+   (void)unlink(acLog);
+   (void)rmdir(acDir);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test clearing and refilling tables of iBindingCount bindings, with
+   their own key copies and with keys from a shared store. */
+
+static void testClear(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   SymTable_T oShared;
+   SymTableKeys_T oKeys;
+   SymTable_Handle sHandle;
+   char acKey[32];
+   int iAllFound = 1;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing clearing and refilling tables.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   oKeys = SymTableKeys_new();
+   ASSURE(oSymTable != NULL && oKeys != NULL);
+   if (oSymTable == NULL || oKeys == NULL)
+      return;
+   oShared = SymTable_newWithKeys(oKeys);
+   ASSURE(oShared != NULL);
+   if (oShared == NULL)
+      return;
+
+   /* Clearing an empty table does nothing. */
+   SymTable_clear(oSymTable);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, (void *)(size_t)(i + 1)));
+      ASSURE(SymTable_put(oShared, acKey, (void *)(size_t)(i + 1)));
+   }
+   ASSURE(SymTable_put(oSymTable, "Ruth", "RF"));
+   ASSURE(SymTable_find(oSymTable, "Ruth", &sHandle));
+
+   SymTable_clear(oSymTable);
+   SymTable_clear(oShared);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   ASSURE(SymTable_getLength(oShared) == 0);
+   ASSURE(SymTableKeys_getLength(oKeys) == 0);
+   ASSURE(! SymTable_contains(oSymTable, "Ruth"));
+   ASSURE(! SymTable_contains(oSymTable, "0"));
+   ASSURE(! SymTable_isValidHandle(oSymTable, sHandle));
+
+   /* Refill with keys both shorter and longer than the old ones. */
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, i % 2 == 0 ? "%d" : "refilled%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, (void *)(size_t)(i + 2)));
+      ASSURE(SymTable_put(oShared, acKey, (void *)(size_t)(i + 2)));
+   }
+   ASSURE(SymTable_put(oSymTable, "Ru", "1B"));
+   ASSURE(! SymTable_isValidHandle(oSymTable, sHandle));
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount + 1);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, i % 2 == 0 ? "%d" : "refilled%d", i);
+      if (SymTable_get(oSymTable, acKey) != (void *)(size_t)(i + 2) ||
+          SymTable_get(oShared, acKey) != (void *)(size_t)(i + 2))
+         iAllFound = 0;
+   }
+   ASSURE(iAllFound);
+   ASSURE(strcmp(SymTable_get(oSymTable, "Ru"), "1B") == 0);
+   ASSURE(! SymTable_contains(oSymTable, "Ruth"));
+
+   SymTable_free(oSymTable);
+   SymTable_free(oShared);
+   SymTableKeys_free(oKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add to the size_t array at pvTotals, which holds the number of
+   bindings visited, the number whose key starts with "new", and the
+   sum of their values, the binding of pcKey to pvValue. */
+
+static void countBinding(const char *pcKey, void *pvValue,
+   void *pvTotals)
+{
+   size_t *puTotals = pvTotals;
+
+   puTotals[0]++;
+   if (strncmp(pcKey, "new", 3) == 0)
+      puTotals[1]++;
+   puTotals[2] += (size_t)pvValue;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test clearing a table that has grown to iBindingCount bindings and
+   refilling it well past that size, checking what SymTable_map
+   visits before and after. */
+
+static void testClearAndGrow(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   size_t auTotals[3];
+   size_t uRefillCount = (size_t)iBindingCount * 3 + 1;
+   size_t uSum = 0;
+   char acKey[32];
+   int iAllFound = 1;
+   size_t u;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing refilling a cleared table past its old size.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+
+   for (u = 0; u < (size_t)iBindingCount; u++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)u);
+      ASSURE(SymTable_put(oSymTable, acKey, (void *)(u + 1)));
+   }
+   SymTable_clear(oSymTable);
+
+   /* A cleared table visits no binding. */
+   memset(auTotals, 0, sizeof(auTotals));
+   SymTable_map(oSymTable, countBinding, auTotals);
+   ASSURE(auTotals[0] == 0);
+
+   for (u = 0; u < uRefillCount; u++)
+   {
+      sprintf(acKey, "new%lu", (unsigned long)u);
+      ASSURE(SymTable_put(oSymTable, acKey, (void *)(u + 1)));
+      uSum += u + 1;
+   }
+   ASSURE(SymTable_getLength(oSymTable) == uRefillCount);
+   for (u = 0; u < uRefillCount; u++)
+   {
+      sprintf(acKey, "new%lu", (unsigned long)u);
+      if (SymTable_get(oSymTable, acKey) != (void *)(u + 1))
+         iAllFound = 0;
+      sprintf(acKey, "%lu", (unsigned long)u);
+      if (SymTable_contains(oSymTable, acKey))
+         iAllFound = 0;
+   }
+   ASSURE(iAllFound);
+
+   /* SymTable_map visits every new binding once and no old one. */
+   memset(auTotals, 0, sizeof(auTotals));
+   SymTable_map(oSymTable, countBinding, auTotals);
+   ASSURE(auTotals[0] == uRefillCount);
+   ASSURE(auTotals[1] == uRefillCount);
+   ASSURE(auTotals[2] == uSum);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store pcKey in the const char * at pvKey. pvValue is unused. */
+
+static void recordKey(const char *pcKey, void *pvValue, void *pvKey)
+{
+   (void)pvValue;
+   *(const char **)pvKey = pcKey;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test clearing and refilling a table of one binding many times, with
+   keys that alternate between short and long ones, none longer than
+   the first, and check that every key is stored in the copy of the
+   first rather than in a new one. */
+
+static void testKeyReuse(void)
+{
+   enum {ROUND_COUNT = 8};
+   const char *pcFirstKey = "George Herman Ruth, the Sultan of Swat";
+   const char *apcKeys[] = {"Ru", "George Herman Ruth"};
+   SymTable_T oSymTable;
+   const char *pcCopy = NULL;
+   const char *pcFirstCopy;
+   int iAllReused = 1;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing reusing key copies of cleared bindings.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+
+   ASSURE(SymTable_put(oSymTable, pcFirstKey, "first"));
+   SymTable_map(oSymTable, recordKey, &pcCopy);
+   pcFirstCopy = pcCopy;
+   ASSURE(pcFirstCopy != NULL && pcFirstCopy != pcFirstKey);
+
+   /* A short key must not shrink the copy for the long one after it. */
+   for (i = 0; i < ROUND_COUNT; i++)
+   {
+      SymTable_clear(oSymTable);
+      ASSURE(SymTable_put(oSymTable, apcKeys[i % 2], (void *)apcKeys));
+      pcCopy = NULL;
+      SymTable_map(oSymTable, recordKey, &pcCopy);
+      if (pcCopy != pcFirstCopy ||
+          SymTable_get(oSymTable, apcKeys[i % 2]) != (void *)apcKeys ||
+          SymTable_contains(oSymTable, apcKeys[(i + 1) % 2]))
+         iAllReused = 0;
+   }
+   ASSURE(iAllReused);
+
+   /* A key longer than the copy gets a new one. */
+   SymTable_clear(oSymTable);
+   ASSURE(SymTable_put(oSymTable,
+      "George Herman Ruth, the Sultan of Swat, the Bambino", "long"));
+   ASSURE(strcmp(SymTable_get(oSymTable,
+      "George Herman Ruth, the Sultan of Swat, the Bambino"),
+      "long") == 0);
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the handle functions of the hash table implementation. As
+   with testsymtable, argv[1] is the number of bindings for the large
+   test. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      return 1;
+   }
+   iBindingCount = atoi(argv[1]);
+
+   testBasics();
+   testLargeTable(iBindingCount);
+   testLogging();
+   testClear(iBindingCount);
+   testClearAndGrow(iBindingCount);
+   testKeyReuse();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,170 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablekeylength.c                                            */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test keys on either side of the inline key limit of sixteen bytes,
+   including keys that agree in their first fifteen bytes. */
+
+static void testBoundaryKeys(void)
+{
+   /* Keys of 14, 15, 16 and 17 characters, then keys of 15 and 16
+      characters that differ only in their last character. */
+   const char *apcKeys[] = {"Lou Gehrig, 1B", "Lou Gehrig, 1B.",
+      "Lou Gehrig, 1B..", "Lou Gehrig, 1B...", "Lou Gehrig, 1B!",
+      "Lou Gehrig, 1B.!"};
+   enum {KEY_COUNT = sizeof(apcKeys) / sizeof(apcKeys[0])};
+   SymTable_T oSymTable;
+   char acCopy[32];
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing keys of 15 and 16 characters.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+
+   for (i = 0; i < KEY_COUNT; i++)
+      ASSURE(SymTable_put(oSymTable, apcKeys[i], (void *)apcKeys[i]));
+   ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT);
+
+   /* Each key is found through a copy in another buffer, and adding
+      it again fails. */
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      strcpy(acCopy, apcKeys[i]);
+      ASSURE(SymTable_get(oSymTable, acCopy) == apcKeys[i]);
+      ASSURE(! SymTable_put(oSymTable, acCopy, NULL));
+   }
+   ASSURE(! SymTable_contains(oSymTable, "Lou Gehrig, 1B?"));
+   ASSURE(! SymTable_contains(oSymTable, "Lou Gehrig, 1B.?"));
+   ASSURE(! SymTable_contains(oSymTable, "Lou Gehrig, 1"));
+
+   /* Removing the 15-character key leaves the 16-character one, and
+      the other way around. */
+   ASSURE(SymTable_remove(oSymTable, "Lou Gehrig, 1B.") == apcKeys[1]);
+   ASSURE(! SymTable_contains(oSymTable, "Lou Gehrig, 1B."));
+   ASSURE(SymTable_get(oSymTable, "Lou Gehrig, 1B..") == apcKeys[2]);
+   ASSURE(SymTable_put(oSymTable, "Lou Gehrig, 1B.", NULL));
+   ASSURE(SymTable_remove(oSymTable, "Lou Gehrig, 1B..") == apcKeys[2]);
+   ASSURE(SymTable_contains(oSymTable, "Lou Gehrig, 1B."));
+   ASSURE(SymTable_get(oSymTable, "Lou Gehrig, 1B.") == NULL);
+   ASSURE(SymTable_replace(oSymTable, "Lou Gehrig, 1B.!", NULL) ==
+      apcKeys[5]);
+   ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT - 1);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test iBindingCount keys of 15 characters and as many of 16, which
+   share probe runs, through growth and removal. */
+
+static void testManyBoundaryKeys(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   char acKey[32];
+   int iAllFound = 1;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing many keys of 15 and 16 characters.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%015d", i);
+      ASSURE(SymTable_put(oSymTable, acKey,
+         (void *)(size_t)(2 * i + 1)));
+      sprintf(acKey, "%016d", i);
+      ASSURE(SymTable_put(oSymTable, acKey,
+         (void *)(size_t)(2 * i + 2)));
+   }
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)(2 * iBindingCount));
+
+   /* Remove the 16-character key of every even i and the 15-character
+      key of every odd i. */
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, i % 2 == 0 ? "%016d" : "%015d", i);
+      if (SymTable_remove(oSymTable, acKey) !=
+          (void *)(size_t)(2 * i + 1 + (i % 2 == 0)))
+         iAllFound = 0;
+   }
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, i % 2 == 0 ? "%015d" : "%016d", i);
+      if (SymTable_get(oSymTable, acKey) !=
+          (void *)(size_t)(2 * i + 1 + (i % 2 != 0)))
+         iAllFound = 0;
+      sprintf(acKey, i % 2 == 0 ? "%016d" : "%015d", i);
+      if (SymTable_contains(oSymTable, acKey))
+         iAllFound = 0;
+   }
+   ASSURE(iAllFound);
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test keys whose lengths straddle the inline key limit of the
+   struct-of-arrays implementation. As with testsymtable, argv[1] is
+   the number of bindings for the large test. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      return 1;
+   }
+   iBindingCount = atoi(argv[1]);
+
+   testBoundaryKeys();
+   testManyBoundaryKeys(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,239 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablekeys.c                                                 */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+#include "symtablehash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the key store on its own. */
+
+static void testStore(void)
+{
+   SymTableKeys_T oKeys;
+   const char *pcRuth;
+   const char *pcGehrig;
+   char acRuth[] = "Ruth";
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the key store.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oKeys = SymTableKeys_new();
+   ASSURE(oKeys != NULL);
+   if (oKeys == NULL)
+      return;
+   ASSURE(SymTableKeys_getLength(oKeys) == 0);
+
+   /* Equal strings are stored once, apart from the caller's copy. */
+   pcRuth = SymTableKeys_intern(oKeys, "Ruth");
+   ASSURE(pcRuth != NULL && strcmp(pcRuth, "Ruth") == 0);
+   ASSURE(pcRuth != acRuth);
+   ASSURE(SymTableKeys_intern(oKeys, acRuth) == pcRuth);
+   pcGehrig = SymTableKeys_intern(oKeys, "Gehrig");
+   ASSURE(pcGehrig != NULL && pcGehrig != pcRuth);
+   ASSURE(SymTableKeys_getLength(oKeys) == 2);
+
+   /* A string stays until its last reference is released. */
+   SymTableKeys_release(oKeys, pcRuth);
+   ASSURE(SymTableKeys_getLength(oKeys) == 2);
+   ASSURE(strcmp(pcRuth, "Ruth") == 0);
+   SymTableKeys_release(oKeys, pcRuth);
+   ASSURE(SymTableKeys_getLength(oKeys) == 1);
+   SymTableKeys_release(oKeys, pcGehrig);
+   ASSURE(SymTableKeys_getLength(oKeys) == 0);
+
+   /* The empty string is a key like any other. */
+   ASSURE(SymTableKeys_intern(oKeys, "") != NULL);
+   ASSURE(SymTableKeys_getLength(oKeys) == 1);
+
+   SymTableKeys_free(oKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test several tables sharing one store. */
+
+static void testSharedTables(void)
+{
+   SymTableKeys_T oKeys;
+   SymTable_T oFirst;
+   SymTable_T oSecond;
+   SymTable_Handle sFirst;
+   SymTable_Handle sSecond;
+   const char *pcMantle;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing tables that share a key store.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oKeys = SymTableKeys_new();
+   ASSURE(oKeys != NULL);
+   if (oKeys == NULL)
+      return;
+   oFirst = SymTable_newWithKeys(oKeys);
+   oSecond = SymTable_newWithKeys(oKeys);
+   ASSURE(oFirst != NULL && oSecond != NULL);
+   if (oFirst == NULL || oSecond == NULL)
+      return;
+
+   ASSURE(SymTable_put(oFirst, "Ruth", "RF"));
+   ASSURE(SymTable_put(oFirst, "Gehrig", "1B"));
+   ASSURE(SymTable_put(oSecond, "Ruth", "P"));
+   ASSURE(! SymTable_put(oSecond, "Ruth", "CF"));
+   ASSURE(SymTableKeys_getLength(oKeys) == 2);
+
+   /* Both tables hold the same copy of a key. */
+   ASSURE(SymTable_find(oFirst, "Ruth", &sFirst));
+   ASSURE(SymTable_find(oSecond, "Ruth", &sSecond));
+   ASSURE(SymTable_getKeyByHandle(oFirst, sFirst) ==
+      SymTable_getKeyByHandle(oSecond, sSecond));
+
+   /* Keys from the store and equal keys from elsewhere both work. */
+   pcMantle = SymTableKeys_intern(oKeys, "Mantle");
+   ASSURE(pcMantle != NULL);
+   ASSURE(SymTable_put(oFirst, pcMantle, "CF"));
+   ASSURE(strcmp(SymTable_get(oFirst, pcMantle), "CF") == 0);
+   ASSURE(strcmp(SymTable_get(oFirst, "Mantle"), "CF") == 0);
+   ASSURE(SymTable_contains(oFirst, SymTable_getKeyByHandle(oSecond,
+      sSecond)));
+   ASSURE(SymTableKeys_getLength(oKeys) == 3);
+
+   /* A key leaves the store once no table or caller holds it. */
+   ASSURE(strcmp(SymTable_remove(oFirst, "Ruth"), "RF") == 0);
+   ASSURE(SymTableKeys_getLength(oKeys) == 3);
+   ASSURE(strcmp(SymTable_get(oSecond, "Ruth"), "P") == 0);
+   ASSURE(strcmp(SymTable_removeByHandle(oSecond, sSecond), "P") == 0);
+   ASSURE(SymTableKeys_getLength(oKeys) == 2);
+   ASSURE(strcmp(SymTable_remove(oFirst, pcMantle), "CF") == 0);
+   ASSURE(SymTableKeys_getLength(oKeys) == 2);
+   SymTableKeys_release(oKeys, pcMantle);
+   ASSURE(SymTableKeys_getLength(oKeys) == 1);
+
+   SymTable_free(oFirst);
+   ASSURE(SymTableKeys_getLength(oKeys) == 0);
+   SymTable_free(oSecond);
+   SymTableKeys_free(oKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test TABLE_COUNT tables of iBindingCount bindings each, all with
+   the same keys, sharing one store. */
+
+static void testLargeTables(int iBindingCount)
+{
+   enum {TABLE_COUNT = 4};
+   SymTableKeys_T oKeys;
+   SymTable_T aoTables[TABLE_COUNT];
+   char acKey[32];
+   int iAllFound = 1;
+   int i, t;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing large tables that share a key store.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oKeys = SymTableKeys_new();
+   ASSURE(oKeys != NULL);
+   if (oKeys == NULL)
+      return;
+   for (t = 0; t < TABLE_COUNT; t++)
+   {
+      aoTables[t] = SymTable_newWithKeys(oKeys);
+      ASSURE(aoTables[t] != NULL);
+      if (aoTables[t] == NULL)
+         return;
+   }
+
+   for (t = 0; t < TABLE_COUNT; t++)
+      for (i = 0; i < iBindingCount; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_put(aoTables[t], acKey, (void *)(size_t)t));
+      }
+   ASSURE(SymTableKeys_getLength(oKeys) == (size_t)iBindingCount);
+
+   for (t = 0; t < TABLE_COUNT; t++)
+      for (i = 0; i < iBindingCount; i++)
+      {
+         sprintf(acKey, "%d", i);
+         if (SymTable_get(aoTables[t], acKey) != (void *)(size_t)t)
+            iAllFound = 0;
+      }
+   ASSURE(iAllFound);
+
+   /* Removing every other key from every table but the last leaves
+      every key in the store; removing it from the last does not. */
+   for (t = 0; t < TABLE_COUNT; t++)
+   {
+      for (i = 0; i < iBindingCount; i += 2)
+      {
+         sprintf(acKey, "%d", i);
+         if (SymTable_remove(aoTables[t], acKey) != (void *)(size_t)t)
+            iAllFound = 0;
+      }
+      if (t < TABLE_COUNT - 1)
+         ASSURE(SymTableKeys_getLength(oKeys) ==
+            (size_t)iBindingCount);
+   }
+   ASSURE(iAllFound);
+   ASSURE(SymTableKeys_getLength(oKeys) == (size_t)iBindingCount / 2);
+
+   for (t = 0; t < TABLE_COUNT; t++)
+      SymTable_free(aoTables[t]);
+   ASSURE(SymTableKeys_getLength(oKeys) == 0);
+   SymTableKeys_free(oKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the shared key store and the hash table implementation's use
+   of it. As with testsymtable, argv[1] is the number of bindings for
+   the large test. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      return 1;
+   }
+   iBindingCount = atoi(argv[1]);
+
+   testStore();
+   testSharedTables();
+   testLargeTables(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,545 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablelog.c                                                  */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+#define _XOPEN_SOURCE 700
+
+#include "symtablehash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* Names of the snapshot and log files, inside a temporary directory */
+static char acDir[] = "/tmp/testsymtablelogXXXXXX";
+static char acSnapshot[sizeof(acDir) + 16];
+static char acLog[sizeof(acDir) + 16];
+static char acStaleLog[sizeof(acDir) + 16];
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a newly allocated copy of pcValue, which is never NULL
+   because the test stops if memory runs out. */
+
+static char *copyValue(const char *pcValue)
+{
+   char *pcCopy = malloc(strlen(pcValue) + 1);
+   assert(pcCopy != NULL);
+   strcpy(pcCopy, pcValue);
+   return pcCopy;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free pvValue, the value of the binding whose key is pcKey.
+   pvExtra is unused. */
+
+static void freeValue(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvExtra == NULL);
+   free(pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Free oSymTable and all of its values. */
+
+static void closeTable(SymTable_T oSymTable)
+{
+   SymTable_map(oSymTable, freeValue, NULL);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if the value of pcKey in oSymTable is a string
+   equal to pcValue, or 0 (FALSE) otherwise. */
+
+static int hasValue(SymTable_T oSymTable, const char *pcKey,
+   const char *pcValue)
+{
+   const char *pcFound = SymTable_get(oSymTable, pcKey);
+   return pcFound != NULL && strcmp(pcFound, pcValue) == 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that updates survive closing and recovering a table, with and
+   without a checkpoint in between. */
+
+static void testRecover(void)
+{
+   SymTable_T oSymTable;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing recovery from snapshot and log.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* Missing files give an empty table. */
+   oSymTable = SymTable_recover(acSnapshot, acLog,
+      &SymTable_stringCodec, 4);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   ASSURE(SymTable_put(oSymTable, "Ruth", copyValue("RF")));
+   ASSURE(SymTable_put(oSymTable, "Gehrig", copyValue("1B")));
+   ASSURE(SymTable_put(oSymTable, "Mantle", copyValue("CF")));
+   ASSURE(SymTable_put(oSymTable, "Maris", NULL));
+   free(SymTable_replace(oSymTable, "Gehrig", copyValue("DH")));
+   free(SymTable_remove(oSymTable, "Mantle"));
+   ASSURE(SymTable_sync(oSymTable));
+   closeTable(oSymTable);
+
+   /* The log alone restores the table. */
+   oSymTable = SymTable_recover(acSnapshot, acLog,
+      &SymTable_stringCodec, 4);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 3);
+   ASSURE(hasValue(oSymTable, "Ruth", "RF"));
+   ASSURE(hasValue(oSymTable, "Gehrig", "DH"));
+   ASSURE(! SymTable_contains(oSymTable, "Mantle"));
+   ASSURE(SymTable_contains(oSymTable, "Maris"));
+   ASSURE(SymTable_get(oSymTable, "Maris") == NULL);
+
+   /* A checkpoint empties the log; later updates go to the log. */
+   ASSURE(SymTable_checkpoint(oSymTable));
+   ASSURE(SymTable_put(oSymTable, "Berra", copyValue("C")));
+   free(SymTable_remove(oSymTable, "Ruth"));
+   closeTable(oSymTable);
+
+   oSymTable = SymTable_recover(acSnapshot, acLog,
+      &SymTable_stringCodec, 4);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 3);
+   ASSURE(! SymTable_contains(oSymTable, "Ruth"));
+   ASSURE(hasValue(oSymTable, "Gehrig", "DH"));
+   ASSURE(hasValue(oSymTable, "Berra", "C"));
+   ASSURE(SymTable_contains(oSymTable, "Maris"));
+   closeTable(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Copy the file named pcFrom to a file named pcTo. Return 1 (TRUE) if
+   successful, or 0 (FALSE) otherwise. */
+
+static int copyFile(const char *pcFrom, const char *pcTo)
+{
+   FILE *psFrom;
+   FILE *psTo;
+   int iChar;
+   int iSuccessful;
+
+   psFrom = fopen(pcFrom, "rb");
+   if (psFrom == NULL)
+      return 0;
+   psTo = fopen(pcTo, "wb");
+   if (psTo == NULL)
+   {
+      fclose(psFrom);
+      return 0;
+   }
+   while ((iChar = getc(psFrom)) != EOF)
+      putc(iChar, psTo);
+   iSuccessful = ! ferror(psFrom);
+   fclose(psFrom);
+   if (fclose(psTo) != 0)
+      iSuccessful = 0;
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test recovery after a crash in the middle of a checkpoint, once the
+   new snapshot is in place but before the log is emptied. The crash
+   is simulated by putting back the log as it was before the
+   checkpoint, when it did not yet hold the pending updates that the
+   snapshot covers. */
+
+static void testCheckpointCrash(void)
+{
+   SymTable_T oSymTable;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a crash during a checkpoint.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   (void)unlink(acSnapshot);
+   (void)unlink(acLog);
+
+   oSymTable = SymTable_recover(acSnapshot, acLog,
+      &SymTable_stringCodec, 100);
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   ASSURE(SymTable_put(oSymTable, "Ruth", copyValue("RF")));
+   ASSURE(SymTable_put(oSymTable, "Mantle", copyValue("CF")));
+   ASSURE(SymTable_sync(oSymTable));
+   ASSURE(copyFile(acLog, acStaleLog));
+
+   /* These updates are still pending when the checkpoint starts. */
+   free(SymTable_remove(oSymTable, "Mantle"));
+   ASSURE(SymTable_put(oSymTable, "Berra", copyValue("C")));
+   ASSURE(SymTable_checkpoint(oSymTable));
+   closeTable(oSymTable);
+   ASSURE(rename(acStaleLog, acLog) == 0);
+
+   /* The stale log must not bring back the removed binding. */
+   oSymTable = SymTable_recover(acSnapshot, acLog,
+      &SymTable_stringCodec, 100);
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+   ASSURE(hasValue(oSymTable, "Ruth", "RF"));
+   ASSURE(hasValue(oSymTable, "Berra", "C"));
+   ASSURE(! SymTable_contains(oSymTable, "Mantle"));
+
+   /* The stale log is started afresh, and later updates are kept. */
+   ASSURE(SymTable_put(oSymTable, "Ford", copyValue("P")));
+   closeTable(oSymTable);
+
+   oSymTable = SymTable_recover(acSnapshot, acLog,
+      &SymTable_stringCodec, 100);
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   ASSURE(SymTable_getLength(oSymTable) == 3);
+   ASSURE(hasValue(oSymTable, "Ford", "P"));
+   ASSURE(! SymTable_contains(oSymTable, "Mantle"));
+
+   /* A later checkpoint and crash are handled the same way. */
+   ASSURE(copyFile(acLog, acStaleLog));
+   free(SymTable_remove(oSymTable, "Ford"));
+   ASSURE(SymTable_checkpoint(oSymTable));
+   closeTable(oSymTable);
+   ASSURE(rename(acStaleLog, acLog) == 0);
+
+   oSymTable = SymTable_recover(acSnapshot, acLog,
+      &SymTable_stringCodec, 100);
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+   ASSURE(! SymTable_contains(oSymTable, "Ford"));
+   closeTable(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a torn record at the end of the log is ignored and then
+   overwritten by later updates. */
+
+static void testTornRecord(void)
+{
+   SymTable_T oSymTable;
+   FILE *psFile;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a torn log record.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* Simulate a crash in the middle of writing a record. */
+   psFile = fopen(acLog, "ab");
+   ASSURE(psFile != NULL);
+   if (psFile != NULL)
+   {
+      fputs("\x12\x34\x56\x78\x01\x05", psFile);
+      fclose(psFile);
+   }
+
+   oSymTable = SymTable_recover(acSnapshot, acLog,
+      &SymTable_stringCodec, 4);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 3);
+   ASSURE(SymTable_put(oSymTable, "Jeter", copyValue("SS")));
+   closeTable(oSymTable);
+
+   oSymTable = SymTable_recover(acSnapshot, acLog,
+      &SymTable_stringCodec, 4);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 4);
+   ASSURE(hasValue(oSymTable, "Jeter", "SS"));
+   ASSURE(hasValue(oSymTable, "Berra", "C"));
+   closeTable(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that iBindingCount bindings logged in groups all survive
+   recovery. */
+
+static void testLargeLog(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   char acKey[32];
+   char acValue[32];
+   int i;
+   int iAllFound = 1;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a large log.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   (void)unlink(acSnapshot);
+   (void)unlink(acLog);
+
+   oSymTable = SymTable_recover(acSnapshot, acLog,
+      &SymTable_stringCodec, 64);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      sprintf(acValue, "%d", i * 3);
+      ASSURE(SymTable_put(oSymTable, acKey, copyValue(acValue)));
+   }
+   for (i = 0; i < iBindingCount; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      free(SymTable_remove(oSymTable, acKey));
+   }
+   closeTable(oSymTable);
+
+   oSymTable = SymTable_recover(acSnapshot, acLog,
+      &SymTable_stringCodec, 64);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount / 2);
+   for (i = 1; i < iBindingCount; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      sprintf(acValue, "%d", i * 3);
+      if (! hasValue(oSymTable, acKey, acValue))
+         iAllFound = 0;
+   }
+   ASSURE(iAllFound);
+   closeTable(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a snapshot written in the background holds the bindings
+   of the table when it was started, while the table itself goes on
+   changing. */
+
+static void testSaveAsync(int iBindingCount)
+{
+   struct timespec sPause = {0, 1000000};
+   SymTable_T oSymTable;
+   SymTableSave_T oSave;
+   char acKey[32];
+   char acValue[32];
+   int i;
+   int iAllFound = 1;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a snapshot written in the background.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   (void)unlink(acSnapshot);
+   (void)unlink(acLog);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      sprintf(acValue, "%d", i * 5);
+      ASSURE(SymTable_put(oSymTable, acKey, copyValue(acValue)));
+   }
+
+   fflush(stdout);
+   oSave = SymTable_saveAsync(oSymTable, acSnapshot,
+      &SymTable_stringCodec);
+   ASSURE(oSave != NULL);
+   if (oSave == NULL)
+   {
+      closeTable(oSymTable);
+      return;
+   }
+
+   /* Change every binding while the snapshot is being written. */
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      free(SymTable_remove(oSymTable, acKey));
+      sprintf(acKey, "new%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, copyValue("new")));
+   }
+   ASSURE(SymTable_waitSave(oSave));
+   closeTable(oSymTable);
+
+   oSymTable = SymTable_recover(acSnapshot, acLog,
+      &SymTable_stringCodec, 64);
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      sprintf(acValue, "%d", i * 5);
+      if (! hasValue(oSymTable, acKey, acValue))
+         iAllFound = 0;
+   }
+   ASSURE(iAllFound);
+   ASSURE(! SymTable_contains(oSymTable, "new0"));
+   closeTable(oSymTable);
+
+   /* A snapshot that cannot be written is reported. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   oSave = SymTable_saveAsync(oSymTable, "/nonexistent/snapshot",
+      &SymTable_stringCodec);
+   ASSURE(oSave != NULL);
+   if (oSave != NULL)
+   {
+      while (! SymTable_isSaveDone(oSave))
+         (void)nanosleep(&sPause, NULL);
+      ASSURE(SymTable_isSaveDone(oSave));
+      ASSURE(! SymTable_waitSave(oSave));
+   }
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a checkpoint taken while a snapshot of the same table to the
+   same file is still being written in the background. The older
+   snapshot must not replace the checkpoint's, which alone holds the
+   updates made in between now that the log has been emptied. */
+
+static void testSaveThenCheckpoint(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   SymTableSave_T oSave;
+   char acKey[32];
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a checkpoint during a background snapshot.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   (void)unlink(acSnapshot);
+   (void)unlink(acLog);
+
+   oSymTable = SymTable_recover(acSnapshot, acLog,
+      &SymTable_stringCodec, 64);
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, copyValue("old")));
+   }
+
+   fflush(stdout);
+   oSave = SymTable_saveAsync(oSymTable, acSnapshot,
+      &SymTable_stringCodec);
+   ASSURE(oSave != NULL);
+   if (oSave == NULL)
+   {
+      closeTable(oSymTable);
+      return;
+   }
+
+   /* The update is only in the log until the checkpoint writes it to
+      the snapshot and empties the log. */
+   ASSURE(SymTable_put(oSymTable, "late", copyValue("new")));
+   ASSURE(SymTable_checkpoint(oSymTable));
+   ASSURE(SymTable_isSaveDone(oSave));
+   ASSURE(SymTable_waitSave(oSave));
+   closeTable(oSymTable);
+
+   oSymTable = SymTable_recover(acSnapshot, acLog,
+      &SymTable_stringCodec, 64);
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   ASSURE(hasValue(oSymTable, "late", "new"));
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount + 1);
+
+   /* A save may also outlive its table. */
+   oSave = SymTable_saveAsync(oSymTable, acSnapshot,
+      &SymTable_stringCodec);
+   ASSURE(oSave != NULL);
+   closeTable(oSymTable);
+   if (oSave != NULL)
+      ASSURE(SymTable_waitSave(oSave));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the durability mode of the hash table implementation. As
+   with testsymtable, argv[1] is the number of bindings for the large
+   test. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      return 1;
+   }
+   iBindingCount = atoi(argv[1]);
+
+   if (mkdtemp(acDir) == NULL)
+   {
+      perror("mkdtemp");
+      return 1;
+   }
+   sprintf(acSnapshot, "%s/snapshot", acDir);
+   sprintf(acLog, "%s/log", acDir);
+   sprintf(acStaleLog, "%s/stalelog", acDir);
+
+   testRecover();
+   testTornRecord();
+   testCheckpointCrash();
+   testLargeLog(iBindingCount);
+   testSaveAsync(iBindingCount);
+   testSaveThenCheckpoint(iBindingCount);
+
+   (void)unlink(acSnapshot);
+   (void)unlink(acLog);
+   (void)unlink(acStaleLog);
+   (void)rmdir(acDir);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
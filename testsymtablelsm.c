@@ -0,0 +1,236 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablelsm.c                                                  */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+#define _XOPEN_SOURCE 700
+
+#include "symtablelsm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <dirent.h>
+#include <unistd.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* Directory holding the files of the store */
+static char acDir[] = "/tmp/testsymtablelsmXXXXXX";
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if the value of pcKey in oLsm is a string equal to
+   pcValue, or 0 (FALSE) otherwise. */
+
+static int hasValue(SymTableLsm_T oLsm, const char *pcKey,
+   const char *pcValue)
+{
+   char *pcFound = SymTableLsm_get(oLsm, pcKey);
+   int iEqual = pcFound != NULL && strcmp(pcFound, pcValue) == 0;
+   free(pcFound);
+   return iEqual;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Delete every file in the store directory. */
+
+static void removeFiles(void)
+{
+   DIR *psDir;
+   struct dirent *psEntry;
+   char acPath[sizeof(acDir) + 256];
+
+   psDir = opendir(acDir);
+   if (psDir == NULL)
+      return;
+   while ((psEntry = readdir(psDir)) != NULL)
+   {
+      if (psEntry->d_name[0] == '.')
+         continue;
+      sprintf(acPath, "%s/%.200s", acDir, psEntry->d_name);
+      (void)unlink(acPath);
+   }
+   (void)closedir(psDir);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the basic operations and reopening a store whose updates are
+   all still in its log. */
+
+static void testBasics(void)
+{
+   SymTableLsm_T oLsm;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the basic functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oLsm = SymTableLsm_new(acDir, 1024 * 1024, &SymTable_stringCodec);
+   ASSURE(oLsm != NULL);
+   if (oLsm == NULL)
+      return;
+   ASSURE(SymTableLsm_getRunCount(oLsm) == 0);
+   ASSURE(! SymTableLsm_contains(oLsm, "Ruth"));
+   ASSURE(SymTableLsm_get(oLsm, "Ruth") == NULL);
+
+   ASSURE(SymTableLsm_put(oLsm, "Ruth", "RF"));
+   ASSURE(SymTableLsm_put(oLsm, "Gehrig", "1B"));
+   ASSURE(SymTableLsm_put(oLsm, "Mantle", "CF"));
+   ASSURE(SymTableLsm_put(oLsm, "Maris", NULL));
+   ASSURE(SymTableLsm_put(oLsm, "Gehrig", "DH"));
+   ASSURE(SymTableLsm_remove(oLsm, "Mantle"));
+   ASSURE(SymTableLsm_remove(oLsm, "Berra"));
+
+   ASSURE(hasValue(oLsm, "Ruth", "RF"));
+   ASSURE(hasValue(oLsm, "Gehrig", "DH"));
+   ASSURE(! SymTableLsm_contains(oLsm, "Mantle"));
+   ASSURE(! SymTableLsm_contains(oLsm, "Berra"));
+   ASSURE(SymTableLsm_contains(oLsm, "Maris"));
+   ASSURE(SymTableLsm_get(oLsm, "Maris") == NULL);
+   ASSURE(SymTableLsm_sync(oLsm));
+   SymTableLsm_free(oLsm);
+
+   oLsm = SymTableLsm_new(acDir, 1024 * 1024, &SymTable_stringCodec);
+   ASSURE(oLsm != NULL);
+   if (oLsm == NULL)
+      return;
+   ASSURE(SymTableLsm_getRunCount(oLsm) == 1);
+   ASSURE(hasValue(oLsm, "Ruth", "RF"));
+   ASSURE(hasValue(oLsm, "Gehrig", "DH"));
+   ASSURE(! SymTableLsm_contains(oLsm, "Mantle"));
+   ASSURE(SymTableLsm_contains(oLsm, "Maris"));
+
+   /* Updates in the memtable hide the runs. */
+   ASSURE(SymTableLsm_remove(oLsm, "Ruth"));
+   ASSURE(SymTableLsm_put(oLsm, "Mantle", "CF"));
+   ASSURE(! SymTableLsm_contains(oLsm, "Ruth"));
+   ASSURE(hasValue(oLsm, "Mantle", "CF"));
+   SymTableLsm_free(oLsm);
+
+   removeFiles();
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a store of iBindingCount bindings whose memtable is small, so
+   that many runs are written and merged. */
+
+static void testLargeStore(int iBindingCount)
+{
+   enum {MEMTABLE_BYTES = 64 * 1024};
+   SymTableLsm_T oLsm;
+   char acKey[32];
+   char acValue[32];
+   int i;
+   int iAllFound = 1;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a large store.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oLsm = SymTableLsm_new(acDir, MEMTABLE_BYTES, &SymTable_stringCodec);
+   ASSURE(oLsm != NULL);
+   if (oLsm == NULL)
+      return;
+
+   /* Bind every key, overwrite every other one, and remove every
+      third one. */
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      sprintf(acValue, "%d", i);
+      ASSURE(SymTableLsm_put(oLsm, acKey, acValue));
+   }
+   for (i = 0; i < iBindingCount; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      sprintf(acValue, "%d", i * 2);
+      ASSURE(SymTableLsm_put(oLsm, acKey, acValue));
+   }
+   for (i = 0; i < iBindingCount; i += 3)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTableLsm_remove(oLsm, acKey));
+   }
+   ASSURE(SymTableLsm_sync(oLsm));
+   SymTableLsm_free(oLsm);
+
+   /* Check every binding after reopening. */
+   oLsm = SymTableLsm_new(acDir, MEMTABLE_BYTES, &SymTable_stringCodec);
+   ASSURE(oLsm != NULL);
+   if (oLsm == NULL)
+      return;
+   ASSURE(iBindingCount == 0 || SymTableLsm_getRunCount(oLsm) > 0);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      sprintf(acValue, "%d", i % 2 == 0 ? i * 2 : i);
+      if (i % 3 == 0)
+      {
+         if (SymTableLsm_contains(oLsm, acKey))
+            iAllFound = 0;
+      }
+      else if (! hasValue(oLsm, acKey, acValue))
+         iAllFound = 0;
+   }
+   ASSURE(iAllFound);
+   ASSURE(! SymTableLsm_contains(oLsm, "-1"));
+   SymTableLsm_free(oLsm);
+
+   removeFiles();
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the log-structured store. As with testsymtable, argv[1] is the
+   number of bindings for the large test. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      return 1;
+   }
+   iBindingCount = atoi(argv[1]);
+
+   if (mkdtemp(acDir) == NULL)
+   {
+      perror("mkdtemp");
+      return 1;
+   }
+
+   testBasics();
+   testLargeStore(iBindingCount);
+
+   (void)rmdir(acDir);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
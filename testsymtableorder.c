@@ -0,0 +1,204 @@
+/*--------------------------------------------------------------------*/
+/* testsymtableorder.c                                                */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* A Visit records the keys passed to SymTable_map, in order */
+struct Visit
+{
+   /* Keys seen so far, separated by spaces */
+   char *keys;
+   /* Number of bytes keys has room for */
+   size_t capacity;
+   /* Number of bindings seen so far */
+   size_t count;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Append pcKey to the Visit at pvVisit. pvValue is unused. */
+
+static void recordKey(const char *pcKey, void *pvValue, void *pvVisit)
+{
+   struct Visit *psVisit = pvVisit;
+   size_t uLength = strlen(psVisit->keys);
+
+   assert(pcKey != NULL);
+   (void)pvValue;
+
+   if (uLength + strlen(pcKey) + 2 <= psVisit->capacity)
+   {
+      if (uLength > 0)
+         strcat(psVisit->keys, " ");
+      strcat(psVisit->keys, pcKey);
+   }
+   psVisit->count++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if SymTable_map visits the keys of oSymTable in
+   the order given by pcExpected, a list of keys separated by
+   spaces, or 0 (FALSE) otherwise. */
+
+static int visitsInOrder(SymTable_T oSymTable, const char *pcExpected)
+{
+   char acKeys[256];
+   struct Visit sVisit;
+
+   acKeys[0] = '\0';
+   sVisit.keys = acKeys;
+   sVisit.capacity = sizeof(acKeys);
+   sVisit.count = 0;
+   SymTable_map(oSymTable, recordKey, &sVisit);
+   return sVisit.count == SymTable_getLength(oSymTable) &&
+      strcmp(acKeys, pcExpected) == 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that SymTable_map visits bindings in the order they were
+   added, that replacing a value keeps its binding's place, and that
+   a key removed and added again moves to the end. */
+
+static void testSmallOrder(void)
+{
+   SymTable_T oSymTable;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the order of a small table.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   ASSURE(visitsInOrder(oSymTable, ""));
+
+   ASSURE(SymTable_put(oSymTable, "Ruth", "RF"));
+   ASSURE(SymTable_put(oSymTable, "Gehrig", "1B"));
+   ASSURE(SymTable_put(oSymTable, "Mantle", "CF"));
+   ASSURE(SymTable_put(oSymTable, "Maris", "RF"));
+   ASSURE(SymTable_put(oSymTable, "Berra", "C"));
+   ASSURE(visitsInOrder(oSymTable, "Ruth Gehrig Mantle Maris Berra"));
+
+   ASSURE(strcmp(SymTable_replace(oSymTable, "Gehrig", "DH"), "1B")
+      == 0);
+   ASSURE(! SymTable_put(oSymTable, "Mantle", "LF"));
+   ASSURE(visitsInOrder(oSymTable, "Ruth Gehrig Mantle Maris Berra"));
+
+   ASSURE(strcmp(SymTable_remove(oSymTable, "Gehrig"), "DH") == 0);
+   ASSURE(strcmp(SymTable_remove(oSymTable, "Maris"), "RF") == 0);
+   ASSURE(visitsInOrder(oSymTable, "Ruth Mantle Berra"));
+
+   ASSURE(SymTable_put(oSymTable, "Gehrig", "1B"));
+   ASSURE(visitsInOrder(oSymTable, "Ruth Mantle Berra Gehrig"));
+   ASSURE(strcmp(SymTable_remove(oSymTable, "Ruth"), "RF") == 0);
+   ASSURE(SymTable_put(oSymTable, "Ruth", "P"));
+   ASSURE(visitsInOrder(oSymTable, "Mantle Berra Gehrig Ruth"));
+   ASSURE(strcmp(SymTable_get(oSymTable, "Ruth"), "P") == 0);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that the order survives the table growing, with holes left by
+   removals dropped along the way. */
+
+static void testOrderAfterGrowth(void)
+{
+   enum {KEY_COUNT = 40};
+   SymTable_T oSymTable;
+   char acExpected[256];
+   char acKey[8];
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the order of a growing table.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+
+   /* Add the keys, removing every third one right after the next is
+      added, and adding key 1 again at the end. */
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(acKey, "k%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, NULL));
+      if (i % 3 == 1)
+      {
+         sprintf(acKey, "k%d", i - 1);
+         ASSURE(SymTable_contains(oSymTable, acKey));
+         (void)SymTable_remove(oSymTable, acKey);
+      }
+   }
+   ASSURE(SymTable_remove(oSymTable, "k1") == NULL);
+   ASSURE(SymTable_put(oSymTable, "k1", NULL));
+
+   acExpected[0] = '\0';
+   for (i = 2; i < KEY_COUNT; i++)
+   {
+      if (i % 3 == 0 && i + 1 < KEY_COUNT)
+         continue;
+      sprintf(acKey, "k%d ", i);
+      strcat(acExpected, acKey);
+   }
+   strcat(acExpected, "k1");
+   ASSURE(visitsInOrder(oSymTable, acExpected));
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the insertion order of SymTable_map in the compact-dictionary
+   implementation. argv[1] is accepted, as with testsymtable, but not
+   used. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      return 1;
+   }
+
+   testSmallOrder();
+   testOrderAfterGrowth();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
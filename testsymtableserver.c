@@ -0,0 +1,310 @@
+/*--------------------------------------------------------------------*/
+/* testsymtableserver.c                                               */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+#define _XOPEN_SOURCE 700
+
+#include "symtableclient.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* Directory holding the socket, and the name of the socket */
+static char acDir[] = "/tmp/testsymtableserverXXXXXX";
+static char acSocket[sizeof(acDir) + 16];
+
+/* Number of clients in the concurrent test */
+enum {CLIENT_COUNT = 4};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a client connected to the server, waiting up to a few
+   seconds for the server to start listening, or NULL if it never
+   does. */
+
+static SymTableClient_T connectToServer(void)
+{
+   struct timespec sPause = {0, 10000000};
+   SymTableClient_T oClient = NULL;
+   int i;
+
+   for (i = 0; i < 500 && oClient == NULL; i++)
+   {
+      oClient = SymTableClient_connect(acSocket);
+      if (oClient == NULL)
+         (void)nanosleep(&sPause, NULL);
+   }
+   return oClient;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if the next response of oClient has status iStatus
+   and, unless pcValue is NULL, the value pcValue, or 0 (FALSE)
+   otherwise. */
+
+static int expect(SymTableClient_T oClient, int iStatus,
+   const char *pcValue)
+{
+   const void *pvValue;
+   size_t uLength;
+
+   if (SymTableClient_receive(oClient, &pvValue, &uLength) != iStatus)
+      return 0;
+   if (pcValue == NULL)
+      return 1;
+   return uLength == strlen(pcValue) &&
+      memcmp(pvValue, pcValue, uLength) == 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test each request on its own. */
+
+static void testBasics(void)
+{
+   SymTableClient_T oClient;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the basic requests.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oClient = connectToServer();
+   ASSURE(oClient != NULL);
+   if (oClient == NULL)
+      return;
+
+   ASSURE(SymTableClient_sendGet(oClient, "Ruth"));
+   ASSURE(expect(oClient, SYMTABLEPROTO_NOT_FOUND, ""));
+   ASSURE(SymTableClient_sendPut(oClient, "Ruth", "RF", 2));
+   ASSURE(expect(oClient, SYMTABLEPROTO_OK, ""));
+   ASSURE(SymTableClient_sendGet(oClient, "Ruth"));
+   ASSURE(expect(oClient, SYMTABLEPROTO_OK, "RF"));
+
+   /* A put replaces the value of a bound key. */
+   ASSURE(SymTableClient_sendPut(oClient, "Ruth", "Pitcher", 7));
+   ASSURE(expect(oClient, SYMTABLEPROTO_OK, ""));
+   ASSURE(SymTableClient_sendGet(oClient, "Ruth"));
+   ASSURE(expect(oClient, SYMTABLEPROTO_OK, "Pitcher"));
+
+   /* Empty keys and values are allowed. */
+   ASSURE(SymTableClient_sendPut(oClient, "", NULL, 0));
+   ASSURE(expect(oClient, SYMTABLEPROTO_OK, ""));
+   ASSURE(SymTableClient_sendGet(oClient, ""));
+   ASSURE(expect(oClient, SYMTABLEPROTO_OK, ""));
+
+   ASSURE(SymTableClient_sendRemove(oClient, "Ruth"));
+   ASSURE(expect(oClient, SYMTABLEPROTO_OK, ""));
+   ASSURE(SymTableClient_sendRemove(oClient, "Ruth"));
+   ASSURE(expect(oClient, SYMTABLEPROTO_NOT_FOUND, ""));
+   ASSURE(SymTableClient_sendGet(oClient, "Ruth"));
+   ASSURE(expect(oClient, SYMTABLEPROTO_NOT_FOUND, ""));
+   ASSURE(SymTableClient_sendRemove(oClient, ""));
+   ASSURE(expect(oClient, SYMTABLEPROTO_OK, ""));
+
+   SymTableClient_free(oClient);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test iBindingCount puts and then as many gets, each sent before
+   any response is received. */
+
+static void testPipelining(int iBindingCount)
+{
+   SymTableClient_T oClient;
+   char acKey[32];
+   char acValue[32];
+   int iAllFound = 1;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing pipelined requests.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oClient = connectToServer();
+   ASSURE(oClient != NULL);
+   if (oClient == NULL)
+      return;
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      sprintf(acValue, "%d", i * 3);
+      ASSURE(SymTableClient_sendPut(oClient, acKey, acValue,
+         strlen(acValue)));
+   }
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTableClient_sendGet(oClient, acKey));
+   }
+   for (i = 0; i < iBindingCount; i++)
+      if (! expect(oClient, SYMTABLEPROTO_OK, ""))
+         iAllFound = 0;
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acValue, "%d", i * 3);
+      if (! expect(oClient, SYMTABLEPROTO_OK, acValue))
+         iAllFound = 0;
+   }
+   ASSURE(iAllFound);
+
+   SymTableClient_free(oClient);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put, get and remove the keys of client iClient, which no other
+   client uses, iBindingCount times in batches. Return 1 (TRUE) if
+   every response was right, or 0 (FALSE) otherwise. */
+
+static int runClient(int iClient, int iBindingCount)
+{
+   enum {BATCH = 64};
+   SymTableClient_T oClient;
+   char acKey[32];
+   int iOk = 1;
+   int iFirst;
+   int i;
+
+   oClient = connectToServer();
+   if (oClient == NULL)
+      return 0;
+
+   for (iFirst = 0; iFirst < iBindingCount; iFirst += BATCH)
+   {
+      for (i = iFirst; i < iBindingCount && i < iFirst + BATCH; i++)
+      {
+         sprintf(acKey, "c%d-%d", iClient, i % BATCH);
+         iOk &= SymTableClient_sendPut(oClient, acKey, acKey,
+            strlen(acKey));
+         iOk &= SymTableClient_sendGet(oClient, acKey);
+         iOk &= SymTableClient_sendRemove(oClient, acKey);
+      }
+      for (i = iFirst; i < iBindingCount && i < iFirst + BATCH; i++)
+      {
+         sprintf(acKey, "c%d-%d", iClient, i % BATCH);
+         iOk &= expect(oClient, SYMTABLEPROTO_OK, "");
+         iOk &= expect(oClient, SYMTABLEPROTO_OK, acKey);
+         iOk &= expect(oClient, SYMTABLEPROTO_OK, "");
+      }
+   }
+
+   SymTableClient_free(oClient);
+   return iOk;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test several clients, each in its own process, at once. */
+
+static void testConcurrentClients(int iBindingCount)
+{
+   pid_t aiPids[CLIENT_COUNT];
+   int iStatus;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing concurrent clients.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < CLIENT_COUNT; i++)
+   {
+      aiPids[i] = fork();
+      ASSURE(aiPids[i] >= 0);
+      if (aiPids[i] == 0)
+         _exit(runClient(i, iBindingCount) ? 0 : 1);
+   }
+   for (i = 0; i < CLIENT_COUNT; i++)
+   {
+      ASSURE(aiPids[i] > 0 && waitpid(aiPids[i], &iStatus, 0) > 0);
+      ASSURE(WIFEXITED(iStatus) && WEXITSTATUS(iStatus) == 0);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test symtableserver by running it with a socket in a temporary
+   directory and sending it requests. As with testsymtable, argv[1] is
+   the number of bindings for the large tests. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+   pid_t iServer;
+   int iStatus;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      return 1;
+   }
+   iBindingCount = atoi(argv[1]);
+
+   if (mkdtemp(acDir) == NULL)
+   {
+      perror("mkdtemp");
+      return 1;
+   }
+   sprintf(acSocket, "%s/socket", acDir);
+
+   fflush(stdout);
+   iServer = fork();
+   if (iServer == 0)
+   {
+      execl("./symtableserver", "symtableserver", acSocket, "2",
+         (char *)NULL);
+      perror("./symtableserver");
+      _exit(1);
+   }
+
+   testBasics();
+   testPipelining(iBindingCount);
+   testConcurrentClients(iBindingCount);
+
+   /* The server stops cleanly and removes its socket. */
+   printf("------------------------------------------------------\n");
+   printf("Testing stopping the server.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+   ASSURE(iServer > 0 && kill(iServer, SIGTERM) == 0);
+   ASSURE(iServer > 0 && waitpid(iServer, &iStatus, 0) == iServer);
+   ASSURE(WIFEXITED(iStatus) && WEXITSTATUS(iStatus) == 0);
+   ASSURE(access(acSocket, F_OK) != 0);
+
+   (void)rmdir(acDir);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,481 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablesharing.c                                              */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+#define _XOPEN_SOURCE 700
+
+#include "symtableshm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* Number of bytes of the regions made by the tests */
+enum {REGION_BYTES = 256 * 1024 * 1024};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the value bound to key i by the tests, as a pointer. */
+
+static void *valueOf(int i)
+{
+   return (void *)(intptr_t)(i * 7 + 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if oSymTable binds keys iFirst through iLast - 1,
+   each to valueOf, or 0 (FALSE) otherwise. */
+
+static int hasKeys(SymTable_T oSymTable, int iFirst, int iLast)
+{
+   char acKey[32];
+   int i;
+
+   for (i = iFirst; i < iLast; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (SymTable_get(oSymTable, acKey) != valueOf(i))
+         return 0;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Bind keys iFirst through iLast - 1 in oSymTable, each to valueOf.
+   Return 1 (TRUE) if every binding was added, or 0 (FALSE) otherwise. */
+
+static int putKeys(SymTable_T oSymTable, int iFirst, int iLast)
+{
+   char acKey[32];
+   int i;
+
+   for (i = iFirst; i < iLast; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (! SymTable_put(oSymTable, acKey, valueOf(i)))
+         return 0;
+   }
+   return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run pfChild with oSymTable and iBindingCount in a child process and
+   return 1 (TRUE) if it returned 1, or 0 (FALSE) otherwise. */
+
+static int runChild(int (*pfChild)(SymTable_T oSymTable,
+                                   int iBindingCount),
+   SymTable_T oSymTable, int iBindingCount)
+{
+   pid_t iPid;
+   int iStatus;
+
+   fflush(stdout);
+   iPid = fork();
+   if (iPid < 0)
+      return 0;
+   if (iPid == 0)
+      _exit((*pfChild)(oSymTable, iBindingCount) ? 0 : 1);
+   if (waitpid(iPid, &iStatus, 0) != iPid)
+      return 0;
+   return WIFEXITED(iStatus) && WEXITSTATUS(iStatus) == 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check the bindings made by the parent in testFork, then replace,
+   remove and add some. Return 1 (TRUE) if every check passed. */
+
+static int updateInChild(SymTable_T oSymTable, int iBindingCount)
+{
+   int iOk = 1;
+
+   if (SymTable_getLength(oSymTable) != (size_t)iBindingCount ||
+       ! hasKeys(oSymTable, 0, iBindingCount))
+      iOk = 0;
+   if (SymTable_replace(oSymTable, "0", "child") != valueOf(0) ||
+       SymTable_remove(oSymTable, "1") != valueOf(1) ||
+       ! putKeys(oSymTable, iBindingCount, iBindingCount * 2))
+      iOk = 0;
+   return iOk;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a child process sees the bindings of its parent and that
+   the parent sees the updates of its child, across expansions of the
+   bucket array made by either process. */
+
+static void testFork(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   size_t uUsed;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a table shared with a child process.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   if (iBindingCount < 2)
+      iBindingCount = 2;
+
+   oSymTable = SymTable_newShared(NULL, REGION_BYTES);
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+
+   ASSURE(putKeys(oSymTable, 0, iBindingCount));
+   ASSURE(runChild(updateInChild, oSymTable, iBindingCount));
+
+   /* The child's "child" is a string literal at the same address in
+      the parent, which forked from the same program. */
+   ASSURE(SymTable_getLength(oSymTable) ==
+          (size_t)(iBindingCount * 2 - 1));
+   ASSURE(SymTable_get(oSymTable, "0") == (void *)"child");
+   ASSURE(! SymTable_contains(oSymTable, "1"));
+   ASSURE(hasKeys(oSymTable, 2, iBindingCount * 2));
+
+   /* Memory of removed bindings is reused. */
+   uUsed = SymTable_getRegionBytesUsed(oSymTable);
+   ASSURE(SymTable_remove(oSymTable, "2") == valueOf(2));
+   ASSURE(SymTable_put(oSymTable, "2", valueOf(2)));
+   ASSURE(SymTable_getRegionBytesUsed(oSymTable) == uUsed);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Read the bindings made by the parent in testConcurrentReaders
+   while the parent adds and removes others. Return 1 (TRUE) if every
+   read found the right value. */
+
+static int readInChild(SymTable_T oSymTable, int iBindingCount)
+{
+   int iRound;
+   int iOk = 1;
+
+   for (iRound = 0; iRound < 20; iRound++)
+      if (! hasKeys(oSymTable, 0, iBindingCount) ||
+          SymTable_contains(oSymTable, "-1"))
+         iOk = 0;
+   return iOk;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test lookups in one process that overlap updates in another. */
+
+static void testConcurrentReaders(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   char acKey[32];
+   pid_t iPid;
+   int iStatus;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing lookups that overlap updates.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_newShared(NULL, REGION_BYTES);
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   ASSURE(putKeys(oSymTable, 0, iBindingCount));
+
+   iPid = fork();
+   ASSURE(iPid >= 0);
+   if (iPid == 0)
+      _exit(readInChild(oSymTable, iBindingCount) ? 0 : 1);
+
+   /* Add and remove other bindings, growing the bucket array, until
+      the reader finishes. */
+   i = iBindingCount;
+   while (waitpid(iPid, &iStatus, WNOHANG) == 0)
+   {
+      sprintf(acKey, "%d", i);
+      (void)SymTable_put(oSymTable, acKey, valueOf(i));
+      if (i % 2 == 0)
+         (void)SymTable_remove(oSymTable, acKey);
+      i++;
+   }
+   ASSURE(WIFEXITED(iStatus) && WEXITSTATUS(iStatus) == 0);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a region kept in a file by attaching to it after the table
+   that made it is freed. */
+
+static void testAttach(int iBindingCount)
+{
+   char acPath[] = "/tmp/testsymtablesharingXXXXXX";
+   SymTable_T oSymTable;
+   FILE *psFile;
+   int fd;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a table kept in a file.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   fd = mkstemp(acPath);
+   ASSURE(fd >= 0);
+   if (fd < 0)
+      return;
+   (void)close(fd);
+
+   /* A file that does not hold a region cannot be attached. */
+   ASSURE(SymTable_attachShared(acPath) == NULL);
+   psFile = fopen(acPath, "w");
+   ASSURE(psFile != NULL);
+   if (psFile != NULL)
+   {
+      fputs("not a symbol table", psFile);
+      fclose(psFile);
+   }
+   ASSURE(SymTable_attachShared(acPath) == NULL);
+
+   /* A file that already exists is not overwritten. */
+   ASSURE(SymTable_newShared(acPath, REGION_BYTES) == NULL);
+   (void)unlink(acPath);
+
+   oSymTable = SymTable_newShared(acPath, REGION_BYTES);
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   ASSURE(putKeys(oSymTable, 0, iBindingCount));
+   SymTable_free(oSymTable);
+   ASSURE(SymTable_newShared(acPath, REGION_BYTES) == NULL);
+
+   oSymTable = SymTable_attachShared(acPath);
+   ASSURE(oSymTable != NULL);
+   if (oSymTable != NULL)
+   {
+      ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount);
+      ASSURE(hasKeys(oSymTable, 0, iBindingCount));
+      ASSURE(! SymTable_contains(oSymTable, "-1"));
+      SymTable_free(oSymTable);
+   }
+
+   (void)unlink(acPath);
+   ASSURE(SymTable_attachShared(acPath) == NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* End the calling process, a child that holds the writer lock of the
+   table whose binding of pcKey to pvValue is being visited. pvExtra
+   is unused. */
+
+static void dieHoldingLock(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   assert(pcKey != NULL);
+   (void)pvValue;
+   (void)pvExtra;
+   _exit(0);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that the writer lock is recovered after a child process dies
+   holding it. */
+
+static void testDeadWriter(void)
+{
+   SymTable_T oSymTable;
+   pid_t iPid;
+   int iStatus;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a process that dies holding the lock.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_newShared(NULL, REGION_BYTES);
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   ASSURE(putKeys(oSymTable, 0, 10));
+
+   fflush(stdout);
+   iPid = fork();
+   ASSURE(iPid >= 0);
+   if (iPid == 0)
+   {
+      SymTable_map(oSymTable, dieHoldingLock, NULL);
+      _exit(1);
+   }
+   ASSURE(waitpid(iPid, &iStatus, 0) == iPid);
+   ASSURE(WIFEXITED(iStatus) && WEXITSTATUS(iStatus) == 0);
+
+   /* Without recovery these would wait for the lock forever. */
+   ASSURE(SymTable_put(oSymTable, "10", valueOf(10)));
+   ASSURE(SymTable_remove(oSymTable, "0") == valueOf(0));
+   ASSURE(SymTable_getLength(oSymTable) == 10);
+   ASSURE(hasKeys(oSymTable, 1, 11));
+   ASSURE(SymTable_getRegionBytesUsed(oSymTable) > 0);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a child process killed while it adds bindings, and so
+   often in the middle of an expansion of the bucket array, loses none
+   of the bindings made before it started. */
+
+static void testKilledWriter(void)
+{
+   enum {KEPT_COUNT = 1000, ROUND_COUNT = 16};
+   SymTable_T oSymTable;
+   struct timespec sPause;
+   pid_t iPid;
+   int iRound;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a process killed during updates.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (iRound = 0; iRound < ROUND_COUNT; iRound++)
+   {
+      oSymTable = SymTable_newShared(NULL, REGION_BYTES);
+      ASSURE(oSymTable != NULL);
+      if (oSymTable == NULL)
+         return;
+      ASSURE(putKeys(oSymTable, 0, KEPT_COUNT));
+
+      /* The child adds bindings until the region is full, unless it
+         is killed first, after a pause that differs in each round. */
+      fflush(stdout);
+      iPid = fork();
+      ASSURE(iPid >= 0);
+      if (iPid == 0)
+      {
+         (void)putKeys(oSymTable, KEPT_COUNT, REGION_BYTES);
+         _exit(0);
+      }
+      if (iPid > 0)
+      {
+         sPause.tv_sec = 0;
+         sPause.tv_nsec = (long)(iRound + 1) * 4000000L;
+         (void)nanosleep(&sPause, NULL);
+         (void)kill(iPid, SIGKILL);
+         (void)waitpid(iPid, NULL, 0);
+      }
+
+      /* The first update recovers the lock if the child died holding
+         it, after which readers no longer wait for the child. */
+      ASSURE(SymTable_remove(oSymTable, "0") == valueOf(0));
+      ASSURE(SymTable_put(oSymTable, "0", valueOf(0)));
+      ASSURE(hasKeys(oSymTable, 0, KEPT_COUNT));
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a region too small for every binding. */
+
+static void testFullRegion(void)
+{
+   enum {SMALL_REGION_BYTES = 64 * 1024};
+   SymTable_T oSymTable;
+   char acKey[32];
+   size_t uLength;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a full region.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   ASSURE(SymTable_newShared(NULL, 16) == NULL);
+
+   oSymTable = SymTable_newShared(NULL, SMALL_REGION_BYTES);
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+
+   /* Bind keys until the region is full. */
+   for (i = 0; i < SMALL_REGION_BYTES; i++)
+   {
+      sprintf(acKey, "%d", i);
+      if (! SymTable_put(oSymTable, acKey, valueOf(i)))
+         break;
+   }
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == (size_t)i);
+   ASSURE(i > 0 && i < SMALL_REGION_BYTES);
+   ASSURE(SymTable_getRegionBytesUsed(oSymTable) <= SMALL_REGION_BYTES);
+   ASSURE(hasKeys(oSymTable, 0, i));
+
+   /* Removing a binding makes room for another. */
+   ASSURE(SymTable_remove(oSymTable, "0") == valueOf(0));
+   ASSURE(SymTable_put(oSymTable, "0", valueOf(0)));
+   ASSURE(SymTable_getLength(oSymTable) == uLength);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test sharing a SymTable among processes. As with testsymtable,
+   argv[1] is the number of bindings for the large tests. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      return 1;
+   }
+   iBindingCount = atoi(argv[1]);
+
+   testFork(iBindingCount);
+   testConcurrentReaders(iBindingCount);
+   testAttach(iBindingCount);
+   testDeadWriter();
+   testKilledWriter();
+   testFullRegion();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,135 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablestash.c                                                */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count the binding at pcKey in the size_t at pvCount. pvValue is
+   unused. */
+
+static void countBinding(const char *pcKey, void *pvValue,
+   void *pvCount)
+{
+   assert(pcKey != NULL);
+   (void)pvValue;
+   (*(size_t *)pvCount)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test keys that all have the same hash code, and so the same two
+   buckets however large the table grows. Once both buckets are full,
+   each further key is left without a slot: the first goes to the
+   stash, and the ones after it must fail to be added rather than
+   push a binding out of the stash. */
+
+static void testHomelessKeys(void)
+{
+   /* Sixteen keys with one hash code, more than the two buckets and
+      the stash can hold */
+   const char *apcKeys[] = {"cccccccccccccccc", "ggjg][ciZZ`bffgd",
+      "^jkia\\`aegh]eaZa", "bnrm[T`g\\^e\\hd^b", "bg`lbf``g`fa^[c]",
+      "fkgp\\^`f^Wc`a^g^", "]nhr`_]^idk[`YZ[", "arovZW]d`[hZc\\^\\",
+      "dahh]bgablebaahe", "heolWZggYcbaddlf", "_hpn[[d_dpj\\c__c",
+      "clwrUSde[gg[fbcd", "ceeq\\ed^fih`\\Yh_", "giluV]dd]`e__\\l`",
+      "^lmwZ^a\\hmmZ^W_]", "bpt{TVab_djYaZc^"};
+   enum {KEY_COUNT = sizeof(apcKeys) / sizeof(apcKeys[0])};
+   SymTable_T oSymTable;
+   int aiAdded[KEY_COUNT];
+   size_t uAddedCount = 0;
+   size_t uMapCount = 0;
+   int iAllFound = 1;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing keys left without a slot.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      aiAdded[i] = SymTable_put(oSymTable, apcKeys[i],
+         (void *)(size_t)(i + 1));
+      if (aiAdded[i])
+         uAddedCount++;
+   }
+   /* Two buckets of six slots and the stash hold thirteen keys, and
+      the keys after them are refused. */
+   ASSURE(uAddedCount == 13);
+   ASSURE(! aiAdded[KEY_COUNT - 1]);
+   ASSURE(SymTable_getLength(oSymTable) == uAddedCount);
+
+   /* No binding that was added has been lost. */
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      if (aiAdded[i])
+      {
+         if (SymTable_get(oSymTable, apcKeys[i]) !=
+             (void *)(size_t)(i + 1))
+            iAllFound = 0;
+      }
+      else if (SymTable_contains(oSymTable, apcKeys[i]))
+         iAllFound = 0;
+   }
+   ASSURE(iAllFound);
+   SymTable_map(oSymTable, countBinding, &uMapCount);
+   ASSURE(uMapCount == uAddedCount);
+
+   /* Removing a binding makes room for one refused key. */
+   ASSURE(SymTable_remove(oSymTable, apcKeys[0]) == (void *)1);
+   ASSURE(SymTable_put(oSymTable, apcKeys[KEY_COUNT - 1], NULL));
+   ASSURE(SymTable_contains(oSymTable, apcKeys[KEY_COUNT - 1]));
+   ASSURE(SymTable_getLength(oSymTable) == uAddedCount);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the stash of the cuckoo implementation. argv[1] is accepted,
+   as with testsymtable, but not used. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      return 1;
+   }
+
+   testHomelessKeys();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
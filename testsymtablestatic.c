@@ -0,0 +1,268 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablestatic.c                                               */
+/* Author: Andy Lau                                                   */
+/*--------------------------------------------------------------------*/
+
+#include "symtablestatic.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* Largest number of bindings in the trees of every size tested, a
+   little more than 2^6 - 1 */
+enum {MAX_TREE_SIZE = 70};
+
+/* A Walk records what SymTableStatic_map has passed to checkOrder. */
+
+struct Walk
+{
+   /* The previous key, and whether there was one. */
+   char acPrevious[128];
+   int iStarted;
+   /* The number of bindings seen, and whether they were in order. */
+   size_t uCount;
+   int iInOrder;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that pcKey follows the previous key of pvWalk, a Walk, and
+   count it. pvValue is unused. */
+
+static void checkOrder(const char *pcKey, void *pvValue, void *pvWalk)
+{
+   struct Walk *psWalk = pvWalk;
+
+   (void)pvValue;
+   if (psWalk->iStarted && strcmp(psWalk->acPrevious, pcKey) >= 0)
+      psWalk->iInOrder = 0;
+   strncpy(psWalk->acPrevious, pcKey, sizeof(psWalk->acPrevious) - 1);
+   psWalk->acPrevious[sizeof(psWalk->acPrevious) - 1] = '\0';
+   psWalk->iStarted = 1;
+   psWalk->uCount++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write to pcKey key number iIndex of a tree, which starts with
+   pcStem. The keys increase with iIndex. */
+
+static void makeKey(char *pcKey, const char *pcStem, int iIndex)
+{
+   sprintf(pcKey, "%s%06d", pcStem, iIndex);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Build a static table of the even-numbered keys from 0 to
+   2 * (iSize - 1) that start with pcStem, and return 1 (TRUE) if
+   every one of them is found with its value, no odd-numbered key or
+   key beyond either end is found, and SymTableStatic_map visits the
+   keys in order, or 0 (FALSE) otherwise. */
+
+static int checkTree(const char *pcStem, int iSize)
+{
+   SymTable_T oSymTable;
+   SymTableStatic_T oStatic;
+   struct Walk sWalk = {"", 0, 0, 1};
+   char acKey[64];
+   int iOk = 1;
+   int i;
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+      return 0;
+   for (i = 0; i < iSize; i++)
+   {
+      makeKey(acKey, pcStem, 2 * i);
+      if (! SymTable_put(oSymTable, acKey, (void *)(size_t)(i + 1)))
+         iOk = 0;
+   }
+   oStatic = SymTable_buildStatic(oSymTable);
+   SymTable_free(oSymTable);
+   if (oStatic == NULL)
+      return 0;
+
+   /* Look up every key and every gap, so that each descent ends on
+      every node and both sides of it. */
+   for (i = 0; i < 2 * iSize + 1; i++)
+   {
+      makeKey(acKey, pcStem, i);
+      if (i % 2 == 0 && i < 2 * iSize)
+      {
+         if (SymTableStatic_get(oStatic, acKey) !=
+             (void *)(size_t)(i / 2 + 1))
+            iOk = 0;
+      }
+      else if (SymTableStatic_contains(oStatic, acKey))
+         iOk = 0;
+   }
+   if (SymTableStatic_contains(oStatic, pcStem) ||
+       SymTableStatic_contains(oStatic, "") ||
+       SymTableStatic_contains(oStatic, "\xff"))
+      iOk = 0;
+
+   SymTableStatic_map(oStatic, checkOrder, &sWalk);
+   if (sWalk.uCount != (size_t)iSize || ! sWalk.iInOrder ||
+       SymTableStatic_getLength(oStatic) != (size_t)iSize)
+      iOk = 0;
+
+   SymTableStatic_free(oStatic);
+   return iOk;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test trees of every size up to MAX_TREE_SIZE, both complete ones
+   of 2^k - 1 nodes and ones whose bottom level is partly filled,
+   whose keys differ within the 16-byte prefix or only after it. */
+
+static void testTreeSizes(void)
+{
+   int iSize;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing static tables of every shape.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (iSize = 0; iSize <= MAX_TREE_SIZE; iSize++)
+   {
+      /* Keys that differ within the prefix */
+      ASSURE(checkTree("k", iSize));
+      /* Keys whose first 16 bytes are all equal */
+      ASSURE(checkTree("George Herman Ru", iSize));
+      /* Keys whose 16-byte prefix ends within the number */
+      ASSURE(checkTree("George Herman ", iSize));
+   }
+
+   /* The complete trees around a power of two, at a larger size */
+   ASSURE(checkTree("George Herman Ru", 511));
+   ASSURE(checkTree("George Herman Ru", 512));
+   ASSURE(checkTree("George Herman Ru", 513));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test keys that tie on their 16-byte prefix: keys of exactly 16
+   bytes, longer keys that extend them, keys that differ only after
+   the prefix, and keys with bytes above 127 in and after it. */
+
+static void testPrefixTies(void)
+{
+   const char *apcKeys[] = {"George Herman Ru", "George Herman Ruth",
+      "George Herman Rush", "George Herman Ruth\xc3\xbc",
+      "George Herman Rut", "George Herman R", "George Herman R\xc3",
+      "George Herman Ru\xc3\xbc", "Ruthlessly", "Ruthlesses", ""};
+   enum {KEY_COUNT = sizeof(apcKeys) / sizeof(apcKeys[0])};
+   SymTable_T oSymTable;
+   SymTableStatic_T oStatic;
+   struct Walk sWalk = {"", 0, 0, 1};
+   int iAllFound = 1;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing keys that tie on their prefix.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (oSymTable == NULL)
+      return;
+   for (i = 0; i < KEY_COUNT; i++)
+      ASSURE(SymTable_put(oSymTable, apcKeys[i], (void *)apcKeys[i]));
+   oStatic = SymTable_buildStatic(oSymTable);
+   SymTable_free(oSymTable);
+   ASSURE(oStatic != NULL);
+   if (oStatic == NULL)
+      return;
+
+   for (i = 0; i < KEY_COUNT; i++)
+      if (SymTableStatic_get(oStatic, apcKeys[i]) != apcKeys[i])
+         iAllFound = 0;
+   ASSURE(iAllFound);
+
+   /* Keys that tie on the prefix with bound keys but are not bound */
+   ASSURE(! SymTableStatic_contains(oStatic, "George Herman Ru\x01"));
+   ASSURE(! SymTableStatic_contains(oStatic, "George Herman Rus"));
+   ASSURE(! SymTableStatic_contains(oStatic, "George Herman Ruths"));
+   ASSURE(! SymTableStatic_contains(oStatic, "George Herman Rushh"));
+   ASSURE(! SymTableStatic_contains(oStatic, "George Herman Ru\xc3"));
+   ASSURE(! SymTableStatic_contains(oStatic, "George Herman Ru\xff"));
+   ASSURE(! SymTableStatic_contains(oStatic, "George Herman Ruth\xc3"));
+   /* Keys that differ from bound keys within the prefix */
+   ASSURE(! SymTableStatic_contains(oStatic, "George Herman "));
+   ASSURE(! SymTableStatic_contains(oStatic, "George Herman Rv"));
+   ASSURE(! SymTableStatic_contains(oStatic, "Ruthlessl"));
+   ASSURE(! SymTableStatic_contains(oStatic, "Ruthlesslyy"));
+
+   SymTableStatic_map(oStatic, checkOrder, &sWalk);
+   ASSURE(sWalk.uCount == KEY_COUNT);
+   ASSURE(sWalk.iInOrder);
+
+   SymTableStatic_free(oStatic);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a static table of iBindingCount bindings whose keys all tie on
+   their prefix, so that every comparison falls back to the rest of
+   the key. */
+
+static void testLargeTable(int iBindingCount)
+{
+   printf("------------------------------------------------------\n");
+   printf("Testing a large static table.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   ASSURE(checkTree("George Herman Ru", iBindingCount));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the static table, built from the hash table implementation.
+   As with testsymtable, argv[1] is the number of bindings for the
+   large test. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      return 1;
+   }
+   iBindingCount = atoi(argv[1]);
+
+   testTreeSizes();
+   testPrefixTies();
+   testLargeTable(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}